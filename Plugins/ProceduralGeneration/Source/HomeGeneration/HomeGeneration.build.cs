@@ -26,6 +26,7 @@ public class HomeGeneration : ModuleRules
 			new string[]
 			{
 				"Core",
+				"HomeGenerationCore",
 				// ... add other public dependencies that you statically link with here ...
 			}
 			);
@@ -38,9 +39,25 @@ public class HomeGeneration : ModuleRules
 				"Engine",
 				"Slate",
 				"SlateCore",
+				"ProceduralMeshComponent",
+				"Json",
+				"Sockets",
+				"Networking",
 				// ... add private dependencies that you statically link with here ...	
 			}
 			);
+
+		//Baking of the shell into a static mesh (see AHomeGenerator::BakeBuilding)
+		if (Target.bBuildEditor)
+		{
+			PrivateDependencyModuleNames.AddRange(
+				new string[]
+				{
+					"MeshDescription",
+					"StaticMeshDescription",
+				}
+				);
+		}
 		
 		
 		DynamicallyLoadedModuleNames.AddRange(
@@ -2,3 +2,45 @@
 
 
 #include "DecoBase.h"
+#include "Materials/MaterialInstanceDynamic.h"
+
+UMaterialInterface* FRoomDecoration::GetMaterial(EDecorationSurface Surface) const
+{
+	switch (Surface)
+	{
+		case EDecorationSurface::Floor: return Floor;
+		case EDecorationSurface::Wall: return Wall;
+		case EDecorationSurface::Ceiling: return Ceiling;
+		default: return nullptr;
+	}
+}
+
+FRoomDecoration UDecoBase::CreateDecoration(const FName& RoomType)
+{
+	FRoomDecoration Decoration;
+	Decoration.Floor = CreateMaterial(FloorMaterial, EDecorationSurface::Floor, RoomType);
+	Decoration.Wall = CreateMaterial(WallMaterial, EDecorationSurface::Wall, RoomType);
+	Decoration.Ceiling = CreateMaterial(CeilingMaterial, EDecorationSurface::Ceiling, RoomType);
+	return Decoration;
+}
+
+void UDecoBase::SetupMaterial_Implementation(EDecorationSurface Surface, FName RoomType, UMaterialInstanceDynamic* Material)
+{
+}
+
+FLinearColor UDecoBase::GetRoomVariation_Implementation(FName RoomType, int32 RoomSeed) const
+{
+	const FRandomStream Stream(RoomSeed);
+	return FLinearColor(Stream.FRand(), Stream.FRand(), Stream.FRand(), 1.f);
+}
+
+UMaterialInterface* UDecoBase::CreateMaterial(UMaterialInterface* Parent, EDecorationSurface Surface, const FName& RoomType)
+{
+	if(!Parent)
+		return nullptr;
+
+	//Outer is the decoration : it lives as long as the world cache
+	UMaterialInstanceDynamic *Material = UMaterialInstanceDynamic::Create(Parent, this);
+	SetupMaterial(Surface, RoomType, Material);
+	return Material;
+}
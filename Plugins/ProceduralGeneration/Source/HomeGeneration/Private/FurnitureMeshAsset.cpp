@@ -3,6 +3,9 @@
 
 #include "FurnitureMeshAsset.h"
 #include "HomeGenerator.h"
+#include "HomeGeneration.h"
+#include "HGLayoutCache.h"
+#include "Engine/StaticMesh.h"
 
 uint8 operator|(EGenerationAxe A, EGenerationAxe B)
 {
@@ -19,71 +22,191 @@ uint8 operator|(uint8 A, EGenerationAxe B)
 	return B | A;
 }
 
-bool FWallInteractionStruct::GetFirstAttractedWall(EGenerationAxe& First) const
+//The plain enums are cast from the asset ones
+static_assert(static_cast<uint8>(EGenerationAxe::X_UP) == static_cast<uint8>(EHGAxe::X_UP) && static_cast<uint8>(EGenerationAxe::X_DOWN) == static_cast<uint8>(EHGAxe::X_DOWN)
+	&& static_cast<uint8>(EGenerationAxe::Y_UP) == static_cast<uint8>(EHGAxe::Y_UP) && static_cast<uint8>(EGenerationAxe::Y_DOWN) == static_cast<uint8>(EHGAxe::Y_DOWN), "EGenerationAxe and EHGAxe must match");
+static_assert(static_cast<uint8>(EWallGlobalInteraction::FAR) == static_cast<uint8>(EHGWallGlobalInteraction::FAR), "EWallGlobalInteraction and EHGWallGlobalInteraction must match");
+static_assert(static_cast<uint8>(EWallAxeInteraction::REJECT) == static_cast<uint8>(EHGWallAxeInteraction::REJECT), "EWallAxeInteraction and EHGWallAxeInteraction must match");
+static_assert(static_cast<uint8>(EDependencyPlace::DEFAULT) == static_cast<uint8>(EHGDependencyPlace::DEFAULT), "EDependencyPlace and EHGDependencyPlace must match");
+
+FHGWallInteraction FWallInteractionStruct::ToCore() const
 {
-	if(XUp == EWallAxeInteraction::ATTRACT)
-	{
-		First = EGenerationAxe::X_UP;
-		return true;
-	}
+	FHGWallInteraction Interaction;
+	Interaction.WallGlobalInteraction = static_cast<EHGWallGlobalInteraction>(WallGlobalInteraction);
+	Interaction.XUp = static_cast<EHGWallAxeInteraction>(XUp);
+	Interaction.XDown = static_cast<EHGWallAxeInteraction>(XDown);
+	Interaction.YUp = static_cast<EHGWallAxeInteraction>(YUp);
+	Interaction.YDown = static_cast<EHGWallAxeInteraction>(YDown);
+	return Interaction;
+}
 
-	if(XDown == EWallAxeInteraction::ATTRACT)
-	{
-		First = EGenerationAxe::X_DOWN;
-		return true;
-	}
+FHGMargin FMarginStruct::ToCore() const
+{
+	FHGMargin CoreMargin;
+	CoreMargin.XUp = XUp;
+	CoreMargin.XDown = XDown;
+	CoreMargin.YUp = YUp;
+	CoreMargin.YDown = YDown;
+	return CoreMargin;
+}
+
+FHGFurnitureConstraint FFurnitureConstraint::ToCore() const
+{
+	FHGFurnitureConstraint Constraint;
+	Constraint.WallAxeInteraction = WallAxeInteraction.ToCore();
+	Constraint.Margin = Margin.ToCore();
+	return Constraint;
+}
+
+FHGFurnitureDependency FFurnitureDependency::ToCore() const
+{
+	FHGFurnitureDependency Dependency;
+	Dependency.Distance = Distance;
+	Dependency.Axe = static_cast<EHGAxe>(Axe);
+	Dependency.Position = static_cast<EHGDependencyPlace>(Position);
+	Dependency.FurnitureType = FurnitureType;
+	return Dependency;
+}
+
+FHGMeshDescriptor UFurnitureMeshAsset::MakeDescriptor(int32 MeshId, const FMeshFootprint &GridFootprint) const
+{
+	FHGMeshDescriptor Descriptor;
+	Descriptor.MeshId = MeshId;
+	Descriptor.GridSize = GridFootprint.GetGridSize();
+	Descriptor.bOverrideConstraint = bOverrideConstraint;
+	Descriptor.ConstraintsOverride = ConstraintsOverride.ToCore();
+	Descriptor.Height = 2.f * GridFootprint.BoxExtent.Z;
+	return Descriptor;
+}
 
-	if(YUp == EWallAxeInteraction::ATTRACT)
+bool UFurnitureMeshAsset::ValidateFootprint(float GridSnapLength, FMeshFootprint &GridFootprint)
+{
+#if WITH_EDITOR
+	//Nothing baked yet (asset never saved since the footprint exists) : bake it now
+	if(!Footprint.HasBounds() && IsValid(Mesh))
+		BakeFootprint();
+#endif
+
+	GridFootprint = Footprint;
+	if(!Footprint.HasBounds())
 	{
-		First = EGenerationAxe::Y_UP;
-		return true;
+		UE_LOG(LogHomeGeneration, Warning, TEXT("%s has no baked footprint : it won't be placed."), *GetName());
+		return false;
 	}
 
-	if(YDown == EWallAxeInteraction::ATTRACT)
+	if(!Footprint.IsValidFor(GridSnapLength))
 	{
-		First = EGenerationAxe::Y_DOWN;
-		return true;
+		UE_LOG(LogHomeGeneration, Verbose, TEXT("%s was baked for a grid snap length of %f (%f needed) : grid data recomputed."), *GetName(), Footprint.GridSnapLength, GridSnapLength);
+		GridFootprint.ComputeGridData(GridSnapLength);
 	}
+	return true;
+}
 
-	return false;
+const FString& UFurnitureMeshAsset::GetLayoutHash() const
+{
+	if(LayoutHash.IsEmpty())
+		LayoutHash = HGLayoutCache::HashAsset(this);
+	return LayoutHash;
 }
 
-bool FWallInteractionStruct::GetSecondAttractedWall(EGenerationAxe& Second) const
+void UFurnitureMeshAsset::PostLoad()
 {
-	EGenerationAxe First = EGenerationAxe::X_UP;
-	if(!GetFirstAttractedWall(First))
-		return false;
+	Super::PostLoad();
+	LayoutHash.Reset();
+
+	if(Footprint.HasBounds() && !Footprint.IsValidFor(BakeGridSnapLength))
+		Footprint.ComputeGridData(BakeGridSnapLength);
+}
+
+#if WITH_EDITOR
+void UFurnitureMeshAsset::PreSave(const ITargetPlatform* TargetPlatform)
+{
+	Super::PreSave(TargetPlatform);
+	BakeFootprint();
+}
+
+void UFurnitureMeshAsset::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+	LayoutHash.Reset();
+
+	const FName PropertyName = PropertyChangedEvent.GetPropertyName();
+	if(PropertyName == GET_MEMBER_NAME_CHECKED(UFurnitureMeshAsset, Mesh) || PropertyName == GET_MEMBER_NAME_CHECKED(UFurnitureMeshAsset, BakeGridSnapLength))
+		BakeFootprint();
+}
+
+void UFurnitureMeshAsset::BakeFootprint()
+{
+	LayoutHash.Reset();
+	//An actor class without mesh is placed using the bounds of the class' default mesh (if it implements the interface) : nothing to bake here
+	if(IsValid(Mesh))
+		Footprint.Bake(Mesh, BakeGridSnapLength);
+	else
+		Footprint = FMeshFootprint();
+}
+#endif
+
+bool FMeshFootprint::HasBounds() const
+{
+	return BoxExtent.X > 0.f && BoxExtent.Y > 0.f;
+}
+
+bool FMeshFootprint::IsValidFor(float _GridSnapLength) const
+{
+	return HasBounds()
+		&& FMath::IsNearlyEqual(GridSnapLength, _GridSnapLength)
+		&& RotatedGridSize.Num() == 4
+		&& RotatedPivotOffset.Num() == 4;
+}
+
+void FMeshFootprint::ComputeGridData(float _GridSnapLength)
+{
+	check(_GridSnapLength > 0.f)
+	GridSnapLength = _GridSnapLength;
 
-	switch (First)
+	//Number of squares needed to contain the whole bounds (a mesh always occupies at least one square)
+	const FIntPoint Size(
+		FMath::Max(1, FMath::CeilToInt(2.f * BoxExtent.X / GridSnapLength - KINDA_SMALL_NUMBER)),
+		FMath::Max(1, FMath::CeilToInt(2.f * BoxExtent.Y / GridSnapLength - KINDA_SMALL_NUMBER))
+	);
+
+	RotatedGridSize.SetNum(4);
+	RotatedPivotOffset.SetNum(4);
+	for (int i = 0; i < 4; ++i)
 	{
-		case EGenerationAxe::X_UP:
-			if(XDown == EWallAxeInteraction::ATTRACT)
-			{
-				Second = EGenerationAxe::X_DOWN;
-				return true;
-			}
-		
-		case EGenerationAxe::X_DOWN:
-			if(YUp == EWallAxeInteraction::ATTRACT)
-			{
-				Second = EGenerationAxe::Y_UP;
-				return true;
-			}
-		
-		case EGenerationAxe::Y_UP:
-			if(YDown == EWallAxeInteraction::ATTRACT)
-			{
-				Second = EGenerationAxe::Y_DOWN;
-				return true;
-			}
-		
-		default:
-			return false;
+		//Clock-wise yaw rotation of 90° * i : (X, Y) -> (-Y, X)
+		const FVector RotatedOrigin = FRotator(0.f, 90.f * i, 0.f).RotateVector(BoundsOrigin);
+		RotatedGridSize[i] = (i % 2) ? FIntPoint(Size.Y, Size.X) : Size;
+
+		//Centers the bounds in the footprint and puts its bottom on the floor
+		RotatedPivotOffset[i] = FVector(
+			RotatedGridSize[i].X * GridSnapLength / 2.f - RotatedOrigin.X,
+			RotatedGridSize[i].Y * GridSnapLength / 2.f - RotatedOrigin.Y,
+			BoxExtent.Z - BoundsOrigin.Z
+		);
 	}
 }
 
-int UFurnitureMeshAsset::GetArea(const FFurniture& CorrespondingFurniture) const
+void FMeshFootprint::Bake(const UStaticMesh* Mesh, float _GridSnapLength)
+{
+	check(Mesh != nullptr)
+	const FBoxSphereBounds Bounds = Mesh->GetBounds();
+	BoundsOrigin = Bounds.Origin;
+	BoxExtent = Bounds.BoxExtent;
+	ComputeGridData(_GridSnapLength);
+}
+
+FVectorGrid FMeshFootprint::GetGridSize(EFurnitureRotation Rotation) const
+{
+	const int Index = static_cast<int>(Rotation);
+	if(!RotatedGridSize.IsValidIndex(Index))
+		return FVectorGrid::Zero;
+
+	return FVectorGrid(RotatedGridSize[Index].X, RotatedGridSize[Index].Y);
+}
+
+FVector FMeshFootprint::GetPivotOffset(EFurnitureRotation Rotation) const
 {
-	const FFurnitureConstraint &Constraints = bOverrideConstraint ? ConstraintsOverride : CorrespondingFurniture.DefaultConstraints;
-	return (GridSize.X + Constraints.Margin.XDown + Constraints.Margin.XUp) * (GridSize.Y + Constraints.Margin.YDown + Constraints.Margin.YUp);
+	const int Index = static_cast<int>(Rotation);
+	return RotatedPivotOffset.IsValidIndex(Index) ? RotatedPivotOffset[Index] : FVector::ZeroVector;
 }
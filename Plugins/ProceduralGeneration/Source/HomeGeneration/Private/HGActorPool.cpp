@@ -0,0 +1,110 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "HGActorPool.h"
+#include "FurnitureMeshInt.h"
+#include "Engine/StaticMeshActor.h"
+#include "Components/StaticMeshComponent.h"
+
+AActor* UHGActorPool::Acquire(UClass* ActorClass, UStaticMesh* Mesh, const FTransform& WorldTransform)
+{
+	if(ActorClass == nullptr)
+		return nullptr;
+
+	//Same class and same mesh first (no mesh update needed)
+	AActor *Actor = nullptr;
+	FHGActorPoolKey Key;
+	Key.ActorClass = ActorClass;
+	Key.Mesh = Mesh;
+	if(FHGActorPoolBucket * const Bucket = FreeActors.Find(Key))
+		Actor = PopActor(*Bucket);
+
+	//Else any actor of the same class, if its mesh can be changed
+	if(Actor == nullptr && Mesh != nullptr)
+	{
+		for(auto &Bucket : FreeActors)
+		{
+			if(Bucket.Key.ActorClass != ActorClass || Bucket.Key.Mesh == nullptr)
+				continue;
+
+			Actor = PopActor(Bucket.Value);
+			if(Actor)
+			{
+				GetMeshComponent(Actor)->SetStaticMesh(Mesh);
+				break;
+			}
+		}
+	}
+
+	if(Actor == nullptr)
+		return nullptr;
+
+	Actor->SetActorTransform(WorldTransform, false, nullptr, ETeleportType::ResetPhysics);
+	Actor->SetActorHiddenInGame(false);
+	Actor->SetActorEnableCollision(true);
+	Actor->SetActorTickEnabled(true);
+	return Actor;
+}
+
+void UHGActorPool::Release(AActor* Actor)
+{
+	if(!IsValid(Actor))
+		return;
+
+	Actor->DetachFromActor(FDetachmentTransformRules::KeepWorldTransform);
+	Actor->SetActorHiddenInGame(true);
+	Actor->SetActorEnableCollision(false);
+	Actor->SetActorTickEnabled(false);
+
+	const UStaticMeshComponent * const MeshComponent = GetMeshComponent(Actor);
+	FHGActorPoolKey Key;
+	Key.ActorClass = Actor->GetClass();
+	Key.Mesh = MeshComponent ? MeshComponent->GetStaticMesh() : nullptr;
+	FreeActors.FindOrAdd(Key).Actors.Push(Actor);
+}
+
+void UHGActorPool::Empty()
+{
+	for(auto &Bucket : FreeActors)
+		for(AActor *Actor : Bucket.Value.Actors)
+			if(IsValid(Actor))
+				Actor->Destroy();
+
+	FreeActors.Empty();
+}
+
+int32 UHGActorPool::Num() const
+{
+	int32 Count = 0;
+	for(const auto &Bucket : FreeActors)
+		Count += Bucket.Value.Actors.Num();
+	return Count;
+}
+
+UStaticMeshComponent* UHGActorPool::GetMeshComponent(AActor* Actor)
+{
+	if(AStaticMeshActor * const StaticActor = Cast<AStaticMeshActor>(Actor))
+		return StaticActor->GetStaticMeshComponent();
+	if(Actor && Actor->GetClass()->ImplementsInterface(UFurnitureMeshInt::StaticClass()))
+		return IFurnitureMeshInt::Execute_GetStaticMeshComponent(Actor);
+	return nullptr;
+}
+
+void UHGActorPool::Deinitialize()
+{
+	//The world is torn down : the actors are destroyed with it
+	FreeActors.Empty();
+	Super::Deinitialize();
+}
+
+AActor* UHGActorPool::PopActor(FHGActorPoolBucket& Bucket)
+{
+	//An actor may have been destroyed by something else while in the pool
+	while(Bucket.Actors.Num() > 0)
+	{
+		AActor * const Actor = Bucket.Actors.Pop(false);
+		if(IsValid(Actor))
+			return Actor;
+	}
+	return nullptr;
+}
@@ -0,0 +1,120 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "HGBakedBuilding.h"
+#include "Components/StaticMeshComponent.h"
+#include "Components/HierarchicalInstancedStaticMeshComponent.h"
+#include "ProceduralMeshComponent.h"
+#include "Engine/StaticMesh.h"
+#include "PhysicsEngine/BodySetup.h"
+#if WITH_EDITOR
+#include "MeshDescription.h"
+#include "StaticMeshAttributes.h"
+#endif
+
+AHGBakedBuilding::AHGBakedBuilding()
+{
+	PrimaryActorTick.bCanEverTick = false;
+
+	ShellComponent = CreateDefaultSubobject<UStaticMeshComponent>(TEXT("Shell"));
+	ShellComponent->SetMobility(EComponentMobility::Static);
+	RootComponent = ShellComponent;
+}
+
+#if WITH_EDITOR
+void AHGBakedBuilding::BakeShell(const TArray<UProceduralMeshComponent *>& Components)
+{
+	FMeshDescription MeshDescription;
+	FStaticMeshAttributes Attributes(MeshDescription);
+	Attributes.Register();
+
+	TVertexAttributesRef<FVector> Positions = Attributes.GetVertexPositions();
+	TVertexInstanceAttributesRef<FVector> Normals = Attributes.GetVertexInstanceNormals();
+	TVertexInstanceAttributesRef<FVector> Tangents = Attributes.GetVertexInstanceTangents();
+	TVertexInstanceAttributesRef<float> BinormalSigns = Attributes.GetVertexInstanceBinormalSigns();
+	TVertexInstanceAttributesRef<FVector4> Colors = Attributes.GetVertexInstanceColors();
+	TVertexInstanceAttributesRef<FVector2D> UVs = Attributes.GetVertexInstanceUVs();
+	TPolygonGroupAttributesRef<FName> SlotNames = Attributes.GetPolygonGroupMaterialSlotNames();
+
+	//One polygon group and one material slot per section
+	TArray<FStaticMaterial> Materials;
+	for(UProceduralMeshComponent *Component : Components)
+	{
+		for(int32 SectionIndex = 0; SectionIndex < Component->GetNumSections(); ++SectionIndex)
+		{
+			const FProcMeshSection * const Section = Component->GetProcMeshSection(SectionIndex);
+			if(Section == nullptr || Section->ProcIndexBuffer.Num() == 0)
+				continue;
+
+			const FName SlotName(*FString::Printf(TEXT("Section%d"), Materials.Num()));
+			const FPolygonGroupID PolygonGroup = MeshDescription.CreatePolygonGroup();
+			SlotNames[PolygonGroup] = SlotName;
+			Materials.Emplace(Component->GetMaterial(SectionIndex), SlotName);
+
+			TArray<FVertexInstanceID> VertexInstances;
+			VertexInstances.Reserve(Section->ProcVertexBuffer.Num());
+			for(const FProcMeshVertex &Vertex : Section->ProcVertexBuffer)
+			{
+				const FVertexID VertexID = MeshDescription.CreateVertex();
+				Positions[VertexID] = Vertex.Position;
+
+				const FVertexInstanceID VertexInstance = MeshDescription.CreateVertexInstance(VertexID);
+				Normals[VertexInstance] = Vertex.Normal;
+				Tangents[VertexInstance] = Vertex.Tangent.TangentX;
+				BinormalSigns[VertexInstance] = Vertex.Tangent.bFlipTangentY ? -1.f : 1.f;
+				Colors[VertexInstance] = FVector4(FLinearColor(Vertex.Color));
+				UVs.Set(VertexInstance, 0, Vertex.UV0);
+				VertexInstances.Push(VertexInstance);
+			}
+
+			for(int32 Index = 0; Index + 2 < Section->ProcIndexBuffer.Num(); Index += 3)
+			{
+				const TArray<FVertexInstanceID> Triangle = {VertexInstances[Section->ProcIndexBuffer[Index]], VertexInstances[Section->ProcIndexBuffer[Index + 1]], VertexInstances[Section->ProcIndexBuffer[Index + 2]]};
+				MeshDescription.CreatePolygon(PolygonGroup, Triangle);
+			}
+		}
+	}
+
+	//Saved with the level, inside this actor
+	UStaticMesh * const ShellMesh = NewObject<UStaticMesh>(this, TEXT("BakedShell"));
+	ShellMesh->StaticMaterials = Materials;
+
+	//Normals and tangents are the ones of the generation
+	FStaticMeshSourceModel &SourceModel = ShellMesh->AddSourceModel();
+	SourceModel.BuildSettings.bRecomputeNormals = false;
+	SourceModel.BuildSettings.bRecomputeTangents = false;
+	ShellMesh->CreateMeshDescription(0, MoveTemp(MeshDescription));
+	ShellMesh->CommitMeshDescription(0);
+
+	//The walls collide as the procedural shell did
+	ShellMesh->CreateBodySetup();
+	ShellMesh->BodySetup->CollisionTraceFlag = CTF_UseComplexAsSimple;
+	ShellMesh->Build(true);
+	ShellMesh->PostEditChange();
+
+	ShellComponent->SetStaticMesh(ShellMesh);
+}
+
+void AHGBakedBuilding::AddInstances(UStaticMesh* Mesh, const TArray<FTransform>& Transforms)
+{
+	if(!IsValid(Mesh) || Transforms.Num() == 0)
+		return;
+
+	UHierarchicalInstancedStaticMeshComponent **Found = InstanceComponents.FindByPredicate([Mesh] (const UHierarchicalInstancedStaticMeshComponent *Component)
+	{
+		return Component->GetStaticMesh() == Mesh;
+	});
+	UHierarchicalInstancedStaticMeshComponent *Component = Found ? *Found : nullptr;
+	if(Component == nullptr)
+	{
+		Component = NewObject<UHierarchicalInstancedStaticMeshComponent>(this);
+		Component->SetMobility(EComponentMobility::Static);
+		Component->SetStaticMesh(Mesh);
+		Component->SetupAttachment(RootComponent);
+		Component->RegisterComponent();
+		AddInstanceComponent(Component);
+		InstanceComponents.Push(Component);
+	}
+	Component->AddInstances(Transforms, false);
+}
+#endif
@@ -0,0 +1,416 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "HGBuildingLayout.h"
+#include "HomeGeneration.h"
+#include "HGGenerationResult.h"
+#include "HGLayoutCache.h"
+#include "HGLayoutFile.h"
+#include "HGMeshBuilder.h"
+
+int32 FHGBuildingLayout::AddCatalogMesh(UFurnitureMeshAsset* MeshAsset)
+{
+	check(IsInGameThread());
+	check(MeshAsset != nullptr)
+	if(const int32 * const Id = MeshCatalogIds.Find(MeshAsset))
+		return *Id;
+
+	//The grid data is computed for this generation : the asset is shared by generators using other grid snap lengths
+	const int32 MeshId = MeshCatalog.Add(MeshAsset);
+	MeshCatalogIds.Add(MeshAsset, MeshId);
+	FMeshFootprint &Footprint = CatalogFootprints[CatalogFootprints.AddDefaulted()];
+	MeshAsset->ValidateFootprint(BuildingConstraints.GridSnapLength, Footprint);
+	FHGCatalogMesh &CatalogMesh = CatalogMeshes[CatalogMeshes.AddDefaulted()];
+	CatalogMesh.Descriptor = MeshAsset->MakeDescriptor(MeshId, Footprint);
+	CatalogMesh.Path = MeshAsset->GetPathName();
+	CatalogMesh.bPlaceable = IsValid(MeshAsset->ActorClass) || IsValid(MeshAsset->Mesh);
+	return MeshId;
+}
+
+int32 FHGBuildingLayout::AddCatalogWindow(UWindowMeshAsset* WindowAsset, const FWindowConstraint& DefaultConstraints)
+{
+	check(IsInGameThread());
+	if(WindowAsset == nullptr)
+		return INDEX_NONE;
+	if(const int32 * const Id = WindowCatalogIds.Find(WindowAsset))
+		return *Id;
+
+	const int32 WindowId = WindowCatalog.Add(WindowAsset);
+	WindowCatalogIds.Add(WindowAsset, WindowId);
+	FMeshFootprint &Footprint = WindowFootprints[WindowFootprints.AddDefaulted()];
+	FVectorGrid GridSize;
+	WindowAsset->ValidateFootprint(BuildingConstraints.GridSnapLength, DefaultConstraints, Footprint, GridSize);
+	FHGCatalogWindow &CatalogWindow = CatalogWindows[CatalogWindows.AddDefaulted()];
+	CatalogWindow.Descriptor = WindowAsset->MakeDescriptor(DefaultConstraints, Footprint, GridSize);
+	CatalogWindow.Path = WindowAsset->GetPathName();
+	return WindowId;
+}
+
+FHGFurnitureDescriptor FHGBuildingLayout::AddCatalogFurniture(const FFurniture& _Furniture)
+{
+	//Same order as the generator's meshes : the placement shuffles them
+	FHGFurnitureDescriptor Descriptor;
+	Descriptor.Meshes.Reserve(_Furniture.Mesh.Num());
+	for(UFurnitureMeshAsset *MeshObj : _Furniture.Mesh)
+		Descriptor.Meshes.Push(MeshObj ? AddCatalogMesh(MeshObj) : INDEX_NONE);
+	Descriptor.DefaultConstraints = _Furniture.DefaultConstraints.ToCore();
+	Descriptor.Dependencies.Reserve(_Furniture.Dependencies.Num());
+	for(const FFurnitureDependency &Dependency : _Furniture.Dependencies)
+		Descriptor.Dependencies.Add(Dependency.ToCore());
+	return Descriptor;
+}
+
+FHGWindowsDescriptor FHGBuildingLayout::AddCatalogWindows(const FWindow& _Windows)
+{
+	FHGWindowsDescriptor Descriptor;
+	Descriptor.Meshes.Reserve(_Windows.Mesh.Num());
+	for(UWindowMeshAsset *MeshObj : _Windows.Mesh)
+		Descriptor.Meshes.Push(AddCatalogWindow(MeshObj, _Windows.DefaultConstraints));
+	Descriptor.Spacing = _Windows.Spacing;
+	return Descriptor;
+}
+
+int32 FHGBuildingLayout::GetMeshCatalogId(const UFurnitureMeshAsset* MeshAsset) const
+{
+	const int32 * const Id = MeshCatalogIds.Find(MeshAsset);
+	return Id ? *Id : INDEX_NONE;
+}
+
+void FHGBuildingLayout::ComputeGeneration(FHomeGenerationResult& Result)
+{
+	QUICK_SCOPE_CYCLE_COUNTER(STAT_HomeGenerator_ComputeGeneration);
+
+	ComputeLayout(Result.SpawnBuffer);
+	if(bCancelGeneration)
+		return;
+
+	//Doors and windows are needed to open the walls
+	BuildShell(Result);
+	DecorateRooms(Result);
+}
+
+void FHGBuildingLayout::ComputeCachedGeneration(FHomeGenerationResult& Result)
+{
+	if(LayoutCacheKey.IsEmpty())
+	{
+		ComputeGeneration(Result);
+		return;
+	}
+
+	//Computed by a previous generation, of this session or of another one
+	if(ReadCachedLayout(Result))
+	{
+		BuildShell(Result);
+		DecorateRooms(Result);
+		return;
+	}
+
+	ComputeGeneration(Result);
+	if(!bCancelGeneration)
+		WriteCachedLayout(Result);
+}
+
+bool FHGBuildingLayout::ReadCachedLayout(FHomeGenerationResult& Result)
+{
+	QUICK_SCOPE_CYCLE_COUNTER(STAT_HomeGenerator_ReadCachedLayout);
+
+	FHGLayoutFile File;
+	if(!HGLayoutCache::Read(LayoutCacheKey, File))
+		return false;
+
+	if(!ReadLayout(File.GetView(), Result.SpawnBuffer))
+	{
+		UE_LOG(LogHomeGeneration, Warning, TEXT("The cached layout %s doesn't match the generator %s."), *LayoutCacheKey, *GeneratorName);
+		Reset();
+		Result.SpawnBuffer.Empty();
+		return false;
+	}
+
+	//Doors are already placed
+	PlaceWindows();
+	Result.bCached = true;
+	return true;
+}
+
+void FHGBuildingLayout::WriteCachedLayout(FHomeGenerationResult& Result) const
+{
+	QUICK_SCOPE_CYCLE_COUNTER(STAT_HomeGenerator_WriteCachedLayout);
+
+	//The streaming mode isn't in the cache key : its rooms aren't recorded yet, but the file is shared with the other mode
+	TArray<uint8> Bytes;
+	if(bStreamFurniture)
+	{
+		FFurnitureSpawnBuffer SpawnBuffer;
+		RecordFurniture(SpawnBuffer);
+		WriteLayout(SpawnBuffer, Bytes);
+	}
+	else
+		WriteLayout(Result.SpawnBuffer, Bytes);
+	HGLayoutCache::Write(LayoutCacheKey, Bytes, static_cast<int64>(LayoutCacheMaxSize * 1024.f * 1024.f));
+	Result.bCached = true;
+}
+
+void FHGBuildingLayout::BuildShell(FHomeGenerationResult &Result) const
+{
+	QUICK_SCOPE_CYCLE_COUNTER(STAT_HomeGenerator_BuildShell);
+	check(RoomBlocks.Num() == BuildingConstraints.Levels && HallBlocks.Num() == BuildingConstraints.Levels)
+
+	//Two sections per level and the roof
+	Result.ShellSections.SetNum(2 * (BuildingConstraints.Levels + 1));
+	for(int Level = 0; Level <= BuildingConstraints.Levels; ++Level)
+		BuildShellLevel(Level, Result);
+}
+
+void FHGBuildingLayout::BuildShellLevel(int Level, FHomeGenerationResult& Result) const
+{
+	check(Result.ShellSections.Num() == 2 * (BuildingConstraints.Levels + 1))
+
+	if(Level < BuildingConstraints.Levels)
+		BuildLevelWalls(Level, Result.ShellSections[2 * Level]);
+	BuildLevelSlab(Level, Result.ShellSections[2 * Level + 1]);
+}
+
+namespace
+{
+	//States of the cells of the shell grids
+	enum EShellCell : uint8 { SHELL_EMPTY, SHELL_WALL, SHELL_LINTEL, SHELL_WINDOW, SHELL_SLAB };
+
+	FBox2D MakeRect(const FVector2D &Offset, const FVector2D &Size)
+	{
+		return FBox2D(Offset, Offset + Size);
+	}
+}
+
+void FHGBuildingLayout::BuildLevelWalls(int Level, FHGMeshSection& Walls) const
+{
+	const float Wall = BuildingConstraints.WallWidth;
+	const TIndirectArray<FRoomBlock> &Rooms = RoomBlocks[Level];
+	const TIndirectArray<FHallBlock> &Halls = HallBlocks[Level];
+
+	TArray<FBox2D> DoorOpenings, WindowOpenings;
+	ComputeOpenings(Level, DoorOpenings, WindowOpenings);
+
+	//Edges of every rect
+	const FBox2D LevelRect = ComputeLevelRect(Level);
+	if(!LevelRect.bIsValid)
+		return;
+
+	FHGRectGrid Grid;
+	for(const FRoomBlock &Room : Rooms)
+	{
+		Grid.AddEdges(MakeRect(Room.GetRealOffset(), Room.GetRealSize()));
+		Grid.AddEdges(ComputeRoomInterior(Room));
+	}
+	for(const FHallBlock &Hall : Halls)
+		Grid.AddEdges(MakeRect(Hall.GetRealOffset(), Hall.GetRealSize()));
+
+	const FBox2D InnerLevelRect(LevelRect.Min + FVector2D(Wall, Wall), LevelRect.Max - FVector2D(Wall, Wall));
+	Grid.AddEdges(LevelRect);
+	Grid.AddEdges(InnerLevelRect);
+	for(const FBox2D &Opening : DoorOpenings)
+		Grid.AddEdges(Opening);
+	for(const FBox2D &Opening : WindowOpenings)
+		Grid.AddEdges(Opening);
+	Grid.Build();
+
+	//Painted by priority : the space which is neither a room nor a hall is filled, room walls are always kept and only the doors open them
+	Grid.Paint(LevelRect, SHELL_WALL);
+	for(const FHallBlock &Hall : Halls)
+		Grid.Paint(MakeRect(Hall.GetRealOffset(), Hall.GetRealSize()), SHELL_EMPTY);
+	for(const FRoomBlock &Room : Rooms)
+		Grid.Paint(MakeRect(Room.GetRealOffset(), Room.GetRealSize()), SHELL_WALL);
+	for(const FRoomBlock &Room : Rooms)
+		Grid.Paint(ComputeRoomInterior(Room), SHELL_EMPTY);
+
+	//Exterior walls
+	Grid.Paint(FBox2D(LevelRect.Min, FVector2D(LevelRect.Max.X, InnerLevelRect.Min.Y)), SHELL_WALL);
+	Grid.Paint(FBox2D(FVector2D(LevelRect.Min.X, InnerLevelRect.Max.Y), LevelRect.Max), SHELL_WALL);
+	Grid.Paint(FBox2D(LevelRect.Min, FVector2D(InnerLevelRect.Min.X, LevelRect.Max.Y)), SHELL_WALL);
+	Grid.Paint(FBox2D(FVector2D(InnerLevelRect.Max.X, LevelRect.Min.Y), LevelRect.Max), SHELL_WALL);
+
+	for(const FBox2D &Opening : DoorOpenings)
+		Grid.Paint(Opening, SHELL_LINTEL, SHELL_WALL);
+	for(const FBox2D &Opening : WindowOpenings)
+		Grid.Paint(Opening, SHELL_WINDOW, SHELL_WALL);
+
+	//Merged walls
+	const float FloorZ = Level * (BuildingConstraints.FloorHeight + BuildingConstraints.FloorWidth);
+	const float DoorHeight = ComputeDoorHeight();
+	TArray<TPair<FBox2D, uint8>> WallRects;
+	Grid.MergeCells(WallRects);
+	for(const auto &WallRect : WallRects)
+	{
+		//Under the window
+		if(WallRect.Value == SHELL_WINDOW && WindowBottom > 0.f)
+			Walls.AddBox(FBox(FVector(WallRect.Key.Min, FloorZ), FVector(WallRect.Key.Max, FloorZ + WindowBottom)), ShellUVLength);
+
+		const float BottomZ = FloorZ + (WallRect.Value == SHELL_LINTEL ? DoorHeight : WallRect.Value == SHELL_WINDOW ? WindowTop : 0.f);
+		if(BottomZ >= FloorZ + BuildingConstraints.FloorHeight)
+			continue;
+
+		Walls.AddBox(FBox(FVector(WallRect.Key.Min, BottomZ), FVector(WallRect.Key.Max, FloorZ + BuildingConstraints.FloorHeight)), ShellUVLength);
+	}
+}
+
+void FHGBuildingLayout::BuildLevelSlab(int Level, FHGMeshSection& Slab) const
+{
+	//The slab covers the level under it (or the first level), and the stairs hall of the level over it is open
+	const int CoveredLevel = FMath::Min(Level, BuildingConstraints.Levels - 1);
+	if(!RoomBlocks.IsValidIndex(CoveredLevel))
+		return;
+
+	const FBox2D LevelRect = ComputeLevelRect(CoveredLevel);
+	if(!LevelRect.bIsValid)
+		return;
+
+	FHGRectGrid Grid;
+	Grid.AddEdges(LevelRect);
+	const FHallBlock *StairsHall = nullptr;
+	if(Level > 0 && Level < BuildingConstraints.Levels)
+	{
+		for(const FHallBlock &Hall : HallBlocks[Level])
+			if(Hall.StairsHall)
+				StairsHall = &Hall;
+	}
+	if(StairsHall)
+		Grid.AddEdges(MakeRect(StairsHall->GetRealOffset(), StairsHall->GetRealSize()));
+	Grid.Build();
+
+	Grid.Paint(LevelRect, SHELL_SLAB);
+	if(StairsHall)
+		Grid.Paint(MakeRect(StairsHall->GetRealOffset(), StairsHall->GetRealSize()), SHELL_EMPTY);
+
+	//The slab is under the floor of the level
+	const float FloorZ = Level * (BuildingConstraints.FloorHeight + BuildingConstraints.FloorWidth);
+	TArray<TPair<FBox2D, uint8>> SlabRects;
+	Grid.MergeCells(SlabRects);
+	for(const auto &SlabRect : SlabRects)
+		Slab.AddBox(FBox(FVector(SlabRect.Key.Min, FloorZ - BuildingConstraints.FloorWidth), FVector(SlabRect.Key.Max, FloorZ)), ShellUVLength);
+}
+
+void FHGBuildingLayout::DecorateRooms(FHomeGenerationResult &Result) const
+{
+	QUICK_SCOPE_CYCLE_COUNTER(STAT_HomeGenerator_DecorateRooms);
+	check(RoomBlocks.Num() == BuildingConstraints.Levels)
+
+	//One batch per decoration class, room type and surface
+	TMap<TPair<UClass *, FName>, int32> FirstBatches;
+	for(int Level = 0; Level < BuildingConstraints.Levels; ++Level)
+	{
+		TArray<FBox2D> DoorOpenings, WindowOpenings;
+		ComputeOpenings(Level, DoorOpenings, WindowOpenings);
+
+		for(const FRoomBlock &RoomBlock : RoomBlocks[Level])
+		{
+			const TSubclassOf<UDecoBase> * const DecorationClass = RoomDecorations.Find(RoomBlock.RoomType);
+			if(!DecorationClass || !*DecorationClass)
+				continue;
+
+			const TPair<UClass *, FName> Key(DecorationClass->Get(), RoomBlock.RoomType);
+			int32 *FirstBatch = FirstBatches.Find(Key);
+			if(!FirstBatch)
+			{
+				FirstBatch = &FirstBatches.Add(Key, Result.DecorationBatches.Num());
+				for(const EDecorationSurface Surface : {EDecorationSurface::Floor, EDecorationSurface::Wall, EDecorationSurface::Ceiling})
+				{
+					FHGDecorationBatch &Batch = Result.DecorationBatches.AddDefaulted_GetRef();
+					Batch.DecorationClass = *DecorationClass;
+					Batch.RoomType = RoomBlock.RoomType;
+					Batch.Surface = Surface;
+				}
+			}
+
+			FHGDecorationBatch *Batches = &Result.DecorationBatches[*FirstBatch];
+			const int32 RoomSeed = GetRandomStream(EHGRandomDomain::Decoration, Level, RoomBlock.Index).GetInitialSeed();
+			for(int32 i = 0; i < 3; ++i)
+				Batches[i].RoomVertices.Push(TPair<int32, int32>(RoomSeed, Batches[i].Geometry.Vertices.Num()));
+			BuildRoomDecoration(Level, RoomBlock, DoorOpenings, WindowOpenings, Batches[0].Geometry, Batches[1].Geometry, Batches[2].Geometry);
+		}
+	}
+}
+
+void FHGBuildingLayout::BuildRoomDecoration(int Level, const FRoomBlock& RoomBlock, const TArray<FBox2D>& Openings, const TArray<FBox2D>& WindowOpenings, FHGMeshSection& Floor, FHGMeshSection& Walls, FHGMeshSection& Ceiling) const
+{
+	const float Inset = DecorationInset;
+	const float Height = BuildingConstraints.FloorHeight;
+	const float FloorZ = Level * (BuildingConstraints.FloorHeight + BuildingConstraints.FloorWidth);
+	const float DoorHeight = ComputeDoorHeight();
+	const FBox2D Interior = ComputeRoomInterior(RoomBlock);
+	const FBox2D Lining(Interior.Min + FVector2D(Inset, Inset), Interior.Max - FVector2D(Inset, Inset));
+	const FVector2D Size = Lining.GetSize();
+	if(Size.X <= 0.f || Size.Y <= 0.f)
+		return;
+
+	Floor.AddQuad(FVector(Lining.Min, FloorZ + Inset), FVector(Size.X, 0.f, 0.f), FVector(0.f, Size.Y, 0.f), FVector::UpVector, ShellUVLength);
+	Ceiling.AddQuad(FVector(Lining.Min.X, Lining.Max.Y, FloorZ + Height - Inset), FVector(Size.X, 0.f, 0.f), FVector(0.f, -Size.Y, 0.f), FVector::DownVector, ShellUVLength);
+
+	//Each side seen from inside the room : start corner, direction along the wall and coordinate of the wall (X for the X sides, Y otherwise)
+	struct FSide { FVector2D Start; FVector2D Direction; FVector Normal; bool bAlongY; float WallCoordinate; };
+	const FSide Sides[] = {
+		{FVector2D(Lining.Max.X, Lining.Max.Y), FVector2D(0.f, -1.f), FVector::BackwardVector, true, Interior.Max.X},
+		{FVector2D(Lining.Min.X, Lining.Min.Y), FVector2D(0.f, 1.f), FVector::ForwardVector, true, Interior.Min.X},
+		{FVector2D(Lining.Min.X, Lining.Max.Y), FVector2D(1.f, 0.f), FVector::LeftVector, false, Interior.Max.Y},
+		{FVector2D(Lining.Max.X, Lining.Min.Y), FVector2D(-1.f, 0.f), FVector::RightVector, false, Interior.Min.Y}
+	};
+
+	for(const FSide &Side : Sides)
+	{
+		const float Length = Side.bAlongY ? Size.Y : Size.X;
+
+		//Holes along the side : position range and height range (the openings touching the wall, the ones of the neighbour rooms included)
+		TArray<TPair<FVector2D, FVector2D>> Holes;
+		const auto AddHoles = [&] (const TArray<FBox2D> &Rects, float Bottom, float Top)
+		{
+			for(const FBox2D &Rect : Rects)
+			{
+				const float RectMin = Side.bAlongY ? Rect.Min.X : Rect.Min.Y;
+				const float RectMax = Side.bAlongY ? Rect.Max.X : Rect.Max.Y;
+				if(RectMin > Side.WallCoordinate + 0.1f || RectMax < Side.WallCoordinate - 0.1f)
+					continue;
+
+				const float A = FVector2D::DotProduct(Rect.Min - Side.Start, Side.Direction);
+				const float B = FVector2D::DotProduct(Rect.Max - Side.Start, Side.Direction);
+				const FVector2D Range(FMath::Clamp(FMath::Min(A, B), 0.f, Length), FMath::Clamp(FMath::Max(A, B), 0.f, Length));
+				if(Range.Y - Range.X > KINDA_SMALL_NUMBER)
+					Holes.Push(TPair<FVector2D, FVector2D>(Range, FVector2D(Bottom, Top)));
+			}
+		};
+		AddHoles(Openings, 0.f, DoorHeight);
+		AddHoles(WindowOpenings, WindowBottom, WindowTop);
+
+		//Cut the side where the holes start and end, then fill every piece around the holes crossing it
+		TArray<float> Cuts = {0.f, Length};
+		for(const auto &Hole : Holes)
+		{
+			Cuts.Push(Hole.Key.X);
+			Cuts.Push(Hole.Key.Y);
+		}
+		Cuts.Sort();
+
+		for(int32 i = 0; i + 1 < Cuts.Num(); ++i)
+		{
+			const float PieceStart = Cuts[i];
+			const float PieceLength = Cuts[i + 1] - PieceStart;
+			if(PieceLength <= KINDA_SMALL_NUMBER)
+				continue;
+
+			TArray<FVector2D> PieceHoles;
+			for(const auto &Hole : Holes)
+				if(Hole.Key.X <= PieceStart + KINDA_SMALL_NUMBER && Hole.Key.Y >= Cuts[i + 1] - KINDA_SMALL_NUMBER)
+					PieceHoles.Push(Hole.Value);
+			PieceHoles.Sort([] (const FVector2D &A, const FVector2D &B) { return A.X < B.X; });
+
+			const FVector2D PieceOrigin = Side.Start + Side.Direction * PieceStart;
+			const FVector Right = FVector(Side.Direction * PieceLength, 0.f);
+			float Bottom = Inset;
+			for(const FVector2D &Hole : PieceHoles)
+			{
+				if(Hole.X > Bottom)
+					Walls.AddQuad(FVector(PieceOrigin, FloorZ + Bottom), Right, FVector(0.f, 0.f, Hole.X - Bottom), Side.Normal, ShellUVLength);
+				Bottom = FMath::Max(Bottom, Hole.Y);
+			}
+			if(Height - Inset > Bottom)
+				Walls.AddQuad(FVector(PieceOrigin, FloorZ + Bottom), Right, FVector(0.f, 0.f, Height - Inset - Bottom), Side.Normal, ShellUVLength);
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,100 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HomeGenerator.h"
+#include "HGBuildingPlan.h"
+
+struct FHomeGenerationResult;
+struct FHGMeshSection;
+
+/**
+ * Layout of one generation, with the assets it has been prepared from (see AHomeGenerator::PrepareGeneration).
+ * The layout itself is computed by the core module (see FHGBuildingPlan) : this class only snapshots the assets on the game thread, caches the layouts and builds the geometry of the shell and the decoration.
+ * Computed on any thread, then only used by the game thread once the generator has spawned it (see FHomeGenerationResult::Layout).
+ */
+class FHGBuildingLayout : public FHGBuildingPlan
+{
+public:
+	float ShellUVLength = 100.f;
+	float DecorationInset = 1.f;
+
+	//Key of the generation in the layout cache (empty if the cache isn't used)
+	FString LayoutCacheKey;
+	float LayoutCacheMaxSize = 256.f;
+
+	//Decoration class of each room type (see FRoom::DecorationClass)
+	TMap<FName, TSubclassOf<UDecoBase>> RoomDecorations;
+
+	///______________________
+	///Assets snapshot (game thread)
+	///
+
+	//All the furniture meshes of the catalog, same index as CatalogMeshes
+	//The pointers are only used as keys out of the game thread
+	TArray<UFurnitureMeshAsset *> MeshCatalog;
+	TMap<const UFurnitureMeshAsset *, int32> MeshCatalogIds;
+
+	//Grid data computed for the grid snap length of the generator (the asset may be baked for another one), same index as MeshCatalog
+	TArray<FMeshFootprint> CatalogFootprints;
+
+	//All the window meshes, same index as CatalogWindows
+	TArray<UWindowMeshAsset *> WindowCatalog;
+	TMap<const UWindowMeshAsset *, int32> WindowCatalogIds;
+	TArray<FMeshFootprint> WindowFootprints;
+
+	//Adds the mesh to the catalog if needed and returns its id
+	int32 AddCatalogMesh(UFurnitureMeshAsset *MeshAsset);
+
+	//Adds the window mesh if needed and returns its id (INDEX_NONE for a missing asset)
+	int32 AddCatalogWindow(UWindowMeshAsset *WindowAsset, const FWindowConstraint &DefaultConstraints);
+
+	//Adds the meshes of the furniture and returns its descriptor
+	FHGFurnitureDescriptor AddCatalogFurniture(const FFurniture &_Furniture);
+
+	//Adds the meshes of the windows and returns their descriptor
+	FHGWindowsDescriptor AddCatalogWindows(const FWindow &_Windows);
+
+	//Returns the id of the given mesh in the catalog (INDEX_NONE if not found)
+	int32 GetMeshCatalogId(const UFurnitureMeshAsset *MeshAsset) const;
+
+	///______________________
+	///Generation pipeline
+	///
+
+	//Layout of the building and furniture placement, then geometry of the shell and the decoration (any thread)
+	void ComputeGeneration(FHomeGenerationResult &Result);
+
+	//Computes the layout, or reads it from the disk cache (any thread)
+	void ComputeCachedGeneration(FHomeGenerationResult &Result);
+
+	//Reads the blocks and the furniture of the cached layout and places the windows. Returns false if it isn't cached.
+	bool ReadCachedLayout(FHomeGenerationResult &Result);
+
+	//Stores the computed layout in the cache (with all its furniture, whatever the streaming mode)
+	void WriteCachedLayout(FHomeGenerationResult &Result) const;
+
+	///______________________
+	///Geometry
+	///
+
+	//Generates the walls, floors and ceilings of all levels as merged geometry : two sections per level (walls and floor slab) and one for the roof.
+	//Walls are the maximal rectangles left by the rooms and halls, with openings above the doors, and the slabs the maximal rectangles of each level (without the stairs hall above the first level).
+	void BuildShell(FHomeGenerationResult &Result) const;
+
+	//Builds the walls and slab sections of one level (Levels for the roof)
+	void BuildShellLevel(int Level, FHomeGenerationResult &Result) const;
+
+	//Fills the section with the walls of the given level (relative to the generator)
+	void BuildLevelWalls(int Level, FHGMeshSection &Walls) const;
+
+	//Fills the section with the slab under the given level (Levels for the roof)
+	void BuildLevelSlab(int Level, FHGMeshSection &Slab) const;
+
+	//Lines the floor, walls and ceiling of the rooms which have a decoration class : one batch per decoration class, room type and surface.
+	void DecorateRooms(FHomeGenerationResult &Result) const;
+
+	//Adds the floor, walls (around the openings) and ceiling of a room in the given sections
+	void BuildRoomDecoration(int Level, const FRoomBlock &RoomBlock, const TArray<FBox2D> &Openings, const TArray<FBox2D> &WindowOpenings, FHGMeshSection &Floor, FHGMeshSection &Walls, FHGMeshSection &Ceiling) const;
+};
\ No newline at end of file
@@ -0,0 +1,42 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "HGDecorationCache.h"
+
+const FRoomDecoration& UHGDecorationCache::GetDecoration(TSubclassOf<UDecoBase> DecorationClass, const FName& RoomType)
+{
+	check(DecorationClass);
+
+	FHGDecorationKey Key;
+	Key.DecorationClass = DecorationClass.Get();
+	Key.RoomType = RoomType;
+	if(const FRoomDecoration *Decoration = Materials.Find(Key))
+		return *Decoration;
+
+	return Materials.Add(Key, GetDecorationObject(DecorationClass)->CreateDecoration(RoomType));
+}
+
+UDecoBase* UHGDecorationCache::GetDecorationObject(TSubclassOf<UDecoBase> DecorationClass)
+{
+	check(DecorationClass);
+
+	UDecoBase *&Decoration = Decorations.FindOrAdd(DecorationClass.Get());
+	if(!Decoration)
+		Decoration = NewObject<UDecoBase>(this, DecorationClass);
+	return Decoration;
+}
+
+int32 UHGDecorationCache::NumMaterials() const
+{
+	int32 Num = 0;
+	for(const auto &Decoration : Materials)
+		Num += (Decoration.Value.Floor != nullptr) + (Decoration.Value.Wall != nullptr) + (Decoration.Value.Ceiling != nullptr);
+	return Num;
+}
+
+void UHGDecorationCache::Deinitialize()
+{
+	Materials.Empty();
+	Decorations.Empty();
+	Super::Deinitialize();
+}
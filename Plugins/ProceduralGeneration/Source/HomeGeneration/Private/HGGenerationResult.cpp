@@ -0,0 +1,29 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "HGGenerationResult.h"
+#include "HGBuildingLayout.h"
+
+SIZE_T FHomeGenerationResult::GetAllocatedSize() const
+{
+	SIZE_T Size = ShellSections.GetAllocatedSize() + DecorationBatches.GetAllocatedSize() + SpawnBuffer.Commands.GetAllocatedSize();
+	for(const FHGMeshSection &Section : ShellSections)
+		Size += Section.GetAllocatedSize();
+	for(const FHGDecorationBatch &Batch : DecorationBatches)
+		Size += Batch.Geometry.GetAllocatedSize() + Batch.RoomVertices.GetAllocatedSize();
+	if(Layout.IsValid())
+		Size += Layout->GetAllocatedSize();
+	return Size;
+}
+
+void FHomeGenerationResult::Shrink()
+{
+	for(FHGMeshSection &Section : ShellSections)
+		Section.Shrink();
+	for(FHGDecorationBatch &Batch : DecorationBatches)
+	{
+		Batch.Geometry.Shrink();
+		Batch.RoomVertices.Shrink();
+	}
+	SpawnBuffer.Commands.Shrink();
+}
@@ -0,0 +1,53 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "DecoBase.h"
+#include "HGBuildingPlan.h"
+#include "HGMeshBuilder.h"
+
+class FHGBuildingLayout;
+
+/**
+ * Geometry of one decoration surface for all the rooms of the same type (built without the materials and the variations, which need the game thread).
+ */
+struct FHGDecorationBatch
+{
+	TSubclassOf<UDecoBase> DecorationClass;
+	FName RoomType;
+	EDecorationSurface Surface = EDecorationSurface::Floor;
+	FHGMeshSection Geometry;
+
+	//Seed of each room and its first vertex (the vertices of a room are contiguous, up to the first vertex of the next one)
+	TArray<TPair<int32, int32>> RoomVertices;
+};
+
+/**
+ * Everything computed out of the game thread by a generation and applied at the end on the game thread.
+ */
+struct FHomeGenerationResult
+{
+	//Parameters of the generation and computed blocks : the computation only writes in the result (see AHomeGenerator::PrepareGeneration)
+	TSharedPtr<FHGBuildingLayout, ESPMode::ThreadSafe> Layout;
+
+	//Division of the levels : only valid during the rooms step of a time sliced generation
+	FHGDivisionState Division;
+
+	//Sections of the shell : walls (2 * Level) and slab (2 * Level + 1) of each level, and the roof
+	TArray<FHGMeshSection> ShellSections;
+
+	TArray<FHGDecorationBatch> DecorationBatches;
+
+	//Furniture of all the rooms (empty in streaming mode)
+	FFurnitureSpawnBuffer SpawnBuffer;
+
+	//The layout is in the disk cache (read from it, or already written)
+	bool bCached = false;
+
+	//Memory used by the geometry, the furniture and the blocks of the layout
+	SIZE_T GetAllocatedSize() const;
+
+	//Frees the slack of all the arrays (results kept for a long time)
+	void Shrink();
+};
@@ -0,0 +1,196 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "HGGenerationScheduler.h"
+#include "HomeGenerator.h"
+#include "HGLayoutPool.h"
+#include "GameFramework/PlayerController.h"
+#include "Camera/PlayerCameraManager.h"
+
+void UHGGenerationScheduler::RequestGeneration(AHomeGenerator* Generator)
+{
+	if(!IsValid(Generator) || IsQueued(Generator))
+		return;
+
+	FHGGenerationRequest Request;
+	Request.Generator = Generator;
+	Requests.Push(Request);
+}
+
+void UHGGenerationScheduler::CancelGeneration(AHomeGenerator* Generator)
+{
+	const int32 Index = Requests.IndexOfByPredicate([Generator] (const FHGGenerationRequest &Request) { return Request.Generator.Get() == Generator; });
+	if(Index == INDEX_NONE)
+		return;
+
+	if(Requests[Index].bRunning && IsValid(Generator))
+		Generator->CancelGeneration();
+	Requests.RemoveAt(Index);
+}
+
+bool UHGGenerationScheduler::IsQueued(const AHomeGenerator* Generator) const
+{
+	return Requests.ContainsByPredicate([Generator] (const FHGGenerationRequest &Request) { return Request.Generator.Get() == Generator; });
+}
+
+int32 UHGGenerationScheduler::NumRequests() const
+{
+	return Requests.Num();
+}
+
+void UHGGenerationScheduler::Deinitialize()
+{
+	for(const FHGGenerationRequest &Request : Requests)
+		if(Request.bRunning && Request.Generator.IsValid())
+			Request.Generator->CancelGeneration();
+	Requests.Empty();
+
+	Super::Deinitialize();
+}
+
+void UHGGenerationScheduler::Tick(float DeltaTime)
+{
+	QUICK_SCOPE_CYCLE_COUNTER(STAT_HGGenerationScheduler_Tick);
+
+	//Priorities are updated each frame : the players are moving
+	TArray<FViewer> Viewers;
+	GetViewers(Viewers);
+	Requests.RemoveAll([] (const FHGGenerationRequest &Request) { return !Request.Generator.IsValid(); });
+	for(FHGGenerationRequest &Request : Requests)
+		Request.Priority = ComputePriority(Request.Generator.Get(), Viewers, Request.Distance);
+	Requests.StableSort([] (const FHGGenerationRequest &A, const FHGGenerationRequest &B) { return A.Priority < B.Priority; });
+
+	//Computations which got too far are cancelled (the spawn steps are always finished) and queued again
+	int32 Running = 0;
+	for(FHGGenerationRequest &Request : Requests)
+	{
+		if(!Request.bRunning)
+			continue;
+
+		if(!Request.Generator->IsWaitingForSpawn() && IsTooFar(Request))
+		{
+			//Doesn't wait for the worker : its result is dropped
+			Request.Generator->CancelGeneration();
+			Request.bRunning = false;
+		}
+		else if(!Request.Generator->IsWaitingForSpawn())
+			++Running;
+	}
+
+	//Nearest generations first
+	for(FHGGenerationRequest &Request : Requests)
+	{
+		if(Running >= MaxConcurrentGenerations)
+			break;
+		if(Request.bRunning || IsTooFar(Request))
+			continue;
+
+		Request.bRunning = Request.Generator->GenerateScheduled();
+		Request.GenerationId = Request.Generator->GenerationId;
+		Running += Request.bRunning;
+	}
+
+	//Generators which will probably come in range soon
+	UHGLayoutPool * const LayoutPool = GetWorld()->GetSubsystem<UHGLayoutPool>();
+	if(LayoutPool && PregenerationMargin > 0.f)
+		for(const FHGGenerationRequest &Request : Requests)
+			if(!Request.bRunning && IsTooFar(Request) && Request.Distance <= MaxGenerationDistance + PregenerationMargin)
+				LayoutPool->Pregenerate(Request.Generator.Get());
+
+	//Spawn steps share the frame budget, nearest first
+	const double EndTime = FPlatformTime::Seconds() + FrameBudget / 1000.0;
+	bool bStepDone = false;
+	for(FHGGenerationRequest &Request : Requests)
+	{
+		if(!Request.bRunning)
+			continue;
+
+		AHomeGenerator * const Generator = Request.Generator.Get();
+		while(Generator->IsWaitingForSpawn() && (!bStepDone || FPlatformTime::Seconds() < EndTime))
+		{
+			Generator->AdvanceSlicedGeneration();
+			bStepDone = true;
+		}
+
+		if(bStepDone && FPlatformTime::Seconds() >= EndTime)
+			break;
+	}
+
+	//Generations cancelled outside of the scheduler are queued again, unless another generation has been spawned meanwhile
+	for(FHGGenerationRequest &Request : Requests)
+		if(Request.bRunning && !Request.Generator->IsGenerating() && Request.Generator->GenerationId != Request.GenerationId && !Request.Generator->bGenerationSpawned)
+			Request.bRunning = false;
+
+	//Finished generations leave the queue
+	Requests.RemoveAll([] (const FHGGenerationRequest &Request) { return Request.bRunning && !Request.Generator->IsGenerating(); });
+}
+
+ETickableTickType UHGGenerationScheduler::GetTickableTickType() const
+{
+	return IsTemplate() ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
+
+bool UHGGenerationScheduler::IsTickable() const
+{
+	return Requests.Num() > 0;
+}
+
+TStatId UHGGenerationScheduler::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UHGGenerationScheduler, STATGROUP_Tickables);
+}
+
+UWorld* UHGGenerationScheduler::GetTickableGameObjectWorld() const
+{
+	return GetWorld();
+}
+
+void UHGGenerationScheduler::GetViewers(TArray<FViewer>& Viewers) const
+{
+	for(FConstPlayerControllerIterator Iterator = GetWorld()->GetPlayerControllerIterator(); Iterator; ++Iterator)
+	{
+		const APlayerController * const PlayerController = Iterator->Get();
+		if(PlayerController == nullptr || !PlayerController->IsLocalController())
+			continue;
+
+		FVector Location;
+		FRotator Rotation;
+		PlayerController->GetPlayerViewPoint(Location, Rotation);
+
+		FViewer Viewer;
+		Viewer.Location = Location;
+		Viewer.Direction = Rotation.Vector();
+		Viewer.HalfFOV = FMath::DegreesToRadians((PlayerController->PlayerCameraManager ? PlayerController->PlayerCameraManager->GetFOVAngle() : 90.f) / 2.f);
+		Viewers.Push(Viewer);
+	}
+}
+
+float UHGGenerationScheduler::ComputePriority(const AHomeGenerator* Generator, const TArray<FViewer>& Viewers, float &NearestDistance) const
+{
+	//Without players, everything has the same priority
+	NearestDistance = 0.f;
+	if(Viewers.Num() == 0)
+		return 0.f;
+
+	const FSphere Bounds = Generator->GetGenerationBounds();
+	float Priority = TNumericLimits<float>::Max();
+	NearestDistance = TNumericLimits<float>::Max();
+	for(const FViewer &Viewer : Viewers)
+	{
+		const FVector ToBuilding = Bounds.Center - Viewer.Location;
+		const float Distance = ToBuilding.Size();
+
+		//Cone test : the bounds widen the view angle
+		const bool bInView = Distance <= Bounds.W
+			|| FMath::Acos(FMath::Clamp(FVector::DotProduct(ToBuilding / Distance, Viewer.Direction), -1.f, 1.f)) <= Viewer.HalfFOV + FMath::Asin(FMath::Min(Bounds.W / Distance, 1.f));
+		Priority = FMath::Min(Priority, bInView ? Distance : Distance * OutOfViewFactor);
+		NearestDistance = FMath::Min(NearestDistance, Distance);
+	}
+	return Priority;
+}
+
+bool UHGGenerationScheduler::IsTooFar(const FHGGenerationRequest& Request) const
+{
+	//The view only changes the order : turning the camera doesn't cancel anything
+	return MaxGenerationDistance > 0.f && Request.Distance > MaxGenerationDistance;
+}
@@ -0,0 +1,131 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "HGLayoutCache.h"
+#include "HomeGeneration.h"
+#include "HGLayoutFile.h"
+#include "HAL/FileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Misc/ScopeLock.h"
+#include "Misc/SecureHash.h"
+
+namespace HGLayoutCache
+{
+	//Files of the cache : the directory is only scanned once, then the index is updated by the reads and the writes
+	struct FCachedFile
+	{
+		FDateTime AccessTime;
+		int64 Size = 0;
+	};
+	static TMap<FString, FCachedFile> CachedFiles;
+	static int64 CachedSize = 0;
+	static bool bIndexed = false;
+
+	//Protects the index (the generators read and write from the worker threads)
+	static FCriticalSection IndexSection;
+
+	//Must be called with IndexSection locked
+	void BuildIndex()
+	{
+		if(bIndexed)
+			return;
+
+		bIndexed = true;
+		IFileManager::Get().IterateDirectoryStat(*GetDirectory(), [] (const TCHAR *Filename, const FFileStatData &StatData)
+		{
+			if(!StatData.bIsDirectory && FPaths::GetExtension(Filename) == TEXT("hglayout"))
+			{
+				CachedFiles.Add(Filename, {StatData.ModificationTime, StatData.FileSize});
+				CachedSize += StatData.FileSize;
+			}
+			return true;
+		});
+	}
+
+	//Must be called with IndexSection locked
+	void Evict(int64 MaxSize)
+	{
+		if(CachedSize <= MaxSize)
+			return;
+
+		//Least recently used first (a read touches the file)
+		CachedFiles.ValueSort([] (const FCachedFile &A, const FCachedFile &B) { return A.AccessTime < B.AccessTime; });
+		for(auto It = CachedFiles.CreateIterator(); It && CachedSize > MaxSize; ++It)
+		{
+			//A mapped file can't always be deleted : it is evicted later
+			if(IFileManager::Get().Delete(*It.Key(), false, false, true))
+			{
+				CachedSize -= It.Value().Size;
+				It.RemoveCurrent();
+			}
+		}
+	}
+
+	FString HashAsset(const UObject* Asset)
+	{
+		check(IsInGameThread());
+		FString Text;
+		for(TFieldIterator<FProperty> It(Asset->GetClass()); It; ++It)
+		{
+			if(It->HasAnyPropertyFlags(CPF_Transient))
+				continue;
+
+			FString Value;
+			It->ExportTextItem(Value, It->ContainerPtrToValuePtr<void>(Asset), nullptr, nullptr, PPF_None);
+			Text += It->GetName() + TEXT("=") + Value + TEXT("\n");
+		}
+
+		FSHAHash Hash;
+		FSHA1::HashBuffer(*Text, Text.Len() * sizeof(TCHAR), Hash.Hash);
+		return Hash.ToString();
+	}
+
+	FString GetDirectory()
+	{
+		return FPaths::ProjectSavedDir() / TEXT("HomeGeneration") / TEXT("LayoutCache");
+	}
+
+	FString GetFilename(const FString& Key)
+	{
+		return GetDirectory() / Key + TEXT(".hglayout");
+	}
+
+	bool Read(const FString& Key, FHGLayoutFile& File)
+	{
+		const FString Filename = GetFilename(Key);
+		if(!IFileManager::Get().FileExists(*Filename) || !File.Open(Filename))
+			return false;
+
+		const FDateTime Now = FDateTime::UtcNow();
+		IFileManager::Get().SetTimeStamp(*Filename, Now);
+
+		FScopeLock Lock(&IndexSection);
+		if(FCachedFile * const CachedFile = CachedFiles.Find(Filename))
+			CachedFile->AccessTime = Now;
+		return true;
+	}
+
+	void Write(const FString& Key, const TArray<uint8>& Bytes, int64 MaxSize)
+	{
+		//Written aside then moved : a file of the cache is always complete
+		const FString Filename = GetFilename(Key);
+		const FString TempFilename = FPaths::CreateTempFilename(*GetDirectory(), TEXT("Layout"), TEXT(".tmp"));
+		if(!FFileHelper::SaveArrayToFile(Bytes, *TempFilename) || !IFileManager::Get().Move(*Filename, *TempFilename, true, true, false, true))
+		{
+			IFileManager::Get().Delete(*TempFilename, false, false, true);
+			UE_LOG(LogHomeGeneration, Warning, TEXT("Can't write the cached layout %s."), *Filename);
+			return;
+		}
+
+		FScopeLock Lock(&IndexSection);
+		BuildIndex();
+
+		//The same key may have been written by another generation meanwhile
+		FCachedFile &CachedFile = CachedFiles.FindOrAdd(Filename);
+		CachedSize += Bytes.Num() - CachedFile.Size;
+		CachedFile.Size = Bytes.Num();
+		CachedFile.AccessTime = FDateTime::UtcNow();
+		Evict(MaxSize);
+	}
+}
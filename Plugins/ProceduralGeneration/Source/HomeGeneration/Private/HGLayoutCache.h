@@ -0,0 +1,31 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+struct FHGLayoutFile;
+
+/**
+ * Disk cache of the computed layouts, shared by all the generators and kept between the sessions.
+ * Each layout file is named after the hash of everything its computation depends on (see AHomeGenerator::ComputeLayoutKey) : a file is never updated, only written or evicted.
+ * The least recently used files are evicted once the cache is bigger than the given size.
+ */
+namespace HGLayoutCache
+{
+	//Must be incremented by any change of the generation which changes the layouts computed from the same parameters
+	constexpr int32 GeneratorVersion = 1;
+
+	FString GetDirectory();
+	FString GetFilename(const FString &Key);
+
+	//Opens the cached layout (any thread). Returns false if there is none.
+	bool Read(const FString &Key, FHGLayoutFile &File);
+
+	//Stores a layout (any thread), then evicts the oldest ones over MaxSize (in bytes).
+	//The size of the cache is kept in memory : the directory is only scanned by the first write.
+	void Write(const FString &Key, const TArray<uint8> &Bytes, int64 MaxSize);
+
+	//Hash of the exported properties of an asset (game thread), kept by the assets used by the layouts (see UFurnitureMeshAsset::GetLayoutHash)
+	FString HashAsset(const UObject *Asset);
+}
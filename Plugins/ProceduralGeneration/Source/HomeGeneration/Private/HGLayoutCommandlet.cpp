@@ -0,0 +1,253 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "HGLayoutCommandlet.h"
+#include "HomeGeneration.h"
+#include "HomeGenerator.h"
+#include "HGBuildingLayout.h"
+#include "HGGenerationResult.h"
+#include "HGLayoutService.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "Async/ParallelFor.h"
+#include "Misc/FileHelper.h"
+#include "HAL/PlatformMisc.h"
+
+UHGLayoutCommandlet::UHGLayoutCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = true;
+	LogToConsole = true;
+
+	HelpDescription = TEXT("Computes the layouts of ranges of seeds for generator presets and writes them as layout files, with a manifest. With -Serve, computes the layouts requested on a local socket. With -ExportPlans, writes the plan files of the presets for the layout tool.");
+	HelpUsage = TEXT("-run=HGLayout -nullrhi -Presets=/Game/BP_House.BP_House_C[,...] -Seeds=0-999[,...] -Output=Dir [-Workers=N] | -run=HGLayout -nullrhi -Serve [-Port=N] [-Workers=N] | -run=HGLayout -nullrhi -ExportPlans -Presets=/Game/BP_House.BP_House_C[,...] -Output=Dir");
+}
+
+int32 UHGLayoutCommandlet::Main(const FString& Params)
+{
+	if(FParse::Param(*Params, TEXT("Serve")))
+		return Serve(Params);
+	if(FParse::Param(*Params, TEXT("ExportPlans")))
+		return ExportPlans(Params);
+
+	FString PresetsParam, SeedsParam, Output;
+	TArray<int32> Seeds;
+	if(!FParse::Value(*Params, TEXT("Presets="), PresetsParam, false) || !FParse::Value(*Params, TEXT("Seeds="), SeedsParam, false)
+		|| !FParse::Value(*Params, TEXT("Output="), Output) || !HGLayoutJob::ParseSeeds(SeedsParam, Seeds))
+	{
+		UE_LOG(LogHomeGeneration, Error, TEXT("Usage : %s"), *HelpUsage);
+		return 1;
+	}
+
+	int32 Workers = FPlatformMisc::NumberOfCoresIncludingHyperthreads();
+	FParse::Value(*Params, TEXT("Workers="), Workers);
+	Workers = FMath::Clamp(Workers, 1, Seeds.Num());
+
+	TArray<FString> Presets;
+	PresetsParam.ParseIntoArray(Presets, TEXT(","));
+
+	UWorld * const World = CreateLayoutWorld();
+	TArray<FHGLayoutJob> Jobs;
+	int32 InvalidPresets = 0;
+	for(const FString &Preset : Presets)
+		if(!GeneratePreset(World, Preset, Seeds, Workers, Output, Jobs))
+			++InvalidPresets;
+	DestroyLayoutWorld(World);
+
+	const FString Manifest = Output / TEXT("Manifest.csv");
+	if(!HGLayoutJob::WriteManifest(Manifest, Jobs))
+		UE_LOG(LogHomeGeneration, Error, TEXT("Can't write the manifest %s."), *Manifest);
+
+	int32 Failures = 0;
+	double TotalTime = 0.0, MaxTime = 0.0;
+	for(const FHGLayoutJob &Job : Jobs)
+	{
+		Failures += Job.Error.IsEmpty() ? 0 : 1;
+		TotalTime += Job.Milliseconds;
+		MaxTime = FMath::Max(MaxTime, Job.Milliseconds);
+	}
+	UE_LOG(LogHomeGeneration, Display, TEXT("%d layouts computed, %d failed (%d invalid presets). Average %.2f ms, max %.2f ms per seed."),
+		Jobs.Num() - Failures, Failures, InvalidPresets, Jobs.Num() > 0 ? TotalTime / Jobs.Num() : 0.0, MaxTime);
+
+	return Failures > 0 || InvalidPresets > 0 ? 1 : 0;
+}
+
+int32 UHGLayoutCommandlet::Serve(const FString& Params)
+{
+	int32 Port = FHGLayoutService::DefaultPort;
+	int32 Workers = FPlatformMisc::NumberOfCoresIncludingHyperthreads();
+	FParse::Value(*Params, TEXT("Port="), Port);
+	FParse::Value(*Params, TEXT("Workers="), Workers);
+	if(Port <= 0 || Port > MAX_uint16)
+	{
+		UE_LOG(LogHomeGeneration, Error, TEXT("Usage : %s"), *HelpUsage);
+		return 1;
+	}
+
+	UWorld * const World = CreateLayoutWorld();
+	int32 Result = 1;
+	{
+		FHGLayoutService Service(*this, *World, FMath::Max(Workers, 1));
+		if(Service.Start(static_cast<uint16>(Port)))
+		{
+			Service.Run();
+			Result = 0;
+		}
+	}
+	DestroyLayoutWorld(World);
+	return Result;
+}
+
+int32 UHGLayoutCommandlet::ExportPlans(const FString& Params)
+{
+	FString PresetsParam, Output;
+	if(!FParse::Value(*Params, TEXT("Presets="), PresetsParam, false) || !FParse::Value(*Params, TEXT("Output="), Output))
+	{
+		UE_LOG(LogHomeGeneration, Error, TEXT("Usage : %s"), *HelpUsage);
+		return 1;
+	}
+
+	TArray<FString> Presets;
+	PresetsParam.ParseIntoArray(Presets, TEXT(","));
+
+	UWorld * const World = CreateLayoutWorld();
+	int32 Failures = 0;
+	for(const FString &PresetPath : Presets)
+	{
+		UClass * const Preset = LoadClass<AHomeGenerator>(nullptr, *PresetPath);
+		AHomeGenerator * const Generator = Preset ? SpawnGenerator(World, Preset) : nullptr;
+		if(!Generator)
+		{
+			UE_LOG(LogHomeGeneration, Error, TEXT("%s isn't a generator class."), *PresetPath);
+			++Failures;
+			continue;
+		}
+
+		//Same preparation as the layouts : only the seed is given by the tool
+		FHomeGenerationResult Result;
+		PrepareLayout(*Generator, 0, Result);
+		DestroyGenerator(*Generator);
+
+		const FString Filename = Output / FString::Printf(TEXT("%s.hgplan"), *Preset->GetName());
+		if(Result.Layout->SaveToFile(Filename))
+		{
+			UE_LOG(LogHomeGeneration, Display, TEXT("Plan of %s written in %s (%d meshes)."), *Preset->GetName(), *Filename, Result.Layout->CatalogMeshes.Num());
+		}
+		else
+		{
+			UE_LOG(LogHomeGeneration, Error, TEXT("Can't write the plan %s."), *Filename);
+			++Failures;
+		}
+	}
+	DestroyLayoutWorld(World);
+	return Failures > 0 ? 1 : 0;
+}
+
+UWorld* UHGLayoutCommandlet::CreateLayoutWorld()
+{
+	//Nothing is spawned but the generators need a world (actor pool, timers)
+	UWorld * const World = UWorld::CreateWorld(EWorldType::Game, false, TEXT("HGLayoutWorld"));
+	FWorldContext &WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+	WorldContext.SetCurrentWorld(World);
+	return World;
+}
+
+void UHGLayoutCommandlet::DestroyLayoutWorld(UWorld* World)
+{
+	GEngine->DestroyWorldContext(World);
+	World->DestroyWorld(false);
+}
+
+bool UHGLayoutCommandlet::GeneratePreset(UWorld* World, const FString& PresetPath, const TArray<int32>& Seeds, int32 Workers, const FString& Output, TArray<FHGLayoutJob>& Jobs) const
+{
+	UClass * const Preset = LoadClass<AHomeGenerator>(nullptr, *PresetPath);
+	if(!Preset)
+	{
+		UE_LOG(LogHomeGeneration, Error, TEXT("%s isn't a generator class."), *PresetPath);
+		return false;
+	}
+
+	//The computations only use the copied parameters : one generator prepares the seeds of all the workers
+	AHomeGenerator * const Generator = SpawnGenerator(World, Preset);
+	if(!Generator)
+	{
+		UE_LOG(LogHomeGeneration, Error, TEXT("Can't spawn the generator %s."), *PresetPath);
+		return false;
+	}
+
+	const FString Directory = Output / Preset->GetName();
+	for(int32 First = 0; First < Seeds.Num(); First += Workers)
+	{
+		const int32 Num = FMath::Min(Workers, Seeds.Num() - First);
+		const int32 FirstJob = Jobs.Num();
+
+		//Game thread : copies the parameters of each seed
+		TIndirectArray<FHomeGenerationResult> Results;
+		for(int32 i = 0; i < Num; ++i)
+		{
+			FHGLayoutJob &Job = Jobs.AddDefaulted_GetRef();
+			Job.Preset = PresetPath;
+			Job.Seed = Seeds[First + i];
+			Job.Filename = Directory / FString::Printf(TEXT("%d.hglayout"), Job.Seed);
+
+			PrepareLayout(*Generator, Job.Seed, *new(Results) FHomeGenerationResult);
+		}
+
+		ParallelFor(Num, [this, &Results, &Jobs, FirstJob] (int32 i)
+		{
+			GenerateLayout(Results[i], Jobs[FirstJob + i]);
+		});
+
+		for(int32 JobIndex = FirstJob; JobIndex < Jobs.Num(); ++JobIndex)
+		{
+			const FHGLayoutJob &Job = Jobs[JobIndex];
+			if(Job.Error.IsEmpty())
+			{
+				UE_LOG(LogHomeGeneration, Display, TEXT("%s seed %d : %d levels, %d rooms, %d furniture in %.2f ms."), *Preset->GetName(), Job.Seed, Job.Levels, Job.Rooms, Job.Furniture, Job.Milliseconds);
+			}
+			else
+			{
+				UE_LOG(LogHomeGeneration, Warning, TEXT("%s seed %d failed : %s"), *Preset->GetName(), Job.Seed, *Job.Error);
+			}
+		}
+	}
+
+	DestroyGenerator(*Generator);
+	return true;
+}
+
+AHomeGenerator* UHGLayoutCommandlet::SpawnGenerator(UWorld* World, UClass* Preset) const
+{
+	AHomeGenerator * const Generator = World->SpawnActor<AHomeGenerator>(Preset);
+
+	//The furniture is only recorded out of streaming mode
+	if(Generator)
+		Generator->bStreamFurniture = false;
+	return Generator;
+}
+
+void UHGLayoutCommandlet::PrepareLayout(AHomeGenerator& Generator, int32 Seed, FHomeGenerationResult& Result) const
+{
+	Generator.Seed = Seed;
+	Generator.PrepareGeneration(Result);
+	++Generator.GenerationId;
+}
+
+void UHGLayoutCommandlet::DestroyGenerator(AHomeGenerator& Generator) const
+{
+	Generator.Destroy();
+}
+
+void UHGLayoutCommandlet::GenerateLayout(FHomeGenerationResult& Result, FHGLayoutJob& Job) const
+{
+	TArray<uint8> Bytes;
+	ComputeLayout(Result, Job, Bytes);
+	if(Job.Error.IsEmpty() && !FFileHelper::SaveArrayToFile(Bytes, *Job.Filename))
+		Job.Error = TEXT("Can't write the layout file");
+}
+
+void UHGLayoutCommandlet::ComputeLayout(FHomeGenerationResult& Result, FHGLayoutJob& Job, TArray<uint8>& Bytes) const
+{
+	HGLayoutJob::ComputeLayout(*Result.Layout, Result.SpawnBuffer, Job, Bytes);
+}
@@ -0,0 +1,191 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "HGLayoutPool.h"
+#include "HomeGenerator.h"
+#include "HGGenerationResult.h"
+#include "HGBuildingLayout.h"
+
+void UHGLayoutPool::Pregenerate(AHomeGenerator* Generator)
+{
+	if(!IsValid(Generator))
+		return;
+
+	const int32 Index = FindLayout(Generator);
+	if(Index != INDEX_NONE)
+	{
+		Layouts[Index].LastUseTime = FPlatformTime::Seconds();
+		return;
+	}
+
+	//Already generated : its layout is known
+	if(Generator->IsGenerating() || Generator->bGenerationSpawned)
+		return;
+
+	FHGPooledLayout Layout;
+	Layout.Generator = Generator;
+	Layout.LastUseTime = FPlatformTime::Seconds();
+	Layouts.Push(Layout);
+}
+
+void UHGLayoutPool::Remove(AHomeGenerator* Generator)
+{
+	const int32 Index = FindLayout(Generator);
+	if(Index == INDEX_NONE)
+		return;
+
+	const FHGPooledLayout Layout = Layouts[Index];
+	Layouts.RemoveAt(Index);
+	if(Layout.bComputing && IsValid(Generator) && Generator->AsyncTarget == EHGAsyncTarget::LayoutPool)
+		Generator->CancelGeneration();
+}
+
+bool UHGLayoutPool::IsReady(const AHomeGenerator* Generator) const
+{
+	const int32 Index = FindLayout(Generator);
+	return Index != INDEX_NONE && Layouts[Index].Result.IsValid() && IsLayoutValid(Layouts[Index]);
+}
+
+int32 UHGLayoutPool::Num() const
+{
+	return Layouts.Num();
+}
+
+SIZE_T UHGLayoutPool::GetUsedMemory() const
+{
+	SIZE_T Size = 0;
+	for(const FHGPooledLayout &Layout : Layouts)
+		Size += Layout.Size;
+	return Size;
+}
+
+TSharedPtr<FHomeGenerationResult, ESPMode::ThreadSafe> UHGLayoutPool::TakeLayout(AHomeGenerator* Generator)
+{
+	const int32 Index = FindLayout(Generator);
+	if(Index == INDEX_NONE || !Layouts[Index].Result.IsValid())
+		return nullptr;
+
+	const FHGPooledLayout Layout = Layouts[Index];
+	Layouts.RemoveAt(Index);
+	return IsLayoutValid(Layout) ? Layout.Result : nullptr;
+}
+
+void UHGLayoutPool::StoreLayout(AHomeGenerator* Generator, const TSharedRef<FHomeGenerationResult, ESPMode::ThreadSafe>& Result)
+{
+	check(IsInGameThread());
+	const int32 Index = FindLayout(Generator);
+	if(Index == INDEX_NONE)
+		return;
+
+	//Kept for a long time : no slack
+	Result->Shrink();
+
+	FHGPooledLayout &Layout = Layouts[Index];
+	Layout.Result = Result;
+	Layout.bComputing = false;
+	//Seed of the snapshot : the generator's one may have been edited during the computation
+	Layout.Seed = Result->Layout->Seed;
+	Layout.Size = Result->GetAllocatedSize();
+	EvictLayouts();
+}
+
+void UHGLayoutPool::Deinitialize()
+{
+	for(const FHGPooledLayout &Layout : Layouts)
+		if(Layout.bComputing && Layout.Generator.IsValid())
+			Layout.Generator->CancelGeneration();
+	Layouts.Empty();
+
+	Super::Deinitialize();
+}
+
+void UHGLayoutPool::Tick(float DeltaTime)
+{
+	QUICK_SCOPE_CYCLE_COUNTER(STAT_HGLayoutPool_Tick);
+
+	//Generators destroyed, generated again or whose computation has been cancelled
+	Layouts.RemoveAll([] (const FHGPooledLayout &Layout)
+	{
+		if(!Layout.Generator.IsValid())
+			return true;
+		if(Layout.bComputing)
+			return !Layout.Generator->IsGenerating() || Layout.Generator->AsyncTarget != EHGAsyncTarget::LayoutPool;
+		return Layout.Result.IsValid() && !IsLayoutValid(Layout, false);
+	});
+
+	int32 Computing = 0;
+	for(const FHGPooledLayout &Layout : Layouts)
+		Computing += Layout.bComputing;
+
+	//Most recently requested first
+	Layouts.StableSort([] (const FHGPooledLayout &A, const FHGPooledLayout &B) { return A.LastUseTime > B.LastUseTime; });
+	for(FHGPooledLayout &Layout : Layouts)
+	{
+		if(Computing >= MaxConcurrentPregenerations)
+			break;
+		if(Layout.bComputing || Layout.Result.IsValid())
+			continue;
+
+		Layout.bComputing = Layout.Generator->Pregenerate();
+		if(Layout.bComputing)
+		{
+			Layout.GenerationId = Layout.Generator->GenerationId;
+			Layout.Seed = Layout.Generator->Seed;
+			Layout.ParametersHash = Layout.Generator->GetParametersHash();
+		}
+		Computing += Layout.bComputing;
+	}
+}
+
+ETickableTickType UHGLayoutPool::GetTickableTickType() const
+{
+	return IsTemplate() ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
+
+bool UHGLayoutPool::IsTickable() const
+{
+	return Layouts.Num() > 0;
+}
+
+TStatId UHGLayoutPool::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UHGLayoutPool, STATGROUP_Tickables);
+}
+
+UWorld* UHGLayoutPool::GetTickableGameObjectWorld() const
+{
+	return GetWorld();
+}
+
+int32 UHGLayoutPool::FindLayout(const AHomeGenerator* Generator) const
+{
+	return Layouts.IndexOfByPredicate([Generator] (const FHGPooledLayout &Layout) { return Layout.Generator.Get() == Generator; });
+}
+
+bool UHGLayoutPool::IsLayoutValid(const FHGPooledLayout& Layout, bool bCompareParameters)
+{
+	const AHomeGenerator * const Generator = Layout.Generator.Get();
+	if(!Generator || Generator->IsGenerating() || Generator->bGenerationSpawned || Generator->GenerationId != Layout.GenerationId || Generator->Seed != Layout.Seed)
+		return false;
+
+	//Edited since the start of the computation
+	return !bCompareParameters || Generator->GetParametersHash() == Layout.ParametersHash;
+}
+
+void UHGLayoutPool::EvictLayouts()
+{
+	const SIZE_T MaxSize = SIZE_T(FMath::Max(MaxMemory, 0.f) * 1024.f * 1024.f);
+	SIZE_T Size = GetUsedMemory();
+	while(Size > MaxSize)
+	{
+		int32 Oldest = INDEX_NONE;
+		for(int32 i = 0; i < Layouts.Num(); ++i)
+			if(Layouts[i].Result.IsValid() && (Oldest == INDEX_NONE || Layouts[i].LastUseTime < Layouts[Oldest].LastUseTime))
+				Oldest = i;
+		if(Oldest == INDEX_NONE)
+			return;
+
+		Size -= Layouts[Oldest].Size;
+		Layouts.RemoveAt(Oldest);
+	}
+}
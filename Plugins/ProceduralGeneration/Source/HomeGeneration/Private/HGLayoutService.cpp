@@ -0,0 +1,338 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "HGLayoutService.h"
+#include "HomeGeneration.h"
+#include "HomeGenerator.h"
+#include "Async/Async.h"
+#include "Common/TcpListener.h"
+#include "Dom/JsonObject.h"
+#include "Interfaces/IPv4/IPv4Endpoint.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+#include "Sockets.h"
+#include "SocketSubsystem.h"
+
+FHGLayoutService::FHGLayoutService(const UHGLayoutCommandlet& InCommandlet, UWorld& InWorld, int32 InWorkers)
+	: Commandlet(InCommandlet), World(InWorld), Workers(InWorkers)
+{
+}
+
+FHGLayoutService::~FHGLayoutService()
+{
+	//Stops the listener thread first
+	Listener.Reset();
+
+	FSocket *Socket = nullptr;
+	while(AcceptedSockets.Dequeue(Socket))
+	{
+		FHGServiceConnection Connection;
+		Connection.Socket = Socket;
+		CloseConnection(Connection);
+	}
+	for(const TSharedPtr<FHGServiceConnection> &Connection : Connections)
+		CloseConnection(*Connection);
+
+	for(const TUniquePtr<FHGServiceTask> &Task : Tasks)
+		Task->Future.Wait();
+	for(const TPair<FString, FHGServicePreset> &Preset : Presets)
+		for(AHomeGenerator *Generator : Preset.Value.Generators)
+			Commandlet.DestroyGenerator(*Generator);
+}
+
+bool FHGLayoutService::Start(uint16 Port)
+{
+	//Only the local tools can connect
+	Listener = MakeUnique<FTcpListener>(FIPv4Endpoint(FIPv4Address::InternalLoopback, Port));
+	if(!Listener->IsActive())
+	{
+		UE_LOG(LogHomeGeneration, Error, TEXT("Can't listen on the port %d."), Port);
+		Listener.Reset();
+		return false;
+	}
+
+	Listener->OnConnectionAccepted().BindRaw(this, &FHGLayoutService::HandleConnectionAccepted);
+	UE_LOG(LogHomeGeneration, Display, TEXT("Layout service listening on %s with %d workers."), *Listener->GetLocalEndpoint().ToString(), Workers);
+	return true;
+}
+
+void FHGLayoutService::Run()
+{
+	while(!bQuit && !IsEngineExitRequested())
+	{
+		AcceptConnections();
+		ReceiveRequests();
+		StartTasks();
+		FinishTasks();
+		SendPendingResponses();
+
+		FPlatformProcess::Sleep(0.001f);
+	}
+
+	//The running requests are still answered
+	for(const TUniquePtr<FHGServiceTask> &Task : Tasks)
+		Task->Future.Wait();
+	FinishTasks();
+
+	const double EndTime = FPlatformTime::Seconds() + QuitSendTimeout;
+	auto HasPendingResponses = [this] ()
+	{
+		return Connections.ContainsByPredicate([] (const TSharedPtr<FHGServiceConnection> &Connection) { return Connection->Socket && Connection->OutgoingOffset < Connection->Outgoing.Num(); });
+	};
+	while(HasPendingResponses() && FPlatformTime::Seconds() < EndTime)
+	{
+		SendPendingResponses();
+		FPlatformProcess::Sleep(0.001f);
+	}
+	UE_LOG(LogHomeGeneration, Display, TEXT("Layout service stopped."));
+}
+
+bool FHGLayoutService::HandleConnectionAccepted(FSocket* Socket, const FIPv4Endpoint& Endpoint)
+{
+	AcceptedSockets.Enqueue(Socket);
+	return true;
+}
+
+void FHGLayoutService::AcceptConnections()
+{
+	FSocket *Socket = nullptr;
+	while(AcceptedSockets.Dequeue(Socket))
+	{
+		//A slow tool must not block the game thread
+		Socket->SetNonBlocking(true);
+
+		const TSharedPtr<FHGServiceConnection> Connection = MakeShared<FHGServiceConnection>();
+		Connection->Socket = Socket;
+		Connections.Push(Connection);
+	}
+}
+
+void FHGLayoutService::ReceiveRequests()
+{
+	for(int32 ConnectionIndex = 0; ConnectionIndex < Connections.Num(); ++ConnectionIndex)
+	{
+		const TSharedPtr<FHGServiceConnection> Connection = Connections[ConnectionIndex];
+		FSocket * const Socket = Connection->Socket;
+		TArray<uint8> &Received = Connection->Received;
+
+		//Waits for its last responses to be sent
+		if(Connection->bClosing && Socket)
+			continue;
+
+		//Readable without data : closed by the tool
+		uint32 PendingSize = 0;
+		bool bOpen = Socket && (Socket->HasPendingData(PendingSize) || !Socket->Wait(ESocketWaitConditions::WaitForRead, FTimespan::Zero()));
+		while(bOpen && PendingSize > 0)
+		{
+			const int32 Offset = Received.Num();
+			Received.AddUninitialized(FMath::Min<uint32>(PendingSize, MaxRequestSize));
+			int32 BytesRead = 0;
+			bOpen = Socket->Recv(Received.GetData() + Offset, Received.Num() - Offset, BytesRead);
+			Received.SetNum(Offset + BytesRead, false);
+			if(!Socket->HasPendingData(PendingSize))
+				PendingSize = 0;
+		}
+
+		//One request per line
+		int32 LineStart = 0;
+		for(int32 i = 0; i < Received.Num(); ++i)
+		{
+			if(Received[i] != '\n')
+				continue;
+
+			const FUTF8ToTCHAR Line(reinterpret_cast<const ANSICHAR *>(Received.GetData() + LineStart), i - LineStart);
+			ParseRequest(Connection, FString(Line.Length(), Line.Get()).TrimStartAndEnd());
+			LineStart = i + 1;
+		}
+		Received.RemoveAt(0, LineStart, false);
+
+		if(Received.Num() > MaxRequestSize)
+		{
+			Received.Empty();
+			Connection->bClosing = true;
+			SendError(*Connection, 0, TEXT("Request too long"));
+			continue;
+		}
+
+		//The requests of a closed connection are still computed, but not answered
+		if(!bOpen || Connection->Socket == nullptr)
+		{
+			CloseConnection(*Connection);
+			Connections.RemoveAt(ConnectionIndex--);
+		}
+	}
+}
+
+void FHGLayoutService::ParseRequest(const TSharedPtr<FHGServiceConnection>& Connection, const FString& Line)
+{
+	if(Line.IsEmpty())
+		return;
+
+	TSharedPtr<FJsonObject> Object;
+	if(!FJsonSerializer::Deserialize(TJsonReaderFactory<>::Create(Line), Object) || !Object.IsValid())
+	{
+		SendError(*Connection, 0, TEXT("Invalid JSON request"));
+		return;
+	}
+
+	FString Command;
+	if(Object->TryGetStringField(TEXT("command"), Command))
+	{
+		if(Command == TEXT("quit"))
+			bQuit = true;
+		else
+			SendError(*Connection, 0, FString::Printf(TEXT("Unknown command %s"), *Command));
+		return;
+	}
+
+	FHGServiceRequest Request;
+	Request.Connection = Connection;
+	if(!Object->TryGetNumberField(TEXT("id"), Request.Id) || !Object->TryGetStringField(TEXT("preset"), Request.Preset) || !Object->TryGetNumberField(TEXT("seed"), Request.Seed))
+	{
+		SendError(*Connection, Request.Id, TEXT("A request needs an id, a preset and a seed"));
+		return;
+	}
+	PendingRequests.Push(MoveTemp(Request));
+}
+
+void FHGLayoutService::StartTasks()
+{
+	//The requests of a busy preset wait, the next ones can start
+	for(int32 RequestIndex = 0; RequestIndex < PendingRequests.Num() && Tasks.Num() < Workers; ++RequestIndex)
+	{
+		FHGServiceRequest &Request = PendingRequests[RequestIndex];
+		FString Error;
+		AHomeGenerator * const Generator = TakeGenerator(Request.Preset, Error);
+		if(Generator == nullptr && Error.IsEmpty())
+			continue;
+
+		if(Generator == nullptr)
+			SendError(*Request.Connection, Request.Id, Error);
+		else
+		{
+			FHGServiceTask &Task = *Tasks.Add_GetRef(MakeUnique<FHGServiceTask>());
+			Task.Request = MoveTemp(Request);
+			Task.Generator = Generator;
+			Task.Job.Preset = Task.Request.Preset;
+			Task.Job.Seed = Task.Request.Seed;
+
+			//Game thread : same preparation as a generation in the game
+			Commandlet.PrepareLayout(*Generator, Task.Job.Seed, Task.Result);
+			Task.Future = Async(EAsyncExecution::ThreadPool, [this, &Task] ()
+			{
+				Commandlet.ComputeLayout(Task.Result, Task.Job, Task.Bytes);
+			});
+		}
+		PendingRequests.RemoveAt(RequestIndex--);
+	}
+}
+
+void FHGLayoutService::FinishTasks()
+{
+	for(int32 TaskIndex = 0; TaskIndex < Tasks.Num(); ++TaskIndex)
+	{
+		FHGServiceTask &Task = *Tasks[TaskIndex];
+		if(!Task.Future.IsReady())
+			continue;
+
+		if(Task.Job.Error.IsEmpty())
+		{
+			UE_LOG(LogHomeGeneration, Verbose, TEXT("%s seed %d : %d bytes in %.2f ms."), *Task.Job.Preset, Task.Job.Seed, Task.Job.Size, Task.Job.Milliseconds);
+			SendResponse(*Task.Request.Connection, Task.Request.Id, 0, Task.Bytes.GetData(), Task.Bytes.Num());
+		}
+		else
+		{
+			UE_LOG(LogHomeGeneration, Warning, TEXT("%s seed %d failed : %s"), *Task.Job.Preset, Task.Job.Seed, *Task.Job.Error);
+			SendError(*Task.Request.Connection, Task.Request.Id, Task.Job.Error);
+		}
+
+		Presets.FindChecked(Task.Request.Preset).Idle.Push(Task.Generator);
+		Tasks.RemoveAt(TaskIndex--);
+	}
+}
+
+AHomeGenerator* FHGLayoutService::TakeGenerator(const FString& Path, FString& Error)
+{
+	FHGServicePreset &Preset = Presets.FindOrAdd(Path);
+	if(Preset.Class == nullptr)
+	{
+		Preset.Class = LoadClass<AHomeGenerator>(nullptr, *Path);
+		if(Preset.Class == nullptr)
+		{
+			Presets.Remove(Path);
+			Error = FString::Printf(TEXT("%s isn't a generator class"), *Path);
+			return nullptr;
+		}
+	}
+
+	if(Preset.Idle.Num() > 0)
+		return Preset.Idle.Pop(false);
+	if(Preset.Generators.Num() >= Workers)
+		return nullptr;
+
+	AHomeGenerator * const Generator = Commandlet.SpawnGenerator(&World, Preset.Class);
+	if(Generator == nullptr)
+	{
+		Error = FString::Printf(TEXT("Can't spawn the generator %s"), *Path);
+		return nullptr;
+	}
+	Preset.Generators.Push(Generator);
+	return Generator;
+}
+
+void FHGLayoutService::SendResponse(FHGServiceConnection& Connection, uint32 Id, uint32 Status, const uint8* Data, int32 Size)
+{
+	if(Connection.Socket == nullptr)
+		return;
+
+	const uint32 Header[] = {Id, Status, static_cast<uint32>(Size)};
+	Connection.Outgoing.Append(reinterpret_cast<const uint8 *>(Header), sizeof(Header));
+	Connection.Outgoing.Append(Data, Size);
+	SendPending(Connection);
+}
+
+void FHGLayoutService::SendPendingResponses()
+{
+	for(const TSharedPtr<FHGServiceConnection> &Connection : Connections)
+		SendPending(*Connection);
+}
+
+void FHGLayoutService::SendPending(FHGServiceConnection& Connection)
+{
+	while(Connection.Socket && Connection.OutgoingOffset < Connection.Outgoing.Num())
+	{
+		int32 BytesSent = 0;
+		if(!Connection.Socket->Send(Connection.Outgoing.GetData() + Connection.OutgoingOffset, Connection.Outgoing.Num() - Connection.OutgoingOffset, BytesSent))
+		{
+			//Full : sent at the next update. Otherwise removed from the connections at the next reception.
+			if(ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->GetLastErrorCode() != SE_EWOULDBLOCK)
+				CloseConnection(Connection);
+			return;
+		}
+		if(BytesSent <= 0)
+			return;
+		Connection.OutgoingOffset += BytesSent;
+	}
+
+	//Everything is sent : the buffer is reused by the next responses
+	Connection.Outgoing.Reset();
+	Connection.OutgoingOffset = 0;
+	if(Connection.bClosing)
+		CloseConnection(Connection);
+}
+
+void FHGLayoutService::SendError(FHGServiceConnection& Connection, uint32 Id, const FString& Error)
+{
+	const FTCHARToUTF8 Message(*Error);
+	SendResponse(Connection, Id, 1, reinterpret_cast<const uint8 *>(Message.Get()), Message.Length());
+}
+
+void FHGLayoutService::CloseConnection(FHGServiceConnection& Connection)
+{
+	if(Connection.Socket == nullptr)
+		return;
+
+	Connection.Socket->Close();
+	ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->DestroySocket(Connection.Socket);
+	Connection.Socket = nullptr;
+}
@@ -0,0 +1,132 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Queue.h"
+#include "Async/Future.h"
+#include "HGLayoutCommandlet.h"
+#include "HGGenerationResult.h"
+
+class AHomeGenerator;
+class FSocket;
+class FTcpListener;
+struct FIPv4Endpoint;
+
+//Connection of a local tool (non-blocking socket)
+struct FHGServiceConnection
+{
+	FSocket *Socket = nullptr;
+
+	//Received bytes which don't form a whole request yet
+	TArray<uint8> Received;
+
+	//Responses not sent yet : a tool which doesn't read its responses doesn't block the others. The bytes before OutgoingOffset are sent.
+	TArray<uint8> Outgoing;
+	int32 OutgoingOffset = 0;
+
+	//Closed once the outgoing bytes are sent (nothing is received anymore)
+	bool bClosing = false;
+};
+
+//Layout requested by a tool
+struct FHGServiceRequest
+{
+	TSharedPtr<FHGServiceConnection> Connection;
+	uint32 Id = 0;
+	FString Preset;
+	int32 Seed = 0;
+};
+
+//Request computed by a generator of the pool
+struct FHGServiceTask
+{
+	FHGServiceRequest Request;
+	AHomeGenerator *Generator = nullptr;
+	FHomeGenerationResult Result;
+	FHGLayoutJob Job;
+	TArray<uint8> Bytes;
+	TFuture<void> Future;
+};
+
+//Generators of a preset, kept between the requests with their loaded assets
+struct FHGServicePreset
+{
+	UClass *Class = nullptr;
+	TArray<AHomeGenerator *> Generators;
+	TArray<AHomeGenerator *> Idle;
+};
+
+/**
+ * Local generation service of the layout commandlet : the tools (scripts, city planner,...) get layouts without an editor.
+ * The layouts are computed by the same code as in the game : a request gives the same layout file as SaveLayout for the same preset and seed.
+ *
+ * The tools connect to 127.0.0.1:Port and send one JSON request per line :
+ *   {"id": 1, "preset": "/Game/BP_House.BP_House_C", "seed": 42}
+ *   {"command": "quit"}
+ * Each layout request is answered, in the order the layouts are computed, by a frame of 3 little endian uint32 : id, status (0 = layout, 1 = error), size,
+ * followed by the layout file (see FHGLayoutView) or the UTF-8 error message.
+ */
+class FHGLayoutService
+{
+public:
+	static constexpr int32 DefaultPort = 7815;
+
+	//Requests are limited to a line of this size
+	static constexpr int32 MaxRequestSize = 64 * 1024;
+
+	FHGLayoutService(const UHGLayoutCommandlet &InCommandlet, UWorld &InWorld, int32 InWorkers);
+	~FHGLayoutService();
+
+	//Starts listening on the local port. Returns false if the port can't be used.
+	bool Start(uint16 Port);
+
+	//Game thread : serves the requests until a quit request or the engine exit
+	void Run();
+
+protected:
+	//Listener thread
+	bool HandleConnectionAccepted(FSocket *Socket, const FIPv4Endpoint &Endpoint);
+
+	void AcceptConnections();
+	void ReceiveRequests();
+	void ParseRequest(const TSharedPtr<FHGServiceConnection> &Connection, const FString &Line);
+
+	//Starts the pending requests on the idle generators
+	void StartTasks();
+
+	//Sends the computed layouts
+	void FinishTasks();
+
+	//Sends what the sockets accept of the queued responses
+	void SendPendingResponses();
+
+	//Idle (or new) generator of the preset. Returns null if they are all busy, or if the preset is invalid (with the error).
+	AHomeGenerator *TakeGenerator(const FString &Path, FString &Error);
+
+	//Queues the response, then sends what the socket accepts
+	void SendResponse(FHGServiceConnection &Connection, uint32 Id, uint32 Status, const uint8 *Data, int32 Size);
+	void SendError(FHGServiceConnection &Connection, uint32 Id, const FString &Error);
+
+	//Sends the queued bytes until the socket would block. The connection is closed on error, or once everything is sent if it is closing.
+	static void SendPending(FHGServiceConnection &Connection);
+
+	static void CloseConnection(FHGServiceConnection &Connection);
+
+	//Time given to the tools to read their last responses when the service stops (in seconds)
+	static constexpr double QuitSendTimeout = 10.0;
+
+	const UHGLayoutCommandlet &Commandlet;
+	UWorld &World;
+	const int32 Workers;
+
+	TUniquePtr<FTcpListener> Listener;
+	TQueue<FSocket *, EQueueMode::Spsc> AcceptedSockets;
+	TArray<TSharedPtr<FHGServiceConnection>> Connections;
+
+	TArray<FHGServiceRequest> PendingRequests;
+	TArray<TUniquePtr<FHGServiceTask>> Tasks;
+	TMap<FString, FHGServicePreset> Presets;
+
+	bool bQuit = false;
+};
@@ -0,0 +1,182 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "HGMeshBuilder.h"
+#include "Algo/BinarySearch.h"
+
+void FHGMeshSection::Append(const FHGMeshSection& Section, const FTransform& Transform)
+{
+	const int32 FirstVertex = Vertices.Num();
+	for(const FVector &Vertex : Section.Vertices)
+		Vertices.Push(Transform.TransformPosition(Vertex));
+	for(const int32 Triangle : Section.Triangles)
+		Triangles.Push(FirstVertex + Triangle);
+	for(const FVector &Normal : Section.Normals)
+		Normals.Push(Transform.TransformVectorNoScale(Normal));
+	UVs.Append(Section.UVs);
+	for(const FProcMeshTangent &Tangent : Section.Tangents)
+		Tangents.Push(FProcMeshTangent(Transform.TransformVectorNoScale(Tangent.TangentX), Tangent.bFlipTangentY));
+	Colors.Append(Section.Colors);
+}
+
+void FHGMeshSection::AddBox(const FBox& Box, float UVLength)
+{
+	const FVector Size = Box.GetSize();
+	const FVector &Min = Box.Min;
+	const FVector &Max = Box.Max;
+
+	//Each face is seen from outside the box
+	AddQuad(FVector(Max.X, Min.Y, Min.Z), FVector(0.f, Size.Y, 0.f), FVector(0.f, 0.f, Size.Z), FVector::ForwardVector, UVLength);
+	AddQuad(FVector(Min.X, Max.Y, Min.Z), FVector(0.f, -Size.Y, 0.f), FVector(0.f, 0.f, Size.Z), FVector::BackwardVector, UVLength);
+	AddQuad(FVector(Max.X, Max.Y, Min.Z), FVector(-Size.X, 0.f, 0.f), FVector(0.f, 0.f, Size.Z), FVector::RightVector, UVLength);
+	AddQuad(FVector(Min.X, Min.Y, Min.Z), FVector(Size.X, 0.f, 0.f), FVector(0.f, 0.f, Size.Z), FVector::LeftVector, UVLength);
+	AddQuad(FVector(Min.X, Min.Y, Max.Z), FVector(Size.X, 0.f, 0.f), FVector(0.f, Size.Y, 0.f), FVector::UpVector, UVLength);
+	AddQuad(FVector(Min.X, Max.Y, Min.Z), FVector(Size.X, 0.f, 0.f), FVector(0.f, -Size.Y, 0.f), FVector::DownVector, UVLength);
+}
+
+bool FHGMeshSection::IsEmpty() const
+{
+	return Triangles.Num() == 0;
+}
+
+SIZE_T FHGMeshSection::GetAllocatedSize() const
+{
+	return Vertices.GetAllocatedSize() + Triangles.GetAllocatedSize() + Normals.GetAllocatedSize() + UVs.GetAllocatedSize() + Tangents.GetAllocatedSize() + Colors.GetAllocatedSize();
+}
+
+void FHGMeshSection::Shrink()
+{
+	Vertices.Shrink();
+	Triangles.Shrink();
+	Normals.Shrink();
+	UVs.Shrink();
+	Tangents.Shrink();
+	Colors.Shrink();
+}
+
+void FHGMeshSection::AddQuad(const FVector& Origin, const FVector& Right, const FVector& Up, const FVector& Normal, float UVLength, const FLinearColor& Color)
+{
+	const int32 FirstVertex = Vertices.Num();
+	Vertices.Push(Origin);
+	Vertices.Push(Origin + Right);
+	Vertices.Push(Origin + Right + Up);
+	Vertices.Push(Origin + Up);
+
+	//Planar projection : the texture is continuous between the merged pieces
+	const FVector2D UVOrigin(FVector::DotProduct(Origin, Right.GetSafeNormal()) / UVLength, -FVector::DotProduct(Origin, Up.GetSafeNormal()) / UVLength);
+	const float UVRight = Right.Size() / UVLength;
+	const float UVUp = Up.Size() / UVLength;
+	UVs.Push(UVOrigin);
+	UVs.Push(UVOrigin + FVector2D(UVRight, 0.f));
+	UVs.Push(UVOrigin + FVector2D(UVRight, -UVUp));
+	UVs.Push(UVOrigin + FVector2D(0.f, -UVUp));
+
+	const FProcMeshTangent Tangent(Right.GetSafeNormal(), false);
+	for(int32 i = 0; i < 4; ++i)
+	{
+		Normals.Push(Normal);
+		Tangents.Push(Tangent);
+		Colors.Push(Color);
+	}
+
+	//Counter clock-wise seen from the normal side (UE front face)
+	Triangles.Append({FirstVertex, FirstVertex + 2, FirstVertex + 1, FirstVertex, FirstVertex + 3, FirstVertex + 2});
+}
+
+void FHGRectGrid::AddEdges(const FBox2D& Rect)
+{
+	EdgesX.Push(Rect.Min.X);
+	EdgesX.Push(Rect.Max.X);
+	EdgesY.Push(Rect.Min.Y);
+	EdgesY.Push(Rect.Max.Y);
+}
+
+void FHGRectGrid::Build()
+{
+	SortEdges(EdgesX);
+	SortEdges(EdgesY);
+	Cells.Init(0, NumX() * NumY());
+}
+
+void FHGRectGrid::Paint(const FBox2D& Rect, uint8 State, int32 OnlyIf)
+{
+	int32 FirstX, LastX, FirstY, LastY;
+	FindCells(EdgesX, Rect.Min.X, Rect.Max.X, FirstX, LastX);
+	FindCells(EdgesY, Rect.Min.Y, Rect.Max.Y, FirstY, LastY);
+
+	for(int32 Y = FirstY; Y < LastY; ++Y)
+		for(int32 X = FirstX; X < LastX; ++X)
+			if(OnlyIf < 0 || Cells[X + Y * NumX()] == OnlyIf)
+				Cells[X + Y * NumX()] = State;
+}
+
+void FHGRectGrid::MergeCells(TArray<TPair<FBox2D, uint8>>& Rects) const
+{
+	TArray<bool> Merged;
+	Merged.Init(false, Cells.Num());
+	const auto IsFree = [&] (int32 X, int32 Y, uint8 State) -> bool { return !Merged[X + Y * NumX()] && Cells[X + Y * NumX()] == State; };
+
+	for(int32 Y = 0; Y < NumY(); ++Y)
+	{
+		for(int32 X = 0; X < NumX(); ++X)
+		{
+			const uint8 State = Cells[X + Y * NumX()];
+			if(State == 0 || Merged[X + Y * NumX()])
+				continue;
+
+			//Longest run on this row
+			int32 EndX = X + 1;
+			while(EndX < NumX() && IsFree(EndX, Y, State))
+				++EndX;
+
+			//Extended over the next rows while the whole run matches
+			int32 EndY = Y + 1;
+			for(; EndY < NumY(); ++EndY)
+			{
+				bool bRowMatches = true;
+				for(int32 RunX = X; RunX < EndX && bRowMatches; ++RunX)
+					bRowMatches = IsFree(RunX, EndY, State);
+				if(!bRowMatches)
+					break;
+			}
+
+			for(int32 MergedY = Y; MergedY < EndY; ++MergedY)
+				for(int32 MergedX = X; MergedX < EndX; ++MergedX)
+					Merged[MergedX + MergedY * NumX()] = true;
+
+			Rects.Push(TPair<FBox2D, uint8>(FBox2D(FVector2D(EdgesX[X], EdgesY[Y]), FVector2D(EdgesX[EndX], EdgesY[EndY])), State));
+		}
+	}
+}
+
+int32 FHGRectGrid::NumX() const
+{
+	return FMath::Max(0, EdgesX.Num() - 1);
+}
+
+int32 FHGRectGrid::NumY() const
+{
+	return FMath::Max(0, EdgesY.Num() - 1);
+}
+
+void FHGRectGrid::SortEdges(TArray<float>& Edges)
+{
+	Edges.Sort();
+
+	//Merges the (almost) equal edges
+	TArray<float> UniqueEdges;
+	UniqueEdges.Reserve(Edges.Num());
+	for(const float Edge : Edges)
+		if(UniqueEdges.Num() == 0 || !FMath::IsNearlyEqual(UniqueEdges.Last(), Edge, KINDA_SMALL_NUMBER))
+			UniqueEdges.Push(Edge);
+	Edges = MoveTemp(UniqueEdges);
+}
+
+void FHGRectGrid::FindCells(const TArray<float>& Edges, float Min, float Max, int32& First, int32& Last)
+{
+	//A cell is inside if its center is
+	First = Algo::LowerBound(Edges, Min - KINDA_SMALL_NUMBER);
+	Last = First;
+	while(Last + 1 < Edges.Num() && (Edges[Last] + Edges[Last + 1]) / 2.f < Max)
+		++Last;
+}
@@ -0,0 +1,72 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ProceduralMeshComponent.h"
+
+/**
+ * Geometry of one merged mesh section (used by the room proxies, the building shell and the decoration).
+ */
+struct FHGMeshSection
+{
+	TArray<FVector> Vertices;
+	TArray<int32> Triangles;
+	TArray<FVector> Normals;
+	TArray<FVector2D> UVs;
+	TArray<FProcMeshTangent> Tangents;
+
+	//Empty or one per vertex
+	TArray<FLinearColor> Colors;
+
+	//Appends another section moved by the given transform
+	void Append(const FHGMeshSection &Section, const FTransform &Transform);
+
+	//Adds an axis aligned box (UVs are projected on each face, one unit of UV every UVLength)
+	void AddBox(const FBox &Box, float UVLength);
+
+	//Adds a quad facing the normal, built from its origin corner and its two sides (the color is stored in each vertex)
+	void AddQuad(const FVector &Origin, const FVector &Right, const FVector &Up, const FVector &Normal, float UVLength, const FLinearColor &Color = FLinearColor::White);
+
+	bool IsEmpty() const;
+
+	//Memory used by the arrays
+	SIZE_T GetAllocatedSize() const;
+
+	//Frees the slack of the arrays
+	void Shrink();
+};
+
+/**
+ * 2D grid built on the edges of a list of rectangles (coordinate compression) : each cell stores a state.
+ * Rectangles are painted in order (the last one wins), then the cells are merged back into maximal rectangles.
+ */
+struct FHGRectGrid
+{
+	//Registers the edges of a rect : must be called for all the rects before Build
+	void AddEdges(const FBox2D &Rect);
+
+	//Sorts the edges and creates the cells (all with the state 0)
+	void Build();
+
+	//Sets the state of all the cells inside the rect (only the ones with the OnlyIf state if it isn't negative)
+	void Paint(const FBox2D &Rect, uint8 State, int32 OnlyIf = -1);
+
+	//Merges the cells of the same state (other than 0) into rectangles : rows are swept to find the longest runs, which are then extended over the next rows.
+	void MergeCells(TArray<TPair<FBox2D, uint8>> &Rects) const;
+
+	int32 NumX() const;
+	int32 NumY() const;
+
+protected:
+	TArray<float> EdgesX;
+	TArray<float> EdgesY;
+
+	//Cells[X + Y * NumX]
+	TArray<uint8> Cells;
+
+	static void SortEdges(TArray<float> &Edges);
+
+	//First and last (excluded) cell inside the interval
+	static void FindCells(const TArray<float> &Edges, float Min, float Max, int32 &First, int32 &Last);
+};
@@ -4,6 +4,8 @@
 
 #define LOCTEXT_NAMESPACE "FHomeGenerationModule"
 
+DEFINE_LOG_CATEGORY(LogHomeGeneration);
+
 void FHomeGenerationModule::StartupModule()
 {
 	// This code will execute after your module is loaded into memory; the exact timing is specified in the .uplugin file per-module
@@ -2,1381 +2,1926 @@
 
 
 #include "HomeGenerator.h"
+#include "HomeGeneration.h"
 #include "Engine/StaticMeshActor.h"
+#include "Components/HierarchicalInstancedStaticMeshComponent.h"
+#include "HGActorPool.h"
+#include "HGBakedBuilding.h"
+#include "HGBuildingLayout.h"
+#include "HGDecorationCache.h"
+#include "HGGenerationResult.h"
+#include "HGLayoutCache.h"
+#include "HGLayoutFile.h"
+#include "HGLayoutPool.h"
+#include "HGMeshBuilder.h"
+#include "ProceduralMeshComponent.h"
+#include "KismetProceduralMeshLibrary.h"
+#include "StaticMeshResources.h"
+#include "TimerManager.h"
+#include "GameFramework/PlayerController.h"
+#include "GameFramework/Pawn.h"
+#include "Async/Async.h"
+#include "LatentActions.h"
+#include "Net/UnrealNetwork.h"
+#include "Misc/FileHelper.h"
+#include "Misc/SecureHash.h"
+
+FHGDivisionConstraints FRoomsDivisionConstraints::ToCore() const
+{
+	FHGDivisionConstraints Constraints;
+	Constraints.HallWidth = HallWidth;
+	Constraints.MaxHallRatio = MaxHallRatio;
+	Constraints.OverDivideProba = OverDivideProba;
+	Constraints.MinSideCoef = MinSideCoef;
+	Constraints.StopSplitCoef = StopSplitCoef;
+	Constraints.SufficientChunkCoef = SufficientChunkCoef;
+	return Constraints;
+}
+
+FHGBuildingConstraints FBuildingConstraint::ToCore() const
+{
+	FHGBuildingConstraints Constraints;
+	Constraints.GridSnapLength = GridSnapLength;
+	Constraints.FloorWidth = FloorWidth;
+	Constraints.FloorHeight = FloorHeight;
+	Constraints.WallWidth = WallWidth;
+	Constraints.MinSideFloorLength = MinSideFloorLength;
+	Constraints.MaxSideFloorLength = MaxSideFloorLength;
+	Constraints.MaxFloorsNumber = MaxFloorsNumber;
+	return Constraints;
+}
+
+FHGRoomDescriptor FRoom::ToCore() const
+{
+	FHGRoomDescriptor Descriptor;
+	Descriptor.Furniture = Furniture;
+	Descriptor.NumPerHab = NumPerHab;
+	return Descriptor;
+}
+
+// Sets default values
+AHomeGenerator::AHomeGenerator()
+{
+	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
+	//Only enabled during a time sliced generation
+	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.bStartWithTickEnabled = false;
+
+	//Needed to attach the generated actors and components
+	RootComponent = CreateDefaultSubobject<USceneComponent>(TEXT("Root"));
+
+	//Only the seed and the furniture modifications are replicated, not the spawned actors : rarely changed, the updates are forced
+	bReplicates = true;
+	SetReplicatingMovement(false);
+	NetUpdateFrequency = 1.f;
+
+	//A building is seen from far away : the clients must keep it (and its deltas) whatever their distance
+	bAlwaysRelevant = true;
+
+	Layout = MakeShared<FHGBuildingLayout, ESPMode::ThreadSafe>();
+}
+
+// Called when the game starts or when spawned
+void AHomeGenerator::BeginPlay()
+{
+	Super::BeginPlay();
+
+	if(bMergeRoomProxies)
+		GetWorldTimerManager().SetTimer(RoomProxyTimer, this, &AHomeGenerator::UpdateRoomProxies, ProxyUpdateInterval, true);
+}
+
+void AHomeGenerator::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	CancelGeneration();
+
+	//Gives back the actors to the pool for the other generators of the world
+	if(EndPlayReason == EEndPlayReason::Destroyed || EndPlayReason == EEndPlayReason::RemovedFromWorld)
+		ClearGeneration();
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void AHomeGenerator::BeginDestroy()
+{
+	//The worker only uses its result, but the module may be unloaded after the destruction
+	CancelGeneration();
+	if(GenerationTask.IsValid())
+		GenerationTask.Wait();
+
+	Super::BeginDestroy();
+}
+
+void AHomeGenerator::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	DOREPLIFETIME(AHomeGenerator, ReplicatedGeneration);
+	DOREPLIFETIME(AHomeGenerator, ReplicatedDeltas);
+	DOREPLIFETIME(AHomeGenerator, ReplicatedFurniture);
+}
+
+void AHomeGenerator::ClearGeneration()
+{
+	//Proxy components are kept for the next generation
+	TArray<FIntPoint> RoomKeys;
+	RoomProxies.GetKeys(RoomKeys);
+	for(const FIntPoint &RoomKey : RoomKeys)
+		ReleaseRoomProxy(RoomKey);
+
+	UHGActorPool * const ActorPool = GetWorld() ? GetWorld()->GetSubsystem<UHGActorPool>() : nullptr;
+	for(AActor *GeneratedActor : GeneratedActors)
+	{
+		if(ActorPool)
+			ActorPool->Release(GeneratedActor);
+		else if(IsValid(GeneratedActor))
+			GeneratedActor->Destroy();
+	}
+	GeneratedActors.Reset();
+	FurnitureActorIds.Reset();
+	UpdateReplicatedFurniture();
+	StreamedRooms.Reset();
+	bGenerationSpawned = false;
+	GetWorldTimerManager().ClearTimer(StreamingTimer);
+
+	//Components are kept for the next generation
+	for(auto &Instances : FurnitureInstances)
+	{
+		if(IsValid(Instances.Value.Component))
+			Instances.Value.Component->ClearInstances();
+		Instances.Value.Infos.Reset();
+		Instances.Value.InstanceIndices.Reset();
+		Instances.Value.PendingTransforms.Reset();
+		Instances.Value.PendingInfos.Reset();
+	}
+}
+
+namespace
+{
+	//Waits for the end of the generation of a generator
+	class FHomeGenerationLatentAction : public FPendingLatentAction
+	{
+	public:
+		FHomeGenerationLatentAction(AHomeGenerator *_Generator, const FLatentActionInfo &LatentInfo)
+			: Generator(_Generator), ExecutionFunction(LatentInfo.ExecutionFunction), OutputLink(LatentInfo.Linkage), CallbackTarget(LatentInfo.CallbackTarget) {}
+
+		virtual void UpdateOperation(FLatentResponse &Response) override
+		{
+			Response.FinishAndTriggerIf(!Generator.IsValid() || !Generator->IsGenerating(), ExecutionFunction, OutputLink, CallbackTarget);
+		}
+
+	protected:
+		TWeakObjectPtr<AHomeGenerator> Generator;
+		FName ExecutionFunction;
+		int32 OutputLink;
+		FWeakObjectPtr CallbackTarget;
+	};
+}
+
+void AHomeGenerator::Generate()
+{
+	QUICK_SCOPE_CYCLE_COUNTER(STAT_HomeGenerator_Generate);
+	check(IsInGameThread());
+
+	//Layout computed in advance : only the spawn step remains
+	const TSharedPtr<FHomeGenerationResult, ESPMode::ThreadSafe> PooledLayout = TakePooledLayout();
+	if(PooledLayout.IsValid())
+	{
+		bGenerating = true;
+		FinishGeneration(*PooledLayout);
+		return;
+	}
+
+	CancelGeneration();
+	FHomeGenerationResult Result;
+	PrepareGeneration(Result);
+	++GenerationId;
+
+	Result.Layout->ComputeCachedGeneration(Result);
+	FinishGeneration(Result);
+}
+
+bool AHomeGenerator::GenerateAsync()
+{
+	return StartAsyncGeneration(EHGAsyncTarget::Spawn);
+}
+
+bool AHomeGenerator::GenerateScheduled()
+{
+	return StartAsyncGeneration(EHGAsyncTarget::Scheduler);
+}
+
+bool AHomeGenerator::Pregenerate()
+{
+	//A pooled layout is spawned without clearing the spawned generation
+	if(bGenerationSpawned)
+		return false;
+	return StartAsyncGeneration(EHGAsyncTarget::LayoutPool);
+}
+
+TSharedPtr<FHomeGenerationResult, ESPMode::ThreadSafe> AHomeGenerator::TakePooledLayout()
+{
+	UHGLayoutPool * const LayoutPool = GetWorld() ? GetWorld()->GetSubsystem<UHGLayoutPool>() : nullptr;
+	return LayoutPool ? LayoutPool->TakeLayout(this) : nullptr;
+}
+
+bool AHomeGenerator::StartAsyncGeneration(EHGAsyncTarget Target)
+{
+	check(IsInGameThread());
+	if(bGenerating)
+	{
+		//Running pregeneration : its result is used as soon as it is computed
+		if(AsyncTarget != EHGAsyncTarget::LayoutPool || Target == EHGAsyncTarget::LayoutPool || SlicedStage != EHGSlicedStage::None)
+			return false;
+
+		AsyncTarget = Target;
+		if(UHGLayoutPool * const LayoutPool = GetWorld()->GetSubsystem<UHGLayoutPool>())
+			LayoutPool->Remove(this);
+		return true;
+	}
+
+	AsyncTarget = Target;
+	if(Target != EHGAsyncTarget::LayoutPool)
+	{
+		const TSharedPtr<FHomeGenerationResult, ESPMode::ThreadSafe> PooledLayout = TakePooledLayout();
+		if(PooledLayout.IsValid())
+		{
+			bGenerating = true;
+			ReceiveAsyncResult(PooledLayout.ToSharedRef());
+			return true;
+		}
+	}
+
+	const TSharedRef<FHomeGenerationResult, ESPMode::ThreadSafe> Result = MakeShared<FHomeGenerationResult, ESPMode::ThreadSafe>();
+	PrepareGeneration(*Result);
+	bGenerating = true;
+	AsyncResult = Result;
+
+	const int32 Id = ++GenerationId;
+	const TWeakObjectPtr<AHomeGenerator> WeakThis(this);
+	GenerationTask = Async(EAsyncExecution::ThreadPool, [WeakThis, Result, Id] ()
+	{
+		//Only the result is used : the generator and its assets can be edited meanwhile
+		Result->Layout->ComputeCachedGeneration(*Result);
+		if(Result->Layout->bCancelGeneration)
+			return;
+
+		//Spawn step
+		AsyncTask(ENamedThreads::GameThread, [WeakThis, Result, Id] ()
+		{
+			AHomeGenerator * const Generator = WeakThis.Get();
+			if(Generator && Generator->bGenerating && Generator->GenerationId == Id && !Result->Layout->bCancelGeneration)
+				Generator->ReceiveAsyncResult(Result);
+		});
+	});
+	return true;
+}
+
+void AHomeGenerator::ReceiveAsyncResult(const TSharedRef<FHomeGenerationResult, ESPMode::ThreadSafe>& Result)
+{
+	check(IsInGameThread());
+	AsyncResult.Reset();
+	switch(AsyncTarget)
+	{
+		case EHGAsyncTarget::Spawn:
+			FinishGeneration(*Result);
+			break;
+
+		//The scheduler runs the spawn steps of the time sliced generation (the tick stays disabled)
+		case EHGAsyncTarget::Scheduler:
+			SlicedResult = Result;
+			SlicedStage = EHGSlicedStage::Apply;
+			bScheduledSpawn = true;
+			break;
+
+		//The layout stays in the result until it is spawned
+		case EHGAsyncTarget::LayoutPool:
+			bGenerating = false;
+			if(UHGLayoutPool * const LayoutPool = GetWorld()->GetSubsystem<UHGLayoutPool>())
+				LayoutPool->StoreLayout(this, Result);
+			break;
+	}
+}
+
+void AHomeGenerator::GenerateAsyncLatent(FLatentActionInfo LatentInfo)
+{
+	//Already running : waits for the current generation
+	GenerateAsync();
+
+	FLatentActionManager &LatentManager = GetWorld()->GetLatentActionManager();
+	if(LatentManager.FindExistingAction<FHomeGenerationLatentAction>(LatentInfo.CallbackTarget, LatentInfo.UUID) == nullptr)
+		LatentManager.AddNewAction(LatentInfo.CallbackTarget, LatentInfo.UUID, new FHomeGenerationLatentAction(this, LatentInfo));
+}
+
+void AHomeGenerator::CancelGeneration()
+{
+	if(SlicedStage != EHGSlicedStage::None)
+	{
+		SlicedStage = EHGSlicedStage::None;
+		SlicedResult.Reset();
+		SetActorTickEnabled(false);
+		bScheduledSpawn = false;
+		bGenerating = false;
+	}
+
+	if(!AsyncResult.IsValid())
+		return;
+
+	//The worker stops at its next stage : its result is dropped by the spawn step, which checks the generation id
+	AsyncResult->Layout->bCancelGeneration = true;
+	AsyncResult.Reset();
+	++GenerationId;
+	bGenerating = false;
+}
+
+bool AHomeGenerator::GenerateTimeSliced()
+{
+	check(IsInGameThread());
+	if(bGenerating)
+		return false;
+
+	SlicedResult = TakePooledLayout();
+	bGenerating = true;
+	SlicedStep = 0;
+	if(SlicedResult.IsValid())
+		SlicedStage = EHGSlicedStage::Apply;
+	else
+	{
+		SlicedResult = MakeShared<FHomeGenerationResult, ESPMode::ThreadSafe>();
+		PrepareGeneration(*SlicedResult);
+		++GenerationId;
+		SlicedStage = EHGSlicedStage::Building;
+	}
+	SetActorTickEnabled(true);
+	return true;
+}
+
+bool AHomeGenerator::AdvanceSlicedGeneration()
+{
+	check(SlicedResult.IsValid());
+	FHomeGenerationResult &Result = *SlicedResult;
+	FHGBuildingLayout &SlicedLayout = *Result.Layout;
+
+	switch(SlicedStage)
+	{
+		case EHGSlicedStage::Building:
+			//Cached layout : only the geometry remains
+			if(!SlicedLayout.LayoutCacheKey.IsEmpty() && SlicedLayout.ReadCachedLayout(Result))
+			{
+				Result.ShellSections.SetNum(2 * (SlicedLayout.BuildingConstraints.Levels + 1));
+				SlicedStage = EHGSlicedStage::Shell;
+				SlicedStep = 0;
+				break;
+			}
+			SlicedLayout.DefineBuilding();
+			SlicedLayout.BeginRoomsDivision(Result.Division);
+			SlicedStage = EHGSlicedStage::Division;
+			SlicedStep = 0;
+			break;
+
+		//One level per step
+		case EHGSlicedStage::Division:
+			if(SlicedStep < SlicedLayout.GetDividedLevels())
+			{
+				if(SlicedLayout.bApartmentBlock)
+					SlicedLayout.DivideUnits(SlicedStep, 1, Result.Division);
+				else
+					SlicedLayout.DivideSurface(SlicedStep, Result.Division.LevelsOrganisation[SlicedStep], Result.Division.NodesToDelete);
+				++SlicedStep;
+			}
+			else
+				SlicedStage = EHGSlicedStage::Surface;
+			break;
+
+		case EHGSlicedStage::Surface:
+			SlicedLayout.EndRoomsDivision(Result.Division);
+			SlicedLayout.PlaceDoorsAndWindows();
+			Result.ShellSections.SetNum(2 * (SlicedLayout.BuildingConstraints.Levels + 1));
+			SlicedStage = EHGSlicedStage::Shell;
+			SlicedStep = 0;
+			break;
+
+		//One level (and the roof) per step
+		case EHGSlicedStage::Shell:
+			SlicedLayout.BuildShellLevel(SlicedStep, Result);
+			if(++SlicedStep > SlicedLayout.BuildingConstraints.Levels)
+				SlicedStage = EHGSlicedStage::Decoration;
+			break;
+
+		case EHGSlicedStage::Decoration:
+			SlicedLayout.DecorateRooms(Result);
+			SlicedStage = SlicedLayout.bStreamFurniture || Result.bCached ? EHGSlicedStage::Apply : EHGSlicedStage::Furniture;
+			SlicedRoom = FIntPoint::ZeroValue;
+			break;
+
+		//One room per step
+		case EHGSlicedStage::Furniture:
+			if(SlicedRoom.X >= SlicedLayout.GetDividedLevels())
+				SlicedStage = EHGSlicedStage::Apply;
+			else if(!SlicedLayout.RoomBlocks[SlicedRoom.X].IsValidIndex(SlicedRoom.Y))
+				SlicedRoom = FIntPoint(SlicedRoom.X + 1, 0);
+			else
+			{
+				const FRoomBlock &RoomBlock = SlicedLayout.RoomBlocks[SlicedRoom.X][SlicedRoom.Y];
+				SlicedLayout.GenerateRoom(RoomBlock.RoomType, RoomBlock, Result.SpawnBuffer);
+				++SlicedRoom.Y;
+			}
+			break;
+
+		case EHGSlicedStage::Apply:
+			//Before the furniture added by the player
+			if(!SlicedLayout.LayoutCacheKey.IsEmpty() && !Result.bCached)
+				SlicedLayout.WriteCachedLayout(Result);
+			Layout = Result.Layout;
+			MeshCatalog = Layout->MeshCatalog;
+			bGenerationSpawned = true;
+			ApplyShell(Result);
+			ApplyDecoration(Result);
+			SpawnWindows();
+			if(!Layout->bStreamFurniture)
+				RecordAddedFurniture(Result.SpawnBuffer);
+			SlicedStage = EHGSlicedStage::Spawn;
+			SlicedStep = 0;
+			break;
+
+		//A few rooms per step
+		case EHGSlicedStage::Spawn:
+			if(Layout->bStreamFurniture)
+				FurnishBuilding(Result.SpawnBuffer);
+			else if(SlicedStep < Result.SpawnBuffer.Num())
+			{
+				SlicedStep += SpawnSlicedCommands(Result.SpawnBuffer, SlicedStep);
+				break;
+			}
+
+			SlicedStage = EHGSlicedStage::None;
+			SlicedResult.Reset();
+			bScheduledSpawn = false;
+			bGenerating = false;
+			OnGenerationCompleted.Broadcast(this);
+			return false;
+
+		case EHGSlicedStage::None:
+		default:
+			return false;
+	}
+	return true;
+}
+
+int32 AHomeGenerator::SpawnSlicedCommands(const FFurnitureSpawnBuffer& SpawnBuffer, int32 FirstCommand)
+{
+	//The commands of a room are contiguous : the room's proxy needs all of them at once
+	FFurnitureSpawnBuffer Slice;
+	int32 CommandIndex = FirstCommand;
+	while(CommandIndex < SpawnBuffer.Num())
+	{
+		const FFurnitureSpawnCommand &Command = SpawnBuffer.Commands[CommandIndex];
+		if(Slice.Num() >= TimeSliceSpawnCount && (Command.Level != Slice.Commands.Last().Level || Command.RoomIndex != Slice.Commands.Last().RoomIndex))
+			break;
+
+		Slice.Commands.Push(Command);
+		++CommandIndex;
+	}
+
+	ExecuteSpawnCommands(Slice);
+	return Slice.Num();
+}
+
+bool AHomeGenerator::IsGenerating() const
+{
+	return bGenerating;
+}
+
+bool AHomeGenerator::IsWaitingForSpawn() const
+{
+	return bScheduledSpawn && SlicedStage != EHGSlicedStage::None;
+}
+
+FSphere AHomeGenerator::GetGenerationBounds() const
+{
+	//The building grows from the actor's location along X and Y
+	const float Side = BuildingConstraints.MaxSideFloorLength * BuildingConstraints.GridSnapLength;
+	return FSphere(GetActorTransform().TransformPosition(FVector(Side / 2.f, Side / 2.f, 0.f)), Side * FMath::Sqrt(2.f) / 2.f);
+}
+
+void AHomeGenerator::PrepareGeneration(FHomeGenerationResult& Result)
+{
+	check(IsInGameThread());
+	check(BuildingConstraints.GridSnapLength > 0.f)
+
+	//Previous generation goes back to the pool
+	ClearGeneration();
+
+	//Deltas of another building (the clients get the deltas of the server)
+	if(HasAuthority() && FurnitureDeltas.Num() > 0 && (Seed != DeltasSeed || GetParametersHash() != DeltasParametersHash))
+		FurnitureDeltas.Reset();
+
+	//The clients rebuild the same building (see OnRep_ReplicatedGeneration)
+	if(HasAuthority() && GetNetMode() != NM_Standalone)
+	{
+		ReplicatedGeneration.Seed = Seed;
+		ReplicatedGeneration.ParametersHash = GetParametersHash();
+		UpdateReplicatedDeltas();
+	}
+
+	//Everything the computation reads, copied once : the worker never reads the generator or the assets
+	Result.Layout = MakeShared<FHGBuildingLayout, ESPMode::ThreadSafe>();
+	FHGBuildingLayout &Parameters = *Result.Layout;
+	Parameters.GeneratorName = GetName();
+	Parameters.Inhabitants = Inhabitants;
+	Parameters.Seed = Seed;
+	Parameters.bApartmentBlock = bApartmentBlock;
+	Parameters.MaxUnitAttempts = MaxUnitAttempts;
+	Parameters.bTypicalFloors = bTypicalFloors;
+	Parameters.TypicalFloorStart = TypicalFloorStart;
+	Parameters.BuildingConstraints = BuildingConstraints.ToCore();
+	Parameters.RoomsDivisionConstraints = RoomsDivisionConstraints.ToCore();
+	for(const auto &Room : Rooms)
+	{
+		Parameters.Rooms.Add(Room.Key, Room.Value.ToCore());
+		Parameters.RoomDecorations.Add(Room.Key, Room.Value.DecorationClass);
+	}
+	Parameters.bStreamFurniture = bStreamFurniture;
+	Parameters.ShellUVLength = ShellUVLength;
+	Parameters.DecorationInset = DecorationInset;
+	Parameters.LayoutCacheMaxSize = LayoutCacheMaxSize;
+
+	//Catalog of all the furniture meshes, with their footprint for the grid snap length : the generation and the spawn commands only know their id in it
+	Parameters.Stairs = Parameters.AddCatalogFurniture(Stairs);
+	Parameters.Doors = Parameters.AddCatalogFurniture(Doors);
+	for(const auto &_Furniture : Furniture)
+		Parameters.Furniture.Add(_Furniture.Key, Parameters.AddCatalogFurniture(_Furniture.Value));
+	Parameters.Windows = Parameters.AddCatalogWindows(Windows);
+	MeshCatalog = Parameters.MeshCatalog;
+
+	Parameters.ComputeSides();
+
+	//Needs the mesh catalog
+	Parameters.LayoutCacheKey = bUseLayoutCache ? ComputeLayoutKey() : FString();
+}
+
+void AHomeGenerator::FinishGeneration(FHomeGenerationResult& Result)
+{
+	QUICK_SCOPE_CYCLE_COUNTER(STAT_HomeGenerator_FinishGeneration);
+	check(IsInGameThread());
+
+	//The layout of the spawned generation is then only used by the game thread
+	Layout = Result.Layout;
+	MeshCatalog = Layout->MeshCatalog;
+
+	bGenerating = false;
+	bGenerationSpawned = true;
+	ApplyShell(Result);
+	ApplyDecoration(Result);
+	SpawnWindows();
+	if(!Layout->bStreamFurniture)
+		RecordAddedFurniture(Result.SpawnBuffer);
+	FurnishBuilding(Result.SpawnBuffer);
+
+	OnGenerationCompleted.Broadcast(this);
+}
+
+bool AHomeGenerator::SaveLayout(const FString& Filename)
+{
+	QUICK_SCOPE_CYCLE_COUNTER(STAT_HomeGenerator_SaveLayout);
+	check(IsInGameThread());
+
+	//The layout must be complete and not modified by a running generation
+	if(bGenerating || !bGenerationSpawned || Layout->RoomBlocks.Num() != Layout->BuildingConstraints.Levels)
+		return false;
+
+	//The placement only depends on the seed and the layout : same commands as the spawned ones
+	FFurnitureSpawnBuffer SpawnBuffer;
+	Layout->RecordFurniture(SpawnBuffer);
+
+	TArray<uint8> Bytes;
+	Layout->WriteLayout(SpawnBuffer, Bytes);
+	if(!FFileHelper::SaveArrayToFile(Bytes, *Filename))
+	{
+		UE_LOG(LogHomeGeneration, Warning, TEXT("Can't write the layout file %s."), *Filename);
+		return false;
+	}
+	return true;
+}
+
+bool AHomeGenerator::LoadLayout(const FString& Filename)
+{
+	QUICK_SCOPE_CYCLE_COUNTER(STAT_HomeGenerator_LoadLayout);
+	check(IsInGameThread());
+
+	FHGLayoutFile File;
+	if(!File.Open(Filename))
+		return false;
+
+	CancelGeneration();
+	FHomeGenerationResult Result;
+	PrepareGeneration(Result);
+	++GenerationId;
+
+	FHGBuildingLayout &LoadedLayout = *Result.Layout;
+	if(!LoadedLayout.ReadLayout(File.GetView(), Result.SpawnBuffer))
+	{
+		UE_LOG(LogHomeGeneration, Warning, TEXT("The layout file %s doesn't match the generator %s."), *Filename, *GetName());
+		return false;
+	}
+
+	//Doors are already placed : only the windows and the geometry are computed
+	LoadedLayout.PlaceWindows();
+	LoadedLayout.BuildShell(Result);
+	LoadedLayout.DecorateRooms(Result);
+
+	bGenerating = true;
+	FinishGeneration(Result);
+	return true;
+}
+
+#if WITH_EDITOR
+void AHomeGenerator::BakeBuilding()
+{
+	UWorld * const World = GetWorld();
+	if(World == nullptr)
+		return;
+
+	//Everything is spawned at once, as instances or actors
+	{
+		TGuardValue<bool> StreamGuard(bStreamFurniture, false);
+		TGuardValue<bool> ProxyGuard(bMergeRoomProxies, false);
+		Generate();
+	}
+	if(!bGenerationSpawned)
+		return;
+
+	FActorSpawnParameters SpawnParameters;
+	SpawnParameters.OverrideLevel = GetLevel();
+	AHGBakedBuilding * const BakedBuilding = World->SpawnActor<AHGBakedBuilding>(AHGBakedBuilding::StaticClass(), GetActorTransform(), SpawnParameters);
+	if(BakedBuilding == nullptr)
+		return;
+	BakedBuilding->SetActorLabel(GetActorLabel() + TEXT("_Baked"));
+
+	TArray<UProceduralMeshComponent *> ShellComponents;
+	if(IsValid(ShellComponent))
+		ShellComponents.Push(ShellComponent);
+	if(IsValid(DecorationComponent))
+		ShellComponents.Push(DecorationComponent);
+	BakedBuilding->BakeShell(ShellComponents);
+
+	//Instances are relative to the generator, so to the baked building
+	TMap<UStaticMesh *, TArray<FTransform>> Instances;
+	auto AddComponentInstances = [&Instances] (const UInstancedStaticMeshComponent *Component)
+	{
+		TArray<FTransform> &Transforms = Instances.FindOrAdd(Component->GetStaticMesh());
+		for(int32 InstanceIndex = 0; InstanceIndex < Component->GetInstanceCount(); ++InstanceIndex)
+			Component->GetInstanceTransform(InstanceIndex, Transforms.AddDefaulted_GetRef(), false);
+	};
+	if(IsValid(WindowComponent))
+		AddComponentInstances(WindowComponent);
+	for(const auto &Group : FurnitureInstances)
+		if(IsValid(Group.Value.Component))
+			AddComponentInstances(Group.Value.Component);
+
+	//Static mesh actors become instances, the others are kept as they are
+	for(AActor *GeneratedActor : GeneratedActors)
+	{
+		if(!IsValid(GeneratedActor))
+			continue;
+
+		const AStaticMeshActor * const MeshActor = Cast<AStaticMeshActor>(GeneratedActor);
+		if(MeshActor && MeshActor->GetClass() == AStaticMeshActor::StaticClass())
+		{
+			Instances.FindOrAdd(MeshActor->GetStaticMeshComponent()->GetStaticMesh()).Push(MeshActor->GetActorTransform().GetRelativeTransform(GetActorTransform()));
+			GeneratedActor->Destroy();
+			continue;
+		}
+
+		GeneratedActor->DetachFromActor(FDetachmentTransformRules::KeepWorldTransform);
+		BakedBuilding->FurnitureActors.Push(GeneratedActor);
+	}
+	GeneratedActors.Reset();
+
+	for(const auto &MeshInstances : Instances)
+		BakedBuilding->AddInstances(MeshInstances.Key, MeshInstances.Value);
+
+	ClearGeneration();
+	if(IsValid(ShellComponent))
+		ShellComponent->ClearAllMeshSections();
+	if(IsValid(DecorationComponent))
+		DecorationComponent->ClearAllMeshSections();
+	if(IsValid(WindowComponent))
+		WindowComponent->ClearInstances();
+	BakedBuilding->MarkPackageDirty();
+}
+#endif
+
+void AHomeGenerator::SpawnWindows()
+{
+	if(IsValid(WindowComponent))
+		WindowComponent->ClearInstances();
+	if(Layout->WindowPlacements.Num() == 0 || !IsValid(Layout->WindowCatalog[Layout->SelectedWindow]->Mesh))
+		return;
+
+	//All the windows of the building are instances of one component
+	if(!IsValid(WindowComponent))
+	{
+		WindowComponent = NewObject<UHierarchicalInstancedStaticMeshComponent>(this);
+		WindowComponent->SetupAttachment(RootComponent);
+		WindowComponent->RegisterComponent();
+		AddInstanceComponent(WindowComponent);
+	}
+	WindowComponent->SetStaticMesh(Layout->WindowCatalog[Layout->SelectedWindow]->Mesh);
+
+	//Exterior face of the mesh turned to the exterior side of the wall
+	const FHGWindowDescriptor &WindowDescriptor = Layout->CatalogWindows[Layout->SelectedWindow].Descriptor;
+	const auto AxeYaw = [] (EHGAxe Axe) -> float {
+		switch(Axe)
+		{
+			case EHGAxe::Y_UP: return 90.f;
+			case EHGAxe::X_DOWN: return 180.f;
+			case EHGAxe::Y_DOWN: return 270.f;
+			default: return 0.f;
+		}
+	};
+	const FMeshFootprint &Footprint = Layout->WindowFootprints[Layout->SelectedWindow];
+	const FVector BottomCenter(Footprint.BoundsOrigin.X, Footprint.BoundsOrigin.Y, Footprint.BoundsOrigin.Z - Footprint.BoxExtent.Z);
+
+	TArray<FTransform> Transforms;
+	Transforms.Reserve(Layout->WindowPlacements.Num());
+	for(const FWindowPlacement &Window : Layout->WindowPlacements)
+	{
+		const FQuat Rotation = FRotator(0.f, AxeYaw(Window.Side) - AxeYaw(WindowDescriptor.ExteriorFace), 0.f).Quaternion();
+		const FVector Location(Window.Center, Window.Level * (Layout->BuildingConstraints.FloorHeight + Layout->BuildingConstraints.FloorWidth) + Layout->WindowBottom);
+		Transforms.Push(FTransform(Rotation, Location - Rotation.RotateVector(BottomCenter)));
+	}
+	WindowComponent->AddInstances(Transforms, false);
+}
+
+void AHomeGenerator::ApplyShell(const FHomeGenerationResult& Result)
+{
+	if(!IsValid(ShellComponent))
+	{
+		ShellComponent = NewObject<UProceduralMeshComponent>(this);
+		ShellComponent->SetupAttachment(RootComponent);
+		ShellComponent->RegisterComponent();
+		AddInstanceComponent(ShellComponent);
+	}
+	ShellComponent->ClearAllMeshSections();
+
+	for(int32 SectionIndex = 0; SectionIndex < Result.ShellSections.Num(); ++SectionIndex)
+	{
+		const FHGMeshSection &Section = Result.ShellSections[SectionIndex];
+		if(Section.IsEmpty())
+			continue;
+
+		ShellComponent->CreateMeshSection_LinearColor(SectionIndex, Section.Vertices, Section.Triangles, Section.Normals, Section.UVs, Section.Colors, Section.Tangents, true);
+		ShellComponent->SetMaterial(SectionIndex, SectionIndex % 2 == 0 ? ShellWallMaterial : ShellFloorMaterial);
+	}
+}
+
+void AHomeGenerator::ApplyDecoration(FHomeGenerationResult& Result)
+{
+	if(!IsValid(DecorationComponent))
+	{
+		DecorationComponent = NewObject<UProceduralMeshComponent>(this);
+		DecorationComponent->SetupAttachment(RootComponent);
+		DecorationComponent->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+		DecorationComponent->RegisterComponent();
+		AddInstanceComponent(DecorationComponent);
+	}
+	DecorationComponent->ClearAllMeshSections();
+
+	UHGDecorationCache *Cache = GetWorld()->GetSubsystem<UHGDecorationCache>();
+	check(Cache);
+
+	//Same material for all the rooms of the same type : one section each
+	int32 SectionIndex = 0;
+	for(FHGDecorationBatch &Batch : Result.DecorationBatches)
+	{
+		UMaterialInterface * const Material = Cache->GetDecoration(Batch.DecorationClass, Batch.RoomType).GetMaterial(Batch.Surface);
+		FHGMeshSection &Geometry = Batch.Geometry;
+		if(!Material || Geometry.IsEmpty())
+			continue;
+
+		//The variation of each room is stored in its vertices
+		const UDecoBase * const Decoration = Cache->GetDecorationObject(Batch.DecorationClass);
+		for(int32 RoomIndex = 0; RoomIndex < Batch.RoomVertices.Num(); ++RoomIndex)
+		{
+			const FLinearColor Variation = Decoration->GetRoomVariation(Batch.RoomType, Batch.RoomVertices[RoomIndex].Key);
+			const int32 LastVertex = RoomIndex + 1 < Batch.RoomVertices.Num() ? Batch.RoomVertices[RoomIndex + 1].Value : Geometry.Colors.Num();
+			for(int32 Vertex = Batch.RoomVertices[RoomIndex].Value; Vertex < LastVertex; ++Vertex)
+				Geometry.Colors[Vertex] = Variation;
+		}
+
+		DecorationComponent->CreateMeshSection_LinearColor(SectionIndex, Geometry.Vertices, Geometry.Triangles, Geometry.Normals, Geometry.UVs, Geometry.Colors, Geometry.Tangents, false);
+		DecorationComponent->SetMaterial(SectionIndex, Material);
+		++SectionIndex;
+	}
+}
+
+void AHomeGenerator::FurnishBuilding(const FFurnitureSpawnBuffer& SpawnBuffer)
+{
+	check(Layout->RoomBlocks.Num() == Layout->BuildingConstraints.Levels)
+
+	//Streaming mode : the rooms are furnished by UpdateStreamedRooms
+	if(Layout->bStreamFurniture)
+	{
+		for(const auto &LevelRooms : Layout->RoomBlocks)
+			for(const FRoomBlock &RoomBlock : LevelRooms)
+				StreamedRooms.Add(FIntPoint(RoomBlock.Level, RoomBlock.Index));
+
+		UpdateStreamedRooms();
+		GetWorldTimerManager().SetTimer(StreamingTimer, this, &AHomeGenerator::UpdateStreamedRooms, StreamingUpdateInterval, true);
+		return;
+	}
+
+	//Spawn step : everything at once
+	ExecuteSpawnCommands(SpawnBuffer);
+}
+
+namespace
+{
+	FHGFurnitureId MakeFurnitureId(const FFurnitureSpawnCommand &Command)
+	{
+		FHGFurnitureId Id;
+		Id.Level = Command.Level;
+		Id.RoomIndex = Command.RoomIndex;
+		Id.Index = Command.Index;
+		return Id;
+	}
+
+	FHGFurnitureId MakeFurnitureId(const FFurnitureInstanceInfo &Info)
+	{
+		FHGFurnitureId Id;
+		Id.Level = Info.Level;
+		Id.RoomIndex = Info.RoomIndex;
+		Id.Index = Info.FurnitureIndex;
+		return Id;
+	}
+}
+
+int32 AHomeGenerator::GetParametersHash() const
+{
+	FString Text;
+	ExportParameters(Text);
+	return static_cast<int32>(FCrc::StrCrc32(*Text));
+}
+
+void AHomeGenerator::ExportParameters(FString& Text) const
+{
+	//Properties copied in the generation parameters (see PrepareGeneration), except the seed : materials, instancing or the furniture streaming don't change the building
+	static const FName ParameterNames[] = {
+		GET_MEMBER_NAME_CHECKED(AHomeGenerator, Inhabitants),
+		GET_MEMBER_NAME_CHECKED(AHomeGenerator, bApartmentBlock),
+		GET_MEMBER_NAME_CHECKED(AHomeGenerator, MaxUnitAttempts),
+		GET_MEMBER_NAME_CHECKED(AHomeGenerator, bTypicalFloors),
+		GET_MEMBER_NAME_CHECKED(AHomeGenerator, TypicalFloorStart),
+		GET_MEMBER_NAME_CHECKED(AHomeGenerator, BuildingConstraints),
+		GET_MEMBER_NAME_CHECKED(AHomeGenerator, Stairs),
+		GET_MEMBER_NAME_CHECKED(AHomeGenerator, Doors),
+		GET_MEMBER_NAME_CHECKED(AHomeGenerator, Windows),
+		GET_MEMBER_NAME_CHECKED(AHomeGenerator, Rooms),
+		GET_MEMBER_NAME_CHECKED(AHomeGenerator, RoomsDivisionConstraints),
+		GET_MEMBER_NAME_CHECKED(AHomeGenerator, Furniture),
+		GET_MEMBER_NAME_CHECKED(AHomeGenerator, ShellUVLength),
+		GET_MEMBER_NAME_CHECKED(AHomeGenerator, DecorationInset)
+	};
+
+	for(const FName &Name : ParameterNames)
+	{
+		const FProperty * const Property = FindFProperty<FProperty>(AHomeGenerator::StaticClass(), Name);
+		check(Property)
+
+		FString Value;
+		Property->ExportTextItem(Value, Property->ContainerPtrToValuePtr<void>(this), nullptr, nullptr, PPF_None);
+		Text += Property->GetName() + TEXT("=") + Value + TEXT("\n");
+	}
+}
+
+FString AHomeGenerator::ComputeLayoutKey() const
+{
+	QUICK_SCOPE_CYCLE_COUNTER(STAT_HomeGenerator_ComputeLayoutKey);
+
+	FString Text = FString::Printf(TEXT("%d %d %d\n"), HGLayoutFile::Version, HGLayoutCache::GeneratorVersion, Seed);
+	ExportParameters(Text);
+
+	//The assets can be edited without changing the parameters : their hash is kept by the assets
+	for(const UFurnitureMeshAsset * const MeshAsset : MeshCatalog)
+		if(MeshAsset)
+			Text += MeshAsset->GetPathName() + TEXT("=") + MeshAsset->GetLayoutHash() + TEXT("\n");
+	for(const UWindowMeshAsset * const WindowAsset : Windows.Mesh)
+		if(WindowAsset)
+			Text += WindowAsset->GetPathName() + TEXT("=") + WindowAsset->GetLayoutHash() + TEXT("\n");
+
+	FSHAHash Hash;
+	FSHA1::HashBuffer(*Text, Text.Len() * sizeof(TCHAR), Hash.Hash);
+	return Hash.ToString();
+}
+
+void AHomeGenerator::SaveGeneration(FHomeGenerationSave& Save) const
+{
+	Save.ParametersHash = GetParametersHash();
+	Save.Seed = Seed;
+	FurnitureDeltas.GenerateValueArray(Save.Deltas);
+}
+
+bool AHomeGenerator::LoadGeneration(const FHomeGenerationSave& Save)
+{
+	check(IsInGameThread());
+
+	const bool bSameParameters = Save.ParametersHash == GetParametersHash();
+	if(!bSameParameters)
+		UE_LOG(LogHomeGeneration, Warning, TEXT("The parameters of %s have changed since the save : its furniture modifications are lost."), *GetName());
+
+	Seed = Save.Seed;
+	FurnitureDeltas.Reset();
+	if(bSameParameters)
+	{
+		DeltasParametersHash = Save.ParametersHash;
+		DeltasSeed = Save.Seed;
+		for(const FHGFurnitureDelta &Delta : Save.Deltas)
+			FurnitureDeltas.Add(Delta.Id, Delta);
+	}
+
+	Generate();
+	return bSameParameters;
+}
+
+bool AHomeGenerator::GetFurnitureId(const UPrimitiveComponent* Component, int32 InstanceIndex, FHGFurnitureId& Id) const
+{
+	if(Component == nullptr)
+		return false;
+
+	FFurnitureInstanceInfo Info;
+	if(const UInstancedStaticMeshComponent * const InstanceComponent = Cast<UInstancedStaticMeshComponent>(Component))
+	{
+		if(!GetFurnitureInstanceInfo(InstanceComponent, InstanceIndex, Info))
+			return false;
+
+		Id.Level = Info.Level;
+		Id.RoomIndex = Info.RoomIndex;
+		Id.Index = Info.FurnitureIndex;
+	}
+	else
+	{
+		const FHGFurnitureId * const ActorId = FurnitureActorIds.FindKey(Component->GetOwner());
+		if(ActorId == nullptr)
+			return false;
+		Id = *ActorId;
+	}
+
+	//The instances of the removed furniture are removed too : only their delta remains
+	const FHGFurnitureDelta * const Delta = FurnitureDeltas.Find(Id);
+	return Delta == nullptr || Delta->Type != EHGFurnitureDeltaType::Removed;
+}
+
+bool AHomeGenerator::RemoveFurniture(const FHGFurnitureId& Id)
+{
+	const FHGFurnitureDelta * const Delta = FurnitureDeltas.Find(Id);
+	if(!bGenerationSpawned || Id.Index == INDEX_NONE || Delta && Delta->Type == EHGFurnitureDeltaType::Removed || Id.Index < 0 && Delta == nullptr)
+		return false;
+
+	//A furniture added by the gameplay is simply forgotten
+	if(Id.Index < 0)
+	{
+		FurnitureDeltas.Remove(Id);
+		UpdateReplicatedDeltas();
+	}
+	else
+	{
+		FHGFurnitureDelta Removed;
+		Removed.Type = EHGFurnitureDeltaType::Removed;
+		Removed.Id = Id;
+		SetFurnitureDelta(Removed);
+	}
+	UpdateSpawnedFurniture(Id);
+	return true;
+}
+
+bool AHomeGenerator::MoveFurniture(const FHGFurnitureId& Id, const FTransform& WorldTransform)
+{
+	const FHGFurnitureDelta * const Delta = FurnitureDeltas.Find(Id);
+	if(!bGenerationSpawned || Id.Index == INDEX_NONE || Delta && Delta->Type == EHGFurnitureDeltaType::Removed || Id.Index < 0 && Delta == nullptr)
+		return false;
+
+	FHGFurnitureDelta Moved = Delta ? *Delta : FHGFurnitureDelta();
+	Moved.Type = Delta ? Delta->Type : EHGFurnitureDeltaType::Moved;
+	Moved.Id = Id;
+	Moved.Transform = WorldTransform.GetRelativeTransform(GetActorTransform());
+	SetFurnitureDelta(Moved);
+	UpdateSpawnedFurniture(Id);
+	return true;
+}
 
-void FRoomsDivisionConstraints::CalculateAllSides(const int _BasicMinimalSide, const int _BasicAverageSide, const int _BasicMaximalSide)
+bool AHomeGenerator::AddFurniture(UFurnitureMeshAsset* MeshAsset, const FTransform& WorldTransform, int32 Level, int32 RoomIndex, FName FurnitureType, FHGFurnitureId& Id)
 {
-	ABSMinimalSide = FMath::CeilToInt(MinSideCoef * _BasicMinimalSide);
-	StopSplitSide = FMath::CeilToInt(StopSplitCoef * _BasicAverageSide);
-	SufficientSide = FMath::CeilToInt(SufficientChunkCoef * _BasicMaximalSide);
+	if(!bGenerationSpawned || MeshAsset == nullptr || !Layout->RoomBlocks.IsValidIndex(Level) || !Layout->RoomBlocks[Level].IsValidIndex(RoomIndex))
+		return false;
+
+	//Negative indices, after the furniture already added in the room
+	Id.Level = Level;
+	Id.RoomIndex = RoomIndex;
+	Id.Index = -1;
+	for(const auto &Delta : FurnitureDeltas)
+		if(Delta.Key.Level == Level && Delta.Key.RoomIndex == RoomIndex)
+			Id.Index = FMath::Min(Id.Index, Delta.Key.Index - 1);
+
+	FHGFurnitureDelta Added;
+	Added.Type = EHGFurnitureDeltaType::Added;
+	Added.Id = Id;
+	Added.Transform = WorldTransform.GetRelativeTransform(GetActorTransform());
+	Added.Mesh = MeshAsset;
+	Added.FurnitureType = FurnitureType;
+	SetFurnitureDelta(Added);
+	SpawnAddedFurniture(Added);
+	return true;
 }
 
-int FRoom::CalculateMinimalSide(TMap<FName, FFurniture> &FurnitureMapping)
+void AHomeGenerator::SpawnAddedFurniture(const FHGFurnitureDelta& Added)
 {
-	int NeededArea = 0;
-	for(const auto FurnitureType : Furniture)
+	const int32 Level = Added.Id.Level;
+	const int32 RoomIndex = Added.Id.RoomIndex;
+	FFurnitureSpawnBuffer AddedBuffer;
+	if(!MakeAddedCommand(Added, AddedBuffer.Commands.AddDefaulted_GetRef()))
+		return;
+
+	//Streaming mode : spawned with its room
+	FRoomStreamingState * const State = StreamedRooms.Find(FIntPoint(Level, RoomIndex));
+	if(Layout->bStreamFurniture)
 	{
-		FFurniture &_Furniture = FurnitureMapping[FurnitureType];
-		NeededArea += _Furniture.GetAverageArea();
+		if(State && State->bRecorded)
+			State->Commands.Append(AddedBuffer);
+		if(State == nullptr || !State->bFurnished)
+			return;
 	}
-	MinRoomSide = FMath::CeilToInt(FMath::Sqrt(NeededArea));
 
-	return MinRoomSide;
+	const int32 FirstActor = GeneratedActors.Num();
+	ReleaseRoomProxy(FIntPoint(Level, RoomIndex));
+	ExecuteSpawnCommands(AddedBuffer);
+	if(Layout->bStreamFurniture)
+		for(int32 ActorIndex = FirstActor; ActorIndex < GeneratedActors.Num(); ++ActorIndex)
+			State->Actors.Push(GeneratedActors[ActorIndex]);
 }
 
-int FRoom::GetMinimalSide() const
+void AHomeGenerator::ClearFurnitureDeltas()
 {
-	return MinRoomSide;
+	FurnitureDeltas.Reset();
+	UpdateReplicatedDeltas();
 }
 
-int FFurniture::GetAverageArea()
+void AHomeGenerator::SetFurnitureDelta(const FHGFurnitureDelta& Delta)
 {
-	if(AverageArea == 0) //If not already calculated, calculate it
+	if(FurnitureDeltas.Num() == 0)
 	{
-		int Sum = 0;
-		for(const UFurnitureMeshAsset * const MeshObj : Mesh)
-			Sum += MeshObj->GetArea(*this);
+		DeltasParametersHash = GetParametersHash();
+		DeltasSeed = Seed;
+	}
+	FurnitureDeltas.Add(Delta.Id, Delta);
+	UpdateReplicatedDeltas();
+}
 
-		// ENH: Floor/Ceil is important there ?
-		AverageArea =  Sum / Mesh.Num();
+void AHomeGenerator::OnRep_ReplicatedGeneration()
+{
+	if(ReplicatedGeneration.ParametersHash != GetParametersHash())
+	{
+		UE_LOG(LogHomeGeneration, Warning, TEXT("The parameters of %s differ from the server's : its building can't be rebuilt from the seed."), *GetName());
+		return;
 	}
 
-	return AverageArea;
+	//Already generated by the client itself
+	if(Seed == ReplicatedGeneration.Seed && (bGenerating || bGenerationSpawned))
+		return;
+
+	UE_LOG(LogHomeGeneration, Log, TEXT("Generating %s from the seed %d of the server."), *GetName(), ReplicatedGeneration.Seed);
+
+	//The running computation isn't waited for (its result is dropped) : the seed can be changed at once, the worker only reads its parameters snapshot
+	CancelGeneration();
+	Seed = ReplicatedGeneration.Seed;
+	GenerateAsync();
 }
 
-// Sets default values
-AHomeGenerator::AHomeGenerator()
+void AHomeGenerator::OnRep_ReplicatedDeltas()
 {
-	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
-	PrimaryActorTick.bCanEverTick = true;
+	TMap<FHGFurnitureId, FHGFurnitureDelta> PreviousDeltas = MoveTemp(FurnitureDeltas);
+	FurnitureDeltas.Reset();
+	for(const FHGFurnitureDelta &Delta : ReplicatedDeltas)
+		FurnitureDeltas.Add(Delta.Id, Delta);
+	DeltasParametersHash = ReplicatedGeneration.ParametersHash;
+	DeltasSeed = ReplicatedGeneration.Seed;
+
+	//Else applied when the building is spawned
+	if(!bGenerationSpawned || Seed != ReplicatedGeneration.Seed)
+		return;
+
+	for(const auto &Delta : FurnitureDeltas)
+	{
+		const FHGFurnitureDelta * const Previous = PreviousDeltas.Find(Delta.Key);
+		if(Previous && Previous->Type == Delta.Value.Type && Previous->Transform.Equals(Delta.Value.Transform))
+			continue;
+
+		if(Previous == nullptr && Delta.Value.Type == EHGFurnitureDeltaType::Added)
+			SpawnAddedFurniture(Delta.Value);
+		else
+			UpdateSpawnedFurniture(Delta.Key);
+	}
+
+	//Furniture added, then removed by the server (the other deltas are only forgotten at the next generation)
+	for(const auto &Previous : PreviousDeltas)
+		if(Previous.Key.Index < 0 && !FurnitureDeltas.Contains(Previous.Key))
+			UpdateSpawnedFurniture(Previous.Key);
 }
 
-// Called when the game starts or when spawned
-void AHomeGenerator::BeginPlay()
+void AHomeGenerator::OnRep_ReplicatedFurniture()
 {
-	Super::BeginPlay();
-	
+	UpdateReplicatedFurniture();
+}
+
+void AHomeGenerator::UpdateReplicatedDeltas()
+{
+	if(!HasAuthority() || GetNetMode() == NM_Standalone)
+		return;
+
+	FurnitureDeltas.GenerateValueArray(ReplicatedDeltas);
+	ForceNetUpdate();
 }
 
-void AHomeGenerator::ComputeSides()
+void AHomeGenerator::UpdateReplicatedFurniture()
 {
-	int MinimalSide = INT_MAX;
-	int MaximalSide = 0;
-	int AverageSide = 0;
-	BuildingConstraints.NormalRoomQuantity = 0;
-	
-	for(auto Room : Rooms)
+	if(GetNetMode() == NM_Standalone)
+		return;
+
+	if(HasAuthority())
 	{
-		const int Quantity = FMath::CeilToInt(Room.Value.NumPerHab * Inhabitants);
-		BuildingConstraints.NormalRoomQuantity += Quantity;
-		
-		if(Room.Value.CalculateMinimalSide(Furniture) > 0 && Quantity > 0)
+		ReplicatedFurniture.Reset();
+		for(const auto &FurnitureActor : FurnitureActorIds)
 		{
-			if(Room.Value.GetMinimalSide() < MinimalSide)
-				MinimalSide = Room.Value.GetMinimalSide();
-			if(Room.Value.GetMinimalSide() > MaximalSide)
-				MaximalSide = Room.Value.GetMinimalSide();
-			
-			AverageSide += Quantity * Room.Value.GetMinimalSide();
+			if(!IsValid(FurnitureActor.Value) || !FurnitureActor.Value->GetIsReplicated())
+				continue;
+
+			FHGReplicatedFurniture &Furniture = ReplicatedFurniture.AddDefaulted_GetRef();
+			Furniture.Id = FurnitureActor.Key;
+			Furniture.Actor = FurnitureActor.Value;
 		}
+		ForceNetUpdate();
+		return;
 	}
-	
-	AverageSide /= BuildingConstraints.NormalRoomQuantity;
-	RoomsDivisionConstraints.CalculateAllSides(MinimalSide, AverageSide, MaximalSide);
-	BuildingConstraints.AverageSide = AverageSide;
 
-	//Croissant order
-	auto PredicateRooms = [&] (const FRoom &A, const FRoom &B) { return A.GetMinimalSide() < B.GetMinimalSide(); };
-	Rooms.ValueSort(PredicateRooms);
+	//The actors of the server replace the ones the client doesn't spawn
+	for(auto It = FurnitureActorIds.CreateIterator(); It; ++It)
+		if(!IsValid(It.Value()) || It.Value()->GetIsReplicated())
+			It.RemoveCurrent();
+	for(const FHGReplicatedFurniture &Furniture : ReplicatedFurniture)
+		if(IsValid(Furniture.Actor))
+			FurnitureActorIds.Add(Furniture.Id, Furniture.Actor);
 }
 
-void AHomeGenerator::GenerateRangeArray(TArray<int32>& InArray, int32 Start, int32 Stop)
+bool AHomeGenerator::ComputeCommandTransform(const FFurnitureSpawnCommand& Command, FTransform& RelativeTransform) const
 {
-	InArray.Empty();
+	const FHGFurnitureDelta * const Delta = FurnitureDeltas.Find(MakeFurnitureId(Command));
+	if(Delta && Delta->Type == EHGFurnitureDeltaType::Removed)
+		return false;
 
-	for (int i  = Start; i < Stop; ++i)
-		InArray.Add(i);
+	RelativeTransform = Delta ? Delta->Transform : ComputeMeshTransform(Command.MeshId, Command.Rect, Command.RoomOffset);
+	return true;
 }
 
-void AHomeGenerator::GenerateRangeArray(TArray<int32>& InArray, int32 Stop)
+void AHomeGenerator::RecordAddedFurniture(FFurnitureSpawnBuffer& SpawnBuffer, int32 Level, int32 RoomIndex)
 {
-	GenerateRangeArray(InArray, 0, Stop);
+	for(const auto &Delta : FurnitureDeltas)
+	{
+		if(Delta.Value.Type != EHGFurnitureDeltaType::Added || Level != INDEX_NONE && (Delta.Key.Level != Level || Delta.Key.RoomIndex != RoomIndex))
+			continue;
+
+		FFurnitureSpawnCommand Command;
+		if(MakeAddedCommand(Delta.Value, Command))
+			SpawnBuffer.Commands.Push(Command);
+	}
 }
 
-void AHomeGenerator::DefineBuilding()
+bool AHomeGenerator::MakeAddedCommand(const FHGFurnitureDelta& Delta, FFurnitureSpawnCommand& Command)
 {
-	//
-	//Chooses for each special furniture a mesh
-	check(Doors.Mesh.Num() > 0 && Stairs.Mesh.Num() > 0 && Windows.Mesh.Num() > 0)
-	SelectedDoor = Doors.Mesh[FMath::RandRange(0, Doors.Mesh.Num() - 1)];
-	SelectedStair = Stairs.Mesh[FMath::RandRange(0, Stairs.Mesh.Num() - 1)];
-	SelectedWindow = Windows.Mesh[FMath::RandRange(0, Windows.Mesh.Num() - 1)];
+	const FHGFurnitureId &Id = Delta.Id;
+	UFurnitureMeshAsset * const MeshAsset = Delta.Mesh.LoadSynchronous();
+	if(MeshAsset == nullptr || !Layout->RoomBlocks.IsValidIndex(Id.Level) || !Layout->RoomBlocks[Id.Level].IsValidIndex(Id.RoomIndex))
+		return false;
+
+	//A mesh which isn't generated is only added to the catalog of this generation
+	const int32 MeshId = Layout->AddCatalogMesh(MeshAsset);
+	MeshCatalog.AddUnique(MeshAsset);
+
+	const FRoomBlock &RoomBlock = Layout->RoomBlocks[Id.Level][Id.RoomIndex];
+	Command.MeshId = MeshId;
+	Command.RoomOffset = RoomBlock.GenerateRoomOffset(Layout->BuildingConstraints);
+	Command.Level = Id.Level;
+	Command.RoomIndex = Id.RoomIndex;
+	Command.Index = Id.Index;
+	Command.RoomType = RoomBlock.RoomType;
+	Command.FurnitureType = Delta.FurnitureType;
+	return true;
+}
 
-	//
-	//Calculates building's dimensions
-	
-	//Basic steps
-	const int MinimalSideMin = FMath::Max(BuildingConstraints.MinSideFloorLength, RoomsDivisionConstraints.ABSMinimalSide + SelectedStair->GridSize.MinSide());
-	const int MinimalSideMax = FMath::Max(BuildingConstraints.MinSideFloorLength, RoomsDivisionConstraints.ABSMinimalSide + FMath::Max(RoomsDivisionConstraints.ABSMinimalSide + RoomsDivisionConstraints.HallWidth, SelectedStair->GridSize.MaxSide()));
-	
-	const int AreaPerStage = FMath::RandRange(
-		FMath::Max(MinimalSideMin * MinimalSideMax,FMath::CeilToInt(SelectedStair->GetArea(Stairs) / (1 - RoomsDivisionConstraints.MaxHallRatio))),
-		FMath::Max(MinimalSideMin * MinimalSideMax, FMath::Square(BuildingConstraints.MaxSideFloorLength)) //ENH:What should we do if set to 0
-	);
-	const float Intermediate = static_cast<float>(AreaPerStage) * (1 - RoomsDivisionConstraints.MaxHallRatio) - static_cast<float>(SelectedStair->GetArea(Stairs));
-
-	//Level's calculation
-	const int LevelMin = FMath::CeilToInt(BuildingConstraints.NormalRoomQuantity * FMath::Square<float>(FMath::Max<int>(
-		BuildingConstraints.AverageSide,
-		RoomsDivisionConstraints.ABSMinimalSide
-	)) / Intermediate);
-	const int LevelMax = FMath::Max(LevelMin,
-		FMath::Min(
-			FMath::CeilToInt((BuildingConstraints.NormalRoomQuantity + Rooms.Num()) * FMath::Square<float>(RoomsDivisionConstraints.SufficientSide) / Intermediate),
-			BuildingConstraints.MaxFloorsNumber > 0 ? BuildingConstraints.MaxFloorsNumber : INT_MAX
-		)
-	);
-	BuildingConstraints.Levels = FMath::RandRange(LevelMin, LevelMax);
+void AHomeGenerator::UpdateSpawnedFurniture(const FHGFurnitureId& Id)
+{
+	const FHGFurnitureDelta * const Delta = FurnitureDeltas.Find(Id);
+	const bool bRemoved = Delta == nullptr || Delta->Type == EHGFurnitureDeltaType::Removed;
+
+	//The merged proxy of the room is outdated
+	ReleaseRoomProxy(FIntPoint(Id.Level, Id.RoomIndex));
+
+	if(AActor ** const FoundActor = FurnitureActorIds.Find(Id))
+	{
+		AActor * const FurnitureActor = *FoundActor;
+
+		//Replicated furniture follows the server
+		if(!HasAuthority() && FurnitureActor->GetIsReplicated())
+			return;
+
+		if(!bRemoved)
+		{
+			FurnitureActor->SetActorTransform(Delta->Transform * GetActorTransform());
+			return;
+		}
+
+		FurnitureActorIds.Remove(Id);
+		GeneratedActors.RemoveSingleSwap(FurnitureActor, false);
+		//A door may be held by the other room of the door (see UnfurnishRoom)
+		for(auto &StreamedRoom : StreamedRooms)
+			StreamedRoom.Value.Actors.RemoveSingleSwap(FurnitureActor, false);
+
+		UHGActorPool * const ActorPool = GetWorld()->GetSubsystem<UHGActorPool>();
+		if(ActorPool)
+			ActorPool->Release(FurnitureActor);
+		else if(IsValid(FurnitureActor))
+			FurnitureActor->Destroy();
+		UpdateReplicatedFurniture();
+		return;
+	}
 
-	//Building size calculation
-	if(FMath::RandBool()) //X side -> min side
+	for(auto &Instances : FurnitureInstances)
 	{
-		BuildingConstraints.BuildingSize.X = FMath::RandRange(MinimalSideMin, AreaPerStage / MinimalSideMax);
-		BuildingConstraints.BuildingSize.Y = FMath::CeilToInt(AreaPerStage / BuildingConstraints.BuildingSize.X);
+		FFurnitureInstanceGroup &Group = Instances.Value;
+		const int32 * const FoundIndex = Group.InstanceIndices.Find(Id);
+		if(FoundIndex == nullptr)
+			continue;
+
+		const int32 InstanceIndex = *FoundIndex;
+		if(!bRemoved)
+		{
+			Group.Component->UpdateInstanceTransform(InstanceIndex, Delta->Transform, false, true, true);
+			return;
+		}
+
+		//The component moves its last instance in place of the removed one : the infos follow
+		Group.Component->RemoveInstance(InstanceIndex);
+		Group.InstanceIndices.Remove(Id);
+		Group.Infos.RemoveAtSwap(InstanceIndex, 1, false);
+		if(Group.Infos.IsValidIndex(InstanceIndex))
+			Group.InstanceIndices.Add(MakeFurnitureId(Group.Infos[InstanceIndex]), InstanceIndex);
+		return;
 	}
-	else
+}
+
+void AHomeGenerator::ExecuteSpawnCommands(const FFurnitureSpawnBuffer& SpawnBuffer)
+{
+	QUICK_SCOPE_CYCLE_COUNTER(STAT_HomeGenerator_ExecuteSpawnCommands);
+
+	//Actors which are constructed and attached in one pass, once all of them have been started
+	TArray<TPair<AActor *, const UFurnitureMeshAsset *>> DeferredActors;
+	DeferredActors.Reserve(SpawnBuffer.Commands.Num());
+	TArray<AActor *> PooledActors;
+	PooledActors.Reserve(SpawnBuffer.Commands.Num());
+
+	//Actor spawned by each command (nullptr if none)
+	TArray<AActor *> CommandActors;
+	CommandActors.SetNumZeroed(SpawnBuffer.Commands.Num());
+
+	auto SpawnActor = [this, &DeferredActors, &PooledActors] (const UFurnitureMeshAsset *MeshAsset, const FTransform &RelativeTransform) -> AActor *
 	{
-		BuildingConstraints.BuildingSize.Y = FMath::RandRange(MinimalSideMin, AreaPerStage / MinimalSideMax);
-		BuildingConstraints.BuildingSize.X = FMath::CeilToInt(AreaPerStage / BuildingConstraints.BuildingSize.Y);
-	}	
-
-	//
-	//Positions the main door and prepare the division for the first floor (the only affected by this door)
-	//ENH : We will see that later actually the enter will be a hole
-}
-
-void AHomeGenerator::DefineRooms()
-{
-	FLevelOrganisation InitialOrganisation; //Stores initial B/H on the heap
-	TArray<FLevelOrganisation> LevelsOrganisation;
-	TDoubleLinkedList<FUnknownBlock> NodesToDelete;
-	
-	StairsPositioning(InitialOrganisation);
-	LevelsOrganisation.Init(InitialOrganisation, BuildingConstraints.Levels);
-	
-	for (int i = 0; i < BuildingConstraints.Levels; ++i)
-	{
-		HallBlocks.Push(TArray<FHallBlock>());
-		RoomBlocks.Push(TArray<FRoomBlock>());
-		DivideSurface(i, LevelsOrganisation[i], NodesToDelete);
-	}
-	InitialOrganisation.Empty();//InitialOrganisation isn't valid anymore
-
-	ComputeWallEffect(LevelsOrganisation);
-	NodesToDelete.Empty();//All level organisations aren't valid anymore
-	
-	AllocateSurface();
-	CompleteHallSurface();
-}
-
-void AHomeGenerator::StairsPositioning(FLevelOrganisation &InitialOrganisation)
-{
-	FRoomGrid LevelGrid(BuildingConstraints.BuildingSize);
-	
-	//Possible positions
-	TArray<int> PositionX;
-	TArray<int> PositionY;
-	TArray<EFurnitureRotation> Rotations = {EFurnitureRotation::ROT0, EFurnitureRotation::ROT90, EFurnitureRotation::ROT180, EFurnitureRotation::ROT270};
-	GenerateRangeArray(PositionX, LevelGrid.GetSizeX());
-	GenerateRangeArray(PositionY, LevelGrid.GetSizeY());
-
-	//Shuffle everything here to allow more random generation
-	ShuffleArray(PositionX);
-	ShuffleArray(PositionY);
-	ShuffleArray(Rotations);
-
-	//Define needed general element for positioning verification
-	const FFurnitureConstraint &FinalConstraints = SelectedStair->bOverrideConstraint ? SelectedStair->ConstraintsOverride : Stairs.DefaultConstraints;
-	const auto IsCenterAvailable = [&] (int GridSize, int Size) -> bool {
-		return ( Size < RoomsDivisionConstraints.ABSMinimalSide + 2 * RoomsDivisionConstraints.HallWidth ) ?
-			GridSize >= 3 * RoomsDivisionConstraints.ABSMinimalSide + 2 * RoomsDivisionConstraints.HallWidth
-		:
-			GridSize >= 2 * RoomsDivisionConstraints.ABSMinimalSide + Size;
+		bool bFromPool = false;
+		AActor * const SpawnedActor = PlaceMeshInWorld(MeshAsset, RelativeTransform * GetActorTransform(), bFromPool);
+		if(SpawnedActor == nullptr)
+			return nullptr;
+
+		//Pooled actors are already constructed
+		if(bFromPool)
+			PooledActors.Push(SpawnedActor);
+		else
+			DeferredActors.Push(TPair<AActor *, const UFurnitureMeshAsset *>(SpawnedActor, MeshAsset));
+		return SpawnedActor;
 	};
-	const auto IsInCenter = [&] (int Coordinate, int GridSize, int Size) -> bool { return RoomsDivisionConstraints.ABSMinimalSide < Coordinate && Coordinate <= GridSize - (Size + RoomsDivisionConstraints.ABSMinimalSide); };
-	const auto IsNHCenterAvailable = [&] (int GridSize, int Size) -> bool { return GridSize >= 2 * RoomsDivisionConstraints.ABSMinimalSide + Size; }; // No hall
-	
-	bool PositionFound = false;
-	for(const int X : PositionX)
+
+	//Typical floor : the furniture is only recorded for the typical level (in streaming mode, each room records its own copy)
+	const FHGBuildingConstraints &Constraints = Layout->BuildingConstraints;
+	const int32 TypicalLevel = Layout->GetDividedLevels() - 1;
+	const bool bRepeatTypicalFloor = !Layout->bStreamFurniture && TypicalLevel + 1 < Constraints.Levels;
+
+	for(int32 CommandIndex = 0; CommandIndex < SpawnBuffer.Commands.Num(); ++CommandIndex)
 	{
-		for(const int Y : PositionY)
+		const FFurnitureSpawnCommand &Command = SpawnBuffer.Commands[CommandIndex];
+		if(!Layout->MeshCatalog.IsValidIndex(Command.MeshId) || Layout->MeshCatalog[Command.MeshId] == nullptr)
+			continue;
+
+		const UFurnitureMeshAsset * const MeshAsset = Layout->MeshCatalog[Command.MeshId];
+
+		//One instance per repeated level (the furniture added by the gameplay is only in its room)
+		if(bRepeatTypicalFloor && Command.Level == TypicalLevel && Command.Index >= 0)
 		{
-			for(const auto Rotation : Rotations)
+			FFurnitureSpawnCommand Copy = Command;
+			for(Copy.Level = TypicalLevel + 1; Copy.Level < Constraints.Levels; ++Copy.Level)
 			{
-				FFurnitureRect FinalRect(Rotation, FVectorGrid(X, Y), SelectedStair->GridSize);
-
-				//Reset if previous operation failed
-				InitialOrganisation.Empty();
-
-				//Checks if the rect respects stairs constraints
-				bool IsStairPlaceable = true;
-				{
-					//Check lambdas
-					const FVectorGrid RotatedSize = FinalRect.WillRotationInvertSize() ? FVectorGrid(FinalRect.Size.Y, FinalRect.Size.X) : FinalRect.Size;
-					const auto IsInXCenter = [&] () -> bool { return IsInCenter(X, LevelGrid.GetSizeX(), RotatedSize.X); };
-					const auto IsInYCenter = [&] () -> bool  { return IsInCenter(Y, LevelGrid.GetSizeY(), RotatedSize.Y); };
-					const auto IsXCenterAvailable = [&] () -> bool { return IsCenterAvailable(LevelGrid.GetSizeX(), RotatedSize.X); };
-					const auto IsYCenterAvailable = [&] () -> bool  { return IsCenterAvailable( LevelGrid.GetSizeY(), RotatedSize.Y); };
-					const auto IsNHXCenterAvailable = [&] () -> bool { return IsNHCenterAvailable(LevelGrid.GetSizeX(), RotatedSize.X); };
-					const auto IsNHYCenterAvailable = [&] () -> bool  { return IsNHCenterAvailable( LevelGrid.GetSizeY(), RotatedSize.Y); };
-
-					InitialOrganisation.SetHallBlock(FLevelOrganisation::Stairs, new FHallBlock(
-						RotatedSize,
-						FinalRect.Position,
-						0
-					));
-
-					//ENH : The code in the center case could replace all other cases (just if we check X > 0 for all X calculated value)			
-					//We could so split the part check if possible and spawn the hall/blocks
-					//Case where it is in center of the room
-					if(IsInXCenter() && IsInYCenter())
-					{
-						if(RotatedSize.X >= RotatedSize.Y)
-						{
-							if(!IsXCenterAvailable() || !IsNHYCenterAvailable())
-								IsStairPlaceable = false;
-
-							const int FHAxis = FMath::RandRange(RoomsDivisionConstraints.ABSMinimalSide, FMath::Min(FinalRect.Position.X, LevelGrid.GetSizeX() - 2 * (RoomsDivisionConstraints.HallWidth + RoomsDivisionConstraints.ABSMinimalSide)));
-							const int SHAxis = FMath::RandRange(FMath::Max(FHAxis + RoomsDivisionConstraints.HallWidth + RoomsDivisionConstraints.ABSMinimalSide, FinalRect.Position.X + RotatedSize.X - RoomsDivisionConstraints.HallWidth), LevelGrid.GetSizeX() - (RoomsDivisionConstraints.HallWidth + RoomsDivisionConstraints.ABSMinimalSide));
-							const int FHSpace = FinalRect.Position.X - (FHAxis + RoomsDivisionConstraints.HallWidth); //No need of min or max, because it is already implied by the def of the axis value
-							const int SHSpace = SHAxis - (FinalRect.Position.X + RotatedSize.X);
-
-							InitialOrganisation.SetHallBlock(
-								FLevelOrganisation::LowCorridor,
-								new FHallBlock(
-									FVectorGrid(RoomsDivisionConstraints.HallWidth, LevelGrid.GetSizeY()),
-									FVectorGrid(FHAxis, 0),
-									0
-							));
-
-							InitialOrganisation.SetHallBlock(
-								FLevelOrganisation::HighCorridor,
-								new FHallBlock(
-									FVectorGrid(RoomsDivisionConstraints.HallWidth, LevelGrid.GetSizeY()),
-									FVectorGrid(SHAxis, 0),
-									0
-							));
-
-							if(FHSpace > 0)
-								InitialOrganisation.SetHallBlock(
-									FLevelOrganisation::LowMargin,
-									new FHallBlock(
-										FVectorGrid(FHSpace, RotatedSize.Y),
-										FVectorGrid(FHAxis + RoomsDivisionConstraints.HallWidth, FinalRect.Position.Y),
-										0
-								));
-
-							if(SHSpace > 0)
-								InitialOrganisation.SetHallBlock(
-									FLevelOrganisation::HighMargin,
-									new FHallBlock(
-										FVectorGrid(SHSpace, RotatedSize.Y),
-										FVectorGrid(FinalRect.Position.X + RotatedSize.X, FinalRect.Position.Y),
-										0
-								));
-
-							InitialOrganisation.SetUnknownBlock(
-								FLevelOrganisation::LowWing,
-								new FUnknownBlock(
-									FVectorGrid(FHAxis, LevelGrid.GetSizeY()),
-									FVectorGrid(0, 0),
-									0,
-									false,
-									static_cast<uint8>(EGenerationAxe::X_UP),
-									EGenerationAxe::X_UP
-							));
-
-							InitialOrganisation.SetUnknownBlock(
-								FLevelOrganisation::HighWing,
-								new FUnknownBlock(
-								FVectorGrid(LevelGrid.GetSizeX() - (SHAxis + RoomsDivisionConstraints.HallWidth), LevelGrid.GetSizeY()),
-								FVectorGrid(SHAxis + RoomsDivisionConstraints.HallWidth, 0),
-								0,
-								false,
-								static_cast<uint8>(EGenerationAxe::X_DOWN),
-								EGenerationAxe::X_DOWN
-							));
-
-							InitialOrganisation.SetUnknownBlock(
-								FLevelOrganisation::LowApartment,
-								new FUnknownBlock(
-									FVectorGrid(SHAxis - (FHAxis + RoomsDivisionConstraints.HallWidth), FinalRect.Position.Y),
-									FVectorGrid(SHAxis + RoomsDivisionConstraints.HallWidth, 0),
-									0,
-									false,
-									EGenerationAxe::X_DOWN | EGenerationAxe::X_UP | EGenerationAxe::Y_UP,
-									EGenerationAxe::X_DOWN
-							));
-
-							InitialOrganisation.SetUnknownBlock(
-								FLevelOrganisation::HighApartment,
-								new FUnknownBlock(
-									FVectorGrid(SHAxis - (FHAxis + RoomsDivisionConstraints.HallWidth), LevelGrid.GetSizeY() - (FinalRect.Position.Y + RotatedSize.Y)),
-									FVectorGrid(FHAxis + RoomsDivisionConstraints.HallWidth, FinalRect.Position.Y + RotatedSize.Y),
-									0,
-									false,
-									EGenerationAxe::X_DOWN | EGenerationAxe::X_UP | EGenerationAxe::Y_DOWN,
-									EGenerationAxe::X_UP
-							));
-						}
-						else
-						{
-							if(!IsYCenterAvailable() || !IsNHXCenterAvailable())
-								IsStairPlaceable = false;
-
-							const int FHAxis = FMath::RandRange(RoomsDivisionConstraints.ABSMinimalSide, FMath::Min(FinalRect.Position.Y, LevelGrid.GetSizeY() - 2 * (RoomsDivisionConstraints.HallWidth + RoomsDivisionConstraints.ABSMinimalSide)));
-							const int SHAxis = FMath::RandRange(FMath::Max(FHAxis + RoomsDivisionConstraints.HallWidth + RoomsDivisionConstraints.ABSMinimalSide, FinalRect.Position.Y + RotatedSize.Y - RoomsDivisionConstraints.HallWidth), LevelGrid.GetSizeY() - (RoomsDivisionConstraints.HallWidth + RoomsDivisionConstraints.ABSMinimalSide));
-							const int FHSpace = FinalRect.Position.Y - (FHAxis + RoomsDivisionConstraints.HallWidth); //No need of min or max, because it is already implied by the def of the axis value
-							const int SHSpace = SHAxis - (FinalRect.Position.Y + RotatedSize.Y);
-
-							InitialOrganisation.SetHallBlock(
-								FLevelOrganisation::LowCorridor,
-								new FHallBlock(
-									FVectorGrid(LevelGrid.GetSizeX(), RoomsDivisionConstraints.HallWidth),
-									FVectorGrid(0, FHAxis),
-									0
-							));
-
-							InitialOrganisation.SetHallBlock(
-								FLevelOrganisation::HighCorridor,
-								new FHallBlock(
-									FVectorGrid(LevelGrid.GetSizeX(), RoomsDivisionConstraints.HallWidth),
-									FVectorGrid(0, SHAxis),
-									0
-							));
-
-							if(FHSpace > 0)
-								InitialOrganisation.SetHallBlock(
-								FLevelOrganisation::LowMargin,
-									new FHallBlock(
-										FVectorGrid(RotatedSize.X, FHSpace),
-										FVectorGrid(FinalRect.Position.X, FHAxis + RoomsDivisionConstraints.HallWidth),
-										0
-								));
-
-							if(SHSpace > 0)
-								InitialOrganisation.SetHallBlock(
-								FLevelOrganisation::HighMargin,
-									new FHallBlock(
-										FVectorGrid(RotatedSize.X, SHSpace),
-										FVectorGrid(FinalRect.Position.X, FinalRect.Position.Y + RotatedSize.Y),
-										0
-								));
-
-							InitialOrganisation.SetUnknownBlock(
-							FLevelOrganisation::LowWing,
-								new FUnknownBlock(
-									FVectorGrid(LevelGrid.GetSizeX(), FHAxis),
-									FVectorGrid(0, 0),
-									0,
-									true,
-									static_cast<uint8>(EGenerationAxe::Y_UP),
-									EGenerationAxe::Y_UP
-							));
-
-							InitialOrganisation.SetUnknownBlock(
-								FLevelOrganisation::HighWing,
-								new FUnknownBlock(
-									FVectorGrid(LevelGrid.GetSizeX(), LevelGrid.GetSizeY() - (SHAxis + RoomsDivisionConstraints.HallWidth)),
-									FVectorGrid(0, SHAxis + RoomsDivisionConstraints.HallWidth),
-									0,
-									true,
-									static_cast<uint8>(EGenerationAxe::Y_DOWN),
-									EGenerationAxe::Y_DOWN
-							));
-
-							InitialOrganisation.SetUnknownBlock(
-								FLevelOrganisation::LowApartment,
-								new FUnknownBlock(
-									FVectorGrid(FinalRect.Position.X, SHAxis - (FHAxis + RoomsDivisionConstraints.HallWidth)),
-									FVectorGrid(0, SHAxis + RoomsDivisionConstraints.HallWidth),
-									0,
-									true,
-									EGenerationAxe::Y_DOWN | EGenerationAxe::Y_UP | EGenerationAxe::X_UP,
-									EGenerationAxe::Y_DOWN
-							));
-
-							InitialOrganisation.SetUnknownBlock(
-								FLevelOrganisation::HighApartment,
-								new FUnknownBlock(
-									FVectorGrid(LevelGrid.GetSizeX() - (FinalRect.Position.X + RotatedSize.X), SHAxis - (FHAxis + RoomsDivisionConstraints.HallWidth)),
-									FVectorGrid(FinalRect.Position.X + RotatedSize.X, FHAxis + RoomsDivisionConstraints.HallWidth),
-									0,
-									true,
-									EGenerationAxe::Y_DOWN | EGenerationAxe::Y_UP | EGenerationAxe::X_DOWN,
-									EGenerationAxe::Y_UP
-							));
-						}
-					}
-				
-					//Case where it is in center along a X wall
-					else if((LevelGrid.IsAlongXDownWall(FinalRect) || LevelGrid.IsAlongXUpWall(FinalRect)) && IsInYCenter())
-					{
-						if(RotatedSize.X < RotatedSize.Y /*To force placement with one hall*/ || !IsYCenterAvailable() || !IsNHXCenterAvailable())
-							IsStairPlaceable = false;
-						
-						else if(LevelGrid.IsAlongXUpWall(FinalRect))
-						{
-							const int Space = FMath::Max(-RoomsDivisionConstraints.HallWidth, FinalRect.Position.X - LevelGrid.GetSizeX() + RoomsDivisionConstraints.ABSMinimalSide);
-							InitialOrganisation.SetHallBlock(
-								FLevelOrganisation::LowCorridor,
-									new FHallBlock(
-										FVectorGrid(RoomsDivisionConstraints.HallWidth, LevelGrid.GetSizeY()),
-										FVectorGrid(FinalRect.Position.X  - Space - RoomsDivisionConstraints.HallWidth, 0),
-										0
-							));
-
-							if(Space > 0)
-								InitialOrganisation.SetHallBlock(
-									FLevelOrganisation::LowMargin,
-									new FHallBlock(
-										FVectorGrid(Space, RotatedSize.Y),
-										FVectorGrid(FinalRect.Position.X  - Space, FinalRect.Position.Y),
-										0
-								));
-
-							InitialOrganisation.SetUnknownBlock(
-								FLevelOrganisation::LowWing,
-								new FUnknownBlock(
-									FVectorGrid(FinalRect.Position.X  - Space - RoomsDivisionConstraints.HallWidth, LevelGrid.GetSizeY()),
-									FVectorGrid(0, 0),
-									0,
-									false,
-									static_cast<uint8>(EGenerationAxe::X_UP),
-									EGenerationAxe::X_UP
-							));
-							
-							InitialOrganisation.SetUnknownBlock(
-								FLevelOrganisation::LowApartment,
-								new FUnknownBlock(
-									FVectorGrid(RotatedSize.X  + Space, FinalRect.Position.Y),
-									FVectorGrid(FinalRect.Position.X  - Space, 0),
-									0,
-									false,
-									EGenerationAxe::X_DOWN | EGenerationAxe::Y_UP,
-									EGenerationAxe::X_DOWN
-							));
-
-							InitialOrganisation.SetUnknownBlock(
-								FLevelOrganisation::HighApartment,
-								new FUnknownBlock(
-									FVectorGrid(RotatedSize.X  + Space, LevelGrid.GetSizeY() - (FinalRect.Position.Y + RotatedSize.Y)),
-									FVectorGrid(FinalRect.Position.X  - Space, FinalRect.Position.Y + RotatedSize.Y),
-									0,
-									false,
-									EGenerationAxe::X_DOWN | EGenerationAxe::Y_DOWN,
-									EGenerationAxe::X_DOWN
-							));
-						}
-						else
-						{
-							const int Space = FMath::Max(-RoomsDivisionConstraints.HallWidth, RoomsDivisionConstraints.ABSMinimalSide - RotatedSize.X);
-							InitialOrganisation.SetHallBlock(
-								FLevelOrganisation::HighCorridor,
-								new FHallBlock(
-									FVectorGrid(RoomsDivisionConstraints.HallWidth, LevelGrid.GetSizeY()),
-									FVectorGrid( RotatedSize.X + Space, 0),
-									0
-							));
-
-							if(Space > 0)
-								InitialOrganisation.SetHallBlock(
-									FLevelOrganisation::HighMargin,
-									new FHallBlock(
-										FVectorGrid(Space, RotatedSize.Y),
-										FVectorGrid(RotatedSize.X, FinalRect.Position.Y),
-										0
-								));
-
-							InitialOrganisation.SetUnknownBlock(
-								FLevelOrganisation::HighWing,
-								new FUnknownBlock(
-									FVectorGrid(LevelGrid.GetSizeX() - (RotatedSize.X + Space + RoomsDivisionConstraints.HallWidth), LevelGrid.GetSizeY()),
-									FVectorGrid(RotatedSize.X + Space + RoomsDivisionConstraints.HallWidth, 0),
-									0,
-									false,
-									static_cast<uint8>(EGenerationAxe::X_DOWN),
-									EGenerationAxe::X_DOWN
-							));
-
-							InitialOrganisation.SetUnknownBlock(
-								FLevelOrganisation::LowApartment,
-								new FUnknownBlock(
-									FVectorGrid(RotatedSize.X  + Space, FinalRect.Position.X),
-									FVectorGrid(0, 0),
-									0,
-									false,
-									EGenerationAxe::X_UP | EGenerationAxe::Y_UP,
-									EGenerationAxe::X_UP
-							));
-
-							InitialOrganisation.SetUnknownBlock(
-								FLevelOrganisation::HighApartment,
-								new FUnknownBlock(
-									FVectorGrid(RotatedSize.X  + Space, LevelGrid.GetSizeY() - (FinalRect.Position.Y + RotatedSize.Y)),
-									FVectorGrid(0, FinalRect.Position.Y + RotatedSize.Y),
-									0,
-									false,
-									EGenerationAxe::X_UP | EGenerationAxe::Y_DOWN,
-									EGenerationAxe::X_UP
-							));
-						}
-					}
-				
-					//Case where it is in center along a Y wall
-					else if((LevelGrid.IsAlongYDownWall(FinalRect) || LevelGrid.IsAlongYUpWall(FinalRect)) && IsInXCenter())
-					{
-						if(RotatedSize.Y < RotatedSize.X || !IsXCenterAvailable() || !IsNHYCenterAvailable())
-							IsStairPlaceable = false;
-
-						if(LevelGrid.IsAlongYUpWall(FinalRect))
-						{
-							const int Space = FMath::Max(-RoomsDivisionConstraints.HallWidth, FinalRect.Position.Y - LevelGrid.GetSizeY() + RoomsDivisionConstraints.ABSMinimalSide);
-							InitialOrganisation.SetHallBlock(
-								FLevelOrganisation::LowCorridor,
-								new FHallBlock(
-									 FVectorGrid(LevelGrid.GetSizeX(), RoomsDivisionConstraints.HallWidth),
-									 FVectorGrid(0, FinalRect.Position.Y  - Space - RoomsDivisionConstraints.HallWidth),
-									 0
-							 ));
-
-							if(Space > 0)
-						 		InitialOrganisation.SetHallBlock(
-								FLevelOrganisation::LowMargin,
-									new FHallBlock(
-										 FVectorGrid(RotatedSize.X, Space),
-										 FVectorGrid(FinalRect.Position.X, FinalRect.Position.Y  - Space),
-										 0
-								));
-
-							InitialOrganisation.SetUnknownBlock(
-								FLevelOrganisation::LowWing,
-								new FUnknownBlock(
-									FVectorGrid(LevelGrid.GetSizeX(), FinalRect.Position.Y  - Space - RoomsDivisionConstraints.HallWidth),
-									FVectorGrid(0, 0),
-									0,
-									true,
-									static_cast<uint8>(EGenerationAxe::Y_UP),
-									EGenerationAxe::Y_UP
-							));
-
-							InitialOrganisation.SetUnknownBlock(
-								FLevelOrganisation::LowApartment,
-								new FUnknownBlock(
-									FVectorGrid(FinalRect.Position.X, RotatedSize.Y  + Space),
-									FVectorGrid(0, FinalRect.Position.Y  - Space),
-									0,
-									true,
-									EGenerationAxe::Y_DOWN | EGenerationAxe::X_UP,
-									EGenerationAxe::Y_DOWN
-							));
-							
-							InitialOrganisation.SetUnknownBlock(
-								FLevelOrganisation::HighApartment,
-								new FUnknownBlock(
-									FVectorGrid(LevelGrid.GetSizeX() - (FinalRect.Position.X + RotatedSize.X), RotatedSize.Y  + Space),
-									FVectorGrid(FinalRect.Position.X + RotatedSize.X, FinalRect.Position.Y  - Space),
-									0,
-									true,
-									EGenerationAxe::Y_DOWN | EGenerationAxe::X_DOWN,
-									EGenerationAxe::Y_DOWN
-							));
-						}
-						else
-						{
-							const int Space = FMath::Max(-RoomsDivisionConstraints.HallWidth, RoomsDivisionConstraints.ABSMinimalSide - RotatedSize.Y);
-							InitialOrganisation.SetHallBlock(
-								FLevelOrganisation::HighCorridor,
-								new FHallBlock(
-									FVectorGrid(LevelGrid.GetSizeX(), RoomsDivisionConstraints.HallWidth),
-									FVectorGrid(0, RotatedSize.Y + Space),
-									0
-							));
-
-							if(Space > 0)
-								InitialOrganisation.SetHallBlock(
-									FLevelOrganisation::HighMargin,
-									new FHallBlock(
-										FVectorGrid(RotatedSize.X, Space),
-										FVectorGrid(FinalRect.Position.X, RotatedSize.Y),
-										0
-								));
-
-							InitialOrganisation.SetUnknownBlock(
-								FLevelOrganisation::HighWing,
-								new FUnknownBlock(
-									FVectorGrid(LevelGrid.GetSizeX(),LevelGrid.GetSizeY() - (RotatedSize.Y + Space + RoomsDivisionConstraints.HallWidth)),
-									FVectorGrid(0, RotatedSize.Y + Space + RoomsDivisionConstraints.HallWidth),
-									0,
-									true,
-									static_cast<uint8>(EGenerationAxe::Y_DOWN),
-									EGenerationAxe::Y_DOWN
-							));
-
-							InitialOrganisation.SetUnknownBlock(
-								FLevelOrganisation::LowApartment,
-								new FUnknownBlock(
-									FVectorGrid(FinalRect.Position.X, RotatedSize.Y  + Space),
-									FVectorGrid(0, 0),
-									0,
-									true,
-									EGenerationAxe::Y_UP | EGenerationAxe::X_UP,
-									EGenerationAxe::Y_UP
-							));
-
-							InitialOrganisation.SetUnknownBlock(
-								FLevelOrganisation::HighApartment,
-								new FUnknownBlock(
-									FVectorGrid(LevelGrid.GetSizeX() - (FinalRect.Position.X + RotatedSize.X), RotatedSize.Y  + Space),
-									FVectorGrid(FinalRect.Position.X + RotatedSize.X, 0),
-									0,
-									true,
-									EGenerationAxe::Y_UP | EGenerationAxe::X_DOWN,
-									EGenerationAxe::Y_UP
-							));
-						}
-					}
-				
-					//Case it is in a corner (always ok, if the building step has successfully done its task)
-					else if(LevelGrid.IsInAnyCorner(FinalRect))
-					{
-						if(RotatedSize.X >= RotatedSize.Y)
-						{
-							if(LevelGrid.IsAlongXUpWall(FinalRect))
-							{
-								const int Space = FMath::Max(-RoomsDivisionConstraints.HallWidth, FinalRect.Position.X - LevelGrid.GetSizeX() + RoomsDivisionConstraints.ABSMinimalSide);
-								InitialOrganisation.SetHallBlock(
-									FLevelOrganisation::LowCorridor,
-									new FHallBlock(
-										FVectorGrid(RoomsDivisionConstraints.HallWidth, LevelGrid.GetSizeY()),
-										FVectorGrid(FinalRect.Position.X  - Space - RoomsDivisionConstraints.HallWidth, 0),
-										0
-								));
-
-								if(Space > 0)
-									InitialOrganisation.SetHallBlock(
-										FLevelOrganisation::LowMargin,
-										new FHallBlock(
-											FVectorGrid(Space, RotatedSize.Y),
-											FVectorGrid(FinalRect.Position.X  - Space, FinalRect.Position.Y),
-											0
-									));
-
-								InitialOrganisation.SetUnknownBlock(
-									FLevelOrganisation::LowWing,
-									new FUnknownBlock(
-										FVectorGrid(FinalRect.Position.X  - Space - RoomsDivisionConstraints.HallWidth, LevelGrid.GetSizeY()),
-										FVectorGrid(0, 0),
-										0,
-										false,
-										static_cast<uint8>(EGenerationAxe::X_UP),
-										EGenerationAxe::X_UP
-								));
-
-								if(LevelGrid.IsAlongYDownWall(FinalRect))
-									InitialOrganisation.SetUnknownBlock(
-										FLevelOrganisation::HighApartment,
-										new FUnknownBlock(
-											FVectorGrid(RotatedSize.X  + Space, LevelGrid.GetSizeY() - RotatedSize.Y),
-											FVectorGrid(FinalRect.Position.X  - Space,  RotatedSize.Y),
-											0,
-											false,
-											EGenerationAxe::X_DOWN | EGenerationAxe::Y_DOWN,
-											EGenerationAxe::X_DOWN
-									));
-								else
-									InitialOrganisation.SetUnknownBlock(
-										FLevelOrganisation::LowApartment,
-										new FUnknownBlock(
-											FVectorGrid(RotatedSize.X  + Space, LevelGrid.GetSizeY() - RotatedSize.Y),
-											FVectorGrid(FinalRect.Position.X  - Space, 0),
-											0,
-											false,
-											EGenerationAxe::X_DOWN | EGenerationAxe::Y_UP,
-											EGenerationAxe::X_DOWN
-									));
-							}
-							else //Along XDown so Position.X = 0
-							{
-								const int Space = FMath::Max(-RoomsDivisionConstraints.HallWidth, RoomsDivisionConstraints.ABSMinimalSide - RotatedSize.X);
-								InitialOrganisation.SetHallBlock(
-									FLevelOrganisation::HighCorridor,
-									new FHallBlock(
-										FVectorGrid(RoomsDivisionConstraints.HallWidth, LevelGrid.GetSizeY()),
-										FVectorGrid( RotatedSize.X + Space, 0),
-										0
-								));
-
-								if(Space > 0)
-									InitialOrganisation.SetHallBlock(
-										FLevelOrganisation::HighMargin,
-										new FHallBlock(
-											FVectorGrid(Space, RotatedSize.Y),
-											FVectorGrid(RotatedSize.X, FinalRect.Position.Y),
-											0
-									));
-
-								InitialOrganisation.SetUnknownBlock(
-									FLevelOrganisation::HighWing,
-									new FUnknownBlock(
-										FVectorGrid(LevelGrid.GetSizeX() - (RotatedSize.X + Space + RoomsDivisionConstraints.HallWidth), LevelGrid.GetSizeY()),
-										FVectorGrid(RotatedSize.X + Space + RoomsDivisionConstraints.HallWidth, 0),
-										0,
-										false,
-										static_cast<uint8>(EGenerationAxe::X_DOWN),
-										EGenerationAxe::X_DOWN
-								));
-
-								if(LevelGrid.IsAlongYDownWall(FinalRect))
-									InitialOrganisation.SetUnknownBlock(
-										FLevelOrganisation::HighApartment,
-										new FUnknownBlock(
-											FVectorGrid(RotatedSize.X  + Space, LevelGrid.GetSizeY() - RotatedSize.Y),
-											FVectorGrid(0, RotatedSize.Y),
-											0,
-											false,
-											EGenerationAxe::X_UP | EGenerationAxe::Y_DOWN,
-											EGenerationAxe::X_UP
-									));
-								else
-									InitialOrganisation.SetUnknownBlock(
-										FLevelOrganisation::LowApartment,
-										new FUnknownBlock(
-											FVectorGrid(RotatedSize.X  + Space, LevelGrid.GetSizeY() - RotatedSize.Y),
-											FVectorGrid(0, 0),
-											0,
-											false,
-											EGenerationAxe::X_UP | EGenerationAxe::Y_UP,
-											EGenerationAxe::X_UP
-									));
-							}
-						}
-						else
-						{
-							if(LevelGrid.IsAlongYUpWall(FinalRect))
-							{
-								const int Space = FMath::Max(-RoomsDivisionConstraints.HallWidth, FinalRect.Position.Y - LevelGrid.GetSizeY() + RoomsDivisionConstraints.ABSMinimalSide);
-								InitialOrganisation.SetHallBlock(
-									FLevelOrganisation::LowCorridor,
-									new FHallBlock(
-										FVectorGrid(LevelGrid.GetSizeX(), RoomsDivisionConstraints.HallWidth),
-										FVectorGrid(0, FinalRect.Position.Y  - Space - RoomsDivisionConstraints.HallWidth),
-										0
-								));
-
-								if(Space > 0)
-									InitialOrganisation.SetHallBlock(
-										FLevelOrganisation::LowMargin,
-										new FHallBlock(
-											FVectorGrid(RotatedSize.X, Space),
-											FVectorGrid(FinalRect.Position.X, FinalRect.Position.Y  - Space),
-											0
-									));
-
-								InitialOrganisation.SetUnknownBlock(
-									FLevelOrganisation::LowWing,
-									new FUnknownBlock(
-										FVectorGrid(LevelGrid.GetSizeX(), FinalRect.Position.Y  - Space - RoomsDivisionConstraints.HallWidth),
-										FVectorGrid(0, 0),
-										0,
-										true,
-										static_cast<uint8>(EGenerationAxe::Y_UP),
-										EGenerationAxe::Y_UP
-								));
-								
-								if(LevelGrid.IsAlongXDownWall(FinalRect))
-									InitialOrganisation.SetUnknownBlock(
-										FLevelOrganisation::HighApartment,
-										new FUnknownBlock(
-											FVectorGrid(LevelGrid.GetSizeX() - RotatedSize.X, RotatedSize.Y  + Space),
-											FVectorGrid(RotatedSize.X, FinalRect.Position.Y  - Space),
-											0,
-											true,
-											EGenerationAxe::Y_DOWN | EGenerationAxe::X_DOWN,
-											EGenerationAxe::Y_DOWN
-									));
-								else
-									InitialOrganisation.SetUnknownBlock(
-										FLevelOrganisation::LowApartment,
-										new FUnknownBlock(
-											FVectorGrid(LevelGrid.GetSizeX() - RotatedSize.X, RotatedSize.Y  + Space),
-											FVectorGrid(0, FinalRect.Position.Y  - Space),
-											0,
-											true,
-											EGenerationAxe::Y_DOWN | EGenerationAxe::X_UP,
-											EGenerationAxe::Y_DOWN
-									));
-							}
-							else
-							{
-								const int Space = FMath::Max(-RoomsDivisionConstraints.HallWidth, RoomsDivisionConstraints.ABSMinimalSide - RotatedSize.Y);
-								InitialOrganisation.SetHallBlock(
-									FLevelOrganisation::HighCorridor,
-									new FHallBlock(
-										FVectorGrid(LevelGrid.GetSizeX(), RoomsDivisionConstraints.HallWidth),
-										FVectorGrid(0, RotatedSize.Y + Space),
-										0
-								));
-
-								if(Space > 0)
-									InitialOrganisation.SetHallBlock(
-										FLevelOrganisation::HighMargin,
-										new FHallBlock(
-											FVectorGrid(RotatedSize.X, Space),
-											FVectorGrid(FinalRect.Position.X, RotatedSize.Y),
-											0
-									));
-
-								InitialOrganisation.SetUnknownBlock(
-									FLevelOrganisation::HighWing,
-									new FUnknownBlock(
-										FVectorGrid(LevelGrid.GetSizeX(),LevelGrid.GetSizeY() - (RotatedSize.Y + Space + RoomsDivisionConstraints.HallWidth)),
-										FVectorGrid(0, RotatedSize.Y + Space + RoomsDivisionConstraints.HallWidth),
-										0,
-										true,
-										static_cast<uint8>(EGenerationAxe::Y_DOWN),
-										EGenerationAxe::Y_DOWN
-								));
-
-								if(LevelGrid.IsAlongXDownWall(FinalRect))
-									InitialOrganisation.SetUnknownBlock(
-										FLevelOrganisation::HighApartment,
-										new FUnknownBlock(
-											FVectorGrid(LevelGrid.GetSizeX() - RotatedSize.X, RotatedSize.Y  + Space),
-											FVectorGrid(RotatedSize.X, 0),
-											0,
-											true,
-											EGenerationAxe::Y_UP | EGenerationAxe::X_DOWN,
-											EGenerationAxe::Y_UP
-									));
-								else
-									InitialOrganisation.SetUnknownBlock(
-										FLevelOrganisation::LowApartment,
-										new FUnknownBlock(
-											FVectorGrid(LevelGrid.GetSizeX() - RotatedSize.X, RotatedSize.Y  + Space),
-											FVectorGrid(0, 0),
-											0,
-											true,
-											EGenerationAxe::Y_UP | EGenerationAxe::X_UP,
-											EGenerationAxe::Y_UP
-									));
-							}
-						}
-					}
-
-					//If none of above cases, it means the rect isn't in a valid position
-					else
-						IsStairPlaceable = false;
-				}
-				
-				if(IsStairPlaceable)
-					PositionFound = LevelGrid.MarkFurnitureAtPosition(FinalRect, FinalConstraints);
-				if(PositionFound) break;
+				Copy.RoomOffset.Z = Command.RoomOffset.Z + (Copy.Level - TypicalLevel) * (Constraints.FloorHeight + Constraints.FloorWidth);
+				FTransform CopyTransform;
+				if(!ComputeCommandTransform(Copy, CopyTransform))
+					continue;
+
+				if(ShouldInstanceFurniture(MeshAsset, Copy.Level))
+					BufferFurnitureInstance(Copy, CopyTransform);
+				else if(AActor * const CopyActor = SpawnActor(MeshAsset, CopyTransform))
+					FurnitureActorIds.Add(MakeFurnitureId(Copy), CopyActor);
 			}
+		}
+
+		//Removed by the gameplay
+		FTransform RelativeTransform;
+		if(!ComputeCommandTransform(Command, RelativeTransform))
+			continue;
 
-			if(PositionFound) break;
+		//Instancing mode : only buffers the instance (added in bulk at the end)
+		if(ShouldInstanceFurniture(MeshAsset, Command.Level))
+		{
+			BufferFurnitureInstance(Command, RelativeTransform);
+			continue;
 		}
 
-		if(PositionFound) break;
+		CommandActors[CommandIndex] = SpawnActor(MeshAsset, RelativeTransform);
+		if(CommandActors[CommandIndex])
+			FurnitureActorIds.Add(MakeFurnitureId(Command), CommandActors[CommandIndex]);
 	}
-	//If no position was found for the stairs, the process exit.
-	check(PositionFound);
-}
 
-void AHomeGenerator::DivideSurface(const int Level, FLevelOrganisation &LevelOrganisation, TDoubleLinkedList<FUnknownBlock> &NodesToDelete)
-{
-	check(HallBlocks.IsValidIndex(Level) && RoomBlocks.IsValidIndex(Level))
-
-	//BSP's storage initialisation
-	FLevelDivisionData LevelDivisionData(BuildingConstraints.BuildingSize.Area(), LevelOrganisation.InitialHallArea());
-	TArray<FUnknownBlock *> FinalBlocks;
-	
-	TDoubleLinkedList<FUnknownBlock> ToDivide;
-	for (uint8 i = 0; i < FLevelOrganisation::BlockPositionsSize; ++i) 
+	//Construction and registration pass
+	for(const auto &Deferred : DeferredActors)
 	{
-		ToDivide.AddHead(*LevelOrganisation.GetBlockList()[i]);
-		ToDivide.GetHead()->GetValue().Level = Level;
+		AActor * const SpawnedActor = Deferred.Key;
+		SpawnedActor->FinishSpawning(SpawnedActor->GetActorTransform(), true);
 
-		// Replaces the pointer to the initial block
-		LevelOrganisation.SetUnknownBlock(static_cast<FLevelOrganisation::EInitialBlockPositions>(i), &ToDivide.GetHead()->GetValue());
+		//Components added by the class' construction script only exist once the actor is constructed
+		const UFurnitureMeshAsset * const MeshAsset = Deferred.Value;
+		if(IsValid(MeshAsset->ActorClass) && MeshAsset->ActorClass.Get()->ImplementsInterface(UFurnitureMeshInt::StaticClass()) && IsValid(MeshAsset->Mesh))
+			IFurnitureMeshInt::Execute_GetStaticMeshComponent(SpawnedActor)->SetStaticMesh(MeshAsset->Mesh);
 	}
 
-	for (uint8 i = 0; i < FLevelOrganisation::HallPositionsSize; ++i) 
+	//Attachment pass (actors are already at their final location)
+	for(const auto &Deferred : DeferredActors)
 	{
-		HallBlocks[Level].Push(*LevelOrganisation.GetHallList()[i]);
-		HallBlocks[Level].Last().Level = Level;
-
-		// Replaces the pointer to the initial block
-		LevelOrganisation.SetHallBlock(static_cast<FLevelOrganisation::EInitialHallPositions>(i), &HallBlocks[Level].Last());
+		Deferred.Key->AttachToActor(this, FAttachmentTransformRules(EAttachmentRule::KeepWorld, false));
+		GeneratedActors.Push(Deferred.Key);
 	}
-	
-	//Divide the generated blocks
-	//When a block is generated it generate two new blocks (added to the list) before being retrieved from the list (its node is pointed by the array NodeToDelete)
-	while (ToDivide.Num() != 0)
+	for(AActor *PooledActor : PooledActors)
+	{
+		PooledActor->AttachToActor(this, FAttachmentTransformRules(EAttachmentRule::KeepWorld, false));
+		GeneratedActors.Push(PooledActor);
+	}
+
+	if(bInstanceFurniture || Layout->bTypicalFloors)
+		FlushFurnitureInstances();
+
+	if(bMergeRoomProxies)
+		BuildRoomProxies(SpawnBuffer, CommandActors);
+
+	UpdateReplicatedFurniture();
+}
+
+bool AHomeGenerator::ShouldInstanceFurniture(const UFurnitureMeshAsset* MeshAsset, int32 Level) const
+{
+	return (bInstanceFurniture || Layout->IsRepeatedLevel(Level)) && !IsValid(MeshAsset->ActorClass) && IsValid(MeshAsset->Mesh);
+}
+
+void AHomeGenerator::BufferFurnitureInstance(const FFurnitureSpawnCommand& Command, const FTransform& RelativeTransform)
+{
+	FFurnitureInstanceInfo Info;
+	Info.Level = Command.Level;
+	Info.RoomIndex = Command.RoomIndex;
+	Info.RoomType = Command.RoomType;
+	Info.FurnitureType = Command.FurnitureType;
+	Info.FurnitureIndex = Command.Index;
+
+	FFurnitureInstanceGroup &Group = FurnitureInstances.FindOrAdd(Layout->MeshCatalog[Command.MeshId]->Mesh);
+	Group.PendingTransforms.Push(RelativeTransform);
+	Group.PendingInfos.Push(Info);
+}
+
+FTransform AHomeGenerator::ComputeMeshTransform(int32 MeshId, const FFurnitureRect& FurnitureRect, const FVector& RoomOffset) const
+{
+	//Handle position and rotation (the footprint gives the pivot of the mesh for each rotation)
+	FTransform MeshTransform(RoomOffset + FurnitureRect.Position.ToVector(Layout->BuildingConstraints.GridSnapLength));
+	MeshTransform.AddToTranslation(Layout->CatalogFootprints[MeshId].GetPivotOffset(FurnitureRect.Rotation));
+	MeshTransform.SetRotation(FRotator(0.f, 90.f * static_cast<uint8>(FurnitureRect.Rotation), 0.f).Quaternion());
+	return MeshTransform;
+}
+
+AActor* AHomeGenerator::PlaceMeshInWorld(const UFurnitureMeshAsset* MeshAsset, const FTransform &WorldTransform, bool &bFromPool)
+{
+	bFromPool = false;
+
+	//Primary check
+	if(MeshAsset == nullptr)
+		return nullptr;
+
+	//Furniture with a gameplay state is spawned by the server and replicated
+	if(GetNetMode() == NM_Client && IsValid(MeshAsset->ActorClass) && MeshAsset->ActorClass.GetDefaultObject()->GetIsReplicated())
+		return nullptr;
+
+	//Reuse a released actor if possible (only the transform and the mesh are updated)
+	const bool bOverrideMesh = IsValid(MeshAsset->Mesh) && (!IsValid(MeshAsset->ActorClass) || MeshAsset->ActorClass.Get()->ImplementsInterface(UFurnitureMeshInt::StaticClass()));
+	UClass * const ActorClass = IsValid(MeshAsset->ActorClass) ? MeshAsset->ActorClass.Get() : AStaticMeshActor::StaticClass();
+	if(UHGActorPool * const ActorPool = GetWorld()->GetSubsystem<UHGActorPool>())
 	{
-		//Removes actual node.
-		TDoubleLinkedList<FUnknownBlock>::TDoubleLinkedListNode * const ExHead = ToDivide.GetHead();
-		TDoubleLinkedList<FUnknownBlock>::TDoubleLinkedListNode *TailBuffer;
-		ToDivide.RemoveNode(ExHead, false);
-		NodesToDelete.AddHead(ExHead);
-		
-		switch (ToDivide.GetHead()->GetValue().ShouldDivide(RoomsDivisionConstraints, LevelDivisionData))
+		if(AActor * const PooledActor = ActorPool->Acquire(ActorClass, bOverrideMesh ? MeshAsset->Mesh : nullptr, WorldTransform))
 		{
-			//Creates a new room.
-			case FUnknownBlock::DivideMethod::NO_DIVIDE:
-				RoomBlocks[Level].Push(FRoomBlock());
-				ExHead->GetValue().TransformToRoom(RoomBlocks[Level].Last());
-				FinalBlocks.Push(&ExHead->GetValue());
-				break;
+			bFromPool = true;
+			return PooledActor;
+		}
+	}
 
-			//Divides the block and places generated blocks at the list's end
-			//Creates a hall.
-			case FUnknownBlock::DivideMethod::SPLIT:
-				HallBlocks[Level].Push(FHallBlock());
-				ToDivide.AddTail(FUnknownBlock());
-				TailBuffer = ToDivide.GetTail();
-				ToDivide.AddTail(FUnknownBlock());
-			
-				ExHead->GetValue().BlockSplit(RoomsDivisionConstraints, TailBuffer->GetValue(), ToDivide.GetTail()->GetValue(), HallBlocks[Level].Last());
-				break;			
-
-			//Divides the block and places generated blocks at the list's end.
-			case FUnknownBlock::DivideMethod::DIVISION:
-				ToDivide.AddTail(FUnknownBlock());
-				TailBuffer = ToDivide.GetTail();
-				ToDivide.AddTail(FUnknownBlock());
-				ExHead->GetValue().BlockDivision(RoomsDivisionConstraints, TailBuffer->GetValue(), ToDivide.GetTail()->GetValue());
-				break;
-			
-			//Trouble in structure : exit.
-			case FUnknownBlock::DivideMethod::ERROR:
-			default:
-				check(false);
-				return;
+	//Handle component creation (the actor is constructed later by ExecuteSpawnCommands)
+	AActor *SpawnedActor;
+	if(IsValid(MeshAsset->ActorClass))
+		SpawnedActor = GetWorld()->SpawnActorDeferred<AActor>(ActorClass, WorldTransform, this);
+	else
+	{
+		AStaticMeshActor * const StaticActor = GetWorld()->SpawnActorDeferred<AStaticMeshActor>(AStaticMeshActor::StaticClass(), WorldTransform, this);
+		if(StaticActor)
+		{
+			//Movable so the actor can be moved when it is reused from the pool
+			StaticActor->SetMobility(EComponentMobility::Movable);
+			StaticActor->GetStaticMeshComponent()->SetStaticMesh(MeshAsset->Mesh);
 		}
+		SpawnedActor = StaticActor;
 	}
 
-	for(auto *FinalBlock : FinalBlocks)
-		FinalBlock->ConnectDoors(SelectedDoor);
+	return SpawnedActor;
 }
 
-void AHomeGenerator::ComputeWallEffect(TArray<FLevelOrganisation>& LevelsOrganisation)
+void AHomeGenerator::FlushFurnitureInstances()
 {
-	check(LevelsOrganisation.Num() == BuildingConstraints.Levels)
-	TArray<FVector2D> NeededOffsets;
-	NeededOffsets.Reserve(LevelsOrganisation.Num());
-	
-	//Compute all basic data recursively
-	for (int i = 0; i < LevelsOrganisation.Num(); ++i)
+	for(auto &Instances : FurnitureInstances)
 	{
-		LevelsOrganisation[i].ComputeBasicRealData(BuildingConstraints, RoomsDivisionConstraints);
-		NeededOffsets.Push(LevelsOrganisation[i].GetStairsRealOffset()); //First stores stairs offset of each lvl
+		FFurnitureInstanceGroup &Group = Instances.Value;
+		if(Group.PendingTransforms.Num() == 0)
+			continue;
+
+		//One component per mesh
+		if(!IsValid(Group.Component))
+		{
+			Group.Component = NewObject<UHierarchicalInstancedStaticMeshComponent>(this);
+			Group.Component->SetStaticMesh(Instances.Key);
+			Group.Component->SetupAttachment(RootComponent);
+			Group.Component->RegisterComponent();
+			AddInstanceComponent(Group.Component);
+		}
+
+		//Transforms are relative to the generator, so to the component
+		Group.Component->AddInstances(Group.PendingTransforms, false);
+		for(const FFurnitureInstanceInfo &Info : Group.PendingInfos)
+			Group.InstanceIndices.Add(MakeFurnitureId(Info), Group.Infos.Add(Info));
+
+		Group.PendingTransforms.Empty();
+		Group.PendingInfos.Empty();
 	}
+}
+
+bool AHomeGenerator::GetFurnitureInstanceInfo(const UInstancedStaticMeshComponent* Component, int32 InstanceIndex, FFurnitureInstanceInfo& Info) const
+{
+	if(Component == nullptr)
+		return false;
 
-	//Find maximal stairs' offset
-	FVector2D MaxOffset = FVector2D::ZeroVector;
-	for (const auto &Offset : NeededOffsets)
+	for(const auto &Instances : FurnitureInstances)
 	{
-		if(Offset.X > MaxOffset.X)
-			MaxOffset.X = Offset.X;
-		if(Offset.Y > MaxOffset.Y)
-			MaxOffset.Y = Offset.Y;
+		if(Instances.Value.Component != Component)
+			continue;
+
+		if(!Instances.Value.Infos.IsValidIndex(InstanceIndex))
+			return false;
+
+		Info = Instances.Value.Infos[InstanceIndex];
+		return true;
 	}
 
-	//Finally compute all internal real data by aligning all stairs
-	for (int i = 0; i < NeededOffsets.Num(); ++i) //Then stores the offset to add to each lvl
-		LevelsOrganisation[i].ComputeAllRealData(MaxOffset - NeededOffsets[i], BuildingConstraints, RoomsDivisionConstraints);
+	return false;
 }
 
-void AHomeGenerator::AllocateSurface()
+namespace
 {
-	check(HallBlocks.Num() == BuildingConstraints.Levels && RoomBlocks.Num() == BuildingConstraints.Levels);
-
-	//Sort all rooms of the building
-	TArray<FRoomBlock *> SortedRoomBlocks;
-	int NeededPlace = 0;
-	for (int i = 0; i < RoomBlocks.Num(); ++i) NeededPlace += RoomBlocks[i].Num(); //To avoid reallocation each time we add something
-	SortedRoomBlocks.Reserve(NeededPlace);
-	
-	for (int i = 0; i < RoomBlocks.Num(); ++i)
-		for (int j = 0; j < RoomBlocks[i].Num(); ++j)
-			SortedRoomBlocks.Push(&RoomBlocks[i][j]);
-	SortedRoomBlocks.Sort(); //Croissant order : we define first the smallest ones
+	//Section of a static mesh (LOD 0) with its material
+	struct FStaticMeshSection
+	{
+		UMaterialInterface *Material = nullptr;
+		FHGMeshSection Geometry;
+	};
 
-	//For the next part we suppose that `Rooms`' map has already been sorted accordingly to its MinimalSide property
-	const int Diff  = BuildingConstraints.NormalRoomQuantity - SortedRoomBlocks.Num();
-	if(0 < Diff)
+	//Reads the geometry of all the sections of a mesh (empty if the mesh can't be read on the CPU)
+	void ReadStaticMeshSections(UStaticMesh *Mesh, TArray<FStaticMeshSection> &Sections)
 	{
-		TArray<FName> RoomsToAvoid;
-		RoomsToAvoid.Reserve(Diff);
-		
-		for (int i = 0; i < Diff; ++i)
+		const FStaticMeshRenderData * const RenderData = Mesh->GetRenderData();
+		if(RenderData == nullptr || RenderData->LODResources.Num() == 0)
+			return;
+#if !WITH_EDITOR
+		if(!Mesh->bAllowCPUAccess)
+			return;
+#endif
+
+		const FStaticMeshLODResources &LOD = RenderData->LODResources[0];
+		for(int32 SectionIndex = 0; SectionIndex < LOD.Sections.Num(); ++SectionIndex)
 		{
-			TPair<FName, int> MaxPresence;
-			TPair<FName, int> MinRest;
-			MaxPresence.Value = 0;
-			MinRest.Value = 1;
+			FStaticMeshSection &Section = Sections.AddDefaulted_GetRef();
+			Section.Material = Mesh->GetMaterial(LOD.Sections[SectionIndex].MaterialIndex);
+			UKismetProceduralMeshLibrary::GetSectionFromStaticMesh(Mesh, 0, SectionIndex, Section.Geometry.Vertices, Section.Geometry.Triangles, Section.Geometry.Normals, Section.Geometry.UVs, Section.Geometry.Tangents);
+		}
+	}
+}
 
-			for (const auto &Room : Rooms)
-			{
-				//Here we use Floor to check the decimal part : lower one means more rounded when floored
-				const float DesiredNumber = Room.Value.NumPerHab * Inhabitants;
-				const float Rest = DesiredNumber - FMath::Floor(DesiredNumber);
-				
-				if(DesiredNumber > MaxPresence.Value)
-				{
-					MaxPresence.Key = Room.Key;
-					MaxPresence.Value = DesiredNumber;
-				}
-				else if(DesiredNumber == MaxPresence.Value)
-				{
-					if(RoomsToAvoid.Contains(MaxPresence.Key) && !RoomsToAvoid.Contains(Room.Key))
-					{
-						MaxPresence.Key = Room.Key;
-						MaxPresence.Value = DesiredNumber;
-					}
-				}
-
-				if(Rest < MinRest.Value)
-				{
-					MinRest.Key = Room.Key;
-					MinRest.Value = Rest;
-				}
-				else if(Rest == MinRest.Value)
-				{
-					if(RoomsToAvoid.Contains(MinRest.Key) && !RoomsToAvoid.Contains(Room.Key))
-					{
-						MinRest.Key = Room.Key;
-						MinRest.Value = Rest;
-					}
-				}
-			}
+void AHomeGenerator::BuildRoomProxies(const FFurnitureSpawnBuffer& SpawnBuffer, const TArray<AActor*>& CommandActors)
+{
+	QUICK_SCOPE_CYCLE_COUNTER(STAT_HomeGenerator_BuildRoomProxies);
+	check(CommandActors.Num() == SpawnBuffer.Commands.Num())
 
-			if(MaxPresence.Value > 1)
-				RoomsToAvoid.Push(MaxPresence.Key);
-			else
-				RoomsToAvoid.Push(MinRest.Key);
-		}
+	//Each mesh is only read once
+	TMap<UStaticMesh *, TArray<FStaticMeshSection>> MeshSections;
+
+	//Merged geometry of each room, by material
+	TMap<FIntPoint, TMap<UMaterialInterface *, FHGMeshSection>> RoomSections;
+
+	for(int32 CommandIndex = 0; CommandIndex < SpawnBuffer.Commands.Num(); ++CommandIndex)
+	{
+		//Only plain static mesh actors are merged (custom classes may have a behaviour)
+		AStaticMeshActor * const StaticActor = Cast<AStaticMeshActor>(CommandActors[CommandIndex]);
+		if(StaticActor == nullptr)
+			continue;
+
+		const FFurnitureSpawnCommand &Command = SpawnBuffer.Commands[CommandIndex];
+		const UFurnitureMeshAsset * const MeshAsset = Layout->MeshCatalog[Command.MeshId];
+		if(!IsValid(MeshAsset->Mesh))
+			continue;
 
-		int RoomIndex = 0;
-		for (const auto &Room : Rooms)
+		TArray<FStaticMeshSection> *Sections = MeshSections.Find(MeshAsset->Mesh);
+		if(Sections == nullptr)
 		{
-			const int DesiredNumber = (Room.Value.NumPerHab * Inhabitants) - RoomsToAvoid.RemoveAll([&Room](const FName &A) {return A == Room.Key;});
-			for (int i = 0; i < DesiredNumber; ++i)
-			{
-				SortedRoomBlocks[RoomIndex]->RoomType = Room.Key;
-				++RoomIndex;
-			}
+			Sections = &MeshSections.Add(MeshAsset->Mesh);
+			ReadStaticMeshSections(MeshAsset->Mesh, *Sections);
 		}
+		if(Sections->Num() == 0)
+			continue;
+
+		//Proxy is built relative to the generator
+		const FIntPoint RoomKey(Command.Level, Command.RoomIndex);
+		FTransform RelativeTransform;
+		if(!ComputeCommandTransform(Command, RelativeTransform))
+			continue;
+		TMap<UMaterialInterface *, FHGMeshSection> &Merged = RoomSections.FindOrAdd(RoomKey);
+		for(const FStaticMeshSection &Section : *Sections)
+			Merged.FindOrAdd(Section.Material).Append(Section.Geometry, RelativeTransform);
+
+		RoomProxies.FindOrAdd(RoomKey).Actors.Push(StaticActor);
 	}
-	else if(0 > Diff)
+
+	for(auto &RoomSection : RoomSections)
 	{
-		TArray<FName> RoomsToAdd;
-		RoomsToAdd.Reserve(-Diff);
-		
-		for (int i = 0; i < -Diff; ++i)
+		FRoomProxy &RoomProxy = RoomProxies[RoomSection.Key];
+		if(!IsValid(RoomProxy.Component))
 		{
-			TPair<FName, int> MinPresence;
-			TPair<FName, int> MaxRest;
-			MinPresence.Value = 0;
-			MaxRest.Value = 1;
-
-			for (const auto &Room : Rooms)
+			if(FreeProxyComponents.Num() > 0)
+				RoomProxy.Component = FreeProxyComponents.Pop(false);
+			else
 			{
-				//Here we use Floor to check the decimal part : bigger one means less rounded when floored
-				const float DesiredNumber = Room.Value.NumPerHab * Inhabitants;
-				const float Rest = DesiredNumber - FMath::Floor(DesiredNumber);
-
-				if(Rest > MaxRest.Value)
-				{
-					MaxRest.Key = Room.Key;
-					MaxRest.Value = Rest;
-				}
-				else if(Rest == MaxRest.Value)
-				{
-					if(RoomsToAdd.Contains(MaxRest.Key) && !RoomsToAdd.Contains(Room.Key))
-					{
-						MaxRest.Key = Room.Key;
-						MaxRest.Value = Rest;
-					}
-				}
-
-				if(DesiredNumber < MinPresence.Value)
-				{
-					MinPresence.Key = Room.Key;
-					MinPresence.Value = DesiredNumber;
-				}
-				else if(DesiredNumber == MinPresence.Value)
-				{
-					if(RoomsToAdd.Contains(MinPresence.Key) && !RoomsToAdd.Contains(Room.Key))
-					{
-						MinPresence.Key = Room.Key;
-						MinPresence.Value = DesiredNumber;
-					}
-				}
+				RoomProxy.Component = NewObject<UProceduralMeshComponent>(this);
+				RoomProxy.Component->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+				RoomProxy.Component->SetupAttachment(RootComponent);
+				RoomProxy.Component->RegisterComponent();
+				AddInstanceComponent(RoomProxy.Component);
 			}
-
-			if(MaxRest.Value > 0.5)
-				RoomsToAdd.Push(MaxRest.Key);
-			else
-				RoomsToAdd.Push(MinPresence.Key);
 		}
 
-		int RoomIndex = 0;
-		for (const auto &Room : Rooms)
+		//One section per material
+		FBox LocalBounds(ForceInit);
+		int32 SectionIndex = 0;
+		for(auto &Section : RoomSection.Value)
 		{
-			const int DesiredNumber = (Room.Value.NumPerHab * Inhabitants) + RoomsToAdd.RemoveAll([&Room](const FName &A) {return A == Room.Key;});
-			for (int i = 0; i < DesiredNumber; ++i)
-			{
-				SortedRoomBlocks[RoomIndex]->RoomType = Room.Key;
-				++RoomIndex;
-			}
+			FHGMeshSection &Geometry = Section.Value;
+			RoomProxy.Component->CreateMeshSection_LinearColor(SectionIndex, Geometry.Vertices, Geometry.Triangles, Geometry.Normals, Geometry.UVs, TArray<FLinearColor>(), Geometry.Tangents, false);
+			RoomProxy.Component->SetMaterial(SectionIndex, Section.Key);
+			LocalBounds += FBox(Geometry.Vertices);
+			++SectionIndex;
 		}
+		RoomProxy.Bounds = LocalBounds.TransformBy(GetActorTransform());
+
+		//Individual furniture until the next update
+		RoomProxy.bProxyShown = true;
+		SetRoomProxyShown(RoomProxy, false);
+	}
+}
+
+void AHomeGenerator::ReleaseRoomProxy(const FIntPoint& RoomKey)
+{
+	FRoomProxy RoomProxy;
+	if(!RoomProxies.RemoveAndCopyValue(RoomKey, RoomProxy))
+		return;
+
+	//Individual furniture visible again (it may be reused by another room)
+	RoomProxy.bProxyShown = true;
+	if(IsValid(RoomProxy.Component))
+	{
+		SetRoomProxyShown(RoomProxy, false);
+		RoomProxy.Component->ClearAllMeshSections();
+		FreeProxyComponents.Push(RoomProxy.Component);
+	}
+}
+
+void AHomeGenerator::UpdateRoomProxies()
+{
+	TArray<FVector> ViewerLocations;
+	GetViewerLocations(ViewerLocations);
+
+	for(auto &RoomProxy : RoomProxies)
+	{
+		FRoomProxy &Proxy = RoomProxy.Value;
+		if(!IsValid(Proxy.Component))
+			continue;
+
+		//A viewer inside the room, or near it, sees the individual furniture
+		const FBox SwapBounds = Proxy.Bounds.ExpandBy(ProxySwapDistance);
+		bool bViewerNear = ViewerLocations.Num() == 0;
+		for(const FVector &Location : ViewerLocations)
+			bViewerNear |= SwapBounds.IsInsideOrOn(Location);
+
+		SetRoomProxyShown(Proxy, !bViewerNear);
 	}
 }
 
-void AHomeGenerator::GenerateRoom(const FName& RoomType, const FRoomBlock& RoomBlock)
+void AHomeGenerator::SetRoomProxyShown(FRoomProxy& RoomProxy, bool bShown)
 {
-	FRoomGrid RoomGrid(RoomBlock.Size);
-	GenerateRoomDoors(RoomType, RoomBlock, RoomGrid);
-	GenerateFurniture(RoomType, RoomBlock.GenerateRoomOffset(BuildingConstraints), RoomGrid);
-	//GenerateDecoration(RoomType, ...)
+	if(RoomProxy.bProxyShown == bShown)
+		return;
+
+	RoomProxy.bProxyShown = bShown;
+	RoomProxy.Component->SetVisibility(bShown);
+	for(AActor *Actor : RoomProxy.Actors)
+		if(IsValid(Actor))
+			Actor->SetActorHiddenInGame(bShown);
 }
 
-void AHomeGenerator::GenerateRoomDoors(const FName& RoomType, const FRoomBlock& RoomBlock, FRoomGrid& RoomGrid)
+void AHomeGenerator::GetViewerLocations(TArray<FVector>& ViewerLocations) const
 {
-	for(FDoorBlock* DoorBlock : RoomBlock.ConnectedDoors)
+	for(FConstPlayerControllerIterator Iterator = GetWorld()->GetPlayerControllerIterator(); Iterator; ++Iterator)
 	{
-		if (!DoorBlock->IsPlaced())
-		{
-			//Define a random possible position
-			if (!DoorBlock->IsPositionValid())
-			{
-				const FRoomBlock *OtherRoom = DoorBlock->ObtainOppositeParent(RoomBlock);
-				const FVectorGrid MarginSize = DoorBlock->GenerateLocalMarginSize(RoomBlock, Doors.DefaultConstraints.Margin);
-
-				//Inclusive limits for the door
-				FVectorGrid PositionMin = OtherRoom != nullptr ? FVectorGrid::Max(FVectorGrid(0,0), OtherRoom->GlobalPosition - RoomBlock.GlobalPosition) : FVectorGrid(0,0);
-				FVectorGrid PositionMax = OtherRoom != nullptr ? FVectorGrid::Min(RoomBlock.Size , OtherRoom->Size + OtherRoom->GlobalPosition - RoomBlock.GlobalPosition) : RoomBlock.Size;
-				PositionMax -= MarginSize;
-
-				//Depending on its opening wall, it adjusts
-				switch(DoorBlock->RoomWallAxe(RoomBlock))
-				{
-					case EGenerationAxe::X_UP: PositionMax.X = PositionMin.X = RoomBlock.Size.X; break;
-					case EGenerationAxe::X_DOWN: PositionMax.X = PositionMin.X = 0; break;
-					
-					case EGenerationAxe::Y_UP: PositionMax.Y = PositionMin.Y = RoomBlock.Size.Y; break;
-					case EGenerationAxe::Y_DOWN: PositionMax.Y = PositionMin.Y = 0; break;
-					default : check(false);
-				}
-
-				DoorBlock->SaveLocalPosition(FVectorGrid::Random(PositionMin, PositionMax), RoomBlock);
-			}
+		const APlayerController * const PlayerController = Iterator->Get();
+		if(PlayerController == nullptr || !PlayerController->IsLocalController())
+			continue;
 
-			//Place the door
-			PlaceMeshInWorld(DoorBlock->GetMeshAsset(), DoorBlock->GenerateLocalFurnitureRect(RoomBlock), RoomBlock.GenerateRoomOffset(BuildingConstraints));
-			DoorBlock->MarkAsPlaced();
+		if(const APawn * const Pawn = PlayerController->GetPawn())
+		{
+			ViewerLocations.Push(Pawn->GetActorLocation());
+			continue;
 		}
 
-		//Marks the grid, for the future furniture placement
-		RoomGrid.MarkDoorAtPosition(DoorBlock->GenerateLocalFurnitureRect(RoomBlock));
+		FVector Location;
+		FRotator Rotation;
+		PlayerController->GetPlayerViewPoint(Location, Rotation);
+		ViewerLocations.Push(Location);
 	}
 }
 
-void AHomeGenerator::GenerateFurniture(const FName& RoomType, const FVector& RoomOrigin, FRoomGrid& RoomGrid)
+void AHomeGenerator::UpdateStreamedRooms()
 {
-	const FRoom * const Room = Rooms.Find(RoomType);
-	check(RoomGrid.GetSizeX() > 0 && RoomGrid.GetSizeY() > 0)
-	check(Room->GetMinimalSide() <= RoomGrid.GetSizeX() &&  Room->GetMinimalSide() <= RoomGrid.GetSizeY())
+	QUICK_SCOPE_CYCLE_COUNTER(STAT_HomeGenerator_UpdateStreamedRooms);
 
-	//Possible positions
-	TArray<int> PositionX;
-	TArray<int> PositionY;
-	TArray<EFurnitureRotation> Rotations = {EFurnitureRotation::ROT0, EFurnitureRotation::ROT90, EFurnitureRotation::ROT180, EFurnitureRotation::ROT270};
-	GenerateRangeArray(PositionX, RoomGrid.GetSizeX());
-	GenerateRangeArray(PositionY, RoomGrid.GetSizeY());
+	TArray<FVector> ViewerLocations;
+	GetViewerLocations(ViewerLocations);
 
-	//Dependencies management
-	TArray<FDependencyBuffer> FurnitureWithDep;
-
-	//First furniture placement
-	for(const auto &_FurnitureType : Room->Furniture)
+	//Rooms a player is in, and rooms a player is near
+	TSet<const FRoomBlock *> OccupiedRooms;
+	TSet<const FRoomBlock *> WantedRooms;
+	TSet<const FRoomBlock *> KeptRooms;
+	for(const auto &LevelRooms : Layout->RoomBlocks)
 	{
-		FFurniture * const _Furniture = Furniture.Find(_FurnitureType);
-		//Checks on the found structure (just skip if there are some errors)
-		if(_Furniture == nullptr)
-			continue;
-		
-		//Shuffle everything here to allow more random generation (useless to update on each mesh)
-		ShuffleArray(_Furniture->Mesh);
-		ShuffleArray(PositionX);
-		ShuffleArray(PositionY);
-		ShuffleArray(Rotations);
-
-		//Find already known values
-		const uint8 DependencyIndex = _Furniture->Dependencies.Num() > 0 ? FurnitureWithDep.Num() + 1 : 0;
-		bool MeshFounded = false;
-		
-		for(const UFurnitureMeshAsset* _Mesh : _Furniture->Mesh)
+		for(const FRoomBlock &RoomBlock : LevelRooms)
 		{
-			//Checks on the found structure (just skip if there are some errors)
-			if(_Mesh == nullptr || !IsValid(_Mesh->ActorClass) && !IsValid(_Mesh->Mesh))
-				continue;
-
-			//Define needed value
-			const FFurnitureConstraint &FinalConstraints = _Mesh->bOverrideConstraint ? _Mesh->ConstraintsOverride : _Furniture->DefaultConstraints;
-			
-			for(const int X : PositionX)
+			const FBox RoomBounds = ComputeRoomBounds(RoomBlock);
+			for(const FVector &Location : ViewerLocations)
 			{
-				for(const int Y : PositionY)
-				{
-					for(const auto Rotation : Rotations)
-					{
-						FFurnitureRect FinalRect(Rotation, FVectorGrid(X, Y), _Mesh->GridSize);
-						MeshFounded = RoomGrid.MarkFurnitureAtPosition(FinalRect, FinalConstraints, DependencyIndex);
-						if(MeshFounded)
-						{
-							AActor * SpawnedActor = PlaceMeshInWorld(_Mesh, FinalRect, RoomOrigin);
-							if(DependencyIndex)
-								FurnitureWithDep.Push(FDependencyBuffer(_Furniture->Dependencies, FinalRect));
-
-							break;
-						}
-					}
-
-					if(MeshFounded)
-						break;
-				}
-
-				if(MeshFounded)
-					break;
+				if(RoomBounds.IsInsideOrOn(Location))
+					OccupiedRooms.Add(&RoomBlock);
+				if(RoomBounds.ExpandBy(StreamingRadius).IsInsideOrOn(Location))
+					WantedRooms.Add(&RoomBlock);
+				if(RoomBounds.ExpandBy(StreamingRadius + StreamingUnloadMargin).IsInsideOrOn(Location))
+					KeptRooms.Add(&RoomBlock);
 			}
+		}
+	}
 
-			if(MeshFounded)
-				break;
-		}		
+	//A player entering a room sees through its doors
+	for(const FRoomBlock *Room : OccupiedRooms)
+	{
+		for(const FDoorBlock *DoorBlock : Room->ConnectedDoors)
+		{
+			if(const FRoomBlock * const OtherRoom = DoorBlock->ObtainOppositeParent(*Room))
+			{
+				WantedRooms.Add(OtherRoom);
+				KeptRooms.Add(OtherRoom);
+			}
+		}
 	}
 
-	//Dependency placement
-	for(uint8 i = 0; i < FurnitureWithDep.Num(); ++i)
+	bool bRebuildInstances = false;
+	for(const auto &LevelRooms : Layout->RoomBlocks)
 	{
-		for(const FFurnitureDependency &_Dependency : FurnitureWithDep[i].Dependencies)
+		for(const FRoomBlock &RoomBlock : LevelRooms)
 		{
-			FFurniture * const _Furniture = Furniture.Find(_Dependency.FurnitureType);
-			//Checks on the found structure (just skip if there are some errors)
-			if(_Furniture == nullptr)
+			const FRoomStreamingState * const State = StreamedRooms.Find(FIntPoint(RoomBlock.Level, RoomBlock.Index));
+			if(State == nullptr)
 				continue;
-		
-			//Shuffle everything here to allow more random generation (useless to update on each mesh)
-			ShuffleArray(_Furniture->Mesh);
-			ShuffleArray(PositionX);
-			ShuffleArray(PositionY);
-			ShuffleArray(Rotations);
-			
-			bool MeshFounded = false;
-		
-			for(const UFurnitureMeshAsset* _Mesh : _Furniture->Mesh)
-			{
-				//Checks on the found structure (just skip if there are some errors)
-				if(_Mesh == nullptr || !IsValid(_Mesh->ActorClass) && !IsValid(_Mesh->Mesh))
-					continue;
 
-				//Define needed value
-				const FFurnitureConstraint &FinalConstraints = _Mesh->bOverrideConstraint ? _Mesh->ConstraintsOverride : _Furniture->DefaultConstraints;
-			
-				for(const int X : PositionX)
-				{
-					for(const int Y : PositionY)
-					{
-						for(const auto Rotation : Rotations)
-						{
-							FFurnitureRect FinalRect(Rotation, FVectorGrid(X, Y), _Mesh->GridSize);
-							MeshFounded = RoomGrid.MarkDependencyAtPosition(FinalRect, FurnitureWithDep[i].ParentPosition, FinalConstraints, _Dependency, i + 1);
-							if(MeshFounded)
-							{
-								AActor *SpawnedActor = PlaceMeshInWorld(_Mesh, FinalRect, RoomOrigin);
-								break;
-							}
-						}
-
-						if(MeshFounded)
-							break;
-					}
-
-					if(MeshFounded)
-						break;
-				}
-
-				if(MeshFounded)
-					break;
-			}		
+			if(!State->bFurnished && WantedRooms.Contains(&RoomBlock))
+				FurnishRoom(RoomBlock);
+			else if(State->bFurnished && !KeptRooms.Contains(&RoomBlock))
+				bRebuildInstances |= UnfurnishRoom(RoomBlock);
 		}
 	}
+
+	if(bRebuildInstances)
+		RebuildFurnitureInstances();
 }
 
-AActor* AHomeGenerator::PlaceMeshInWorld(const UFurnitureMeshAsset* MeshAsset, const FFurnitureRect& FurnitureRect, const FVector& RoomOffset)
+void AHomeGenerator::FurnishRoom(const FRoomBlock& RoomBlock)
 {
-	//Primary check
-	if(MeshAsset == nullptr)
+	FRoomStreamingState &State = StreamedRooms.FindOrAdd(FIntPoint(RoomBlock.Level, RoomBlock.Index));
+	if(State.bFurnished)
+		return;
+
+	//Placement is only done once : the room is then always furnished identically
+	if(!State.bRecorded)
+	{
+		Layout->GenerateRoom(RoomBlock.RoomType, RoomBlock, State.Commands);
+		RecordAddedFurniture(State.Commands, RoomBlock.Level, RoomBlock.Index);
+		State.bRecorded = true;
+	}
+
+	const int32 FirstActor = GeneratedActors.Num();
+	ExecuteSpawnCommands(State.Commands);
+	State.Actors.Reset();
+	for(int32 ActorIndex = FirstActor; ActorIndex < GeneratedActors.Num(); ++ActorIndex)
+		State.Actors.Push(GeneratedActors[ActorIndex]);
+
+	State.bFurnished = true;
+}
+
+bool AHomeGenerator::UnfurnishRoom(const FRoomBlock& RoomBlock)
+{
+	const FIntPoint RoomKey(RoomBlock.Level, RoomBlock.Index);
+	FRoomStreamingState * const State = StreamedRooms.Find(RoomKey);
+	if(State == nullptr || !State->bFurnished)
+		return false;
+
+	ReleaseRoomProxy(RoomKey);
+
+	//A door stays while the other room of the door is furnished : it is handed over to that room.
+	//Else it is released, and its command goes back to the room recording it.
+	TArray<FFurnitureSpawnCommand> ReleasedCommands;
+	for(int32 CommandIndex = State->Commands.Num() - 1; CommandIndex >= 0; --CommandIndex)
+	{
+		const FFurnitureSpawnCommand Command = State->Commands.Commands[CommandIndex];
+		const FDoorBlock * const DoorBlock = FindCommandDoor(Command);
+		if(DoorBlock == nullptr)
+		{
+			ReleasedCommands.Push(Command);
+			continue;
+		}
+
+		const FRoomBlock * const OtherRoom = DoorBlock->ObtainOppositeParent(RoomBlock);
+		FRoomStreamingState * const OtherState = OtherRoom ? StreamedRooms.Find(FIntPoint(OtherRoom->Level, OtherRoom->Index)) : nullptr;
+		FRoomStreamingState * const RecordingState = StreamedRooms.Find(FIntPoint(Command.Level, Command.RoomIndex));
+		if(OtherState && OtherState->bFurnished)
+		{
+			OtherState->Commands.Commands.Push(Command);
+			if(AActor * const * const DoorActor = FurnitureActorIds.Find(MakeFurnitureId(Command)))
+			{
+				State->Actors.RemoveSingleSwap(*DoorActor, false);
+				OtherState->Actors.Push(*DoorActor);
+			}
+			State->Commands.Commands.RemoveAt(CommandIndex);
+		}
+		else
+		{
+			ReleasedCommands.Push(Command);
+			if(RecordingState && RecordingState != State)
+			{
+				RecordingState->Commands.Commands.Push(Command);
+				State->Commands.Commands.RemoveAt(CommandIndex);
+			}
+		}
+	}
+
+	UHGActorPool * const ActorPool = GetWorld()->GetSubsystem<UHGActorPool>();
+	for(AActor *RoomActor : State->Actors)
+	{
+		GeneratedActors.RemoveSingleSwap(RoomActor, false);
+		if(ActorPool)
+			ActorPool->Release(RoomActor);
+		else if(IsValid(RoomActor))
+			RoomActor->Destroy();
+	}
+	State->Actors.Reset();
+	State->bFurnished = false;
+	for(const FFurnitureSpawnCommand &Command : ReleasedCommands)
+		FurnitureActorIds.Remove(MakeFurnitureId(Command));
+	UpdateReplicatedFurniture();
+
+	//Checks if some of the furniture was instanced
+	for(const FFurnitureSpawnCommand &Command : ReleasedCommands)
+		if(Layout->MeshCatalog.IsValidIndex(Command.MeshId) && Layout->MeshCatalog[Command.MeshId] && ShouldInstanceFurniture(Layout->MeshCatalog[Command.MeshId], Command.Level))
+			return true;
+	return false;
+}
+
+const FDoorBlock* AHomeGenerator::FindCommandDoor(const FFurnitureSpawnCommand& Command) const
+{
+	if(Command.Index < 0 || Command.FurnitureType != TEXT("Door") || !Layout->RoomBlocks.IsValidIndex(Command.Level) || !Layout->RoomBlocks[Command.Level].IsValidIndex(Command.RoomIndex))
 		return nullptr;
 
-	//Handle position and rotation
-	FTransform ToSpawnTransform(RoomOffset + FurnitureRect.Position.ToVector(BuildingConstraints.GridSnapLength));
-	switch (FurnitureRect.Rotation)
+	//The door at the position of the command, among the doors recorded by its room
+	const FRoomBlock &RecordingRoom = Layout->RoomBlocks[Command.Level][Command.RoomIndex];
+	for(const FDoorBlock *DoorBlock : RecordingRoom.ConnectedDoors)
 	{
-		case EFurnitureRotation::ROT0:
-			ToSpawnTransform.AddToTranslation(-MeshAsset->BoundsOrigin);
-			break;
-		case EFurnitureRotation::ROT90:
-			ToSpawnTransform.AddToTranslation(-FVector(MeshAsset->BoundsOrigin.Y, MeshAsset->BoundsOrigin.X, MeshAsset->BoundsOrigin.Z));
-			ToSpawnTransform.SetRotation(FRotator(0.f, 90.f, 0.f).Quaternion());
-			break;
-		case EFurnitureRotation::ROT180: 
-			ToSpawnTransform.AddToTranslation(MeshAsset->BoundsOrigin);
-			ToSpawnTransform.SetRotation(FRotator(0.f, 180.f, 0.f).Quaternion());
-			break;
-		case EFurnitureRotation::ROT270:
-			ToSpawnTransform.AddToTranslation(FVector(MeshAsset->BoundsOrigin.Y, MeshAsset->BoundsOrigin.X, MeshAsset->BoundsOrigin.Z));
-			ToSpawnTransform.SetRotation(FRotator(0.f, 270.f, 0.f).Quaternion());
-			break;
+		if(!DoorBlock->IsRecordedBy(RecordingRoom))
+			continue;
+
+		const FFurnitureRect DoorRect = DoorBlock->GenerateLocalFurnitureRect(RecordingRoom);
+		if(DoorRect.Position.X == Command.Rect.Position.X && DoorRect.Position.Y == Command.Rect.Position.Y)
+			return DoorBlock;
 	}
+	return nullptr;
+}
 
-	//Handle component creation
-	AActor *SpawnedActor;
-	if(IsValid(MeshAsset->ActorClass))
+void AHomeGenerator::RebuildFurnitureInstances()
+{
+	for(auto &Instances : FurnitureInstances)
 	{
-		SpawnedActor = GetWorld()->SpawnActor(MeshAsset->ActorClass.Get(), &ToSpawnTransform);
-		
-		if(MeshAsset->ActorClass.Get()->ImplementsInterface(UFurnitureMeshInt::StaticClass()) && IsValid(MeshAsset->Mesh))
-			IFurnitureMeshInt::Execute_GetStaticMeshComponent(SpawnedActor)->SetStaticMesh(MeshAsset->Mesh);
+		if(IsValid(Instances.Value.Component))
+			Instances.Value.Component->ClearInstances();
+		Instances.Value.Infos.Reset();
+		Instances.Value.InstanceIndices.Reset();
+		Instances.Value.PendingTransforms.Reset();
+		Instances.Value.PendingInfos.Reset();
 	}
-	else
+
+	for(const auto &StreamedRoom : StreamedRooms)
 	{
-		SpawnedActor = GetWorld()->SpawnActor(AStaticMeshActor::StaticClass(), &ToSpawnTransform);
-		const AStaticMeshActor * const StaticActor = Cast<AStaticMeshActor>(SpawnedActor);
-		StaticActor->GetStaticMeshComponent()->SetStaticMesh(MeshAsset->Mesh);
+		if(!StreamedRoom.Value.bFurnished)
+			continue;
+
+		for(const FFurnitureSpawnCommand &Command : StreamedRoom.Value.Commands.Commands)
+		{
+			if(!Layout->MeshCatalog.IsValidIndex(Command.MeshId) || Layout->MeshCatalog[Command.MeshId] == nullptr)
+				continue;
+
+			FTransform RelativeTransform;
+			if(ShouldInstanceFurniture(Layout->MeshCatalog[Command.MeshId], Command.Level) && ComputeCommandTransform(Command, RelativeTransform))
+				BufferFurnitureInstance(Command, RelativeTransform);
+		}
 	}
 
-	//Finally attach to the generator
-	SpawnedActor->AttachToActor(this, FAttachmentTransformRules(EAttachmentRule::KeepRelative, false));
+	FlushFurnitureInstances();
+}
 
-	return SpawnedActor;
+FBox AHomeGenerator::ComputeRoomBounds(const FRoomBlock& RoomBlock) const
+{
+	const FHGBuildingConstraints &Constraints = Layout->BuildingConstraints;
+	const FVector RoomOffset = RoomBlock.GenerateRoomOffset(Constraints);
+	const FVector RoomSize(
+		RoomBlock.Size.X * Constraints.GridSnapLength,
+		RoomBlock.Size.Y * Constraints.GridSnapLength,
+		Constraints.FloorHeight + Constraints.FloorWidth
+	);
+	return FBox(RoomOffset, RoomOffset + RoomSize).TransformBy(GetActorTransform());
 }
 
 // Called every frame
 void AHomeGenerator::Tick(float DeltaTime)
 {
 	Super::Tick(DeltaTime);
+
+	//Only ticks during a time sliced generation (not driven by the scheduler)
+	if(SlicedStage == EHGSlicedStage::None || bScheduledSpawn)
+	{
+		SetActorTickEnabled(false);
+		return;
+	}
+
+	QUICK_SCOPE_CYCLE_COUNTER(STAT_HomeGenerator_SlicedGeneration);
+	const double EndTime = FPlatformTime::Seconds() + TimeSliceBudget / 1000.0;
+	do
+	{
+		if(!AdvanceSlicedGeneration())
+		{
+			SetActorTickEnabled(false);
+			return;
+		}
+	}
+	while(FPlatformTime::Seconds() < EndTime);
 }
 
@@ -2,4 +2,93 @@
 
 
 #include "WindowMeshAsset.h"
+#include "HomeGeneration.h"
+#include "HGLayoutCache.h"
 
+bool UWindowMeshAsset::ValidateFootprint(float GridSnapLength, const FWindowConstraint& DefaultConstraints, FMeshFootprint& GridFootprint, FVectorGrid& GridSize)
+{
+#if WITH_EDITOR
+	//Nothing baked yet (asset never saved since the footprint exists) : bake it now
+	if(!Footprint.HasBounds() && IsValid(Mesh))
+		BakeFootprint();
+#endif
+
+	GridFootprint = Footprint;
+	if(!Footprint.HasBounds())
+	{
+		UE_LOG(LogHomeGeneration, Warning, TEXT("%s has no baked footprint : it won't be placed."), *GetName());
+		GridSize = FVectorGrid::Zero;
+		return false;
+	}
+
+	if(!Footprint.IsValidFor(GridSnapLength))
+		GridFootprint.ComputeGridData(GridSnapLength);
+
+	//A window is placed inside a wall : it doesn't occupy any square along its exterior axis
+	GridSize = GridFootprint.GetGridSize();
+	switch (bOverrideConstraint ? ConstraintsOverride.ExteriorFace : DefaultConstraints.ExteriorFace)
+	{
+		case EGenerationAxe::X_UP:
+		case EGenerationAxe::X_DOWN: GridSize.X = 0; break;
+		case EGenerationAxe::Y_UP:
+		case EGenerationAxe::Y_DOWN: GridSize.Y = 0; break;
+		default: break;
+	}
+
+	return true;
+}
+
+FHGWindowDescriptor UWindowMeshAsset::MakeDescriptor(const FWindowConstraint& DefaultConstraints, const FMeshFootprint& GridFootprint, const FVectorGrid& GridSize) const
+{
+	const FWindowConstraint &Constraints = bOverrideConstraint ? ConstraintsOverride : DefaultConstraints;
+	FHGWindowDescriptor Descriptor;
+	Descriptor.GridSize = GridSize;
+	Descriptor.bHasBounds = GridFootprint.HasBounds();
+	Descriptor.Height = 2.f * GridFootprint.BoxExtent.Z;
+	Descriptor.DistanceFromFloor = Constraints.DistanceFromFloor;
+	Descriptor.ExteriorFace = static_cast<EHGAxe>(Constraints.ExteriorFace);
+	return Descriptor;
+}
+
+const FString& UWindowMeshAsset::GetLayoutHash() const
+{
+	if(LayoutHash.IsEmpty())
+		LayoutHash = HGLayoutCache::HashAsset(this);
+	return LayoutHash;
+}
+
+void UWindowMeshAsset::PostLoad()
+{
+	Super::PostLoad();
+	LayoutHash.Reset();
+
+	if(Footprint.HasBounds() && !Footprint.IsValidFor(BakeGridSnapLength))
+		Footprint.ComputeGridData(BakeGridSnapLength);
+}
+
+#if WITH_EDITOR
+void UWindowMeshAsset::PreSave(const ITargetPlatform* TargetPlatform)
+{
+	Super::PreSave(TargetPlatform);
+	BakeFootprint();
+}
+
+void UWindowMeshAsset::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+	LayoutHash.Reset();
+
+	const FName PropertyName = PropertyChangedEvent.GetPropertyName();
+	if(PropertyName == GET_MEMBER_NAME_CHECKED(UWindowMeshAsset, Mesh) || PropertyName == GET_MEMBER_NAME_CHECKED(UWindowMeshAsset, BakeGridSnapLength))
+		BakeFootprint();
+}
+
+void UWindowMeshAsset::BakeFootprint()
+{
+	LayoutHash.Reset();
+	if(IsValid(Mesh))
+		Footprint.Bake(Mesh, BakeGridSnapLength);
+	else
+		Footprint = FMeshFootprint();
+}
+#endif
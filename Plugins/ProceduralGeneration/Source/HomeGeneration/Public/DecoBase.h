@@ -6,12 +6,68 @@
 #include "UObject/Object.h"
 #include "DecoBase.generated.h"
 
+class UMaterialInterface;
+class UMaterialInstanceDynamic;
+
+//Surfaces of a room which are decorated
+UENUM(BlueprintType)
+enum class EDecorationSurface : uint8
+{
+	Floor,
+	Wall,
+	Ceiling
+};
+
+//Materials of the three surfaces of one room's type
+USTRUCT(BlueprintType)
+struct FRoomDecoration
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly)
+	UMaterialInterface *Floor = nullptr;
+
+	UPROPERTY(BlueprintReadOnly)
+	UMaterialInterface *Wall = nullptr;
+
+	UPROPERTY(BlueprintReadOnly)
+	UMaterialInterface *Ceiling = nullptr;
+
+	UMaterialInterface *GetMaterial(EDecorationSurface Surface) const;
+};
+
 /**
  * Base class for all room's decoration class : they generate the floor, walls and ceil texture for room of the given type.
- * These classes can only have one instance for each HomeGenerator instance (acts like a singleton, but everything is handled by the generator) : it allows more complex generation where one instance generate a more uniform decoration (using room's type).
+ * These classes can only have one instance for each world (acts like a singleton, but everything is handled by the HGDecorationCache) : it allows more complex generation where one instance generate a more uniform decoration (using room's type).
+ * Materials are created once per room's type and shared by all the rooms of this type (of all the generators) : the variation between rooms only comes from the vertex color given by GetRoomVariation.
  */
-UCLASS()
+UCLASS(Blueprintable)
 class HOMEGENERATION_API UDecoBase : public UObject
 {
 	GENERATED_BODY()
+
+public:
+	//Parent materials of each surface : a dynamic instance is created from them for each room's type
+	UPROPERTY(EditAnywhere, BlueprintReadOnly)
+	UMaterialInterface *FloorMaterial = nullptr;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly)
+	UMaterialInterface *WallMaterial = nullptr;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly)
+	UMaterialInterface *CeilingMaterial = nullptr;
+
+	//Creates the materials of the given room's type (called only once per room's type and world)
+	FRoomDecoration CreateDecoration(const FName &RoomType);
+
+	//Sets the parameters of the material of one surface for the given room's type (nothing by default)
+	UFUNCTION(BlueprintNativeEvent)
+	void SetupMaterial(EDecorationSurface Surface, FName RoomType, UMaterialInstanceDynamic *Material);
+
+	//Per room value written in the vertex color of its surfaces : the shared material reads it to vary between rooms (random hue by default)
+	UFUNCTION(BlueprintNativeEvent)
+	FLinearColor GetRoomVariation(FName RoomType, int32 RoomSeed) const;
+
+protected:
+	UMaterialInterface *CreateMaterial(UMaterialInterface *Parent, EDecorationSurface Surface, const FName &RoomType);
 };
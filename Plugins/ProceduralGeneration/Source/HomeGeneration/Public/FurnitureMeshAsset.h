@@ -5,6 +5,7 @@
 #include "CoreMinimal.h"
 #include "FurnitureMeshInt.h"
 #include "HGBasicType.h"
+#include "HGDescriptors.h"
 #include "Engine/DataAsset.h"
 #include "FurnitureMeshAsset.generated.h"
 
@@ -13,7 +14,7 @@ extern struct FFurniture;
 /**
  * Represents a side of a furniture or an element in the generation system (a room's side for example).
  * This information is based on the local axes of a mesh (for a furniture).
- * Can be used in a mask storage.
+ * Can be used in a mask storage. Same values as EHGAxe, used by the algorithms.
  */
 UENUM(BlueprintType)
 enum class EGenerationAxe : uint8
@@ -102,13 +103,8 @@ struct FWallInteractionStruct
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta=(DisplayName="Axe Y-"))
 	EWallAxeInteraction YDown;
 
-	//Return the first attracted wall that the function can find. Return false if it can't.
-	//Guarantees that at least one attracted wall exists.
-	bool GetFirstAttractedWall(EGenerationAxe &First) const;
-	
-	//Return the second attracted wall that the function can find (different from the first one returned by the other function). Return false if it can't.
-	//Guarantees that at least two attracted walls exist.
-	bool GetSecondAttractedWall(EGenerationAxe &Second) const;
+	//Plain copy for the generation algorithms
+	FHGWallInteraction ToCore() const;
 };
 
 /**
@@ -136,6 +132,9 @@ struct FMarginStruct
 	//Defines the margin's size for the furniture's Y- side
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta=(DisplayName="Axe Y-"))
 	int YDown;
+
+	//Plain copy for the generation algorithms
+	FHGMargin ToCore() const;
 };
 
 /**
@@ -155,6 +154,9 @@ struct FFurnitureConstraint
 	//They are given in number of grid square.
 	UPROPERTY(EditAnywhere, BlueprintReadWrite)
 	FMarginStruct Margin;
+
+	//Plain copy for the generation algorithms
+	FHGFurnitureConstraint ToCore() const;
 };
 
 //Dependency information
@@ -199,6 +201,64 @@ struct FFurnitureDependency
 	//The furniture type of this dependency
 	UPROPERTY(EditAnywhere, BlueprintReadWrite)
 	FName FurnitureType;
+
+	//Plain copy for the generation algorithms
+	FHGFurnitureDependency ToCore() const;
+};
+
+//Footprint data
+
+/**
+ * Describes the space occupied by a mesh in the generation system.
+ * This data is baked in the editor (each time the asset is saved or cooked) from the bounds of the mesh, thus the generation never needs to load a mesh to know its size.
+ * The grid data depends on the grid snap length : if the generator uses another one, it is recomputed from the baked extent (never from the mesh).
+ */
+USTRUCT(BlueprintType)
+struct FMeshFootprint
+{
+	GENERATED_BODY()
+
+	//Origin of the bounds of the mesh (in the local space of the mesh)
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
+	FVector BoundsOrigin = FVector::ZeroVector;
+
+	//Half size of the bounds of the mesh (in the local space of the mesh)
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
+	FVector BoxExtent = FVector::ZeroVector;
+
+	//Grid snap length used to bake the following grid data
+	//In UE unit
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
+	float GridSnapLength = 0.f;
+
+	//Occupied grid squares for each rotation (indexed by EFurnitureRotation : 0°, 90°, 180°, 270°)
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
+	TArray<FIntPoint> RotatedGridSize;
+
+	//Translation from the first grid square of the footprint to the pivot of the mesh, for each rotation (indexed by EFurnitureRotation)
+	//The mesh is centered in its footprint and placed on the floor
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
+	TArray<FVector> RotatedPivotOffset;
+
+	//Returns true if some bounds have been baked
+	bool HasBounds() const;
+
+	//Returns true if the grid data has been computed for the given grid snap length
+	bool IsValidFor(float _GridSnapLength) const;
+
+	//Recomputes all the grid data for the given grid snap length, using only the baked bounds
+	void ComputeGridData(float _GridSnapLength);
+
+	//Bakes the bounds of the given mesh and the grid data for the given grid snap length
+	//Editor only : reading the bounds of a mesh needs it to be loaded
+	void Bake(const UStaticMesh *Mesh, float _GridSnapLength);
+
+	//Getters on the per-rotation data (valid only once the grid data is computed)
+	FVectorGrid GetGridSize(EFurnitureRotation Rotation = EFurnitureRotation::ROT0) const;
+	FVector GetPivotOffset(EFurnitureRotation Rotation) const;
+
+	//Default grid snap length used when an asset is baked
+	static constexpr float DefaultGridSnapLength = 100.f;
 };
 
 /**
@@ -231,12 +291,40 @@ public:
 	UPROPERTY(EditAnyWhere, BlueprintReadWrite, meta=(EditCondition="bOverrideConstraint"))
 	FFurnitureConstraint ConstraintsOverride;
 
-	//Calculates the area occupied by this furniture including margin (without any dependency)
-	//Doesn't store it because will be generally called once (for one furniture)
-	int GetArea(const FFurniture& CorrespondingFurniture) const;
+	//Grid snap length used to bake the footprint of the mesh : should be the one of the generators using this asset
+	//In UE unit
+	UPROPERTY(EditAnyWhere, BlueprintReadWrite, meta=(ClampMin="1.0"))
+	float BakeGridSnapLength = FMeshFootprint::DefaultGridSnapLength;
+
+	//Footprint of the mesh, baked when the asset is saved or cooked
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
+	FMeshFootprint Footprint;
+
+	//Checks the baked footprint against the given grid snap length and copies it in GridFootprint.
+	//The grid data of the copy is recomputed from the baked bounds if needed : the asset isn't modified, it can be shared by generators using other grid snap lengths
+	//(never reads the mesh, except in editor when nothing has been baked yet).
+	//Returns false if no footprint is available.
+	bool ValidateFootprint(float GridSnapLength, FMeshFootprint &GridFootprint);
+
+	//Plain description of this mesh for the generation algorithms, with its id in the catalog of the generator and its footprint for the grid snap length of the generator
+	FHGMeshDescriptor MakeDescriptor(int32 MeshId, const FMeshFootprint &GridFootprint) const;
+
+	//Hash of the properties of this asset, used by the keys of the layout cache (see AHomeGenerator::ComputeLayoutKey).
+	//Computed once, then again after a load or an edit (a property set at runtime isn't seen).
+	const FString &GetLayoutHash() const;
+
+	//Checks the baked grid data against the baked grid snap length (recomputed from the baked bounds if outdated)
+	virtual void PostLoad() override;
+
+#if WITH_EDITOR
+	virtual void PreSave(const class ITargetPlatform* TargetPlatform) override;
+	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+
+	//Bakes the footprint from the current mesh
+	void BakeFootprint();
+#endif
 
-	//TODO : Actually never calculated but say it works
-	FVector BoundsOrigin;
-	FVector BoxExtent;
-	FVectorGrid GridSize;
+protected:
+	//Empty until computed
+	mutable FString LayoutHash;
 };
@@ -0,0 +1,74 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "HGActorPool.generated.h"
+
+class UStaticMesh;
+class UStaticMeshComponent;
+
+//Key of a pooled actor : the class of the actor and the mesh it is displaying
+USTRUCT()
+struct FHGActorPoolKey
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	UClass *ActorClass = nullptr;
+
+	UPROPERTY()
+	UStaticMesh *Mesh = nullptr;
+
+	bool operator==(const FHGActorPoolKey &Other) const { return ActorClass == Other.ActorClass && Mesh == Other.Mesh; }
+	friend uint32 GetTypeHash(const FHGActorPoolKey &Key) { return HashCombine(GetTypeHash(Key.ActorClass), GetTypeHash(Key.Mesh)); }
+};
+
+//All the free actors for one key
+USTRUCT()
+struct FHGActorPoolBucket
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	TArray<AActor *> Actors;
+};
+
+/**
+ * Per world pool of the actors spawned by the generators (furniture, doors and stairs).
+ * Released actors are hidden, without collision and detached : they are reused by the next generations with only a transform and a mesh update.
+ */
+UCLASS()
+class HOMEGENERATION_API UHGActorPool : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	//Returns a free actor of the given class displaying the given mesh (or only of the given class, its mesh is then updated).
+	//The actor is shown, moved to the given transform and its collision is enabled. Returns nullptr if the pool has no such actor.
+	AActor *Acquire(UClass *ActorClass, UStaticMesh *Mesh, const FTransform &WorldTransform);
+
+	//Gives back an actor to the pool : it is hidden, its collision is disabled and it is detached.
+	void Release(AActor *Actor);
+
+	//Destroys all the free actors
+	UFUNCTION(BlueprintCallable)
+	void Empty();
+
+	//Number of free actors in the pool
+	UFUNCTION(BlueprintCallable)
+	int32 Num() const;
+
+	//Returns the component displaying the mesh of a generated actor (AStaticMeshActor or class implementing FurnitureMeshInt), nullptr otherwise.
+	static UStaticMeshComponent *GetMeshComponent(AActor *Actor);
+
+	virtual void Deinitialize() override;
+
+protected:
+	UPROPERTY()
+	TMap<FHGActorPoolKey, FHGActorPoolBucket> FreeActors;
+
+	//Removes and returns the last valid actor of the bucket
+	static AActor *PopActor(FHGActorPoolBucket &Bucket);
+};
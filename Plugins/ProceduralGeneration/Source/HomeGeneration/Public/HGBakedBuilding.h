@@ -0,0 +1,46 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "HGBakedBuilding.generated.h"
+
+class UStaticMesh;
+class UStaticMeshComponent;
+class UHierarchicalInstancedStaticMeshComponent;
+class UProceduralMeshComponent;
+
+/**
+ * Static copy of a generated building, created in the editor by AHomeGenerator::BakeBuilding.
+ * Only static data is saved with the level : the shell and the decoration merged in one static mesh, and one instance component per furniture mesh.
+ * The furniture with its own actor class is kept as separate actors of the level.
+ */
+UCLASS()
+class HOMEGENERATION_API AHGBakedBuilding : public AActor
+{
+	GENERATED_BODY()
+
+public:
+	AHGBakedBuilding();
+
+	//Shell and decoration (one section per material)
+	UPROPERTY(VisibleAnywhere)
+	UStaticMeshComponent *ShellComponent;
+
+	//One component per mesh (furniture and windows)
+	UPROPERTY(VisibleAnywhere)
+	TArray<UHierarchicalInstancedStaticMeshComponent *> InstanceComponents;
+
+	//Furniture actors of the building (not instanced)
+	UPROPERTY(VisibleAnywhere)
+	TArray<AActor *> FurnitureActors;
+
+#if WITH_EDITOR
+	//Merges all the sections of the components (placed at the root of an actor with the same transform) in the static mesh of the shell
+	void BakeShell(const TArray<UProceduralMeshComponent *> &Components);
+
+	//Adds instances of the mesh (relative to this actor)
+	void AddInstances(UStaticMesh *Mesh, const TArray<FTransform> &Transforms);
+#endif
+};
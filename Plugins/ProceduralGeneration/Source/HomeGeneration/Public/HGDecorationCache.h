@@ -0,0 +1,54 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "DecoBase.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "HGDecorationCache.generated.h"
+
+//Key of a cached decoration : the decoration class and the room's type
+USTRUCT()
+struct FHGDecorationKey
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	UClass *DecorationClass = nullptr;
+
+	UPROPERTY()
+	FName RoomType;
+
+	bool operator==(const FHGDecorationKey &Other) const { return DecorationClass == Other.DecorationClass && RoomType == Other.RoomType; }
+	friend uint32 GetTypeHash(const FHGDecorationKey &Key) { return HashCombine(GetTypeHash(Key.DecorationClass), GetTypeHash(Key.RoomType)); }
+};
+
+/**
+ * Per world cache of the decorations : one instance of each decoration class, and the materials of each room's type.
+ * All the generators of the world share them, so the number of materials only depends on the number of room's types.
+ */
+UCLASS()
+class HOMEGENERATION_API UHGDecorationCache : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	//Returns the materials of the room's type, created by the decoration class on the first call
+	const FRoomDecoration &GetDecoration(TSubclassOf<UDecoBase> DecorationClass, const FName &RoomType);
+
+	//Returns the only instance of the decoration class in this world
+	UDecoBase *GetDecorationObject(TSubclassOf<UDecoBase> DecorationClass);
+
+	//Number of materials created by the decorations of this world
+	UFUNCTION(BlueprintCallable)
+	int32 NumMaterials() const;
+
+	virtual void Deinitialize() override;
+
+protected:
+	UPROPERTY()
+	TMap<UClass *, UDecoBase *> Decorations;
+
+	UPROPERTY()
+	TMap<FHGDecorationKey, FRoomDecoration> Materials;
+};
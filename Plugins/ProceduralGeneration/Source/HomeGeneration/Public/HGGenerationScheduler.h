@@ -0,0 +1,103 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "HGGenerationScheduler.generated.h"
+
+class AHomeGenerator;
+
+//Generator waiting for or running its generation
+struct FHGGenerationRequest
+{
+	TWeakObjectPtr<AHomeGenerator> Generator;
+
+	//Lower is generated first : distance to the nearest viewer (increased out of the view)
+	float Priority = 0.f;
+
+	//Distance to the nearest viewer, in or out of the view (range checks only)
+	float Distance = 0.f;
+
+	//The generation has been started (computed on a worker thread, then spawned by the scheduler)
+	bool bRunning = false;
+
+	//Generation id of the started generation : another id means it was cancelled or replaced outside of the scheduler
+	int32 GenerationId = 0;
+};
+
+/**
+ * Per world queue of the generations : the generators nearest to the players (and in their view) are generated first.
+ * At most MaxConcurrentGenerations are computed at the same time on the worker threads, and the spawn steps of all the generators share FrameBudget each frame.
+ * Running generations which get too far from the players are cancelled and queued again.
+ */
+UCLASS()
+class HOMEGENERATION_API UHGGenerationScheduler : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	//Adds the generator to the queue (nothing is done if it is already queued)
+	UFUNCTION(BlueprintCallable)
+	void RequestGeneration(AHomeGenerator *Generator);
+
+	//Removes the generator from the queue and cancels its generation if it is running
+	UFUNCTION(BlueprintCallable)
+	void CancelGeneration(AHomeGenerator *Generator);
+
+	UFUNCTION(BlueprintCallable)
+	bool IsQueued(const AHomeGenerator *Generator) const;
+
+	//Number of queued and running generations
+	UFUNCTION(BlueprintCallable)
+	int32 NumRequests() const;
+
+	//Maximal number of generations computed at the same time on the worker threads
+	UPROPERTY(BlueprintReadWrite)
+	int32 MaxConcurrentGenerations = 2;
+
+	//Time (in ms) spent each frame by the spawn steps of all the generators (at least one step is done per frame)
+	UPROPERTY(BlueprintReadWrite)
+	float FrameBudget = 2.f;
+
+	//Generators farther than this distance from all the players aren't started, and their running generation is cancelled (0 for no limit)
+	UPROPERTY(BlueprintReadWrite)
+	float MaxGenerationDistance = 30000.f;
+
+	//Generators beyond MaxGenerationDistance, but not farther than this margin, have their layout computed in advance by the world's layout pool (0 to disable)
+	UPROPERTY(BlueprintReadWrite)
+	float PregenerationMargin = 10000.f;
+
+	//Multiplies the distance of the generators outside the view of the players
+	UPROPERTY(BlueprintReadWrite)
+	float OutOfViewFactor = 3.f;
+
+	virtual void Deinitialize() override;
+
+	//FTickableGameObject
+	virtual void Tick(float DeltaTime) override;
+	virtual ETickableTickType GetTickableTickType() const override;
+	virtual bool IsTickable() const override;
+	virtual TStatId GetStatId() const override;
+	virtual UWorld *GetTickableGameObjectWorld() const override;
+
+protected:
+	TArray<FHGGenerationRequest> Requests;
+
+	//Point of view of a player
+	struct FViewer
+	{
+		FVector Location;
+		FVector Direction;
+		float HalfFOV;
+	};
+
+	void GetViewers(TArray<FViewer> &Viewers) const;
+
+	//Distance of the generator to the nearest viewer, multiplied by OutOfViewFactor if no viewer sees it.
+	//The raw distance to the nearest viewer is given too.
+	float ComputePriority(const AHomeGenerator *Generator, const TArray<FViewer> &Viewers, float &NearestDistance) const;
+
+	bool IsTooFar(const FHGGenerationRequest &Request) const;
+};
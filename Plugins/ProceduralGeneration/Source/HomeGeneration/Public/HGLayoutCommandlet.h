@@ -0,0 +1,63 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "HGLayoutJob.h"
+#include "HGLayoutCommandlet.generated.h"
+
+class AHomeGenerator;
+struct FHomeGenerationResult;
+
+/**
+ * Computes the layouts of ranges of seeds offline, without spawning anything, and writes them as layout files (see AHomeGenerator::LoadLayout).
+ * The seeds are computed in parallel, each worker with its own copy of the parameters. A manifest lists every seed with its timing, or the reason of its failure.
+ *
+ * UE4Editor-Cmd Project -run=HGLayout -nullrhi -Presets=/Game/BP_House.BP_House_C[,...] -Seeds=0-999[,2000,...] -Output=Dir [-Workers=N]
+ *
+ * With -Serve, the commandlet stays up and computes the layouts requested by the local tools instead (see FHGLayoutService) :
+ * UE4Editor-Cmd Project -run=HGLayout -nullrhi -Serve [-Port=N] [-Workers=N]
+ *
+ * With -ExportPlans, only writes the plan file of each preset (Output/Preset.hgplan) : the layout tool program then computes its layouts without the engine (see HGLayoutTool).
+ * UE4Editor-Cmd Project -run=HGLayout -nullrhi -ExportPlans -Presets=/Game/BP_House.BP_House_C[,...] -Output=Dir
+ */
+UCLASS()
+class HOMEGENERATION_API UHGLayoutCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UHGLayoutCommandlet();
+
+	virtual int32 Main(const FString &Params) override;
+
+	friend class FHGLayoutService;
+
+protected:
+	//Runs the generation service until it is asked to quit
+	int32 Serve(const FString &Params);
+
+	//Writes the plan files of the presets
+	int32 ExportPlans(const FString &Params);
+
+	static UWorld *CreateLayoutWorld();
+	static void DestroyLayoutWorld(UWorld *World);
+
+	//Game thread : spawns a generator of the preset which records its furniture
+	AHomeGenerator *SpawnGenerator(UWorld *World, UClass *Preset) const;
+
+	//Game thread : copies the parameters of the generator for the seed in the layout of the result
+	void PrepareLayout(AHomeGenerator &Generator, int32 Seed, FHomeGenerationResult &Result) const;
+
+	void DestroyGenerator(AHomeGenerator &Generator) const;
+
+	//Generates all the seeds with the given preset (a blueprint class of generator). Returns false if the preset can't be used.
+	bool GeneratePreset(UWorld *World, const FString &PresetPath, const TArray<int32> &Seeds, int32 Workers, const FString &Output, TArray<FHGLayoutJob> &Jobs) const;
+
+	//Any thread : computes the prepared layout and writes it
+	void GenerateLayout(FHomeGenerationResult &Result, FHGLayoutJob &Job) const;
+
+	//Any thread : computes the prepared layout in the layout file format (Bytes is left empty if the layout is invalid)
+	void ComputeLayout(FHomeGenerationResult &Result, FHGLayoutJob &Job, TArray<uint8> &Bytes) const;
+};
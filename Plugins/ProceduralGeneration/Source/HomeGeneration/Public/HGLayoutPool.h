@@ -0,0 +1,97 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "HGLayoutPool.generated.h"
+
+class AHomeGenerator;
+struct FHomeGenerationResult;
+
+//Layout computed in advance for a generator
+struct FHGPooledLayout
+{
+	TWeakObjectPtr<AHomeGenerator> Generator;
+
+	//Generation, seed and parameters of the layout : the blocks stored in the generator are only valid until its next generation
+	int32 GenerationId = 0;
+	int32 Seed = 0;
+	int32 ParametersHash = 0;
+
+	//Null until computed
+	TSharedPtr<FHomeGenerationResult, ESPMode::ThreadSafe> Result;
+	bool bComputing = false;
+
+	SIZE_T Size = 0;
+
+	//Last time the layout has been requested (least recently used layouts are evicted first)
+	double LastUseTime = 0.0;
+};
+
+/**
+ * Per world pool of layouts computed in advance, on worker threads, for the generators which will probably be generated soon.
+ * The generators take their layout back when they are generated : only the spawn steps remain.
+ * Computed layouts are evicted, least recently used first, once they use more than MaxMemory.
+ */
+UCLASS()
+class HOMEGENERATION_API UHGLayoutPool : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	//Computes the layout of the generator in the background (only if nothing is generated by it yet). Touches the layout if it is already pooled.
+	UFUNCTION(BlueprintCallable)
+	void Pregenerate(AHomeGenerator *Generator);
+
+	//Forgets the layout of the generator (its computation is cancelled if running)
+	UFUNCTION(BlueprintCallable)
+	void Remove(AHomeGenerator *Generator);
+
+	//The layout of the generator is computed and still valid
+	UFUNCTION(BlueprintCallable)
+	bool IsReady(const AHomeGenerator *Generator) const;
+
+	//Number of pooled layouts (computed or not)
+	UFUNCTION(BlueprintCallable)
+	int32 Num() const;
+
+	//Memory used by the computed layouts (geometry, furniture and blocks)
+	SIZE_T GetUsedMemory() const;
+
+	//Maximal memory (in MB) used by the computed layouts
+	UPROPERTY(BlueprintReadWrite)
+	float MaxMemory = 64.f;
+
+	//Maximal number of layouts computed at the same time on the worker threads
+	UPROPERTY(BlueprintReadWrite)
+	int32 MaxConcurrentPregenerations = 1;
+
+	//Returns the computed layout of the generator and forgets it (null if there is none or if it isn't valid anymore)
+	TSharedPtr<FHomeGenerationResult, ESPMode::ThreadSafe> TakeLayout(AHomeGenerator *Generator);
+
+	//Called by the generator once its layout is computed (game thread)
+	void StoreLayout(AHomeGenerator *Generator, const TSharedRef<FHomeGenerationResult, ESPMode::ThreadSafe> &Result);
+
+	virtual void Deinitialize() override;
+
+	//FTickableGameObject
+	virtual void Tick(float DeltaTime) override;
+	virtual ETickableTickType GetTickableTickType() const override;
+	virtual bool IsTickable() const override;
+	virtual TStatId GetStatId() const override;
+	virtual UWorld *GetTickableGameObjectWorld() const override;
+
+protected:
+	TArray<FHGPooledLayout> Layouts;
+
+	int32 FindLayout(const AHomeGenerator *Generator) const;
+
+	//The layout can still be replayed by its generator.
+	//The parameters are exported to be compared : only done when the layout is requested, not each frame.
+	static bool IsLayoutValid(const FHGPooledLayout &Layout, bool bCompareParameters = true);
+
+	//Evicts the least recently used computed layouts until the memory is under MaxMemory
+	void EvictLayouts();
+};
@@ -8,8 +8,48 @@
 #include "WindowMeshAsset.h"
 #include "DecoBase.h"
 #include "HGInternalStruct.h"
+#include "Async/Future.h"
+#include "Engine/LatentActionManager.h"
 #include "HomeGenerator.generated.h"
 
+class UInstancedStaticMeshComponent;
+class UHierarchicalInstancedStaticMeshComponent;
+class UProceduralMeshComponent;
+class UMaterialInterface;
+struct FHGMeshSection;
+struct FHomeGenerationResult;
+struct FHGDwellingUnit;
+struct FHGLayoutView;
+class FHGBuildingLayout;
+class AHomeGenerator;
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnHomeGenerated, AHomeGenerator *, Generator);
+
+//Stages of a time sliced generation, in order
+enum class EHGSlicedStage : uint8
+{
+	None,
+	Building,
+	Division,
+	Surface,
+	Shell,
+	Decoration,
+	Furniture,
+	Apply,
+	Spawn
+};
+
+//What is done with the result of an asynchronous generation once computed
+enum class EHGAsyncTarget : uint8
+{
+	//Spawned at once
+	Spawn,
+	//Spawned by steps by the world's scheduler (see HGGenerationScheduler)
+	Scheduler,
+	//Kept by the world's layout pool until the generator is generated (see HGLayoutPool)
+	LayoutPool
+};
+
 /**
  * Groups all the information needed to define the global building shape.
  * The constraints indicated in this structure are not absolute : they will be ignored if some other calculated value over-constraint the calculus.
@@ -57,18 +97,8 @@ struct FBuildingConstraint
 	UPROPERTY(EditAnywhere, BlueprintReadWrite)
 	float WallWidth = 10.f;
 
-protected://Generated data by the procedural generator
-	//Room average minimal side : an average of all minimal side (for each room) pondered by the quantity these rooms
-	int AverageSide = 0;
-
-	//Total desired quantity of rooms, according to the number per inhabitant and the number of inhabitants.
-	int NormalRoomQuantity = 0;
-	
-	//Building dimensions
-	FVectorGrid BuildingSize; //In grid square
-	int Levels = 0;
-
-	friend class AHomeGenerator;
+	//Plain constraints for the generation algorithms : the building dimensions are computed there (see FHGBuildingPlan::DefineBuilding)
+	FHGBuildingConstraints ToCore() const;
 };
 
 /**
@@ -110,22 +140,9 @@ struct FRoomsDivisionConstraints
 	//In percent : [0; 1]
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta=(DisplayName="OverDivideProbability", ClampMin="0.0", ClampMax="1.0"))
 	float OverDivideProba = 0.5f;
-	
-protected://Generated data by the procedural generator
-	//Absolute minimal side
-	int ABSMinimalSide = 0;
-
-	//Side under which the split will be stopped
-	int StopSplitSide = 0;
 
-	//Sufficient side
-	int SufficientSide = 0;
-
-	//Computes previously indicated calculus
-	void CalculateAllSides(const int _BasicMinimalSide, const int _BasicAverageSide, const int _BasicMaximalSide);
-	
-	friend class AHomeGenerator;
-	friend struct FUnknownBlock;
+	//Plain constraints for the generation algorithms : the sides are computed there (see FHGBuildingPlan::ComputeSides)
+	FHGDivisionConstraints ToCore() const;
 };
 
 /**
@@ -151,16 +168,8 @@ struct FRoom
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta=(DisplayName="NumberPerInhabitant", ClampMin="0.0", ClampMax="5.0"))
 	float NumPerHab = 1.f;
 
-	//Recalculate MinRoomSide
-	int CalculateMinimalSide(TMap<FName, FFurniture> &FurnitureMapping);
-
-	//Getter to MinRoomSide
-	int GetMinimalSide() const;
-
-protected:
-	//Computed value which depends on the selected furniture (in Furniture)
-	//For one room
-	int MinRoomSide = 0;
+	//Plain description for the generation algorithms (without the decoration class) : the minimal side is computed there
+	FHGRoomDescriptor ToCore() const;
 };
 
 /**
@@ -185,11 +194,6 @@ struct FFurniture
 	UPROPERTY(EditAnywhere, BlueprintReadWrite)
 	FFurnitureConstraint DefaultConstraints;
 
-	//Indicates the average area of all its meshes
-	int GetAverageArea();
-
-protected:
-	int AverageArea = 0;
 };
 
 /**
@@ -208,6 +212,218 @@ struct FWindow
 	//Default constraints for this furniture which will be applied to the mesh if they don't override it.
 	UPROPERTY(EditAnywhere, BlueprintReadWrite)
 	FWindowConstraint DefaultConstraints;
+
+	//Number of grid squares between two windows along a wall
+	//In grid square
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta=(ClampMin="0"))
+	int Spacing = 1;
+};
+
+/**
+ * Identifies a furniture generated by the system : allows to find back the room and the furniture type of an instance.
+ */
+USTRUCT(BlueprintType)
+struct FFurnitureInstanceInfo
+{
+	GENERATED_BODY()
+
+	//Level of the room containing the furniture
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
+	int32 Level = INDEX_NONE;
+
+	//Index of the room in its level
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
+	int32 RoomIndex = INDEX_NONE;
+
+	//Type of the room containing the furniture
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
+	FName RoomType;
+
+	//Type of the furniture (key in the Furniture map, or Door/Stairs for special furniture)
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
+	FName FurnitureType;
+
+	//Index of the furniture in its room (see FHGFurnitureId)
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
+	int32 FurnitureIndex = INDEX_NONE;
+};
+
+/**
+ * Identifies a furniture of a generated building : the same parameters and seed always give the same furniture the same id.
+ */
+USTRUCT(BlueprintType)
+struct FHGFurnitureId
+{
+	GENERATED_BODY()
+
+	UPROPERTY(SaveGame, EditAnywhere, BlueprintReadWrite)
+	int32 Level = INDEX_NONE;
+
+	UPROPERTY(SaveGame, EditAnywhere, BlueprintReadWrite)
+	int32 RoomIndex = INDEX_NONE;
+
+	//Order of placement in the room (negative for the furniture added by the gameplay)
+	UPROPERTY(SaveGame, EditAnywhere, BlueprintReadWrite)
+	int32 Index = INDEX_NONE;
+
+	bool operator==(const FHGFurnitureId &Other) const
+	{
+		return Level == Other.Level && RoomIndex == Other.RoomIndex && Index == Other.Index;
+	}
+
+	friend uint32 GetTypeHash(const FHGFurnitureId &Id)
+	{
+		return HashCombine(HashCombine(GetTypeHash(Id.Level), GetTypeHash(Id.RoomIndex)), GetTypeHash(Id.Index));
+	}
+};
+
+UENUM(BlueprintType)
+enum class EHGFurnitureDeltaType : uint8
+{
+	Removed,
+	Moved,
+	Added
+};
+
+/**
+ * Modification of the generated furniture by the gameplay : applied again each time the building is generated.
+ */
+USTRUCT(BlueprintType)
+struct FHGFurnitureDelta
+{
+	GENERATED_BODY()
+
+	UPROPERTY(SaveGame, EditAnywhere, BlueprintReadWrite)
+	EHGFurnitureDeltaType Type = EHGFurnitureDeltaType::Removed;
+
+	UPROPERTY(SaveGame, EditAnywhere, BlueprintReadWrite)
+	FHGFurnitureId Id;
+
+	//Relative to the generator (moved and added furniture)
+	UPROPERTY(SaveGame, EditAnywhere, BlueprintReadWrite)
+	FTransform Transform;
+
+	//Added furniture only
+	UPROPERTY(SaveGame, EditAnywhere, BlueprintReadWrite)
+	TSoftObjectPtr<UFurnitureMeshAsset> Mesh;
+
+	UPROPERTY(SaveGame, EditAnywhere, BlueprintReadWrite)
+	FName FurnitureType;
+};
+
+/**
+ * Saved state of a generated building : only what is needed to generate it again, and the modifications of the gameplay.
+ */
+USTRUCT(BlueprintType)
+struct FHomeGenerationSave
+{
+	GENERATED_BODY()
+
+	//The deltas are only applied to a generator with the same parameters (see AHomeGenerator::GetParametersHash)
+	UPROPERTY(SaveGame, EditAnywhere, BlueprintReadWrite)
+	int32 ParametersHash = 0;
+
+	UPROPERTY(SaveGame, EditAnywhere, BlueprintReadWrite)
+	int32 Seed = 0;
+
+	//One delta per modified furniture
+	UPROPERTY(SaveGame, EditAnywhere, BlueprintReadWrite)
+	TArray<FHGFurnitureDelta> Deltas;
+};
+
+//Everything a client needs to rebuild the building of the server
+USTRUCT()
+struct FHGReplicatedGeneration
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	int32 Seed = 0;
+
+	//The client can only rebuild the building with the same parameters (see AHomeGenerator::GetParametersHash)
+	UPROPERTY()
+	int32 ParametersHash = 0;
+};
+
+//Furniture with a gameplay state (its actor class is replicated) : only spawned by the server, mapped to its id on the clients
+USTRUCT()
+struct FHGReplicatedFurniture
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	FHGFurnitureId Id;
+
+	UPROPERTY()
+	AActor *Actor = nullptr;
+};
+
+/**
+ * Groups all the instances of one mesh generated by a HomeGenerator in instancing mode.
+ * Instances are buffered until the generator flushes them, so they can be added in bulk.
+ */
+USTRUCT()
+struct FFurnitureInstanceGroup
+{
+	GENERATED_BODY()
+
+	//Component rendering all the instances of the mesh
+	UPROPERTY()
+	UHierarchicalInstancedStaticMeshComponent *Component = nullptr;
+
+	//Information of each instance of the component (same index as the instance)
+	UPROPERTY()
+	TArray<FFurnitureInstanceInfo> Infos;
+
+	//Index of the instance of each furniture (a removed instance takes the last one's place, as in the component)
+	TMap<FHGFurnitureId, int32> InstanceIndices;
+
+	//Instances waiting to be added to the component (relative to the generator)
+	TArray<FTransform> PendingTransforms;
+	TArray<FFurnitureInstanceInfo> PendingInfos;
+};
+
+/**
+ * Merged mesh of all the furniture of one room : displayed instead of the individual furniture when no viewer is near the room.
+ */
+USTRUCT()
+struct FRoomProxy
+{
+	GENERATED_BODY()
+
+	//Component rendering all the merged furniture (one section per material)
+	UPROPERTY()
+	UProceduralMeshComponent *Component = nullptr;
+
+	//Furniture actors represented by the proxy (hidden while the proxy is displayed)
+	UPROPERTY()
+	TArray<AActor *> Actors;
+
+	//World bounds of the merged furniture
+	FBox Bounds = FBox(ForceInit);
+
+	bool bProxyShown = false;
+};
+
+/**
+ * Furnishing state of one room in streaming mode.
+ * The spawn commands are recorded the first time the room is furnished and replayed afterwards, so the room is always furnished identically.
+ */
+USTRUCT()
+struct FRoomStreamingState
+{
+	GENERATED_BODY()
+
+	//Recorded placement of the room (valid once bRecorded is set)
+	FFurnitureSpawnBuffer Commands;
+	bool bRecorded = false;
+
+	//Is the furniture currently spawned
+	bool bFurnished = false;
+
+	//Actors spawned for the room while furnished
+	UPROPERTY()
+	TArray<AActor *> Actors;
 };
 
 /**
@@ -218,6 +434,9 @@ class HOMEGENERATION_API AHomeGenerator : public AActor
 {
 	GENERATED_BODY()
 	//TODO : Add categories !!
+	friend class UHGGenerationScheduler;
+	friend class UHGLayoutPool;
+	friend class UHGLayoutCommandlet;
 	//ENH : Instead of using assert, launch exceptions (avoid editor crashes) or at least UE_CHECK 
 
 public:
@@ -228,6 +447,28 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta=(ClampMin="1.0"))
 	int Inhabitants;
 
+	//Seed of all the random choices : the same seed with the same parameters always rebuilds the same building
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 Seed = 0;
+
+	//If true, each wing and apartment of each level is a dwelling unit for a share of the inhabitants : the units are divided, allocated and furnished independently, in parallel.
+	//Meant for big residential buildings : a unit which doesn't get enough rooms is divided again on its own.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	bool bApartmentBlock = false;
+
+	//Maximal number of divisions of a dwelling unit (the last one is kept even if it doesn't give enough rooms)
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta=(ClampMin="1"))
+	int32 MaxUnitAttempts = 4;
+
+	//If true, all the levels above TypicalFloorStart repeat its layout and its furniture : only the levels up to the typical one are divided and furnished.
+	//The furniture of the repeated levels is rendered as instances (except the furniture with a custom ActorClass).
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	bool bTypicalFloors = false;
+
+	//Level repeated up to the roof when bTypicalFloors is set (the levels under it are generated normally)
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta=(ClampMin="0"))
+	int32 TypicalFloorStart = 1;
+
 	///______________________
 	///Building data
 	///
@@ -275,126 +516,454 @@ public:
 
 	//ENH: Add advanced furniture positioning parameter (bounds threshold and completion)
 
+	///______________________
+	///Shell
+	///
+
+	//Material of the walls of the building (inside and outside)
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	UMaterialInterface *ShellWallMaterial = nullptr;
+
+	//Material of the floor and ceiling slabs (and the roof)
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	UMaterialInterface *ShellFloorMaterial = nullptr;
+
+	//Length (in UE unit) covered by one unit of UV on the shell
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta=(ClampMin="1.0"))
+	float ShellUVLength = 100.f;
+
+	//Distance between the decoration of a room (given by the DecorationClass of its type) and its walls, floor and ceiling
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta=(ClampMin="0.1"))
+	float DecorationInset = 1.f;
+
+	//If true, the furniture without a custom ActorClass is rendered as instances of one component per mesh (owned by this generator) instead of one actor per furniture.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	bool bInstanceFurniture = false;
+
+	//If true, all the furniture actors without custom ActorClass of a room are also merged in one mesh, displayed instead of them when no viewer is near the room.
+	//In packaged builds, the furniture meshes need to allow CPU access to be merged.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	bool bMergeRoomProxies = false;
+
+	//Distance from a room's furniture under which a viewer sees the individual furniture instead of the merged proxy.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta=(ClampMin="0.0"))
+	float ProxySwapDistance = 1500.f;
+
+	//Time (in s) between two updates of the displayed proxies.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta=(ClampMin="0.01"))
+	float ProxyUpdateInterval = 0.25f;
+
+	//If true, the layout is generated up front but the rooms are only furnished when a player comes near them (and unfurnished when it leaves).
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	bool bStreamFurniture = false;
+
+	//Distance from a room under which a player makes the room furnished. The rooms connected by a door to the room a player is in are also furnished.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta=(ClampMin="0.0"))
+	float StreamingRadius = 2000.f;
+
+	//Additional distance a player must go away before a room is unfurnished (avoids furnishing the same room again and again at the limit).
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta=(ClampMin="0.0"))
+	float StreamingUnloadMargin = 500.f;
+
+	//Time (in s) between two updates of the furnished rooms.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta=(ClampMin="0.01"))
+	float StreamingUpdateInterval = 0.5f;
+
+	//Finds the room and the furniture type of an instance generated in instancing mode.
+	//Returns false if the component or the instance hasn't been generated by this generator.
+	UFUNCTION(BlueprintCallable)
+	bool GetFurnitureInstanceInfo(const UInstancedStaticMeshComponent *Component, int32 InstanceIndex, FFurnitureInstanceInfo &Info) const;
+
+	//Removes everything generated : the actors are given back to the world's pool and the instance components are emptied (but kept).
+	UFUNCTION(BlueprintCallable)
+	virtual void ClearGeneration();
+
+	//Generates the whole building at once on the game thread : layout, shell, decoration and furniture.
+	UFUNCTION(BlueprintCallable)
+	virtual void Generate();
+
+	//Generates the building in the background : the layout and the furniture placement are computed on a worker thread, only the spawn step is done on the game thread.
+	//OnGenerationCompleted is broadcast once everything is spawned. Returns false if a generation is already running.
+	bool GenerateAsync();
+
+	//Blueprint version of GenerateAsync : the output is triggered once the building is spawned (or the generation cancelled).
+	UFUNCTION(BlueprintCallable, meta=(Latent, LatentInfo="LatentInfo", DisplayName="Generate Async"))
+	void GenerateAsyncLatent(FLatentActionInfo LatentInfo);
+
+	//Generates the building over several frames on the game thread : each Tick runs the next steps (one level's division, one room's furnishing, a few spawns,...) until TimeSliceBudget is spent.
+	//OnGenerationCompleted is broadcast at the end. Returns false if a generation is already running.
+	UFUNCTION(BlueprintCallable)
+	bool GenerateTimeSliced();
+
+	//Maximal time (in ms) spent each frame by a time sliced generation (at least one step is done per frame)
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta=(ClampMin="0.1"))
+	float TimeSliceBudget = 1.5f;
+
+	//Number of furniture spawned by one step of a time sliced generation (the furniture of a room is always spawned in the same step)
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta=(ClampMin="1"))
+	int32 TimeSliceSpawnCount = 16;
+
+	//If true, the computed layouts are stored on disk (in Saved/HomeGeneration/LayoutCache) : a generation with the same parameters, seed and assets only rebuilds the geometry and spawns.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	bool bUseLayoutCache = false;
+
+	//Size (in MB) over which the least recently used layouts of the cache are deleted
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta=(ClampMin="1.0"))
+	float LayoutCacheMaxSize = 256.f;
+
+	//Stops the running asynchronous or time sliced generation : nothing more is spawned.
+	//Never waits for the worker thread : it stops at its next stage and its result is dropped.
+	UFUNCTION(BlueprintCallable)
+	void CancelGeneration();
+
+	UFUNCTION(BlueprintPure)
+	bool IsGenerating() const;
+
+	//Called when a generation has spawned the building (in streaming mode, the furniture is spawned later)
+	UPROPERTY(BlueprintAssignable)
+	FOnHomeGenerated OnGenerationCompleted;
+
+	//World bounds which can be covered by the building (from its maximal side)
+	FSphere GetGenerationBounds() const;
+
+	//Writes the current layout (blocks, doors and furniture placements) in a binary layout file, which LoadLayout spawns again without any division or placement.
+	//Returns false if nothing is generated or the file can't be written.
+	UFUNCTION(BlueprintCallable)
+	bool SaveLayout(const FString &Filename);
+
+	//Spawns the layout stored in the file (see SaveLayout) : the shell and the decoration are rebuilt from the blocks, the furniture placements are used as they are.
+	//Returns false if the file is invalid or doesn't match the generator (seed, grid snap length, floors and walls, typical floors, room types, assets).
+	UFUNCTION(BlueprintCallable)
+	bool LoadLayout(const FString &Filename);
+
+	//Hash of the parameters read by the generation (see ExportParameters), except the seed : a building generated with the same hash and seed is identical
+	UFUNCTION(BlueprintPure)
+	int32 GetParametersHash() const;
+
+	//Fills the save of the building : its seed and the modifications of its furniture
+	UFUNCTION(BlueprintCallable)
+	void SaveGeneration(FHomeGenerationSave &Save) const;
+
+	//Generates the saved building again and applies the saved modifications.
+	//Returns false if the parameters have changed since the save : the building is generated with the saved seed, but without the modifications.
+	UFUNCTION(BlueprintCallable)
+	bool LoadGeneration(const FHomeGenerationSave &Save);
+
+	//Finds the furniture of a spawned actor, or of an instance of a furniture component. Returns false if it hasn't been generated by this generator.
+	UFUNCTION(BlueprintCallable)
+	bool GetFurnitureId(const UPrimitiveComponent *Component, int32 InstanceIndex, FHGFurnitureId &Id) const;
+
+	//Removes a furniture of the building (kept removed by the next generations with the same seed)
+	UFUNCTION(BlueprintCallable)
+	bool RemoveFurniture(const FHGFurnitureId &Id);
+
+	//Moves a furniture of the building (kept moved by the next generations with the same seed)
+	UFUNCTION(BlueprintCallable)
+	bool MoveFurniture(const FHGFurnitureId &Id, const FTransform &WorldTransform);
+
+	//Adds a furniture in a room of the building (added again by the next generations with the same seed). Returns false if the room doesn't exist.
+	UFUNCTION(BlueprintCallable)
+	bool AddFurniture(UFurnitureMeshAsset *MeshAsset, const FTransform &WorldTransform, int32 Level, int32 RoomIndex, FName FurnitureType, FHGFurnitureId &Id);
+
+	//Forgets all the modifications of the furniture (only applied by the next generation)
+	UFUNCTION(BlueprintCallable)
+	void ClearFurnitureDeltas();
+
+#if WITH_EDITOR
+	//Generates the building and copies it in a static actor of the level (see AHGBakedBuilding) : the copy has no runtime generation cost, the generator can then be removed.
+	UFUNCTION(CallInEditor)
+	void BakeBuilding();
+#endif
+
 protected:
 	// Called when the game starts or when spawned
 
 	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+	virtual void BeginDestroy() override;
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty> &OutLifetimeProps) const override;
 
 	///______________________
-	///Initial step
+	///Generation pipeline
 	///
 
-	//Computes the bounds for each mesh of every FurnitureMeshAsset or WindowMeshAsset.
-	//Function to use really carefully : it takes a lot of time.
-	void ComputeBounds();
+	//Game thread : clears the previous generation and copies the parameters, the footprints and the computed constants (sides) in a new layout of the result.
+	//The computation only reads and writes this layout : the generator and its assets can be modified while it runs.
+	virtual void PrepareGeneration(FHomeGenerationResult &Result);
 
-	//Computes all minimal sides and sort elements based on this value (ex : rooms)
-	//Also computes additional room's constants
-	void ComputeSides();
+	//Game thread : adopts the layout of the result, creates the components and spawns everything, then broadcasts OnGenerationCompleted.
+	virtual void FinishGeneration(FHomeGenerationResult &Result);
+
+	//Layout of the spawned generation (blocks, doors, windows), used by the streaming, the furniture deltas and SaveLayout.
+	//Never null : empty until something is spawned.
+	TSharedPtr<FHGBuildingLayout, ESPMode::ThreadSafe> Layout;
 
-	//Generated data is stored in the RoomsDivisionConstraintStruct or in BuildingConstraintStruct
-	
 	///______________________
-	///Building Step
+	///Layout cache
 	///
 
-	virtual void DefineBuilding();
+	//Hash of everything the layout depends on : versions, parameters, seed and placed assets
+	FString ComputeLayoutKey() const;
+
+	//Exported values of the parameters read by the computation (see GetParametersHash).
+	//Must be extended by the child classes which read more properties in PrepareGeneration.
+	virtual void ExportParameters(FString &Text) const;
+
+	//True from the start of an asynchronous generation until its spawn step
+	bool bGenerating = false;
+
+	//Incremented by each generation : the spawn step of an older generation is ignored
+	int32 GenerationId = 0;
+
+	//Last started worker task : only waited for by BeginDestroy
+	TFuture<void> GenerationTask;
+
+	//Result computed by the running asynchronous generation (its layout is cancelled by CancelGeneration)
+	TSharedPtr<FHomeGenerationResult, ESPMode::ThreadSafe> AsyncResult;
+
+	//Starts the computation on a worker thread, or uses the layout computed in advance by the world's layout pool.
+	//A running pregeneration is kept and only changes its target.
+	bool StartAsyncGeneration(EHGAsyncTarget Target);
+
+	//Game thread : uses the computed result according to AsyncTarget
+	void ReceiveAsyncResult(const TSharedRef<FHomeGenerationResult, ESPMode::ThreadSafe> &Result);
+
+	//Generation started by the world's scheduler
+	bool GenerateScheduled();
+
+	//Computes the layout for the world's layout pool : nothing is spawned
+	bool Pregenerate();
+
+	//Layout computed in advance by the world's layout pool (null if there is none)
+	TSharedPtr<FHomeGenerationResult, ESPMode::ThreadSafe> TakePooledLayout();
+
+	//Target of the running asynchronous generation
+	EHGAsyncTarget AsyncTarget = EHGAsyncTarget::Spawn;
+
+	//Something has been spawned since the last clear : the layout of the generator is in use
+	bool bGenerationSpawned = false;
+
+	//The computation is done and the scheduler is running the spawn steps
+	bool IsWaitingForSpawn() const;
+
+	//Set once a scheduled generation is computed : its sliced stages are advanced by the scheduler, not by Tick
+	bool bScheduledSpawn = false;
+
+	//Runs the next step of the time sliced generation. Returns false once the generation is finished.
+	virtual bool AdvanceSlicedGeneration();
+
+	//Sends the recorded furniture from FirstCommand to the spawn step, by whole rooms, until TimeSliceSpawnCount is reached. Returns the number of sent commands.
+	int32 SpawnSlicedCommands(const FFurnitureSpawnBuffer &SpawnBuffer, int32 FirstCommand);
+
+	//Current stage of the time sliced generation, and progress inside it (level, shell section or command)
+	EHGSlicedStage SlicedStage = EHGSlicedStage::None;
+	int32 SlicedStep = 0;
+
+	//Next room recorded by the time sliced generation (level, index)
+	FIntPoint SlicedRoom;
+
+	TSharedPtr<FHomeGenerationResult, ESPMode::ThreadSafe> SlicedResult;
 
-	//Selected furniture (stairs, windows and doors)
-	UPROPERTY() UFurnitureMeshAsset *SelectedStair;
-	UPROPERTY() UFurnitureMeshAsset *SelectedDoor;
-	UPROPERTY() UWindowMeshAsset *SelectedWindow;
-	
 	///______________________
-	///Rooms step
+	///Initial step
 	///
 
-	virtual void DefineRooms();
+	//Meshes of the catalog of the last prepared generation, then of the spawned one (see FHGBuildingLayout::MeshCatalog for the ids).
+	//Only keeps the assets alive while the generation uses them.
+	UPROPERTY()
+	TArray<UFurnitureMeshAsset *> MeshCatalog;
 
-	//Defines the position of the stairs and the first halls (stairs must be connected to at least one hall)
-	//These position are used by all levels
-	virtual void StairsPositioning(FLevelOrganisation &InitialOrganisation);
-	
-	//Divide given level into a list of room and halls
-	virtual void DivideSurface(const int Level, FLevelOrganisation& LevelOrganisation, TDoubleLinkedList<FUnknownBlock>& NodesToDelete);
+	///______________________
+	///Rooms step
+	///
 
-	//Computes for each block (room, level, ...) their real offset.
-	//This offset take in account the walls : in the grid system they don't have any width.
-	virtual void ComputeWallEffect(TArray<FLevelOrganisation> &LevelsOrganisation);
+	//Adds all the placed windows as instances of one component
+	virtual void SpawnWindows();
 
-	//Called when all levels have been divided to define the type for each room block created.
-	//Acts globally on all levels simultaneously
-	virtual void AllocateSurface();
+	//Component rendering all the windows of the building
+	UPROPERTY()
+	UHierarchicalInstancedStaticMeshComponent *WindowComponent = nullptr;
 
-	//TODO : Remove wall
-	//TODO : Add windows and decoration
-	virtual void CompleteHallSurface();
+	//Creates the sections of the shell component (game thread)
+	void ApplyShell(const FHomeGenerationResult &Result);
 
-	//31/12/2021 : No fucking idea how to do this shit
-	//01/02/2022 Lol, progress : 0%
-	//05/02/2022 : Easy : just add placo around rooms : really thick walls just for deco, rest of walls will be empty, same for floor and ceil.
+	//Component rendering the shell of the building
+	UPROPERTY()
+	UProceduralMeshComponent *ShellComponent = nullptr;
 
-	//All halls in the building by level (first index)
-	TArray<TArray<FHallBlock>> HallBlocks;
+	//Creates the sections of the decoration (game thread).
+	//The materials are shared by all the rooms of the same type in the world (see HGDecorationCache) : one section per material, the room variation is stored in the vertex color.
+	void ApplyDecoration(FHomeGenerationResult &Result);
 
-	//All rooms in the building by level (first index)
-	TArray<TArray<FRoomBlock>> RoomBlocks;
+	//Component rendering the decoration of all the rooms
+	UPROPERTY()
+	UProceduralMeshComponent *DecorationComponent = nullptr;
 
-	//TODO : Missing step where connect the doors between each other
-	//TODO : Missing step where we generate the wall/floor -> done for each room
-	
 	///______________________
 	///Furniture Step
 	///
 
-	//Generate and place all the furniture and decoration for a room.
-	virtual void GenerateRoom(const FName &RoomType, const FRoomBlock &RoomBlock);
+	//Spawns all the recorded furniture in one step.
+	//In streaming mode, only the rooms near the players are furnished (see UpdateStreamedRooms) : the buffer isn't used.
+	virtual void FurnishBuilding(const FFurnitureSpawnBuffer &SpawnBuffer);
+	///______________________
+	///Spawn Step
+	///
+
+	//Replays all the recorded spawn commands in one batch : actors are spawned deferred, then constructed and attached in single passes, and instances are added in bulk.
+	virtual void ExecuteSpawnCommands(const FFurnitureSpawnBuffer &SpawnBuffer);
 
-	//Depending on the needed rooms, randomly place the non placed doors, and spawn it.
-	//Starts to fill the grid.
-	virtual void GenerateRoomDoors(const FName &RoomType, const FRoomBlock &RoomBlock, FRoomGrid &RoomGrid);
+	//Starts the spawning of the correct actor (with the correct component) at the given world transform and return it.
+	//A released actor of the world's pool is reused if possible (bFromPool), else the spawning is deferred : the actor is constructed by ExecuteSpawnCommands.
+	//In both cases, the actor is attached to the AHomeGenerator by ExecuteSpawnCommands.
+	virtual AActor *PlaceMeshInWorld(const UFurnitureMeshAsset *MeshAsset, const FTransform &WorldTransform, bool &bFromPool);
 
-	//Place all the needed furniture for a room and their dependencies.
-	virtual void GenerateFurniture(const FName &RoomType, const FVector &RoomOrigin, FRoomGrid &RoomGrid);
+	//All the actors spawned by this generator
+	UPROPERTY()
+	TArray<AActor *> GeneratedActors;
 
-	//Spawns the correct actor (with the correct component) and return it.
-	//It will be placed according to the given rect and then attached to the AHomeGenerator
-	virtual AActor *PlaceMeshInWorld(const UFurnitureMeshAsset *MeshAsset, const FFurnitureRect &FurnitureRect, const FVector &RoomOffset);
+	//Returns true if the furniture is rendered as an instance instead of an actor (always possible on the repeated levels)
+	bool ShouldInstanceFurniture(const UFurnitureMeshAsset *MeshAsset, int32 Level) const;
 
-public:
-	// Called every frame
-	virtual void Tick(float DeltaTime) override;
+	//Buffers an instance of the furniture of the command (added by FlushFurnitureInstances)
+	void BufferFurnitureInstance(const FFurnitureSpawnCommand &Command, const FTransform &RelativeTransform);
+
+	//Adds in bulk all the buffered instances to their component (creates the components if needed)
+	virtual void FlushFurnitureInstances();
+
+	//Computes the transform (relative to the generator) of a mesh of the catalog placed at the given rect
+	FTransform ComputeMeshTransform(int32 MeshId, const FFurnitureRect &FurnitureRect, const FVector &RoomOffset) const;
+
+	//Instances of the furniture by mesh (instancing mode only)
+	UPROPERTY()
+	TMap<UStaticMesh *, FFurnitureInstanceGroup> FurnitureInstances;
 
 	///______________________
-	///Array helper
+	///Furniture deltas
 	///
 
-	//Generate the list of the integers in the range : [Start; Stop[
-	//Acts like python function : range(start, stop)
-	static void GenerateRangeArray(TArray<int32> &InArray, int32 Start, int32 Stop);
+	//Computes the transform (relative to the generator) of the furniture of the command, with its delta if any. Returns false if the furniture is removed.
+	bool ComputeCommandTransform(const FFurnitureSpawnCommand &Command, FTransform &RelativeTransform) const;
 
-	//Generate the list of the integers in the range : [0; Stop[
-	//Acts like python function : range(stop)
-	static void GenerateRangeArray(TArray<int32> &InArray, int32 Stop);
+	//Records the commands of the furniture added in the given room (in all the rooms if INDEX_NONE)
+	void RecordAddedFurniture(FFurnitureSpawnBuffer &SpawnBuffer, int32 Level = INDEX_NONE, int32 RoomIndex = INDEX_NONE);
 
-	//Shuffle the element of a given array
-	template<typename T>
-	static void ShuffleArray(TArray<T> &InArray);
-};
+	//Command spawning an added furniture (its mesh is added to the catalog if needed). Returns false if its room or its mesh doesn't exist.
+	bool MakeAddedCommand(const FHGFurnitureDelta &Delta, FFurnitureSpawnCommand &Command);
 
-/**
- * Inline definitions of template functions
- */
-template <typename T>
-void AHomeGenerator::ShuffleArray(TArray<T>& InArray)
-{
-	if (InArray.Num() > 0)
-	{
-		for (int32 i = 0; i < InArray.Num(); ++i)
-		{
-			int32 Index = FMath::RandRange(i, InArray.Num() - 1);
-			if (i != Index)
-				InArray.Swap(i, Index);
-		}
-	}
-}
+	//Applies the delta of the furniture to its spawned actor or instance
+	void UpdateSpawnedFurniture(const FHGFurnitureId &Id);
+
+	//Records a delta for the current building
+	void SetFurnitureDelta(const FHGFurnitureDelta &Delta);
+
+	//Spawns an added furniture in the current building (with its room in streaming mode)
+	void SpawnAddedFurniture(const FHGFurnitureDelta &Added);
+
+	//Last delta of each modified furniture
+	UPROPERTY()
+	TMap<FHGFurnitureId, FHGFurnitureDelta> FurnitureDeltas;
+
+	//Building the deltas have been recorded for : they are forgotten by a generation with other parameters or another seed
+	int32 DeltasParametersHash = 0;
+	int32 DeltasSeed = 0;
+
+	//Furniture of each spawned actor
+	UPROPERTY()
+	TMap<FHGFurnitureId, AActor *> FurnitureActorIds;
+
+	///______________________
+	///Replication
+	///
+
+	//Clients : generates the building of the server
+	UFUNCTION()
+	void OnRep_ReplicatedGeneration();
+
+	//Clients : applies the furniture modifications of the server to the spawned building
+	UFUNCTION()
+	void OnRep_ReplicatedDeltas();
+
+	UFUNCTION()
+	void OnRep_ReplicatedFurniture();
+
+	//Server : copies the deltas to their replicated array
+	void UpdateReplicatedDeltas();
+
+	//Server : lists the spawned furniture with a gameplay state. Clients : maps it to its id.
+	void UpdateReplicatedFurniture();
+
+	//Only the seed and the parameters hash are replicated for the building : the clients run the same generation
+	UPROPERTY(ReplicatedUsing=OnRep_ReplicatedGeneration)
+	FHGReplicatedGeneration ReplicatedGeneration;
+
+	UPROPERTY(ReplicatedUsing=OnRep_ReplicatedDeltas)
+	TArray<FHGFurnitureDelta> ReplicatedDeltas;
+
+	UPROPERTY(ReplicatedUsing=OnRep_ReplicatedFurniture)
+	TArray<FHGReplicatedFurniture> ReplicatedFurniture;
+
+	///______________________
+	///Room proxies
+	///
+
+	//Merges the furniture actors of each room (CommandActors[i] is the actor spawned by the i-th command, if any) in one mesh per room, with one section per material.
+	virtual void BuildRoomProxies(const FFurnitureSpawnBuffer &SpawnBuffer, const TArray<AActor *> &CommandActors);
+
+	//Displays, for each room, either the merged proxy or the individual furniture, depending on the distance of the viewers.
+	UFUNCTION()
+	virtual void UpdateRoomProxies();
+
+	//Swaps between the merged proxy and the individual furniture of a room
+	void SetRoomProxyShown(FRoomProxy &RoomProxy, bool bShown);
+
+	//Fills the locations of all the local players (their pawn, or their camera if they have none)
+	void GetViewerLocations(TArray<FVector> &ViewerLocations) const;
+
+	//Merged proxy of each room (by level and room index)
+	UPROPERTY()
+	TMap<FIntPoint, FRoomProxy> RoomProxies;
+
+	//Proxy components of the previous generations, reused by the next ones
+	UPROPERTY()
+	TArray<UProceduralMeshComponent *> FreeProxyComponents;
+
+	FTimerHandle RoomProxyTimer;
+
+	//Releases the proxy of a room (its component is kept for the next proxies)
+	void ReleaseRoomProxy(const FIntPoint &RoomKey);
+
+	///______________________
+	///Streaming
+	///
+
+	//Furnishes the rooms near the players and unfurnishes the others.
+	UFUNCTION()
+	virtual void UpdateStreamedRooms();
+
+	//Spawns the furniture of the room (its placement is only done the first time).
+	virtual void FurnishRoom(const FRoomBlock &RoomBlock);
+
+	//Gives back the furniture of the room to the pool. Returns true if some instances must be removed (see RebuildFurnitureInstances).
+	//A door is kept until both of its rooms are unfurnished.
+	virtual bool UnfurnishRoom(const FRoomBlock &RoomBlock);
+
+	//Door spawned by a command (nullptr if the command isn't a door)
+	const FDoorBlock *FindCommandDoor(const FFurnitureSpawnCommand &Command) const;
+
+	//Adds again the instances of all the furnished rooms (instances can't be removed by room)
+	void RebuildFurnitureInstances();
+
+	//World bounds of a room (from its floor to the next floor)
+	FBox ComputeRoomBounds(const FRoomBlock &RoomBlock) const;
+
+	//State of each room (by level and room index), streaming mode only
+	UPROPERTY()
+	TMap<FIntPoint, FRoomStreamingState> StreamedRooms;
+
+	FTimerHandle StreamingTimer;
+
+public:
+	// Called every frame
+	virtual void Tick(float DeltaTime) override;
+};
@@ -56,8 +56,39 @@ public:
 	UPROPERTY(EditAnyWhere, BlueprintReadWrite, meta=(EditCondition="bOverrideConstraint"))
 	FWindowConstraint ConstraintsOverride;
 
-	//TODO : Actually never calculated but say it works
-	FVector BoundsOrigin;
-	FVector BoxExtent;
-	FVectorGrid GridSize; //0 along the exterior axis
+	//Grid snap length used to bake the footprint of the mesh : should be the one of the generators using this asset
+	//In UE unit
+	UPROPERTY(EditAnyWhere, BlueprintReadWrite, meta=(ClampMin="1.0"))
+	float BakeGridSnapLength = FMeshFootprint::DefaultGridSnapLength;
+
+	//Footprint of the mesh, baked when the asset is saved or cooked
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
+	FMeshFootprint Footprint;
+
+	//Checks the baked footprint against the given grid snap length and copies it in GridFootprint, with its size in grid square (non-rotated, 0 along the exterior axis of the given constraints).
+	//The asset isn't modified : the grid data of the copy is recomputed from the baked bounds if needed (never reads the mesh, except in editor when nothing has been baked yet).
+	//Returns false if no footprint is available.
+	bool ValidateFootprint(float GridSnapLength, const FWindowConstraint &DefaultConstraints, FMeshFootprint &GridFootprint, FVectorGrid &GridSize);
+
+	//Plain description of this window for the generation algorithms, from its footprint and grid size for the grid snap length of the generator (see ValidateFootprint)
+	FHGWindowDescriptor MakeDescriptor(const FWindowConstraint &DefaultConstraints, const FMeshFootprint &GridFootprint, const FVectorGrid &GridSize) const;
+
+	//Hash of the properties of this asset, used by the keys of the layout cache (see AHomeGenerator::ComputeLayoutKey).
+	//Computed once, then again after a load or an edit (a property set at runtime isn't seen).
+	const FString &GetLayoutHash() const;
+
+	//Checks the baked grid data against the baked grid snap length (recomputed from the baked bounds if outdated)
+	virtual void PostLoad() override;
+
+#if WITH_EDITOR
+	virtual void PreSave(const class ITargetPlatform* TargetPlatform) override;
+	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+
+	//Bakes the footprint from the current mesh
+	void BakeFootprint();
+#endif
+
+protected:
+	//Empty until computed
+	mutable FString LayoutHash;
 };
@@ -2,6 +2,63 @@
 
 #include "HGBasicType.h"
 
+uint8 operator|(EHGAxe A, EHGAxe B)
+{
+	return static_cast<uint8>(A) | static_cast<uint8>(B);
+}
+
+uint8 operator|(EHGAxe A, uint8 B)
+{
+	return static_cast<uint8>(A) | B;
+}
+
+uint8 operator|(uint8 A, EHGAxe B)
+{
+	return B | A;
+}
+
+FHGRandomStream::FHGRandomStream() : Stream(0) {}
+
+FHGRandomStream::FHGRandomStream(int32 Seed) : Stream(Seed) {}
+
+FHGRandomStream FHGRandomStream::Split(int32 Key) const
+{
+	return FHGRandomStream(static_cast<int32>(HashCombine(static_cast<uint32>(Stream.GetInitialSeed()), static_cast<uint32>(Key))));
+}
+
+int32 FHGRandomStream::RandRange(int32 Min, int32 Max) const
+{
+	return Stream.RandRange(Min, Max);
+}
+
+float FHGRandomStream::FRandRange(float Min, float Max) const
+{
+	return Stream.FRandRange(Min, Max);
+}
+
+bool FHGRandomStream::RandBool() const
+{
+	return Stream.RandRange(0, 1) == 1;
+}
+
+int32 FHGRandomStream::GetInitialSeed() const
+{
+	return Stream.GetInitialSeed();
+}
+
+void HGArray::GenerateRangeArray(TArray<int32>& InArray, int32 Start, int32 Stop)
+{
+	InArray.Empty();
+
+	for (int i  = Start; i < Stop; ++i)
+		InArray.Add(i);
+}
+
+void HGArray::GenerateRangeArray(TArray<int32>& InArray, int32 Stop)
+{
+	GenerateRangeArray(InArray, 0, Stop);
+}
+
 const FVectorGrid FVectorGrid::Zero(0,0);
 const FVectorGrid FVectorGrid::Unit(1, 1);
 const FVectorGrid FVectorGrid::IVector(1, 0);
@@ -64,9 +121,10 @@ float FVectorGrid::Norm() const
 	return FMath::Sqrt(X*X + Y*Y);
 }
 
-FVectorGrid FVectorGrid::Random(const FVectorGrid& min, const FVectorGrid& max)
+FVectorGrid FVectorGrid::Random(const FVectorGrid& min, const FVectorGrid& max, const FHGRandomStream& Stream)
 {
-	return FVectorGrid(FMath::RandRange(min.X, max.X), FMath::RandRange(min.Y, max.Y));
+	const int RandX = Stream.RandRange(min.X, max.X);
+	return FVectorGrid(RandX, Stream.RandRange(min.Y, max.Y));
 }
 
 FVectorGrid FVectorGrid::Min(const FVectorGrid& a, const FVectorGrid& b)
@@ -0,0 +1,1999 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "HGBuildingPlan.h"
+#include "HomeGenerationCore.h"
+#include "HGLayoutFile.h"
+#include "Async/ParallelFor.h"
+#include "Misc/FileHelper.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+//Plan file serialization of the descriptors (field by field : the floats are written as they are, the layouts stay the same)
+static FArchive &operator<<(FArchive &Ar, FVectorGrid &Vector)
+{
+	return Ar << Vector.X << Vector.Y;
+}
+
+static FArchive &operator<<(FArchive &Ar, FHGFurnitureConstraint &Constraint)
+{
+	FHGWallInteraction &Interaction = Constraint.WallAxeInteraction;
+	Ar << Interaction.WallGlobalInteraction << Interaction.XUp << Interaction.XDown << Interaction.YUp << Interaction.YDown;
+	return Ar << Constraint.Margin.XUp << Constraint.Margin.XDown << Constraint.Margin.YUp << Constraint.Margin.YDown;
+}
+
+static FArchive &operator<<(FArchive &Ar, FHGFurnitureDependency &Dependency)
+{
+	return Ar << Dependency.Distance << Dependency.Axe << Dependency.Position << Dependency.FurnitureType;
+}
+
+static FArchive &operator<<(FArchive &Ar, FHGFurnitureDescriptor &Descriptor)
+{
+	return Ar << Descriptor.Meshes << Descriptor.DefaultConstraints << Descriptor.Dependencies;
+}
+
+static FArchive &operator<<(FArchive &Ar, FHGRoomDescriptor &Room)
+{
+	return Ar << Room.Furniture << Room.NumPerHab << Room.MinimalSide;
+}
+
+static FArchive &operator<<(FArchive &Ar, FHGCatalogMesh &CatalogMesh)
+{
+	FHGMeshDescriptor &Descriptor = CatalogMesh.Descriptor;
+	Ar << Descriptor.MeshId << Descriptor.GridSize << Descriptor.bOverrideConstraint << Descriptor.ConstraintsOverride << Descriptor.Height;
+	return Ar << CatalogMesh.Path << CatalogMesh.bPlaceable;
+}
+
+static FArchive &operator<<(FArchive &Ar, FHGCatalogWindow &CatalogWindow)
+{
+	FHGWindowDescriptor &Descriptor = CatalogWindow.Descriptor;
+	Ar << Descriptor.GridSize << Descriptor.bHasBounds << Descriptor.Height << Descriptor.DistanceFromFloor << Descriptor.ExteriorFace;
+	return Ar << CatalogWindow.Path;
+}
+
+int32 FHGPlanParameters::FindCatalogMesh(const FString& Path) const
+{
+	return CatalogMeshes.IndexOfByPredicate([&Path] (const FHGCatalogMesh &CatalogMesh) { return CatalogMesh.Path == Path; });
+}
+
+int32 FHGPlanParameters::FindCatalogWindow(const FString& Path) const
+{
+	return CatalogWindows.IndexOfByPredicate([&Path] (const FHGCatalogWindow &CatalogWindow) { return CatalogWindow.Path == Path; });
+}
+
+const FHGFurnitureConstraint& FHGPlanParameters::GetMeshConstraints(int32 MeshId, const FHGFurnitureDescriptor& CorrespondingFurniture) const
+{
+	const FHGMeshDescriptor &Descriptor = CatalogMeshes[MeshId].Descriptor;
+	return Descriptor.bOverrideConstraint ? Descriptor.ConstraintsOverride : CorrespondingFurniture.DefaultConstraints;
+}
+
+int FHGPlanParameters::GetMeshArea(int32 MeshId, const FHGFurnitureDescriptor& CorrespondingFurniture) const
+{
+	const FVectorGrid &GridSize = CatalogMeshes[MeshId].Descriptor.GridSize;
+	const FHGMargin &Margin = GetMeshConstraints(MeshId, CorrespondingFurniture).Margin;
+	return (GridSize.X + Margin.XDown + Margin.XUp) * (GridSize.Y + Margin.YDown + Margin.YUp);
+}
+
+int FHGPlanParameters::GetAverageArea(const FHGFurnitureDescriptor& CorrespondingFurniture) const
+{
+	int Sum = 0;
+	for(const int32 MeshId : CorrespondingFurniture.Meshes)
+		Sum += GetMeshArea(MeshId, CorrespondingFurniture);
+
+	// ENH: Floor/Ceil is important there ?
+	return Sum / CorrespondingFurniture.Meshes.Num();
+}
+
+int FHGPlanParameters::ComputeMinimalSide(FHGRoomDescriptor& Room) const
+{
+	int NeededArea = 0;
+	for(const FName &FurnitureType : Room.Furniture)
+		NeededArea += GetAverageArea(Furniture.FindChecked(FurnitureType));
+	Room.MinimalSide = FMath::CeilToInt(FMath::Sqrt(NeededArea));
+
+	return Room.MinimalSide;
+}
+
+void FHGPlanParameters::Serialize(FArchive& Ar)
+{
+	Ar << GeneratorName << Inhabitants << Seed << bApartmentBlock << MaxUnitAttempts << bTypicalFloors << TypicalFloorStart;
+
+	//Computed data included (see ComputeSides) : the rooms keep their order
+	FHGBuildingConstraints &Building = BuildingConstraints;
+	Ar << Building.GridSnapLength << Building.FloorWidth << Building.FloorHeight << Building.WallWidth;
+	Ar << Building.MinSideFloorLength << Building.MaxSideFloorLength << Building.MaxFloorsNumber;
+	Ar << Building.AverageSide << Building.NormalRoomQuantity << Building.BuildingSize << Building.Levels;
+
+	FHGDivisionConstraints &Division = RoomsDivisionConstraints;
+	Ar << Division.HallWidth << Division.MaxHallRatio << Division.OverDivideProba;
+	Ar << Division.ABSMinimalSide << Division.StopSplitSide << Division.SufficientSide;
+	Ar << Division.MinSideCoef << Division.StopSplitCoef << Division.SufficientChunkCoef;
+
+	Ar << Stairs << Doors << Windows.Meshes << Windows.Spacing << Rooms << Furniture;
+	Ar << bStreamFurniture << CatalogMeshes << CatalogWindows;
+}
+
+bool FHGPlanParameters::SaveToFile(const FString& Filename) const
+{
+	TArray<uint8> Bytes;
+	FMemoryWriter Writer(Bytes);
+	uint32 Magic = HGPlanFile::Magic;
+	uint32 Version = HGPlanFile::Version;
+	Writer << Magic << Version;
+
+	//Only read by the writer
+	const_cast<FHGPlanParameters *>(this)->Serialize(Writer);
+	return FFileHelper::SaveArrayToFile(Bytes, *Filename);
+}
+
+bool FHGPlanParameters::LoadFromFile(const FString& Filename)
+{
+	TArray<uint8> Bytes;
+	if(!FFileHelper::LoadFileToArray(Bytes, *Filename, FILEREAD_Silent))
+		return false;
+
+	FMemoryReader Reader(Bytes);
+	uint32 Magic = 0, Version = 0;
+	Reader << Magic << Version;
+	if(Reader.IsError() || Magic != HGPlanFile::Magic || Version != HGPlanFile::Version)
+	{
+		UE_LOG(LogHomeGenerationCore, Warning, TEXT("%s isn't a valid plan file (version %d expected)."), *Filename, HGPlanFile::Version);
+		return false;
+	}
+
+	Serialize(Reader);
+	return !Reader.IsError() && Reader.AtEnd();
+}
+
+FHGBuildingPlan::~FHGBuildingPlan()
+{
+	Reset();
+}
+
+void FHGBuildingPlan::Reset()
+{
+	//Doors are shared by the two rooms they connect
+	TSet<FDoorBlock *> DoorBlocks;
+	for(const auto &LevelRooms : RoomBlocks)
+		for(const FRoomBlock &RoomBlock : LevelRooms)
+			DoorBlocks.Append(RoomBlock.ConnectedDoors);
+	for(FDoorBlock *DoorBlock : DoorBlocks)
+		delete DoorBlock;
+
+	HallBlocks.Empty();
+	RoomBlocks.Empty();
+	WindowPlacements.Reset();
+}
+
+SIZE_T FHGBuildingPlan::GetAllocatedSize() const
+{
+	SIZE_T Size = HallBlocks.GetAllocatedSize() + RoomBlocks.GetAllocatedSize() + WindowPlacements.GetAllocatedSize();
+	for(const auto &LevelHalls : HallBlocks)
+		Size += LevelHalls.GetAllocatedSize() + LevelHalls.Num() * sizeof(FHallBlock);
+
+	//Doors are shared by the two rooms they connect
+	TSet<const FDoorBlock *> DoorBlocks;
+	for(const auto &LevelRooms : RoomBlocks)
+	{
+		Size += LevelRooms.GetAllocatedSize() + LevelRooms.Num() * sizeof(FRoomBlock);
+		for(const FRoomBlock &RoomBlock : LevelRooms)
+		{
+			Size += RoomBlock.ConnectedDoors.GetAllocatedSize();
+			DoorBlocks.Append(RoomBlock.ConnectedDoors);
+		}
+	}
+	return Size + DoorBlocks.Num() * sizeof(FDoorBlock);
+}
+
+void FHGBuildingPlan::ComputeLayout(FFurnitureSpawnBuffer& SpawnBuffer)
+{
+	QUICK_SCOPE_CYCLE_COUNTER(STAT_HomeGenerator_ComputeLayout);
+
+	DefineBuilding();
+	if(bCancelGeneration)
+		return;
+
+	DefineRooms();
+	if(bCancelGeneration)
+		return;
+
+	//In streaming mode, the rooms are recorded when they are furnished
+	if(!bStreamFurniture)
+		RecordFurniture(SpawnBuffer);
+}
+
+void FHGBuildingPlan::WriteLayout(const FFurnitureSpawnBuffer& SpawnBuffer, TArray<uint8>& Bytes) const
+{
+	check(RoomBlocks.Num() == BuildingConstraints.Levels)
+
+	FHGLayoutWriter Writer;
+	FHGLayoutHeader &Header = Writer.Header;
+	Header.Seed = Seed;
+	Header.Levels = BuildingConstraints.Levels;
+	Header.DividedLevels = GetDividedLevels();
+	Header.BuildingSizeX = BuildingConstraints.BuildingSize.X;
+	Header.BuildingSizeY = BuildingConstraints.BuildingSize.Y;
+	Header.GridSnapLength = BuildingConstraints.GridSnapLength;
+	Header.FloorHeight = BuildingConstraints.FloorHeight;
+	Header.FloorWidth = BuildingConstraints.FloorWidth;
+	Header.WallWidth = BuildingConstraints.WallWidth;
+	Header.SelectedDoor = CatalogMeshes.IsValidIndex(SelectedDoor) ? Writer.AddString(CatalogMeshes[SelectedDoor].Path) : INDEX_NONE;
+	Header.SelectedStair = CatalogMeshes.IsValidIndex(SelectedStair) ? Writer.AddString(CatalogMeshes[SelectedStair].Path) : INDEX_NONE;
+	Header.SelectedWindow = CatalogWindows.IsValidIndex(SelectedWindow) ? Writer.AddString(CatalogWindows[SelectedWindow].Path) : INDEX_NONE;
+
+	//The ids of the commands are the ones of the catalog
+	for(const FHGCatalogMesh &CatalogMesh : CatalogMeshes)
+		Writer.Meshes.Push(Writer.AddString(CatalogMesh.Path));
+
+	for(const auto &LevelHalls : HallBlocks)
+		for(const FHallBlock &Hall : LevelHalls)
+		{
+			FHGLayoutHall &Record = Writer.Halls.AddDefaulted_GetRef();
+			Record.Level = Hall.Level;
+			Record.PositionX = Hall.GlobalPosition.X;
+			Record.PositionY = Hall.GlobalPosition.Y;
+			Record.SizeX = Hall.Size.X;
+			Record.SizeY = Hall.Size.Y;
+			Record.RealOffsetX = Hall.GetRealOffset().X;
+			Record.RealOffsetY = Hall.GetRealOffset().Y;
+			Record.RealSizeX = Hall.GetRealSize().X;
+			Record.RealSizeY = Hall.GetRealSize().Y;
+			Record.bStairsHall = Hall.StairsHall;
+		}
+
+	//A door shared by two rooms is saved once
+	TSet<const FDoorBlock *> SavedDoors;
+	for(const auto &LevelRooms : RoomBlocks)
+		for(const FRoomBlock &Room : LevelRooms)
+		{
+			FHGLayoutRoom &Record = Writer.Rooms.AddDefaulted_GetRef();
+			Record.Level = Room.Level;
+			Record.Index = Room.Index;
+			Record.PositionX = Room.GlobalPosition.X;
+			Record.PositionY = Room.GlobalPosition.Y;
+			Record.SizeX = Room.Size.X;
+			Record.SizeY = Room.Size.Y;
+			Record.RealOffsetX = Room.GetRealOffset().X;
+			Record.RealOffsetY = Room.GetRealOffset().Y;
+			Record.RealSizeX = Room.GetRealSize().X;
+			Record.RealSizeY = Room.GetRealSize().Y;
+			Record.RoomType = Writer.AddString(Room.RoomType.ToString());
+
+			for(const FDoorBlock *DoorBlock : Room.ConnectedDoors)
+			{
+				bool bAlreadySaved;
+				SavedDoors.Add(DoorBlock, &bAlreadySaved);
+				if(bAlreadySaved)
+					continue;
+
+				FHGLayoutDoor &DoorRecord = Writer.Doors.AddDefaulted_GetRef();
+				DoorRecord.Level = Room.Level;
+				DoorRecord.MainRoom = DoorBlock->GetMainParent() ? DoorBlock->GetMainParent()->Index : INDEX_NONE;
+				DoorRecord.SecondRoom = DoorBlock->GetSecondParent() ? DoorBlock->GetSecondParent()->Index : INDEX_NONE;
+				DoorRecord.RecordingRoom = DoorBlock->GetRecordingRoom() ? DoorBlock->GetRecordingRoom()->Index : INDEX_NONE;
+				DoorRecord.PositionX = DoorBlock->GetGlobalPosition().X;
+				DoorRecord.PositionY = DoorBlock->GetGlobalPosition().Y;
+				DoorRecord.Mesh = CatalogMeshes.IsValidIndex(DoorBlock->GetMesh().MeshId) ? Writer.AddString(CatalogMeshes[DoorBlock->GetMesh().MeshId].Path) : INDEX_NONE;
+				DoorRecord.OpeningSide = static_cast<uint8>(DoorBlock->GetOpeningSide());
+			}
+		}
+
+	Writer.Furniture.Reserve(SpawnBuffer.Num());
+	for(const FFurnitureSpawnCommand &Command : SpawnBuffer.Commands)
+	{
+		FHGLayoutFurniture &Record = Writer.Furniture.AddDefaulted_GetRef();
+		Record.Mesh = Command.MeshId;
+		Record.Rotation = static_cast<uint8>(Command.Rect.Rotation);
+		Record.PositionX = Command.Rect.Position.X;
+		Record.PositionY = Command.Rect.Position.Y;
+		Record.SizeX = Command.Rect.Size.X;
+		Record.SizeY = Command.Rect.Size.Y;
+		Record.RoomOffsetX = Command.RoomOffset.X;
+		Record.RoomOffsetY = Command.RoomOffset.Y;
+		Record.RoomOffsetZ = Command.RoomOffset.Z;
+		Record.Level = Command.Level;
+		Record.RoomIndex = Command.RoomIndex;
+		Record.RoomType = Writer.AddString(Command.RoomType.ToString());
+		Record.FurnitureType = Writer.AddString(Command.FurnitureType.ToString());
+	}
+
+	Writer.Write(Bytes);
+}
+
+bool FHGBuildingPlan::ReadLayout(const FHGLayoutView& View, FFurnitureSpawnBuffer& SpawnBuffer)
+{
+	QUICK_SCOPE_CYCLE_COUNTER(STAT_HomeGenerator_ReadLayout);
+	check(HallBlocks.Num() == 0 && RoomBlocks.Num() == 0)
+
+	//The footprints of the meshes have been validated with the grid snap length of the generator
+	const FHGLayoutHeader &Header = View.GetHeader();
+	if(Header.GridSnapLength != BuildingConstraints.GridSnapLength || Header.Levels <= 0 || Header.DividedLevels <= 0 || Header.DividedLevels > Header.Levels)
+		return false;
+
+	//Only the computed size of the building (levels and grid size) is taken from the file : the generator must have the same seed, floors and walls
+	if(Header.Seed != Seed || Header.FloorHeight != BuildingConstraints.FloorHeight || Header.FloorWidth != BuildingConstraints.FloorWidth || Header.WallWidth != BuildingConstraints.WallWidth)
+		return false;
+	if(Header.BuildingSizeX <= 0 || Header.BuildingSizeY <= 0)
+		return false;
+	BuildingConstraints.Levels = Header.Levels;
+	BuildingConstraints.BuildingSize = FVectorGrid(Header.BuildingSizeX, Header.BuildingSizeY);
+	if(Header.DividedLevels != GetDividedLevels())
+		return false;
+
+	//Assets are found by path among the ones of the generator
+	auto FindMesh = [this, &View] (int32 PathId) -> int32 { return FindCatalogMesh(View.GetString(PathId)); };
+	SelectedDoor = FindMesh(Header.SelectedDoor);
+	SelectedStair = FindMesh(Header.SelectedStair);
+	SelectedWindow = FindCatalogWindow(View.GetString(Header.SelectedWindow));
+	if(SelectedDoor == INDEX_NONE || SelectedStair == INDEX_NONE)
+		return false;
+
+	HallBlocks.SetNum(BuildingConstraints.Levels);
+	RoomBlocks.SetNum(BuildingConstraints.Levels);
+	for(const FHGLayoutHall &Record : View.GetHalls())
+	{
+		if(!HallBlocks.IsValidIndex(Record.Level) || Record.SizeX <= 0 || Record.SizeY <= 0)
+			return false;
+
+		FHallBlock * const Hall = new FHallBlock(FVectorGrid(Record.SizeX, Record.SizeY), FVectorGrid(Record.PositionX, Record.PositionY), Record.Level);
+		Hall->SetRealData(FVector2D(Record.RealOffsetX, Record.RealOffsetY), FVector2D(Record.RealSizeX, Record.RealSizeY));
+		Hall->StairsHall = Record.bStairsHall != 0;
+		HallBlocks[Record.Level].Add(Hall);
+	}
+
+	//Saved in the order of their index
+	for(const FHGLayoutRoom &Record : View.GetRooms())
+	{
+		if(!RoomBlocks.IsValidIndex(Record.Level) || Record.Index != RoomBlocks[Record.Level].Num() || Record.SizeX <= 0 || Record.SizeY <= 0)
+			return false;
+
+		//The furniture of the room is found by its type
+		const FName RoomType(*View.GetString(Record.RoomType));
+		if(!Rooms.Contains(RoomType))
+			return false;
+
+		FRoomBlock * const Room = new FRoomBlock(FVectorGrid(Record.SizeX, Record.SizeY), FVectorGrid(Record.PositionX, Record.PositionY), Record.Level);
+		Room->SetRealData(FVector2D(Record.RealOffsetX, Record.RealOffsetY), FVector2D(Record.RealSizeX, Record.RealSizeY));
+		Room->RoomType = RoomType;
+		Room->Index = RoomBlocks[Record.Level].Add(Room);
+	}
+
+	//A door is deleted with the rooms once connected
+	for(const FHGLayoutDoor &Record : View.GetDoors())
+	{
+		if(!RoomBlocks.IsValidIndex(Record.Level))
+			return false;
+
+		TIndirectArray<FRoomBlock> &LevelRooms = RoomBlocks[Record.Level];
+		FRoomBlock * const MainRoom = LevelRooms.IsValidIndex(Record.MainRoom) ? &LevelRooms[Record.MainRoom] : nullptr;
+		FRoomBlock * const SecondRoom = LevelRooms.IsValidIndex(Record.SecondRoom) ? &LevelRooms[Record.SecondRoom] : nullptr;
+		const int32 DoorMesh = FindMesh(Record.Mesh);
+		if(!MainRoom || DoorMesh == INDEX_NONE)
+			return false;
+
+		const EHGAxe OpeningSide = static_cast<EHGAxe>(Record.OpeningSide);
+		if(OpeningSide != EHGAxe::X_UP && OpeningSide != EHGAxe::X_DOWN && OpeningSide != EHGAxe::Y_UP && OpeningSide != EHGAxe::Y_DOWN)
+			return false;
+
+		const FRoomBlock * const RecordingRoom = LevelRooms.IsValidIndex(Record.RecordingRoom) ? &LevelRooms[Record.RecordingRoom] : nullptr;
+		FDoorBlock * const DoorBlock = new FDoorBlock(MainRoom, SecondRoom, OpeningSide, CatalogMeshes[DoorMesh].Descriptor, FVectorGrid(Record.PositionX, Record.PositionY), RecordingRoom);
+		MainRoom->ConnectedDoors.Push(DoorBlock);
+		if(SecondRoom)
+			SecondRoom->ConnectedDoors.Push(DoorBlock);
+	}
+
+	//In streaming mode, the rooms are recorded again when they are furnished
+	if(bStreamFurniture)
+		return true;
+
+	//Ids of the file's catalog to the ids of the generator's one (a mesh removed since is skipped)
+	TArray<int32> MeshIds;
+	MeshIds.Reserve(View.GetMeshes().Num());
+	for(const int32 PathId : View.GetMeshes())
+		MeshIds.Push(FindMesh(PathId));
+
+	//Only the names are converted : the records are read in place
+	TMap<int32, FName> Names;
+	auto FindName = [&View, &Names] (int32 StringId) -> FName
+	{
+		if(const FName * const Name = Names.Find(StringId))
+			return *Name;
+		return Names.Add(StringId, FName(*View.GetString(StringId)));
+	};
+
+	int32 FurnitureIndex = 0;
+	const TArrayView<const FHGLayoutFurniture> Furniture = View.GetFurniture();
+	SpawnBuffer.Commands.Reserve(Furniture.Num());
+	for(int32 RecordIndex = 0; RecordIndex < Furniture.Num(); ++RecordIndex)
+	{
+		//The furniture of a room is stored in its order of placement (its id doesn't depend on the skipped records)
+		const FHGLayoutFurniture &Record = Furniture[RecordIndex];
+		const bool bSameRoom = RecordIndex > 0 && Furniture[RecordIndex - 1].Level == Record.Level && Furniture[RecordIndex - 1].RoomIndex == Record.RoomIndex;
+		FurnitureIndex = bSameRoom ? FurnitureIndex + 1 : 0;
+
+		if(!MeshIds.IsValidIndex(Record.Mesh) || MeshIds[Record.Mesh] == INDEX_NONE || Record.Rotation > static_cast<uint8>(EFurnitureRotation::ROT270))
+			continue;
+
+		FFurnitureSpawnCommand &Command = SpawnBuffer.Commands.AddDefaulted_GetRef();
+		Command.MeshId = MeshIds[Record.Mesh];
+		Command.Rect.Rotation = static_cast<EFurnitureRotation>(Record.Rotation);
+		Command.Rect.Position = FVectorGrid(Record.PositionX, Record.PositionY);
+		Command.Rect.Size = FVectorGrid(Record.SizeX, Record.SizeY);
+		Command.RoomOffset = FVector(Record.RoomOffsetX, Record.RoomOffsetY, Record.RoomOffsetZ);
+		Command.Level = Record.Level;
+		Command.RoomIndex = Record.RoomIndex;
+		Command.RoomType = FindName(Record.RoomType);
+		Command.FurnitureType = FindName(Record.FurnitureType);
+		Command.Index = FurnitureIndex;
+	}
+	return true;
+}
+
+void FHGBuildingPlan::ComputeSides()
+{
+	int MinimalSide = INT_MAX;
+	int MaximalSide = 0;
+	int AverageSide = 0;
+	BuildingConstraints.NormalRoomQuantity = 0;
+	
+	for(auto Room : Rooms)
+	{
+		const int Quantity = FMath::CeilToInt(Room.Value.NumPerHab * Inhabitants);
+		BuildingConstraints.NormalRoomQuantity += Quantity;
+		
+		if(ComputeMinimalSide(Room.Value) > 0 && Quantity > 0)
+		{
+			if(Room.Value.MinimalSide < MinimalSide)
+				MinimalSide = Room.Value.MinimalSide;
+			if(Room.Value.MinimalSide > MaximalSide)
+				MaximalSide = Room.Value.MinimalSide;
+			
+			AverageSide += Quantity * Room.Value.MinimalSide;
+		}
+	}
+	
+	AverageSide /= BuildingConstraints.NormalRoomQuantity;
+	RoomsDivisionConstraints.CalculateAllSides(MinimalSide, AverageSide, MaximalSide);
+	BuildingConstraints.AverageSide = AverageSide;
+
+	//Croissant order
+	auto PredicateRooms = [&] (const FHGRoomDescriptor &A, const FHGRoomDescriptor &B) { return A.MinimalSide < B.MinimalSide; };
+	Rooms.ValueSort(PredicateRooms);
+}
+
+FHGRandomStream FHGBuildingPlan::GetRandomStream(EHGRandomDomain Domain, int32 Level, int32 RoomIndex) const
+{
+	return FHGRandomStream(Seed).Split(static_cast<int32>(Domain)).Split(Level).Split(RoomIndex);
+}
+
+void FHGBuildingPlan::DefineBuilding()
+{
+	const FHGRandomStream Stream = GetRandomStream(EHGRandomDomain::Building);
+
+	//
+	//Chooses for each special furniture a mesh
+	check(Doors.Meshes.Num() > 0 && Stairs.Meshes.Num() > 0 && Windows.Meshes.Num() > 0)
+	SelectedDoor = Doors.Meshes[Stream.RandRange(0, Doors.Meshes.Num() - 1)];
+	SelectedStair = Stairs.Meshes[Stream.RandRange(0, Stairs.Meshes.Num() - 1)];
+	SelectedWindow = Windows.Meshes[Stream.RandRange(0, Windows.Meshes.Num() - 1)];
+	check(SelectedDoor != INDEX_NONE && SelectedStair != INDEX_NONE)
+
+	//
+	//Calculates building's dimensions
+	const FVectorGrid StairSize = CatalogMeshes[SelectedStair].Descriptor.GridSize;
+	const int StairArea = GetMeshArea(SelectedStair, Stairs);
+	
+	//Basic steps
+	const int MinimalSideMin = FMath::Max(BuildingConstraints.MinSideFloorLength, RoomsDivisionConstraints.ABSMinimalSide + StairSize.MinSide());
+	const int MinimalSideMax = FMath::Max(BuildingConstraints.MinSideFloorLength, RoomsDivisionConstraints.ABSMinimalSide + FMath::Max(RoomsDivisionConstraints.ABSMinimalSide + RoomsDivisionConstraints.HallWidth, StairSize.MaxSide()));
+	
+	const int AreaPerStage = Stream.RandRange(
+		FMath::Max(MinimalSideMin * MinimalSideMax,FMath::CeilToInt(StairArea / (1 - RoomsDivisionConstraints.MaxHallRatio))),
+		FMath::Max(MinimalSideMin * MinimalSideMax, FMath::Square(BuildingConstraints.MaxSideFloorLength)) //ENH:What should we do if set to 0
+	);
+	const float Intermediate = static_cast<float>(AreaPerStage) * (1 - RoomsDivisionConstraints.MaxHallRatio) - static_cast<float>(StairArea);
+
+	//Level's calculation
+	const int LevelMin = FMath::CeilToInt(BuildingConstraints.NormalRoomQuantity * FMath::Square<float>(FMath::Max<int>(
+		BuildingConstraints.AverageSide,
+		RoomsDivisionConstraints.ABSMinimalSide
+	)) / Intermediate);
+	const int LevelMax = FMath::Max(LevelMin,
+		FMath::Min(
+			FMath::CeilToInt((BuildingConstraints.NormalRoomQuantity + Rooms.Num()) * FMath::Square<float>(RoomsDivisionConstraints.SufficientSide) / Intermediate),
+			BuildingConstraints.MaxFloorsNumber > 0 ? BuildingConstraints.MaxFloorsNumber : INT_MAX
+		)
+	);
+	BuildingConstraints.Levels = Stream.RandRange(LevelMin, LevelMax);
+
+	//Building size calculation
+	if(Stream.RandBool()) //X side -> min side
+	{
+		BuildingConstraints.BuildingSize.X = Stream.RandRange(MinimalSideMin, AreaPerStage / MinimalSideMax);
+		BuildingConstraints.BuildingSize.Y = FMath::CeilToInt(AreaPerStage / BuildingConstraints.BuildingSize.X);
+	}
+	else
+	{
+		BuildingConstraints.BuildingSize.Y = Stream.RandRange(MinimalSideMin, AreaPerStage / MinimalSideMax);
+		BuildingConstraints.BuildingSize.X = FMath::CeilToInt(AreaPerStage / BuildingConstraints.BuildingSize.Y);
+	}	
+
+	//
+	//Positions the main door and prepare the division for the first floor (the only affected by this door)
+	//ENH : We will see that later actually the enter will be a hole
+}
+
+void FHGBuildingPlan::DefineRooms()
+{
+	FHGDivisionState Division;
+	BeginRoomsDivision(Division);
+	if(bApartmentBlock)
+		DivideUnits(0, GetDividedLevels(), Division);
+	else
+		for (int i = 0; i < GetDividedLevels(); ++i)
+			DivideSurface(i, Division.LevelsOrganisation[i], Division.NodesToDelete);
+	EndRoomsDivision(Division);
+
+	//Once placed, the doors and the windows open the walls of the shell
+	PlaceDoorsAndWindows();
+}
+
+void FHGBuildingPlan::BeginRoomsDivision(FHGDivisionState& Division)
+{
+	StairsPositioning(Division.InitialOrganisation); //Stores initial B/H on the heap
+	Division.LevelsOrganisation.Init(Division.InitialOrganisation, BuildingConstraints.Levels);
+
+	for (int i = 0; i < BuildingConstraints.Levels; ++i)
+	{
+		HallBlocks.Push(TIndirectArray<FHallBlock>());
+		RoomBlocks.Push(TIndirectArray<FRoomBlock>());
+	}
+}
+
+void FHGBuildingPlan::EndRoomsDivision(FHGDivisionState& Division)
+{
+	Division.InitialOrganisation.Empty();//InitialOrganisation isn't valid anymore
+
+	//The repeated levels aren't divided : they are copied once the doors are placed
+	Division.LevelsOrganisation.SetNum(GetDividedLevels());
+	ComputeWallEffect(Division.LevelsOrganisation);
+	FUnknownBlock::DeleteAdjacencyMarkers(Division.NodesToDelete);
+	Division.NodesToDelete.Empty();//All level organisations aren't valid anymore
+	Division.LevelsOrganisation.Empty();
+
+	//The dwelling units are already allocated
+	if(!bApartmentBlock)
+		AllocateSurface();
+}
+
+void FHGBuildingPlan::StairsPositioning(FLevelOrganisation &InitialOrganisation)
+{
+	FRoomGrid LevelGrid(BuildingConstraints.BuildingSize);
+	
+	//Possible positions
+	TArray<int> PositionX;
+	TArray<int> PositionY;
+	TArray<EFurnitureRotation> Rotations = {EFurnitureRotation::ROT0, EFurnitureRotation::ROT90, EFurnitureRotation::ROT180, EFurnitureRotation::ROT270};
+	HGArray::GenerateRangeArray(PositionX, LevelGrid.GetSizeX());
+	HGArray::GenerateRangeArray(PositionY, LevelGrid.GetSizeY());
+
+	//Shuffle everything here to allow more random generation
+	const FHGRandomStream Stream = GetRandomStream(EHGRandomDomain::Stairs);
+	Stream.Shuffle(PositionX);
+	Stream.Shuffle(PositionY);
+	Stream.Shuffle(Rotations);
+
+	//Define needed general element for positioning verification
+	const FHGMeshDescriptor &StairMesh = CatalogMeshes[SelectedStair].Descriptor;
+	const FHGFurnitureConstraint &FinalConstraints = GetMeshConstraints(SelectedStair, Stairs);
+	const auto IsCenterAvailable = [&] (int GridSize, int Size) -> bool {
+		return ( Size < RoomsDivisionConstraints.ABSMinimalSide + 2 * RoomsDivisionConstraints.HallWidth ) ?
+			GridSize >= 3 * RoomsDivisionConstraints.ABSMinimalSide + 2 * RoomsDivisionConstraints.HallWidth
+		:
+			GridSize >= 2 * RoomsDivisionConstraints.ABSMinimalSide + Size;
+	};
+	const auto IsInCenter = [&] (int Coordinate, int GridSize, int Size) -> bool { return RoomsDivisionConstraints.ABSMinimalSide < Coordinate && Coordinate <= GridSize - (Size + RoomsDivisionConstraints.ABSMinimalSide); };
+	const auto IsNHCenterAvailable = [&] (int GridSize, int Size) -> bool { return GridSize >= 2 * RoomsDivisionConstraints.ABSMinimalSide + Size; }; // No hall
+	
+	bool PositionFound = false;
+	for(const int X : PositionX)
+	{
+		for(const int Y : PositionY)
+		{
+			for(const auto Rotation : Rotations)
+			{
+				FFurnitureRect FinalRect(Rotation, FVectorGrid(X, Y), StairMesh.GridSize);
+
+				//Reset if previous operation failed
+				InitialOrganisation.Empty();
+
+				//Checks if the rect respects stairs constraints
+				bool IsStairPlaceable = true;
+				{
+					//Check lambdas
+					const FVectorGrid RotatedSize = FinalRect.WillRotationInvertSize() ? FVectorGrid(FinalRect.Size.Y, FinalRect.Size.X) : FinalRect.Size;
+					const auto IsInXCenter = [&] () -> bool { return IsInCenter(X, LevelGrid.GetSizeX(), RotatedSize.X); };
+					const auto IsInYCenter = [&] () -> bool  { return IsInCenter(Y, LevelGrid.GetSizeY(), RotatedSize.Y); };
+					const auto IsXCenterAvailable = [&] () -> bool { return IsCenterAvailable(LevelGrid.GetSizeX(), RotatedSize.X); };
+					const auto IsYCenterAvailable = [&] () -> bool  { return IsCenterAvailable( LevelGrid.GetSizeY(), RotatedSize.Y); };
+					const auto IsNHXCenterAvailable = [&] () -> bool { return IsNHCenterAvailable(LevelGrid.GetSizeX(), RotatedSize.X); };
+					const auto IsNHYCenterAvailable = [&] () -> bool  { return IsNHCenterAvailable( LevelGrid.GetSizeY(), RotatedSize.Y); };
+
+					InitialOrganisation.SetHallBlock(FLevelOrganisation::Stairs, new FHallBlock(
+						RotatedSize,
+						FinalRect.Position,
+						0
+					));
+
+					//ENH : The code in the center case could replace all other cases (just if we check X > 0 for all X calculated value)			
+					//We could so split the part check if possible and spawn the hall/blocks
+					//Case where it is in center of the room
+					if(IsInXCenter() && IsInYCenter())
+					{
+						if(RotatedSize.X >= RotatedSize.Y)
+						{
+							if(!IsXCenterAvailable() || !IsNHYCenterAvailable())
+								IsStairPlaceable = false;
+
+							const int FHAxis = Stream.RandRange(RoomsDivisionConstraints.ABSMinimalSide, FMath::Min(FinalRect.Position.X, LevelGrid.GetSizeX() - 2 * (RoomsDivisionConstraints.HallWidth + RoomsDivisionConstraints.ABSMinimalSide)));
+							const int SHAxis = Stream.RandRange(FMath::Max(FHAxis + RoomsDivisionConstraints.HallWidth + RoomsDivisionConstraints.ABSMinimalSide, FinalRect.Position.X + RotatedSize.X - RoomsDivisionConstraints.HallWidth), LevelGrid.GetSizeX() - (RoomsDivisionConstraints.HallWidth + RoomsDivisionConstraints.ABSMinimalSide));
+							const int FHSpace = FinalRect.Position.X - (FHAxis + RoomsDivisionConstraints.HallWidth); //No need of min or max, because it is already implied by the def of the axis value
+							const int SHSpace = SHAxis - (FinalRect.Position.X + RotatedSize.X);
+
+							InitialOrganisation.SetHallBlock(
+								FLevelOrganisation::LowCorridor,
+								new FHallBlock(
+									FVectorGrid(RoomsDivisionConstraints.HallWidth, LevelGrid.GetSizeY()),
+									FVectorGrid(FHAxis, 0),
+									0
+							));
+
+							InitialOrganisation.SetHallBlock(
+								FLevelOrganisation::HighCorridor,
+								new FHallBlock(
+									FVectorGrid(RoomsDivisionConstraints.HallWidth, LevelGrid.GetSizeY()),
+									FVectorGrid(SHAxis, 0),
+									0
+							));
+
+							if(FHSpace > 0)
+								InitialOrganisation.SetHallBlock(
+									FLevelOrganisation::LowMargin,
+									new FHallBlock(
+										FVectorGrid(FHSpace, RotatedSize.Y),
+										FVectorGrid(FHAxis + RoomsDivisionConstraints.HallWidth, FinalRect.Position.Y),
+										0
+								));
+
+							if(SHSpace > 0)
+								InitialOrganisation.SetHallBlock(
+									FLevelOrganisation::HighMargin,
+									new FHallBlock(
+										FVectorGrid(SHSpace, RotatedSize.Y),
+										FVectorGrid(FinalRect.Position.X + RotatedSize.X, FinalRect.Position.Y),
+										0
+								));
+
+							InitialOrganisation.SetUnknownBlock(
+								FLevelOrganisation::LowWing,
+								new FUnknownBlock(
+									FVectorGrid(FHAxis, LevelGrid.GetSizeY()),
+									FVectorGrid(0, 0),
+									0,
+									false,
+									static_cast<uint8>(EHGAxe::X_UP),
+									EHGAxe::X_UP
+							));
+
+							InitialOrganisation.SetUnknownBlock(
+								FLevelOrganisation::HighWing,
+								new FUnknownBlock(
+								FVectorGrid(LevelGrid.GetSizeX() - (SHAxis + RoomsDivisionConstraints.HallWidth), LevelGrid.GetSizeY()),
+								FVectorGrid(SHAxis + RoomsDivisionConstraints.HallWidth, 0),
+								0,
+								false,
+								static_cast<uint8>(EHGAxe::X_DOWN),
+								EHGAxe::X_DOWN
+							));
+
+							InitialOrganisation.SetUnknownBlock(
+								FLevelOrganisation::LowApartment,
+								new FUnknownBlock(
+									FVectorGrid(SHAxis - (FHAxis + RoomsDivisionConstraints.HallWidth), FinalRect.Position.Y),
+									FVectorGrid(SHAxis + RoomsDivisionConstraints.HallWidth, 0),
+									0,
+									false,
+									EHGAxe::X_DOWN | EHGAxe::X_UP | EHGAxe::Y_UP,
+									EHGAxe::X_DOWN
+							));
+
+							InitialOrganisation.SetUnknownBlock(
+								FLevelOrganisation::HighApartment,
+								new FUnknownBlock(
+									FVectorGrid(SHAxis - (FHAxis + RoomsDivisionConstraints.HallWidth), LevelGrid.GetSizeY() - (FinalRect.Position.Y + RotatedSize.Y)),
+									FVectorGrid(FHAxis + RoomsDivisionConstraints.HallWidth, FinalRect.Position.Y + RotatedSize.Y),
+									0,
+									false,
+									EHGAxe::X_DOWN | EHGAxe::X_UP | EHGAxe::Y_DOWN,
+									EHGAxe::X_UP
+							));
+						}
+						else
+						{
+							if(!IsYCenterAvailable() || !IsNHXCenterAvailable())
+								IsStairPlaceable = false;
+
+							const int FHAxis = Stream.RandRange(RoomsDivisionConstraints.ABSMinimalSide, FMath::Min(FinalRect.Position.Y, LevelGrid.GetSizeY() - 2 * (RoomsDivisionConstraints.HallWidth + RoomsDivisionConstraints.ABSMinimalSide)));
+							const int SHAxis = Stream.RandRange(FMath::Max(FHAxis + RoomsDivisionConstraints.HallWidth + RoomsDivisionConstraints.ABSMinimalSide, FinalRect.Position.Y + RotatedSize.Y - RoomsDivisionConstraints.HallWidth), LevelGrid.GetSizeY() - (RoomsDivisionConstraints.HallWidth + RoomsDivisionConstraints.ABSMinimalSide));
+							const int FHSpace = FinalRect.Position.Y - (FHAxis + RoomsDivisionConstraints.HallWidth); //No need of min or max, because it is already implied by the def of the axis value
+							const int SHSpace = SHAxis - (FinalRect.Position.Y + RotatedSize.Y);
+
+							InitialOrganisation.SetHallBlock(
+								FLevelOrganisation::LowCorridor,
+								new FHallBlock(
+									FVectorGrid(LevelGrid.GetSizeX(), RoomsDivisionConstraints.HallWidth),
+									FVectorGrid(0, FHAxis),
+									0
+							));
+
+							InitialOrganisation.SetHallBlock(
+								FLevelOrganisation::HighCorridor,
+								new FHallBlock(
+									FVectorGrid(LevelGrid.GetSizeX(), RoomsDivisionConstraints.HallWidth),
+									FVectorGrid(0, SHAxis),
+									0
+							));
+
+							if(FHSpace > 0)
+								InitialOrganisation.SetHallBlock(
+								FLevelOrganisation::LowMargin,
+									new FHallBlock(
+										FVectorGrid(RotatedSize.X, FHSpace),
+										FVectorGrid(FinalRect.Position.X, FHAxis + RoomsDivisionConstraints.HallWidth),
+										0
+								));
+
+							if(SHSpace > 0)
+								InitialOrganisation.SetHallBlock(
+								FLevelOrganisation::HighMargin,
+									new FHallBlock(
+										FVectorGrid(RotatedSize.X, SHSpace),
+										FVectorGrid(FinalRect.Position.X, FinalRect.Position.Y + RotatedSize.Y),
+										0
+								));
+
+							InitialOrganisation.SetUnknownBlock(
+							FLevelOrganisation::LowWing,
+								new FUnknownBlock(
+									FVectorGrid(LevelGrid.GetSizeX(), FHAxis),
+									FVectorGrid(0, 0),
+									0,
+									true,
+									static_cast<uint8>(EHGAxe::Y_UP),
+									EHGAxe::Y_UP
+							));
+
+							InitialOrganisation.SetUnknownBlock(
+								FLevelOrganisation::HighWing,
+								new FUnknownBlock(
+									FVectorGrid(LevelGrid.GetSizeX(), LevelGrid.GetSizeY() - (SHAxis + RoomsDivisionConstraints.HallWidth)),
+									FVectorGrid(0, SHAxis + RoomsDivisionConstraints.HallWidth),
+									0,
+									true,
+									static_cast<uint8>(EHGAxe::Y_DOWN),
+									EHGAxe::Y_DOWN
+							));
+
+							InitialOrganisation.SetUnknownBlock(
+								FLevelOrganisation::LowApartment,
+								new FUnknownBlock(
+									FVectorGrid(FinalRect.Position.X, SHAxis - (FHAxis + RoomsDivisionConstraints.HallWidth)),
+									FVectorGrid(0, SHAxis + RoomsDivisionConstraints.HallWidth),
+									0,
+									true,
+									EHGAxe::Y_DOWN | EHGAxe::Y_UP | EHGAxe::X_UP,
+									EHGAxe::Y_DOWN
+							));
+
+							InitialOrganisation.SetUnknownBlock(
+								FLevelOrganisation::HighApartment,
+								new FUnknownBlock(
+									FVectorGrid(LevelGrid.GetSizeX() - (FinalRect.Position.X + RotatedSize.X), SHAxis - (FHAxis + RoomsDivisionConstraints.HallWidth)),
+									FVectorGrid(FinalRect.Position.X + RotatedSize.X, FHAxis + RoomsDivisionConstraints.HallWidth),
+									0,
+									true,
+									EHGAxe::Y_DOWN | EHGAxe::Y_UP | EHGAxe::X_DOWN,
+									EHGAxe::Y_UP
+							));
+						}
+					}
+				
+					//Case where it is in center along a X wall
+					else if((LevelGrid.IsAlongXDownWall(FinalRect) || LevelGrid.IsAlongXUpWall(FinalRect)) && IsInYCenter())
+					{
+						if(RotatedSize.X < RotatedSize.Y /*To force placement with one hall*/ || !IsYCenterAvailable() || !IsNHXCenterAvailable())
+							IsStairPlaceable = false;
+						
+						else if(LevelGrid.IsAlongXUpWall(FinalRect))
+						{
+							const int Space = FMath::Max(-RoomsDivisionConstraints.HallWidth, FinalRect.Position.X - LevelGrid.GetSizeX() + RoomsDivisionConstraints.ABSMinimalSide);
+							InitialOrganisation.SetHallBlock(
+								FLevelOrganisation::LowCorridor,
+									new FHallBlock(
+										FVectorGrid(RoomsDivisionConstraints.HallWidth, LevelGrid.GetSizeY()),
+										FVectorGrid(FinalRect.Position.X  - Space - RoomsDivisionConstraints.HallWidth, 0),
+										0
+							));
+
+							if(Space > 0)
+								InitialOrganisation.SetHallBlock(
+									FLevelOrganisation::LowMargin,
+									new FHallBlock(
+										FVectorGrid(Space, RotatedSize.Y),
+										FVectorGrid(FinalRect.Position.X  - Space, FinalRect.Position.Y),
+										0
+								));
+
+							InitialOrganisation.SetUnknownBlock(
+								FLevelOrganisation::LowWing,
+								new FUnknownBlock(
+									FVectorGrid(FinalRect.Position.X  - Space - RoomsDivisionConstraints.HallWidth, LevelGrid.GetSizeY()),
+									FVectorGrid(0, 0),
+									0,
+									false,
+									static_cast<uint8>(EHGAxe::X_UP),
+									EHGAxe::X_UP
+							));
+							
+							InitialOrganisation.SetUnknownBlock(
+								FLevelOrganisation::LowApartment,
+								new FUnknownBlock(
+									FVectorGrid(RotatedSize.X  + Space, FinalRect.Position.Y),
+									FVectorGrid(FinalRect.Position.X  - Space, 0),
+									0,
+									false,
+									EHGAxe::X_DOWN | EHGAxe::Y_UP,
+									EHGAxe::X_DOWN
+							));
+
+							InitialOrganisation.SetUnknownBlock(
+								FLevelOrganisation::HighApartment,
+								new FUnknownBlock(
+									FVectorGrid(RotatedSize.X  + Space, LevelGrid.GetSizeY() - (FinalRect.Position.Y + RotatedSize.Y)),
+									FVectorGrid(FinalRect.Position.X  - Space, FinalRect.Position.Y + RotatedSize.Y),
+									0,
+									false,
+									EHGAxe::X_DOWN | EHGAxe::Y_DOWN,
+									EHGAxe::X_DOWN
+							));
+						}
+						else
+						{
+							const int Space = FMath::Max(-RoomsDivisionConstraints.HallWidth, RoomsDivisionConstraints.ABSMinimalSide - RotatedSize.X);
+							InitialOrganisation.SetHallBlock(
+								FLevelOrganisation::HighCorridor,
+								new FHallBlock(
+									FVectorGrid(RoomsDivisionConstraints.HallWidth, LevelGrid.GetSizeY()),
+									FVectorGrid( RotatedSize.X + Space, 0),
+									0
+							));
+
+							if(Space > 0)
+								InitialOrganisation.SetHallBlock(
+									FLevelOrganisation::HighMargin,
+									new FHallBlock(
+										FVectorGrid(Space, RotatedSize.Y),
+										FVectorGrid(RotatedSize.X, FinalRect.Position.Y),
+										0
+								));
+
+							InitialOrganisation.SetUnknownBlock(
+								FLevelOrganisation::HighWing,
+								new FUnknownBlock(
+									FVectorGrid(LevelGrid.GetSizeX() - (RotatedSize.X + Space + RoomsDivisionConstraints.HallWidth), LevelGrid.GetSizeY()),
+									FVectorGrid(RotatedSize.X + Space + RoomsDivisionConstraints.HallWidth, 0),
+									0,
+									false,
+									static_cast<uint8>(EHGAxe::X_DOWN),
+									EHGAxe::X_DOWN
+							));
+
+							InitialOrganisation.SetUnknownBlock(
+								FLevelOrganisation::LowApartment,
+								new FUnknownBlock(
+									FVectorGrid(RotatedSize.X  + Space, FinalRect.Position.X),
+									FVectorGrid(0, 0),
+									0,
+									false,
+									EHGAxe::X_UP | EHGAxe::Y_UP,
+									EHGAxe::X_UP
+							));
+
+							InitialOrganisation.SetUnknownBlock(
+								FLevelOrganisation::HighApartment,
+								new FUnknownBlock(
+									FVectorGrid(RotatedSize.X  + Space, LevelGrid.GetSizeY() - (FinalRect.Position.Y + RotatedSize.Y)),
+									FVectorGrid(0, FinalRect.Position.Y + RotatedSize.Y),
+									0,
+									false,
+									EHGAxe::X_UP | EHGAxe::Y_DOWN,
+									EHGAxe::X_UP
+							));
+						}
+					}
+				
+					//Case where it is in center along a Y wall
+					else if((LevelGrid.IsAlongYDownWall(FinalRect) || LevelGrid.IsAlongYUpWall(FinalRect)) && IsInXCenter())
+					{
+						if(RotatedSize.Y < RotatedSize.X || !IsXCenterAvailable() || !IsNHYCenterAvailable())
+							IsStairPlaceable = false;
+
+						if(LevelGrid.IsAlongYUpWall(FinalRect))
+						{
+							const int Space = FMath::Max(-RoomsDivisionConstraints.HallWidth, FinalRect.Position.Y - LevelGrid.GetSizeY() + RoomsDivisionConstraints.ABSMinimalSide);
+							InitialOrganisation.SetHallBlock(
+								FLevelOrganisation::LowCorridor,
+								new FHallBlock(
+									 FVectorGrid(LevelGrid.GetSizeX(), RoomsDivisionConstraints.HallWidth),
+									 FVectorGrid(0, FinalRect.Position.Y  - Space - RoomsDivisionConstraints.HallWidth),
+									 0
+							 ));
+
+							if(Space > 0)
+						 		InitialOrganisation.SetHallBlock(
+								FLevelOrganisation::LowMargin,
+									new FHallBlock(
+										 FVectorGrid(RotatedSize.X, Space),
+										 FVectorGrid(FinalRect.Position.X, FinalRect.Position.Y  - Space),
+										 0
+								));
+
+							InitialOrganisation.SetUnknownBlock(
+								FLevelOrganisation::LowWing,
+								new FUnknownBlock(
+									FVectorGrid(LevelGrid.GetSizeX(), FinalRect.Position.Y  - Space - RoomsDivisionConstraints.HallWidth),
+									FVectorGrid(0, 0),
+									0,
+									true,
+									static_cast<uint8>(EHGAxe::Y_UP),
+									EHGAxe::Y_UP
+							));
+
+							InitialOrganisation.SetUnknownBlock(
+								FLevelOrganisation::LowApartment,
+								new FUnknownBlock(
+									FVectorGrid(FinalRect.Position.X, RotatedSize.Y  + Space),
+									FVectorGrid(0, FinalRect.Position.Y  - Space),
+									0,
+									true,
+									EHGAxe::Y_DOWN | EHGAxe::X_UP,
+									EHGAxe::Y_DOWN
+							));
+							
+							InitialOrganisation.SetUnknownBlock(
+								FLevelOrganisation::HighApartment,
+								new FUnknownBlock(
+									FVectorGrid(LevelGrid.GetSizeX() - (FinalRect.Position.X + RotatedSize.X), RotatedSize.Y  + Space),
+									FVectorGrid(FinalRect.Position.X + RotatedSize.X, FinalRect.Position.Y  - Space),
+									0,
+									true,
+									EHGAxe::Y_DOWN | EHGAxe::X_DOWN,
+									EHGAxe::Y_DOWN
+							));
+						}
+						else
+						{
+							const int Space = FMath::Max(-RoomsDivisionConstraints.HallWidth, RoomsDivisionConstraints.ABSMinimalSide - RotatedSize.Y);
+							InitialOrganisation.SetHallBlock(
+								FLevelOrganisation::HighCorridor,
+								new FHallBlock(
+									FVectorGrid(LevelGrid.GetSizeX(), RoomsDivisionConstraints.HallWidth),
+									FVectorGrid(0, RotatedSize.Y + Space),
+									0
+							));
+
+							if(Space > 0)
+								InitialOrganisation.SetHallBlock(
+									FLevelOrganisation::HighMargin,
+									new FHallBlock(
+										FVectorGrid(RotatedSize.X, Space),
+										FVectorGrid(FinalRect.Position.X, RotatedSize.Y),
+										0
+								));
+
+							InitialOrganisation.SetUnknownBlock(
+								FLevelOrganisation::HighWing,
+								new FUnknownBlock(
+									FVectorGrid(LevelGrid.GetSizeX(),LevelGrid.GetSizeY() - (RotatedSize.Y + Space + RoomsDivisionConstraints.HallWidth)),
+									FVectorGrid(0, RotatedSize.Y + Space + RoomsDivisionConstraints.HallWidth),
+									0,
+									true,
+									static_cast<uint8>(EHGAxe::Y_DOWN),
+									EHGAxe::Y_DOWN
+							));
+
+							InitialOrganisation.SetUnknownBlock(
+								FLevelOrganisation::LowApartment,
+								new FUnknownBlock(
+									FVectorGrid(FinalRect.Position.X, RotatedSize.Y  + Space),
+									FVectorGrid(0, 0),
+									0,
+									true,
+									EHGAxe::Y_UP | EHGAxe::X_UP,
+									EHGAxe::Y_UP
+							));
+
+							InitialOrganisation.SetUnknownBlock(
+								FLevelOrganisation::HighApartment,
+								new FUnknownBlock(
+									FVectorGrid(LevelGrid.GetSizeX() - (FinalRect.Position.X + RotatedSize.X), RotatedSize.Y  + Space),
+									FVectorGrid(FinalRect.Position.X + RotatedSize.X, 0),
+									0,
+									true,
+									EHGAxe::Y_UP | EHGAxe::X_DOWN,
+									EHGAxe::Y_UP
+							));
+						}
+					}
+				
+					//Case it is in a corner (always ok, if the building step has successfully done its task)
+					else if(LevelGrid.IsInAnyCorner(FinalRect))
+					{
+						if(RotatedSize.X >= RotatedSize.Y)
+						{
+							if(LevelGrid.IsAlongXUpWall(FinalRect))
+							{
+								const int Space = FMath::Max(-RoomsDivisionConstraints.HallWidth, FinalRect.Position.X - LevelGrid.GetSizeX() + RoomsDivisionConstraints.ABSMinimalSide);
+								InitialOrganisation.SetHallBlock(
+									FLevelOrganisation::LowCorridor,
+									new FHallBlock(
+										FVectorGrid(RoomsDivisionConstraints.HallWidth, LevelGrid.GetSizeY()),
+										FVectorGrid(FinalRect.Position.X  - Space - RoomsDivisionConstraints.HallWidth, 0),
+										0
+								));
+
+								if(Space > 0)
+									InitialOrganisation.SetHallBlock(
+										FLevelOrganisation::LowMargin,
+										new FHallBlock(
+											FVectorGrid(Space, RotatedSize.Y),
+											FVectorGrid(FinalRect.Position.X  - Space, FinalRect.Position.Y),
+											0
+									));
+
+								InitialOrganisation.SetUnknownBlock(
+									FLevelOrganisation::LowWing,
+									new FUnknownBlock(
+										FVectorGrid(FinalRect.Position.X  - Space - RoomsDivisionConstraints.HallWidth, LevelGrid.GetSizeY()),
+										FVectorGrid(0, 0),
+										0,
+										false,
+										static_cast<uint8>(EHGAxe::X_UP),
+										EHGAxe::X_UP
+								));
+
+								if(LevelGrid.IsAlongYDownWall(FinalRect))
+									InitialOrganisation.SetUnknownBlock(
+										FLevelOrganisation::HighApartment,
+										new FUnknownBlock(
+											FVectorGrid(RotatedSize.X  + Space, LevelGrid.GetSizeY() - RotatedSize.Y),
+											FVectorGrid(FinalRect.Position.X  - Space,  RotatedSize.Y),
+											0,
+											false,
+											EHGAxe::X_DOWN | EHGAxe::Y_DOWN,
+											EHGAxe::X_DOWN
+									));
+								else
+									InitialOrganisation.SetUnknownBlock(
+										FLevelOrganisation::LowApartment,
+										new FUnknownBlock(
+											FVectorGrid(RotatedSize.X  + Space, LevelGrid.GetSizeY() - RotatedSize.Y),
+											FVectorGrid(FinalRect.Position.X  - Space, 0),
+											0,
+											false,
+											EHGAxe::X_DOWN | EHGAxe::Y_UP,
+											EHGAxe::X_DOWN
+									));
+							}
+							else //Along XDown so Position.X = 0
+							{
+								const int Space = FMath::Max(-RoomsDivisionConstraints.HallWidth, RoomsDivisionConstraints.ABSMinimalSide - RotatedSize.X);
+								InitialOrganisation.SetHallBlock(
+									FLevelOrganisation::HighCorridor,
+									new FHallBlock(
+										FVectorGrid(RoomsDivisionConstraints.HallWidth, LevelGrid.GetSizeY()),
+										FVectorGrid( RotatedSize.X + Space, 0),
+										0
+								));
+
+								if(Space > 0)
+									InitialOrganisation.SetHallBlock(
+										FLevelOrganisation::HighMargin,
+										new FHallBlock(
+											FVectorGrid(Space, RotatedSize.Y),
+											FVectorGrid(RotatedSize.X, FinalRect.Position.Y),
+											0
+									));
+
+								InitialOrganisation.SetUnknownBlock(
+									FLevelOrganisation::HighWing,
+									new FUnknownBlock(
+										FVectorGrid(LevelGrid.GetSizeX() - (RotatedSize.X + Space + RoomsDivisionConstraints.HallWidth), LevelGrid.GetSizeY()),
+										FVectorGrid(RotatedSize.X + Space + RoomsDivisionConstraints.HallWidth, 0),
+										0,
+										false,
+										static_cast<uint8>(EHGAxe::X_DOWN),
+										EHGAxe::X_DOWN
+								));
+
+								if(LevelGrid.IsAlongYDownWall(FinalRect))
+									InitialOrganisation.SetUnknownBlock(
+										FLevelOrganisation::HighApartment,
+										new FUnknownBlock(
+											FVectorGrid(RotatedSize.X  + Space, LevelGrid.GetSizeY() - RotatedSize.Y),
+											FVectorGrid(0, RotatedSize.Y),
+											0,
+											false,
+											EHGAxe::X_UP | EHGAxe::Y_DOWN,
+											EHGAxe::X_UP
+									));
+								else
+									InitialOrganisation.SetUnknownBlock(
+										FLevelOrganisation::LowApartment,
+										new FUnknownBlock(
+											FVectorGrid(RotatedSize.X  + Space, LevelGrid.GetSizeY() - RotatedSize.Y),
+											FVectorGrid(0, 0),
+											0,
+											false,
+											EHGAxe::X_UP | EHGAxe::Y_UP,
+											EHGAxe::X_UP
+									));
+							}
+						}
+						else
+						{
+							if(LevelGrid.IsAlongYUpWall(FinalRect))
+							{
+								const int Space = FMath::Max(-RoomsDivisionConstraints.HallWidth, FinalRect.Position.Y - LevelGrid.GetSizeY() + RoomsDivisionConstraints.ABSMinimalSide);
+								InitialOrganisation.SetHallBlock(
+									FLevelOrganisation::LowCorridor,
+									new FHallBlock(
+										FVectorGrid(LevelGrid.GetSizeX(), RoomsDivisionConstraints.HallWidth),
+										FVectorGrid(0, FinalRect.Position.Y  - Space - RoomsDivisionConstraints.HallWidth),
+										0
+								));
+
+								if(Space > 0)
+									InitialOrganisation.SetHallBlock(
+										FLevelOrganisation::LowMargin,
+										new FHallBlock(
+											FVectorGrid(RotatedSize.X, Space),
+											FVectorGrid(FinalRect.Position.X, FinalRect.Position.Y  - Space),
+											0
+									));
+
+								InitialOrganisation.SetUnknownBlock(
+									FLevelOrganisation::LowWing,
+									new FUnknownBlock(
+										FVectorGrid(LevelGrid.GetSizeX(), FinalRect.Position.Y  - Space - RoomsDivisionConstraints.HallWidth),
+										FVectorGrid(0, 0),
+										0,
+										true,
+										static_cast<uint8>(EHGAxe::Y_UP),
+										EHGAxe::Y_UP
+								));
+								
+								if(LevelGrid.IsAlongXDownWall(FinalRect))
+									InitialOrganisation.SetUnknownBlock(
+										FLevelOrganisation::HighApartment,
+										new FUnknownBlock(
+											FVectorGrid(LevelGrid.GetSizeX() - RotatedSize.X, RotatedSize.Y  + Space),
+											FVectorGrid(RotatedSize.X, FinalRect.Position.Y  - Space),
+											0,
+											true,
+											EHGAxe::Y_DOWN | EHGAxe::X_DOWN,
+											EHGAxe::Y_DOWN
+									));
+								else
+									InitialOrganisation.SetUnknownBlock(
+										FLevelOrganisation::LowApartment,
+										new FUnknownBlock(
+											FVectorGrid(LevelGrid.GetSizeX() - RotatedSize.X, RotatedSize.Y  + Space),
+											FVectorGrid(0, FinalRect.Position.Y  - Space),
+											0,
+											true,
+											EHGAxe::Y_DOWN | EHGAxe::X_UP,
+											EHGAxe::Y_DOWN
+									));
+							}
+							else
+							{
+								const int Space = FMath::Max(-RoomsDivisionConstraints.HallWidth, RoomsDivisionConstraints.ABSMinimalSide - RotatedSize.Y);
+								InitialOrganisation.SetHallBlock(
+									FLevelOrganisation::HighCorridor,
+									new FHallBlock(
+										FVectorGrid(LevelGrid.GetSizeX(), RoomsDivisionConstraints.HallWidth),
+										FVectorGrid(0, RotatedSize.Y + Space),
+										0
+								));
+
+								if(Space > 0)
+									InitialOrganisation.SetHallBlock(
+										FLevelOrganisation::HighMargin,
+										new FHallBlock(
+											FVectorGrid(RotatedSize.X, Space),
+											FVectorGrid(FinalRect.Position.X, RotatedSize.Y),
+											0
+									));
+
+								InitialOrganisation.SetUnknownBlock(
+									FLevelOrganisation::HighWing,
+									new FUnknownBlock(
+										FVectorGrid(LevelGrid.GetSizeX(),LevelGrid.GetSizeY() - (RotatedSize.Y + Space + RoomsDivisionConstraints.HallWidth)),
+										FVectorGrid(0, RotatedSize.Y + Space + RoomsDivisionConstraints.HallWidth),
+										0,
+										true,
+										static_cast<uint8>(EHGAxe::Y_DOWN),
+										EHGAxe::Y_DOWN
+								));
+
+								if(LevelGrid.IsAlongXDownWall(FinalRect))
+									InitialOrganisation.SetUnknownBlock(
+										FLevelOrganisation::HighApartment,
+										new FUnknownBlock(
+											FVectorGrid(LevelGrid.GetSizeX() - RotatedSize.X, RotatedSize.Y  + Space),
+											FVectorGrid(RotatedSize.X, 0),
+											0,
+											true,
+											EHGAxe::Y_UP | EHGAxe::X_DOWN,
+											EHGAxe::Y_UP
+									));
+								else
+									InitialOrganisation.SetUnknownBlock(
+										FLevelOrganisation::LowApartment,
+										new FUnknownBlock(
+											FVectorGrid(LevelGrid.GetSizeX() - RotatedSize.X, RotatedSize.Y  + Space),
+											FVectorGrid(0, 0),
+											0,
+											true,
+											EHGAxe::Y_UP | EHGAxe::X_UP,
+											EHGAxe::Y_UP
+									));
+							}
+						}
+					}
+
+					//If none of above cases, it means the rect isn't in a valid position
+					else
+						IsStairPlaceable = false;
+				}
+				
+				if(IsStairPlaceable)
+					PositionFound = LevelGrid.MarkFurnitureAtPosition(FinalRect, FinalConstraints);
+				if(PositionFound) break;
+			}
+
+			if(PositionFound) break;
+		}
+
+		if(PositionFound) break;
+	}
+	//If no position was found for the stairs, the process exit.
+	check(PositionFound);
+}
+
+void FHGBuildingPlan::DivideSurface(const int Level, FLevelOrganisation &LevelOrganisation, TDoubleLinkedList<FUnknownBlock> &NodesToDelete)
+{
+	check(HallBlocks.IsValidIndex(Level) && RoomBlocks.IsValidIndex(Level))
+
+	//Each level has its own stream : the levels don't depend on each other
+	const FHGRandomStream Stream = GetRandomStream(EHGRandomDomain::LevelDivision, Level);
+
+	//BSP's storage initialisation
+	FLevelDivisionData LevelDivisionData(BuildingConstraints.BuildingSize.Area(), LevelOrganisation.InitialHallArea());
+	
+	TDoubleLinkedList<FUnknownBlock> ToDivide;
+	for (uint8 i = 0; i < FLevelOrganisation::BlockPositionsSize; ++i) 
+	{
+		ToDivide.AddHead(*LevelOrganisation.GetBlockList()[i]);
+		ToDivide.GetHead()->GetValue().Level = Level;
+
+		// Replaces the pointer to the initial block
+		LevelOrganisation.SetUnknownBlock(static_cast<FLevelOrganisation::EInitialBlockPositions>(i), &ToDivide.GetHead()->GetValue());
+	}
+	InitLevelHalls(Level, LevelOrganisation);
+
+	TArray<FRoomBlock *> Rooms;
+	TArray<FHallBlock *> Halls;
+	const bool bDivided = DivideBlocks(ToDivide, LevelDivisionData, Stream, Rooms, Halls, NodesToDelete);
+	for (FHallBlock *Hall : Halls)
+		HallBlocks[Level].Add(Hall);
+	for (FRoomBlock *Room : Rooms)
+		Room->Index = RoomBlocks[Level].Add(Room);
+
+	//Trouble in structure
+	check(bDivided)
+}
+
+bool FHGBuildingPlan::DivideBlocks(TDoubleLinkedList<FUnknownBlock>& ToDivide, FLevelDivisionData& DivisionData, const FHGRandomStream& Stream, TArray<FRoomBlock*>& Rooms, TArray<FHallBlock*>& Halls, TDoubleLinkedList<FUnknownBlock>& Nodes) const
+{
+	TArray<FUnknownBlock *> FinalBlocks;
+	const FHGDivisionMetrics &DivisionMetrics = RoomsDivisionConstraints;
+	
+	//Divide the generated blocks
+	//When a block is generated it generate two new blocks (added to the list) before being retrieved from the list (its node is moved to Nodes)
+	while (ToDivide.Num() != 0)
+	{
+		//Removes actual node.
+		TDoubleLinkedList<FUnknownBlock>::TDoubleLinkedListNode * const ExHead = ToDivide.GetHead();
+		TDoubleLinkedList<FUnknownBlock>::TDoubleLinkedListNode *TailBuffer;
+		ToDivide.RemoveNode(ExHead, false);
+		Nodes.AddHead(ExHead);
+		
+		switch (ExHead->GetValue().ShouldDivide(DivisionMetrics, DivisionData, Stream))
+		{
+			//Creates a new room.
+			case FUnknownBlock::DivideMethod::NO_DIVIDE:
+			{
+				FRoomBlock * const Room = new FRoomBlock();
+				Rooms.Push(Room);
+				ExHead->GetValue().TransformToRoom(*Room);
+				FinalBlocks.Push(&ExHead->GetValue());
+				break;
+			}
+
+			//Divides the block and places generated blocks at the list's end
+			//Creates a hall.
+			case FUnknownBlock::DivideMethod::SPLIT:
+				Halls.Push(new FHallBlock());
+				ToDivide.AddTail(FUnknownBlock());
+				TailBuffer = ToDivide.GetTail();
+				ToDivide.AddTail(FUnknownBlock());
+			
+				ExHead->GetValue().BlockSplit(DivisionMetrics, TailBuffer->GetValue(), ToDivide.GetTail()->GetValue(), *Halls.Last(), Stream);
+				break;			
+
+			//Divides the block and places generated blocks at the list's end.
+			case FUnknownBlock::DivideMethod::DIVISION:
+				ToDivide.AddTail(FUnknownBlock());
+				TailBuffer = ToDivide.GetTail();
+				ToDivide.AddTail(FUnknownBlock());
+				ExHead->GetValue().BlockDivision(DivisionMetrics, TailBuffer->GetValue(), ToDivide.GetTail()->GetValue(), Stream);
+				break;
+			
+			//Trouble in structure : the blocks still to divide share markers with the divided ones, they are given to Nodes too
+			case FUnknownBlock::DivideMethod::ERROR:
+			default:
+				while (ToDivide.Num() != 0)
+				{
+					TDoubleLinkedList<FUnknownBlock>::TDoubleLinkedListNode * const Node = ToDivide.GetHead();
+					ToDivide.RemoveNode(Node, false);
+					Nodes.AddHead(Node);
+				}
+				return false;
+		}
+	}
+
+	const FHGMeshDescriptor &Door = CatalogMeshes[SelectedDoor].Descriptor;
+	for(auto *FinalBlock : FinalBlocks)
+		FinalBlock->ConnectDoors(Door, Stream);
+	return true;
+}
+
+void FHGBuildingPlan::InitLevelHalls(const int Level, FLevelOrganisation& LevelOrganisation)
+{
+	for (uint8 i = 0; i < FLevelOrganisation::HallPositionsSize; ++i) 
+	{
+		if(LevelOrganisation.GetHallList()[i] == nullptr)
+			continue;
+
+		FHallBlock * const Hall = new FHallBlock(*LevelOrganisation.GetHallList()[i]);
+		Hall->Level = Level;
+		Hall->StairsHall = i == FLevelOrganisation::Stairs;
+		HallBlocks[Level].Add(Hall);
+
+		// Replaces the pointer to the initial block
+		LevelOrganisation.SetHallBlock(static_cast<FLevelOrganisation::EInitialHallPositions>(i), Hall);
+	}
+}
+
+void FHGBuildingPlan::DivideUnits(int FirstLevel, int NumLevels, FHGDivisionState& Division)
+{
+	QUICK_SCOPE_CYCLE_COUNTER(STAT_HomeGenerator_DivideUnits);
+
+	TArray<int> UnitInhabitants;
+	ComputeUnitInhabitants(Division.InitialOrganisation, UnitInhabitants);
+
+	//One unit per initial block of each level
+	TIndirectArray<FHGDwellingUnit> Units;
+	for (int Level = FirstLevel; Level < FirstLevel + NumLevels; ++Level)
+	{
+		check(HallBlocks.IsValidIndex(Level) && RoomBlocks.IsValidIndex(Level))
+		InitLevelHalls(Level, Division.LevelsOrganisation[Level]);
+
+		for (uint8 i = 0; i < FLevelOrganisation::BlockPositionsSize; ++i)
+		{
+			if(Division.InitialOrganisation.GetBlockList()[i] == nullptr)
+				continue;
+
+			FHGDwellingUnit * const Unit = new FHGDwellingUnit();
+			Unit->Level = Level;
+			Unit->Position = static_cast<FLevelOrganisation::EInitialBlockPositions>(i);
+			Unit->InitialBlock = Division.InitialOrganisation.GetBlockList()[i];
+			Unit->Inhabitants = UnitInhabitants[Level * FLevelOrganisation::BlockPositionsSize + i];
+			for (const auto &Room : Rooms)
+				Unit->RoomQuantity += FMath::CeilToInt(Room.Value.NumPerHab * Unit->Inhabitants);
+			Units.Add(Unit);
+		}
+	}
+
+	//Units don't share anything : a failed unit is divided again with another stream, without touching the others
+	ParallelFor(Units.Num(), [this, &Units] (int32 i)
+	{
+		FHGDwellingUnit &Unit = Units[i];
+		const FHGRandomStream UnitStream = GetRandomStream(EHGRandomDomain::LevelDivision, Unit.Level, Unit.Position + 1);
+		do
+		{
+			Unit.bSucceeded = DivideUnit(Unit, UnitStream.Split(Unit.Attempts++));
+		}
+		while(!Unit.bSucceeded && Unit.Attempts < MaxUnitAttempts);
+	});
+
+	//The blocks are given to the levels in the same order, whatever the number of threads
+	for (FHGDwellingUnit &Unit : Units)
+	{
+		check(Unit.Root != nullptr)
+		if(!Unit.bSucceeded)
+			UE_LOG(LogHomeGenerationCore, Warning, TEXT("%s : the dwelling unit %d of the level %d has only %d rooms for %d needed."), *GeneratorName, static_cast<int>(Unit.Position), Unit.Level, Unit.Rooms.Num(), Unit.RoomQuantity);
+
+		for (FHallBlock *Hall : Unit.Halls)
+			HallBlocks[Unit.Level].Add(Hall);
+		for (FRoomBlock *Room : Unit.Rooms)
+			Room->Index = RoomBlocks[Unit.Level].Add(Room);
+		Division.LevelsOrganisation[Unit.Level].SetUnknownBlock(Unit.Position, Unit.Root);
+
+		//The nodes are pointed by the organisation until the wall effect is computed
+		while(Unit.Nodes.Num() > 0)
+		{
+			TDoubleLinkedList<FUnknownBlock>::TDoubleLinkedListNode * const Node = Unit.Nodes.GetHead();
+			Unit.Nodes.RemoveNode(Node, false);
+			Division.NodesToDelete.AddHead(Node);
+		}
+		Unit.Halls.Empty();
+		Unit.Rooms.Empty();
+		Unit.Root = nullptr;
+	}
+}
+
+bool FHGBuildingPlan::DivideUnit(FHGDwellingUnit& Unit, const FHGRandomStream& Stream) const
+{
+	Unit.Reset();
+
+	//The hall ratio is respected inside each unit
+	FLevelDivisionData UnitDivisionData(Unit.InitialBlock->Size.Area(), 0);
+
+	TDoubleLinkedList<FUnknownBlock> ToDivide;
+	ToDivide.AddHead(*Unit.InitialBlock);
+	ToDivide.GetHead()->GetValue().Level = Unit.Level;
+	Unit.Root = &ToDivide.GetHead()->GetValue();
+
+	//Trouble in structure : the unit is divided again (its markers are freed with its nodes)
+	if(!DivideBlocks(ToDivide, UnitDivisionData, Stream, Unit.Rooms, Unit.Halls, Unit.Nodes))
+	{
+		Unit.Reset();
+		return false;
+	}
+
+	//Allocation of the unit's rooms only
+	TArray<FRoomBlock *> SortedRoomBlocks = Unit.Rooms;
+	SortedRoomBlocks.Sort();
+	AllocateRooms(SortedRoomBlocks, Unit.Inhabitants, Unit.RoomQuantity);
+
+	return Unit.Rooms.Num() >= Unit.RoomQuantity;
+}
+
+void FHGBuildingPlan::ComputeUnitInhabitants(const FLevelOrganisation& InitialOrganisation, TArray<int>& UnitInhabitants) const
+{
+	//Same units on each level
+	int LevelArea = 0;
+	for (const FUnknownBlock *Block : InitialOrganisation.GetBlockList())
+		LevelArea += Block ? Block->Size.Area() : 0;
+
+	UnitInhabitants.Init(0, BuildingConstraints.Levels * FLevelOrganisation::BlockPositionsSize);
+	if(LevelArea == 0)
+		return;
+
+	//Largest remainder : the sum is exactly the number of inhabitants (before the minimum of one per unit)
+	TArray<TPair<float, int>> Remainders;
+	int Given = 0;
+	for (int i = 0; i < UnitInhabitants.Num(); ++i)
+	{
+		const FUnknownBlock * const Block = InitialOrganisation.GetBlockList()[i % FLevelOrganisation::BlockPositionsSize];
+		if(Block == nullptr)
+			continue;
+
+		const float Share = static_cast<float>(Inhabitants) * Block->Size.Area() / (LevelArea * BuildingConstraints.Levels);
+		UnitInhabitants[i] = FMath::FloorToInt(Share);
+		Given += UnitInhabitants[i];
+		Remainders.Add(TPair<float, int>(Share - UnitInhabitants[i], i));
+	}
+
+	Remainders.StableSort([] (const TPair<float, int> &A, const TPair<float, int> &B) { return A.Key > B.Key; });
+	for (int i = 0; i < Remainders.Num() && Given < Inhabitants; ++i, ++Given)
+		++UnitInhabitants[Remainders[i].Value];
+
+	for (const TPair<float, int> &Remainder : Remainders)
+		UnitInhabitants[Remainder.Value] = FMath::Max(UnitInhabitants[Remainder.Value], 1);
+}
+
+void FHGBuildingPlan::ComputeWallEffect(TArray<FLevelOrganisation>& LevelsOrganisation)
+{
+	check(LevelsOrganisation.Num() == GetDividedLevels())
+	TArray<FVector2D> NeededOffsets;
+	NeededOffsets.Reserve(LevelsOrganisation.Num());
+	const FHGBuildingMetrics &BuildingMetrics = BuildingConstraints;
+	const FHGDivisionMetrics &DivisionMetrics = RoomsDivisionConstraints;
+	
+	//Compute all basic data recursively
+	for (int i = 0; i < LevelsOrganisation.Num(); ++i)
+	{
+		LevelsOrganisation[i].ComputeBasicRealData(BuildingMetrics, DivisionMetrics);
+		NeededOffsets.Push(LevelsOrganisation[i].GetStairsRealOffset()); //First stores stairs offset of each lvl
+	}
+
+	//Find maximal stairs' offset
+	FVector2D MaxOffset = FVector2D::ZeroVector;
+	for (const auto &Offset : NeededOffsets)
+	{
+		if(Offset.X > MaxOffset.X)
+			MaxOffset.X = Offset.X;
+		if(Offset.Y > MaxOffset.Y)
+			MaxOffset.Y = Offset.Y;
+	}
+
+	//Finally compute all internal real data by aligning all stairs
+	for (int i = 0; i < NeededOffsets.Num(); ++i) //Then stores the offset to add to each lvl
+		LevelsOrganisation[i].ComputeAllRealData(MaxOffset - NeededOffsets[i], BuildingMetrics, DivisionMetrics);
+}
+
+void FHGBuildingPlan::AllocateSurface()
+{
+	check(HallBlocks.Num() == BuildingConstraints.Levels && RoomBlocks.Num() == BuildingConstraints.Levels);
+
+	//Sort all rooms of the building
+	TArray<FRoomBlock *> SortedRoomBlocks;
+	int NeededPlace = 0;
+	for (int i = 0; i < RoomBlocks.Num(); ++i) NeededPlace += RoomBlocks[i].Num(); //To avoid reallocation each time we add something
+	SortedRoomBlocks.Reserve(NeededPlace);
+	
+	for (int i = 0; i < RoomBlocks.Num(); ++i)
+		for (int j = 0; j < RoomBlocks[i].Num(); ++j)
+			SortedRoomBlocks.Push(&RoomBlocks[i][j]);
+	SortedRoomBlocks.Sort(); //Croissant order : we define first the smallest ones
+
+	//Typical floor : the divided levels only get their share of the inhabitants (the repeated levels copy the typical one)
+	const int DividedLevels = GetDividedLevels();
+	if(DividedLevels < BuildingConstraints.Levels)
+	{
+		const int RoomInhabitants = FMath::CeilToInt(static_cast<float>(Inhabitants) * DividedLevels / BuildingConstraints.Levels);
+		int RoomQuantity = 0;
+		for (const auto &Room : Rooms)
+			RoomQuantity += FMath::CeilToInt(Room.Value.NumPerHab * RoomInhabitants);
+		AllocateRooms(SortedRoomBlocks, RoomInhabitants, RoomQuantity);
+		return;
+	}
+
+	AllocateRooms(SortedRoomBlocks, Inhabitants, BuildingConstraints.NormalRoomQuantity);
+}
+
+void FHGBuildingPlan::AllocateRooms(const TArray<FRoomBlock*>& SortedRoomBlocks, int RoomInhabitants, int RoomQuantity) const
+{
+	TArray<FHGRoomQuota> Quotas;
+	Quotas.Reserve(Rooms.Num());
+	for (const auto &Room : Rooms)
+		Quotas.Add({Room.Key, Room.Value.NumPerHab});
+
+	FRoomBlock::AllocateTypes(SortedRoomBlocks, Quotas, RoomInhabitants, RoomQuantity);
+}
+
+void FHGBuildingPlan::PlaceDoorsAndWindows()
+{
+	for(const auto &LevelRooms : RoomBlocks)
+		for(const FRoomBlock &RoomBlock : LevelRooms)
+			for(FDoorBlock *DoorBlock : RoomBlock.ConnectedDoors)
+			{
+				PlaceDoor(RoomBlock, DoorBlock);
+				DoorBlock->SetRecordingRoom(RoomBlock);
+			}
+	RepeatTypicalFloor();
+	PlaceWindows();
+}
+
+int32 FHGBuildingPlan::GetDividedLevels() const
+{
+	return bTypicalFloors ? FMath::Clamp(TypicalFloorStart + 1, 1, BuildingConstraints.Levels) : BuildingConstraints.Levels;
+}
+
+bool FHGBuildingPlan::IsRepeatedLevel(int32 Level) const
+{
+	return Level >= GetDividedLevels();
+}
+
+void FHGBuildingPlan::RepeatTypicalFloor()
+{
+	const int32 TypicalLevel = GetDividedLevels() - 1;
+	for(int32 Level = TypicalLevel + 1; Level < BuildingConstraints.Levels; ++Level)
+	{
+		for(const FHallBlock &HallBlock : HallBlocks[TypicalLevel])
+		{
+			FHallBlock * const Copy = new FHallBlock(HallBlock);
+			Copy->Level = Level;
+			HallBlocks[Level].Add(Copy);
+		}
+
+		//Same indices as the typical rooms
+		TMap<const FRoomBlock *, const FRoomBlock *> RoomCopies;
+		for(const FRoomBlock &RoomBlock : RoomBlocks[TypicalLevel])
+		{
+			FRoomBlock * const Copy = new FRoomBlock(RoomBlock);
+			Copy->Level = Level;
+			Copy->ConnectedDoors.Reset();
+			RoomBlocks[Level].Add(Copy);
+			RoomCopies.Add(&RoomBlock, Copy);
+		}
+
+		//A door shared by two rooms is copied once
+		TMap<const FDoorBlock *, FDoorBlock *> DoorCopies;
+		for(const FRoomBlock &RoomBlock : RoomBlocks[TypicalLevel])
+			for(const FDoorBlock *DoorBlock : RoomBlock.ConnectedDoors)
+			{
+				FDoorBlock *&DoorCopy = DoorCopies.FindOrAdd(DoorBlock);
+				if(DoorCopy == nullptr)
+					DoorCopy = DoorBlock->CopyForRooms(RoomCopies);
+				RoomBlocks[Level][RoomBlock.Index].ConnectedDoors.Push(DoorCopy);
+			}
+	}
+}
+
+void FHGBuildingPlan::PlaceWindows()
+{
+	WindowPlacements.Reset();
+	WindowWidth = WindowBottom = WindowTop = 0.f;
+	if(!CatalogWindows.IsValidIndex(SelectedWindow) || !CatalogWindows[SelectedWindow].Descriptor.bHasBounds)
+		return;
+
+	//A window which doesn't fit between the floor and the ceiling is never placed
+	const FHGWindowDescriptor &Window = CatalogWindows[SelectedWindow].Descriptor;
+	if(Window.DistanceFromFloor + Window.Height > BuildingConstraints.FloorHeight)
+		return;
+
+	//The grid size is 0 along the exterior axis
+	const bool bExteriorAlongX = Window.ExteriorFace == EHGAxe::X_UP || Window.ExteriorFace == EHGAxe::X_DOWN;
+	FWindowLayout Layout;
+	Layout.Width = (bExteriorAlongX ? Window.GridSize.Y : Window.GridSize.X) * BuildingConstraints.GridSnapLength;
+	Layout.Spacing = Windows.Spacing * BuildingConstraints.GridSnapLength;
+	Layout.WallWidth = BuildingConstraints.WallWidth;
+
+	WindowWidth = Layout.Width;
+	WindowBottom = Window.DistanceFromFloor;
+	WindowTop = Window.DistanceFromFloor + Window.Height;
+
+	for(int Level = 0; Level < BuildingConstraints.Levels; ++Level)
+	{
+		const FBox2D LevelRect = ComputeLevelRect(Level);
+		if(!LevelRect.bIsValid)
+			continue;
+
+		for(FHallBlock &Hall : HallBlocks[Level])
+			Hall.AddWindow(LevelRect, Layout, WindowPlacements);
+		for(const FRoomBlock &Room : RoomBlocks[Level])
+			Room.AddWindow(LevelRect, Layout, WindowPlacements);
+	}
+}
+
+void FHGBuildingPlan::ComputeOpenings(int Level, TArray<FBox2D>& DoorOpenings, TArray<FBox2D>& WindowOpenings) const
+{
+	const float Wall = BuildingConstraints.WallWidth;
+	const float Snap = BuildingConstraints.GridSnapLength;
+
+	//Openings of the doors : through the wall of the room (and a possible second wall behind it)
+	for(const FRoomBlock &Room : RoomBlocks[Level])
+	{
+		for(const FDoorBlock *DoorBlock : Room.ConnectedDoors)
+		{
+			if(!DoorBlock->IsPositionValid() || DoorBlock->ObtainOppositeParent(Room) != nullptr && DoorBlock->ObtainOppositeParent(Room) < &Room)
+				continue;
+
+			const FFurnitureRect DoorRect = DoorBlock->GenerateLocalFurnitureRect(Room);
+			const FBox2D Interior = ComputeRoomInterior(Room);
+			const float Width = DoorBlock->GetMesh().GridSize.Y * Snap;
+			switch(DoorBlock->RoomWallAxe(Room))
+			{
+				case EHGAxe::X_UP: DoorOpenings.Push(FBox2D(FVector2D(Interior.Max.X, Interior.Min.Y + DoorRect.Position.Y * Snap), FVector2D(Interior.Max.X + 2.f * Wall, Interior.Min.Y + DoorRect.Position.Y * Snap + Width))); break;
+				case EHGAxe::X_DOWN: DoorOpenings.Push(FBox2D(FVector2D(Interior.Min.X - 2.f * Wall, Interior.Min.Y + DoorRect.Position.Y * Snap), FVector2D(Interior.Min.X, Interior.Min.Y + DoorRect.Position.Y * Snap + Width))); break;
+				case EHGAxe::Y_UP: DoorOpenings.Push(FBox2D(FVector2D(Interior.Min.X + DoorRect.Position.X * Snap, Interior.Max.Y), FVector2D(Interior.Min.X + DoorRect.Position.X * Snap + Width, Interior.Max.Y + 2.f * Wall))); break;
+				case EHGAxe::Y_DOWN: DoorOpenings.Push(FBox2D(FVector2D(Interior.Min.X + DoorRect.Position.X * Snap, Interior.Min.Y - 2.f * Wall), FVector2D(Interior.Min.X + DoorRect.Position.X * Snap + Width, Interior.Min.Y))); break;
+				default: break;
+			}
+		}
+	}
+
+	//Openings of the windows : through the exterior wall
+	for(const FWindowPlacement &Window : WindowPlacements)
+	{
+		if(Window.Level != Level)
+			continue;
+
+		const bool bAlongY = Window.Side == EHGAxe::X_UP || Window.Side == EHGAxe::X_DOWN;
+		const FVector2D HalfSize = bAlongY ? FVector2D(Wall, WindowWidth) / 2.f : FVector2D(WindowWidth, Wall) / 2.f;
+		WindowOpenings.Push(FBox2D(Window.Center - HalfSize, Window.Center + HalfSize));
+	}
+}
+
+FBox2D FHGBuildingPlan::ComputeRoomInterior(const FRoomBlock& RoomBlock) const
+{
+	//The real rect of a room includes its walls
+	const FVector2D Wall(BuildingConstraints.WallWidth, BuildingConstraints.WallWidth);
+	return FBox2D(RoomBlock.GetRealOffset() + Wall, RoomBlock.GetRealOffset() + RoomBlock.GetRealSize() - Wall);
+}
+
+FBox2D FHGBuildingPlan::ComputeLevelRect(int Level) const
+{
+	FBox2D LevelRect(ForceInit);
+	for(const FRoomBlock &Room : RoomBlocks[Level])
+		LevelRect += FBox2D(Room.GetRealOffset(), Room.GetRealOffset() + Room.GetRealSize());
+	for(const FHallBlock &Hall : HallBlocks[Level])
+		LevelRect += FBox2D(Hall.GetRealOffset(), Hall.GetRealOffset() + Hall.GetRealSize());
+	return LevelRect;
+}
+
+float FHGBuildingPlan::ComputeDoorHeight() const
+{
+	return CatalogMeshes.IsValidIndex(SelectedDoor) ? FMath::Min(CatalogMeshes[SelectedDoor].Descriptor.Height, BuildingConstraints.FloorHeight) : 0.f;
+}
+
+void FHGBuildingPlan::PlaceDoor(const FRoomBlock& RoomBlock, FDoorBlock* DoorBlock)
+{
+	if(DoorBlock->IsPositionValid())
+		return;
+
+	const FRoomBlock *OtherRoom = DoorBlock->ObtainOppositeParent(RoomBlock);
+	const FVectorGrid MarginSize = DoorBlock->GenerateLocalMarginSize(RoomBlock, Doors.DefaultConstraints.Margin);
+
+	//Inclusive limits for the door
+	FVectorGrid PositionMin = OtherRoom != nullptr ? FVectorGrid::Max(FVectorGrid(0,0), OtherRoom->GlobalPosition - RoomBlock.GlobalPosition) : FVectorGrid(0,0);
+	FVectorGrid PositionMax = OtherRoom != nullptr ? FVectorGrid::Min(RoomBlock.Size , OtherRoom->Size + OtherRoom->GlobalPosition - RoomBlock.GlobalPosition) : RoomBlock.Size;
+	PositionMax -= MarginSize;
+
+	//Depending on its opening wall, it adjusts
+	switch(DoorBlock->RoomWallAxe(RoomBlock))
+	{
+		case EHGAxe::X_UP: PositionMax.X = PositionMin.X = RoomBlock.Size.X; break;
+		case EHGAxe::X_DOWN: PositionMax.X = PositionMin.X = 0; break;
+		
+		case EHGAxe::Y_UP: PositionMax.Y = PositionMin.Y = RoomBlock.Size.Y; break;
+		case EHGAxe::Y_DOWN: PositionMax.Y = PositionMin.Y = 0; break;
+		default : check(false);
+	}
+
+	//One stream per door of the room : the position doesn't depend on the order in which the doors are placed
+	const FHGRandomStream Stream = GetRandomStream(EHGRandomDomain::Doors, RoomBlock.Level, RoomBlock.Index).Split(RoomBlock.ConnectedDoors.Find(DoorBlock));
+	DoorBlock->SaveLocalPosition(FVectorGrid::Random(PositionMin, PositionMax, Stream), RoomBlock);
+}
+
+void FHGBuildingPlan::RecordFurniture(FFurnitureSpawnBuffer& SpawnBuffer) const
+{
+	QUICK_SCOPE_CYCLE_COUNTER(STAT_HomeGenerator_RecordFurniture);
+	check(RoomBlocks.Num() == BuildingConstraints.Levels)
+
+	//Placement step : only records the spawn commands, one buffer per room (the doors are already resolved)
+	//The repeated levels are instanced copies of the typical floor (see ExecuteSpawnCommands)
+	TArray<const FRoomBlock *> AllRooms;
+	for(int32 Level = 0; Level < GetDividedLevels(); ++Level)
+		for(const FRoomBlock &RoomBlock : RoomBlocks[Level])
+			AllRooms.Push(&RoomBlock);
+
+	TArray<FFurnitureSpawnBuffer> RoomBuffers;
+	RoomBuffers.SetNum(AllRooms.Num());
+	ParallelFor(AllRooms.Num(), [this, &AllRooms, &RoomBuffers] (int32 i)
+	{
+		if(!bCancelGeneration)
+			GenerateRoom(AllRooms[i]->RoomType, *AllRooms[i], RoomBuffers[i]);
+	});
+
+	//Same order as a serial placement
+	for(const FFurnitureSpawnBuffer &RoomBuffer : RoomBuffers)
+		SpawnBuffer.Append(RoomBuffer);
+}
+
+void FHGBuildingPlan::GenerateRoom(const FName& RoomType, const FRoomBlock& RoomBlock, FFurnitureSpawnBuffer &SpawnBuffer) const
+{
+	//Room of a repeated level (streaming mode) : same furniture as the typical room, moved up
+	if(IsRepeatedLevel(RoomBlock.Level))
+	{
+		const int32 TypicalLevel = GetDividedLevels() - 1;
+		const int32 FirstCommand = SpawnBuffer.Num();
+		GenerateRoom(RoomType, RoomBlocks[TypicalLevel][RoomBlock.Index], SpawnBuffer);
+		for(int32 CommandIndex = FirstCommand; CommandIndex < SpawnBuffer.Num(); ++CommandIndex)
+		{
+			FFurnitureSpawnCommand &Command = SpawnBuffer.Commands[CommandIndex];
+			Command.Level = RoomBlock.Level;
+			Command.RoomOffset.Z += (RoomBlock.Level - TypicalLevel) * (BuildingConstraints.FloorHeight + BuildingConstraints.FloorWidth);
+		}
+		return;
+	}
+
+	FRoomGrid RoomGrid(RoomBlock.Size);
+	GenerateRoomDoors(RoomType, RoomBlock, RoomGrid, SpawnBuffer);
+	GenerateFurniture(RoomType, RoomBlock, RoomGrid, SpawnBuffer);
+	//GenerateDecoration(RoomType, ...)
+}
+
+void FHGBuildingPlan::GenerateRoomDoors(const FName& RoomType, const FRoomBlock& RoomBlock, FRoomGrid& RoomGrid, FFurnitureSpawnBuffer &SpawnBuffer) const
+{
+	for(const FDoorBlock* DoorBlock : RoomBlock.ConnectedDoors)
+	{
+		//Door without any valid position
+		if(!DoorBlock->IsPositionValid())
+			continue;
+
+		//A door is recorded by only one of its rooms
+		if(DoorBlock->IsRecordedBy(RoomBlock))
+		{
+			SpawnBuffer.Record(
+				DoorBlock->GetMesh().MeshId,
+				DoorBlock->GenerateLocalFurnitureRect(RoomBlock),
+				RoomBlock,
+				RoomBlock.GenerateRoomOffset(BuildingConstraints),
+				RoomType,
+				TEXT("Door")
+			);
+		}
+
+		//Marks the grid, for the future furniture placement
+		RoomGrid.MarkDoorAtPosition(DoorBlock->GenerateLocalFurnitureRect(RoomBlock));
+	}
+}
+
+void FHGBuildingPlan::GenerateFurniture(const FName& RoomType, const FRoomBlock &RoomBlock, FRoomGrid& RoomGrid, FFurnitureSpawnBuffer &SpawnBuffer) const
+{
+	const FHGRoomDescriptor * const Room = Rooms.Find(RoomType);
+	const FVector RoomOrigin = RoomBlock.GenerateRoomOffset(BuildingConstraints);
+	check(RoomGrid.GetSizeX() > 0 && RoomGrid.GetSizeY() > 0)
+	check(Room->MinimalSide <= RoomGrid.GetSizeX() &&  Room->MinimalSide <= RoomGrid.GetSizeY())
+
+	//Possible positions
+	TArray<int> PositionX;
+	TArray<int> PositionY;
+	TArray<EFurnitureRotation> Rotations = {EFurnitureRotation::ROT0, EFurnitureRotation::ROT90, EFurnitureRotation::ROT180, EFurnitureRotation::ROT270};
+	HGArray::GenerateRangeArray(PositionX, RoomGrid.GetSizeX());
+	HGArray::GenerateRangeArray(PositionY, RoomGrid.GetSizeY());
+
+	//Dependencies management
+	TArray<FDependencyBuffer> FurnitureWithDep;
+
+	//Each furniture item has its own stream : the room is always furnished identically, whenever it is generated
+	const FHGRandomStream RoomStream = GetRandomStream(EHGRandomDomain::Furniture, RoomBlock.Level, RoomBlock.Index);
+	int32 ItemIndex = 0;
+
+	//First furniture placement
+	for(const auto &_FurnitureType : Room->Furniture)
+	{
+		const FHGRandomStream Stream = RoomStream.Split(ItemIndex++);
+		const FHGFurnitureDescriptor * const _Furniture = Furniture.Find(_FurnitureType);
+		//Checks on the found structure (just skip if there are some errors)
+		if(_Furniture == nullptr)
+			continue;
+		
+		//Shuffle everything here to allow more random generation (useless to update on each mesh)
+		//The meshes are copied : the placement doesn't modify the generator's data
+		TArray<int32> Meshes = _Furniture->Meshes;
+		Stream.Shuffle(Meshes);
+		Stream.Shuffle(PositionX);
+		Stream.Shuffle(PositionY);
+		Stream.Shuffle(Rotations);
+
+		//Find already known values
+		const uint8 DependencyIndex = _Furniture->Dependencies.Num() > 0 ? FurnitureWithDep.Num() + 1 : 0;
+		bool MeshFounded = false;
+		
+		for(const int32 MeshId : Meshes)
+		{
+			//Checks on the found structure (just skip if there are some errors)
+			if(MeshId == INDEX_NONE || !CatalogMeshes[MeshId].bPlaceable)
+				continue;
+
+			//Define needed value
+			const FHGMeshDescriptor &Descriptor = CatalogMeshes[MeshId].Descriptor;
+			const FHGFurnitureConstraint &FinalConstraints = GetMeshConstraints(MeshId, *_Furniture);
+			
+			for(const int X : PositionX)
+			{
+				for(const int Y : PositionY)
+				{
+					for(const auto Rotation : Rotations)
+					{
+						FFurnitureRect FinalRect(Rotation, FVectorGrid(X, Y), Descriptor.GridSize);
+						MeshFounded = RoomGrid.MarkFurnitureAtPosition(FinalRect, FinalConstraints, DependencyIndex);
+						if(MeshFounded)
+						{
+							SpawnBuffer.Record(MeshId, FinalRect, RoomBlock, RoomOrigin, RoomType, _FurnitureType);
+							if(DependencyIndex)
+								FurnitureWithDep.Push(FDependencyBuffer(TArray<FHGFurnitureDependency>(_Furniture->Dependencies), FinalRect));
+
+							break;
+						}
+					}
+
+					if(MeshFounded)
+						break;
+				}
+
+				if(MeshFounded)
+					break;
+			}
+
+			if(MeshFounded)
+				break;
+		}		
+	}
+
+	//Dependency placement
+	for(uint8 i = 0; i < FurnitureWithDep.Num(); ++i)
+	{
+		for(const FHGFurnitureDependency &_Dependency : FurnitureWithDep[i].Dependencies)
+		{
+			const FHGRandomStream Stream = RoomStream.Split(ItemIndex++);
+			const FHGFurnitureDescriptor * const _Furniture = Furniture.Find(_Dependency.FurnitureType);
+			//Checks on the found structure (just skip if there are some errors)
+			if(_Furniture == nullptr)
+				continue;
+		
+			//Shuffle everything here to allow more random generation (useless to update on each mesh)
+			TArray<int32> Meshes = _Furniture->Meshes;
+			Stream.Shuffle(Meshes);
+			Stream.Shuffle(PositionX);
+			Stream.Shuffle(PositionY);
+			Stream.Shuffle(Rotations);
+			
+			bool MeshFounded = false;
+		
+			for(const int32 MeshId : Meshes)
+			{
+				//Checks on the found structure (just skip if there are some errors)
+				if(MeshId == INDEX_NONE || !CatalogMeshes[MeshId].bPlaceable)
+					continue;
+
+				//Define needed value
+				const FHGMeshDescriptor &Descriptor = CatalogMeshes[MeshId].Descriptor;
+				const FHGFurnitureConstraint &FinalConstraints = GetMeshConstraints(MeshId, *_Furniture);
+			
+				for(const int X : PositionX)
+				{
+					for(const int Y : PositionY)
+					{
+						for(const auto Rotation : Rotations)
+						{
+							FFurnitureRect FinalRect(Rotation, FVectorGrid(X, Y), Descriptor.GridSize);
+							MeshFounded = RoomGrid.MarkDependencyAtPosition(FinalRect, FurnitureWithDep[i].ParentPosition, FinalConstraints, _Dependency, i + 1);
+							if(MeshFounded)
+							{
+								SpawnBuffer.Record(MeshId, FinalRect, RoomBlock, RoomOrigin, RoomType, _Dependency.FurnitureType);
+								break;
+							}
+						}
+
+						if(MeshFounded)
+							break;
+					}
+
+					if(MeshFounded)
+						break;
+				}
+
+				if(MeshFounded)
+					break;
+			}		
+		}
+	}
+}
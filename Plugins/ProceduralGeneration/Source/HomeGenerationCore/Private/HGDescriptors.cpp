@@ -0,0 +1,74 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "HGDescriptors.h"
+
+bool FHGWallInteraction::GetFirstAttractedWall(EHGAxe& First) const
+{
+	if(XUp == EHGWallAxeInteraction::ATTRACT)
+	{
+		First = EHGAxe::X_UP;
+		return true;
+	}
+
+	if(XDown == EHGWallAxeInteraction::ATTRACT)
+	{
+		First = EHGAxe::X_DOWN;
+		return true;
+	}
+
+	if(YUp == EHGWallAxeInteraction::ATTRACT)
+	{
+		First = EHGAxe::Y_UP;
+		return true;
+	}
+
+	if(YDown == EHGWallAxeInteraction::ATTRACT)
+	{
+		First = EHGAxe::Y_DOWN;
+		return true;
+	}
+
+	return false;
+}
+
+bool FHGWallInteraction::GetSecondAttractedWall(EHGAxe& Second) const
+{
+	EHGAxe First = EHGAxe::X_UP;
+	if(!GetFirstAttractedWall(First))
+		return false;
+
+	switch (First)
+	{
+		case EHGAxe::X_UP:
+			if(XDown == EHGWallAxeInteraction::ATTRACT)
+			{
+				Second = EHGAxe::X_DOWN;
+				return true;
+			}
+		
+		case EHGAxe::X_DOWN:
+			if(YUp == EHGWallAxeInteraction::ATTRACT)
+			{
+				Second = EHGAxe::Y_UP;
+				return true;
+			}
+		
+		case EHGAxe::Y_UP:
+			if(YDown == EHGWallAxeInteraction::ATTRACT)
+			{
+				Second = EHGAxe::Y_DOWN;
+				return true;
+			}
+		
+		default:
+			return false;
+	}
+}
+
+void FHGDivisionConstraints::CalculateAllSides(const int _BasicMinimalSide, const int _BasicAverageSide, const int _BasicMaximalSide)
+{
+	ABSMinimalSide = FMath::CeilToInt(MinSideCoef * _BasicMinimalSide);
+	StopSplitSide = FMath::CeilToInt(StopSplitCoef * _BasicAverageSide);
+	SufficientSide = FMath::CeilToInt(SufficientChunkCoef * _BasicMaximalSide);
+}
@@ -1,7 +1,6 @@
 ﻿//Copyright
 
 #include "HGInternalStruct.h"
-#include "HomeGenerator.h"
 
 #define CONSTRUCT_GRID(X,Y) check(X > 0 && Y > 0) Grid.SetNum(X); for (int i = 0; i < X; ++i) { Grid[i].SetNum(X); }
 
@@ -15,9 +14,57 @@ const FVector2D& FBasicBlock::GetRealOffset() const
 	return RealOffset;
 }
 
+void FBasicBlock::SetRealData(const FVector2D& _RealOffset, const FVector2D& _RealSize)
+{
+	RealOffset = _RealOffset;
+	RealSize = _RealSize;
+}
+
 FBasicBlock::FBasicBlock(const FVectorGrid& _Size, const FVectorGrid& _GlobalPosition, int _Level)
 	: Size(_Size), GlobalPosition(_GlobalPosition), Level(_Level) {}
 
+void FBasicBlock::AddExteriorWindows(const FBox2D& Interior, const FBox2D& LevelRect, int Level, const FWindowLayout& Layout, TArray<FWindowPlacement>& Windows)
+{
+	if(Layout.Width <= 0.f)
+		return;
+
+	//A side is exterior if only the exterior wall separates it from the level limit
+	const float Tolerance = Layout.WallWidth + 1.f;
+	const float HalfWall = Layout.WallWidth / 2.f;
+
+	//Windows are centered on the run (the run stops at the exterior walls)
+	const auto AddRun = [&] (float Start, float End, float Across, EHGAxe Side, bool bAlongY) {
+		const float Length = End - Start;
+		if(Length < Layout.Width)
+			return;
+
+		const float Stride = Layout.Width + Layout.Spacing;
+		const int Count = FMath::FloorToInt((Length - Layout.Width) / Stride) + 1;
+		const float First = Start + (Length - (Count * Stride - Layout.Spacing)) / 2.f + Layout.Width / 2.f;
+		for(int i = 0; i < Count; ++i)
+		{
+			FWindowPlacement &Window = Windows.AddDefaulted_GetRef();
+			Window.Level = Level;
+			Window.Side = Side;
+			Window.Center = bAlongY ? FVector2D(Across, First + i * Stride) : FVector2D(First + i * Stride, Across);
+		}
+	};
+
+	const float MinX = FMath::Max(Interior.Min.X, LevelRect.Min.X + Layout.WallWidth);
+	const float MaxX = FMath::Min(Interior.Max.X, LevelRect.Max.X - Layout.WallWidth);
+	const float MinY = FMath::Max(Interior.Min.Y, LevelRect.Min.Y + Layout.WallWidth);
+	const float MaxY = FMath::Min(Interior.Max.Y, LevelRect.Max.Y - Layout.WallWidth);
+
+	if(Interior.Max.X >= LevelRect.Max.X - Tolerance)
+		AddRun(MinY, MaxY, LevelRect.Max.X - HalfWall, EHGAxe::X_UP, true);
+	if(Interior.Min.X <= LevelRect.Min.X + Tolerance)
+		AddRun(MinY, MaxY, LevelRect.Min.X + HalfWall, EHGAxe::X_DOWN, true);
+	if(Interior.Max.Y >= LevelRect.Max.Y - Tolerance)
+		AddRun(MinX, MaxX, LevelRect.Max.Y - HalfWall, EHGAxe::Y_UP, false);
+	if(Interior.Min.Y <= LevelRect.Min.Y + Tolerance)
+		AddRun(MinX, MaxX, LevelRect.Min.Y + HalfWall, EHGAxe::Y_DOWN, false);
+}
+
 uint32 FRoomCell::IndexToMarker(uint8 FurnitureIndex)
 {
 	if(FurnitureIndex > 32 || FurnitureIndex == 0)
@@ -58,7 +105,7 @@ int FRoomGrid::GetSizeY() const
 	return Grid[0].Num();
 }
 
-bool FRoomGrid::MarkFurnitureAtPosition(const FFurnitureRect& Position, const FFurnitureConstraint& Constraints, uint8 DependencyMarker)
+bool FRoomGrid::MarkFurnitureAtPosition(const FFurnitureRect& Position, const FHGFurnitureConstraint& Constraints, uint8 DependencyMarker)
 {
 	//Basic checks to avoid troubles
 	check(GetSizeX() > 0 && GetSizeY() > 0)
@@ -67,7 +114,7 @@ bool FRoomGrid::MarkFurnitureAtPosition(const FFurnitureRect& Position, const FF
 	if(Position.Size.X <= 0 || Position.Size.Y <= 0)
 		return false;
 	
-	FFurnitureConstraint RotatedConstraints;
+	FHGFurnitureConstraint RotatedConstraints;
 	FFurnitureRect RotatedPosition;
 
 	//Rotate data, to get a furniture with no more rotation (allows simplification of the rest of the code)
@@ -86,7 +133,7 @@ bool FRoomGrid::MarkFurnitureAtPosition(const FFurnitureRect& Position, const FF
 	return true;
 }
 
-bool FRoomGrid::MarkDependencyAtPosition(const FFurnitureRect& Position, const FFurnitureRect &ParentPosition, const FFurnitureConstraint& Constraints, const FFurnitureDependency& DependencyConstraints, uint8 DependencyMarker)
+bool FRoomGrid::MarkDependencyAtPosition(const FFurnitureRect& Position, const FFurnitureRect &ParentPosition, const FHGFurnitureConstraint& Constraints, const FHGFurnitureDependency& DependencyConstraints, uint8 DependencyMarker)
 {
 	//Basic checks to avoid troubles
 	check(GetSizeX() > 0 && GetSizeY() > 0)
@@ -95,10 +142,10 @@ bool FRoomGrid::MarkDependencyAtPosition(const FFurnitureRect& Position, const F
 	if(Position.Size.X <= 0 || Position.Size.Y <= 0)
 		return false;
 	
-	FFurnitureConstraint RotatedConstraints;
+	FHGFurnitureConstraint RotatedConstraints;
 	FFurnitureRect RotatedPosition;
 	FFurnitureRect RotatedParentPosition;
-	FFurnitureDependency RotatedDependency;
+	FHGFurnitureDependency RotatedDependency;
 
 	//Rotate data, to get a furniture with no more rotation (allows simplification of the rest of the code)
 	RotateData(Position, Constraints, RotatedPosition, RotatedConstraints);
@@ -146,13 +193,13 @@ bool FRoomGrid::MarkDoorAtPosition(const FFurnitureRect& Position)
 	return true;
 }
 
-bool FRoomGrid::IsAlongAxeWall(const FFurnitureRect& Position, const EGenerationAxe Axe) const
+bool FRoomGrid::IsAlongAxeWall(const FFurnitureRect& Position, const EHGAxe Axe) const
 {
 	switch (Axe) {
-		case EGenerationAxe::X_UP: return IsAlongXUpWall(Position);
-		case EGenerationAxe::X_DOWN: return IsAlongXDownWall(Position);
-		case EGenerationAxe::Y_UP: return IsAlongYUpWall(Position);
-		case EGenerationAxe::Y_DOWN: return IsAlongYDownWall(Position);
+		case EHGAxe::X_UP: return IsAlongXUpWall(Position);
+		case EHGAxe::X_DOWN: return IsAlongXDownWall(Position);
+		case EHGAxe::Y_UP: return IsAlongYUpWall(Position);
+		case EHGAxe::Y_DOWN: return IsAlongYDownWall(Position);
 		default: return false;
 	}
 }
@@ -207,7 +254,7 @@ bool FRoomGrid::CheckLimits(const FFurnitureRect& Position) const
 	return true;
 }
 
-void FRoomGrid::RotateData(const FFurnitureRect& InPosition, const FFurnitureConstraint& InConstraints, FFurnitureRect& RotatedPosition, FFurnitureConstraint& RotatedConstraints)
+void FRoomGrid::RotateData(const FFurnitureRect& InPosition, const FHGFurnitureConstraint& InConstraints, FFurnitureRect& RotatedPosition, FHGFurnitureConstraint& RotatedConstraints)
 {
 	RotatedPosition.Position = InPosition.Position;
 	RotatedPosition.Rotation = EFurnitureRotation::ROT0;
@@ -265,7 +312,7 @@ void FRoomGrid::RotateData(const FFurnitureRect& InPosition, const FFurnitureCon
 	}
 }
 
-void FRoomGrid::RotateDependencyData(const FFurnitureRect& InParentPosition, const FFurnitureDependency& InDependency, FFurnitureRect& RotatedParentPosition, FFurnitureDependency& RotatedDependency)
+void FRoomGrid::RotateDependencyData(const FFurnitureRect& InParentPosition, const FHGFurnitureDependency& InDependency, FFurnitureRect& RotatedParentPosition, FHGFurnitureDependency& RotatedDependency)
 {
 	RotatedParentPosition.Position = InParentPosition.Position;
 	RotatedParentPosition.Rotation = EFurnitureRotation::ROT0;
@@ -283,10 +330,10 @@ void FRoomGrid::RotateDependencyData(const FFurnitureRect& InParentPosition, con
 
 			switch (InDependency.Axe)
 			{
-				case EGenerationAxe::X_UP: RotatedDependency.Axe = EGenerationAxe::Y_UP; break;
-				case EGenerationAxe::X_DOWN: RotatedDependency.Axe = EGenerationAxe::Y_DOWN; break;
-				case EGenerationAxe::Y_UP: RotatedDependency.Axe = EGenerationAxe::X_DOWN; break;
-				case EGenerationAxe::Y_DOWN: RotatedDependency.Axe = EGenerationAxe::X_UP; break;
+				case EHGAxe::X_UP: RotatedDependency.Axe = EHGAxe::Y_UP; break;
+				case EHGAxe::X_DOWN: RotatedDependency.Axe = EHGAxe::Y_DOWN; break;
+				case EHGAxe::Y_UP: RotatedDependency.Axe = EHGAxe::X_DOWN; break;
+				case EHGAxe::Y_DOWN: RotatedDependency.Axe = EHGAxe::X_UP; break;
 				default : check(false);
 			}
 			break;
@@ -296,10 +343,10 @@ void FRoomGrid::RotateDependencyData(const FFurnitureRect& InParentPosition, con
 			
 			switch (InDependency.Axe)
 			{
-				case EGenerationAxe::X_UP: RotatedDependency.Axe = EGenerationAxe::X_DOWN; break;
-				case EGenerationAxe::X_DOWN: RotatedDependency.Axe = EGenerationAxe::X_UP; break;
-				case EGenerationAxe::Y_UP: RotatedDependency.Axe = EGenerationAxe::Y_DOWN; break;
-				case EGenerationAxe::Y_DOWN: RotatedDependency.Axe = EGenerationAxe::Y_UP; break;
+				case EHGAxe::X_UP: RotatedDependency.Axe = EHGAxe::X_DOWN; break;
+				case EHGAxe::X_DOWN: RotatedDependency.Axe = EHGAxe::X_UP; break;
+				case EHGAxe::Y_UP: RotatedDependency.Axe = EHGAxe::Y_DOWN; break;
+				case EHGAxe::Y_DOWN: RotatedDependency.Axe = EHGAxe::Y_UP; break;
 				default : check(false);
 			}
 			break;
@@ -310,17 +357,17 @@ void FRoomGrid::RotateDependencyData(const FFurnitureRect& InParentPosition, con
 
 			switch (InDependency.Axe)
 			{
-				case EGenerationAxe::X_UP: RotatedDependency.Axe = EGenerationAxe::Y_DOWN; break;
-				case EGenerationAxe::X_DOWN: RotatedDependency.Axe = EGenerationAxe::Y_UP; break;
-				case EGenerationAxe::Y_UP: RotatedDependency.Axe = EGenerationAxe::X_UP; break;
-				case EGenerationAxe::Y_DOWN: RotatedDependency.Axe = EGenerationAxe::X_DOWN; break;
+				case EHGAxe::X_UP: RotatedDependency.Axe = EHGAxe::Y_DOWN; break;
+				case EHGAxe::X_DOWN: RotatedDependency.Axe = EHGAxe::Y_UP; break;
+				case EHGAxe::Y_UP: RotatedDependency.Axe = EHGAxe::X_UP; break;
+				case EHGAxe::Y_DOWN: RotatedDependency.Axe = EHGAxe::X_DOWN; break;
 				default: check(false);
 			}
 			break;
 	}
 }
 
-void FRoomGrid::GenerateMarginRect(const FFurnitureRect& RotatedPosition, const FMarginStruct& RotatedMargin, FFurnitureRect& MarginRect)
+void FRoomGrid::GenerateMarginRect(const FFurnitureRect& RotatedPosition, const FHGMargin& RotatedMargin, FFurnitureRect& MarginRect)
 {
 	MarginRect = RotatedPosition;
 	MarginRect.Position.X -= RotatedMargin.XDown;
@@ -329,7 +376,7 @@ void FRoomGrid::GenerateMarginRect(const FFurnitureRect& RotatedPosition, const
 	MarginRect.Size.Y += RotatedMargin.YDown + RotatedMargin.YUp;
 }
 
-bool FRoomGrid::CheckFurnitureRect(const FFurnitureRect& RotatedPosition, const FWallInteractionStruct& RotatedInteraction, uint8 DependencyMarker) const
+bool FRoomGrid::CheckFurnitureRect(const FFurnitureRect& RotatedPosition, const FHGWallInteraction& RotatedInteraction, uint8 DependencyMarker) const
 {
 	//I : Check Rect
 	if(RotatedPosition.Rotation != EFurnitureRotation::ROT0)
@@ -351,29 +398,29 @@ bool FRoomGrid::CheckFurnitureRect(const FFurnitureRect& RotatedPosition, const
 		}
 
 	//II : Check walls
-	EGenerationAxe Buffer;
+	EHGAxe Buffer;
 	switch (RotatedInteraction.WallGlobalInteraction)
 	{
-		case EWallGlobalInteraction::CORNER:
+		case EHGWallGlobalInteraction::CORNER:
 			if(!RotatedInteraction.GetSecondAttractedWall(Buffer) || !IsAlongAxeWall(RotatedPosition, Buffer))
 				return false;
 		
-		case EWallGlobalInteraction::WALL:
+		case EHGWallGlobalInteraction::WALL:
 			if(!RotatedInteraction.GetFirstAttractedWall(Buffer) || !IsAlongAxeWall(RotatedPosition, Buffer))
 				return false;
 		
-		case EWallGlobalInteraction::DEFAULT:
-			if(RotatedInteraction.XDown == EWallAxeInteraction::REJECT && IsAlongXDownWall(RotatedPosition))
+		case EHGWallGlobalInteraction::DEFAULT:
+			if(RotatedInteraction.XDown == EHGWallAxeInteraction::REJECT && IsAlongXDownWall(RotatedPosition))
 				return false;
-			if(RotatedInteraction.XUp == EWallAxeInteraction::REJECT && IsAlongXUpWall(RotatedPosition))
+			if(RotatedInteraction.XUp == EHGWallAxeInteraction::REJECT && IsAlongXUpWall(RotatedPosition))
 				return false;
-			if(RotatedInteraction.YDown == EWallAxeInteraction::REJECT && IsAlongYDownWall(RotatedPosition))
+			if(RotatedInteraction.YDown == EHGWallAxeInteraction::REJECT && IsAlongYDownWall(RotatedPosition))
 				return false;
-			if(RotatedInteraction.YUp == EWallAxeInteraction::REJECT && IsAlongYUpWall(RotatedPosition))
+			if(RotatedInteraction.YUp == EHGWallAxeInteraction::REJECT && IsAlongYUpWall(RotatedPosition))
 				return false;
 			break;
 		
-		case EWallGlobalInteraction::FAR:
+		case EHGWallGlobalInteraction::FAR:
 			if(!IsAlongXDownWall(RotatedPosition) || !IsAlongXUpWall(RotatedPosition) || !IsAlongYDownWall(RotatedPosition) || !IsAlongYUpWall(RotatedPosition))
 				return false;
 			break;
@@ -384,7 +431,7 @@ bool FRoomGrid::CheckFurnitureRect(const FFurnitureRect& RotatedPosition, const
 	return true;
 }
 
-bool FRoomGrid::CheckMarginRect(const FFurnitureRect& RotatedPosition, const FMarginStruct& RotatedMargin, uint8 DependencyMarker) const
+bool FRoomGrid::CheckMarginRect(const FFurnitureRect& RotatedPosition, const FHGMargin& RotatedMargin, uint8 DependencyMarker) const
 {
 	if(RotatedPosition.Rotation != EFurnitureRotation::ROT0)
 		return false;
@@ -406,7 +453,7 @@ bool FRoomGrid::CheckMarginRect(const FFurnitureRect& RotatedPosition, const FMa
 	return true;
 }
 
-bool FRoomGrid::CheckDependencyConstraints(const FFurnitureRect& RotatedPosition, const FFurnitureRect& RotatedParentPosition, const FFurnitureDependency& RotatedDependency, uint8 DependencyMarker) const
+bool FRoomGrid::CheckDependencyConstraints(const FFurnitureRect& RotatedPosition, const FFurnitureRect& RotatedParentPosition, const FHGFurnitureDependency& RotatedDependency, uint8 DependencyMarker) const
 {
 	if(RotatedPosition.Rotation != EFurnitureRotation::ROT0)
 		return false;
@@ -416,24 +463,24 @@ bool FRoomGrid::CheckDependencyConstraints(const FFurnitureRect& RotatedPosition
 	int Distance;
 	switch(RotatedDependency.Axe)
 	{
-		case EGenerationAxe::X_UP:
+		case EHGAxe::X_UP:
 			DVirtualLeft = RotatedPosition.Position.Y - RotatedParentPosition.Position.Y;
 			DVirtualRight = RotatedParentPosition.Position.Y + RotatedParentPosition.Size.Y - (RotatedPosition.Position.Y + RotatedPosition.Size.Y);
 			Distance = RotatedPosition.Position.X - (RotatedParentPosition.Position.X + RotatedParentPosition.Size.X);
 			break;
 		
-		case EGenerationAxe::X_DOWN:
+		case EHGAxe::X_DOWN:
 			DVirtualLeft = RotatedParentPosition.Position.Y + RotatedParentPosition.Size.Y - (RotatedPosition.Position.Y + RotatedPosition.Size.Y);
 			DVirtualRight = RotatedPosition.Position.Y - RotatedParentPosition.Position.Y;
 			Distance = RotatedParentPosition.Position.X - (RotatedPosition.Position.X + RotatedPosition.Size.X);
 			break;
 		
-		case EGenerationAxe::Y_UP:
+		case EHGAxe::Y_UP:
 			DVirtualLeft = RotatedParentPosition.Position.X + RotatedParentPosition.Size.X - (RotatedPosition.Position.X + RotatedPosition.Size.X);
 			DVirtualRight = RotatedPosition.Position.X - RotatedParentPosition.Position.X;
 			Distance = RotatedPosition.Position.X - (RotatedParentPosition.Position.X + RotatedParentPosition.Size.X);
 			break;
-		case EGenerationAxe::Y_DOWN:
+		case EHGAxe::Y_DOWN:
 			DVirtualLeft = RotatedPosition.Position.X - RotatedParentPosition.Position.X;
 			DVirtualRight = RotatedParentPosition.Position.X + RotatedParentPosition.Size.X - (RotatedPosition.Position.X + RotatedPosition.Size.X);
 			Distance = RotatedParentPosition.Position.Y - (RotatedPosition.Position.Y + RotatedPosition.Size.Y);
@@ -445,17 +492,17 @@ bool FRoomGrid::CheckDependencyConstraints(const FFurnitureRect& RotatedPosition
 		return false;
 
 	switch (RotatedDependency.Position) {
-		case EDependencyPlace::EDGE_L:
+		case EHGDependencyPlace::EDGE_L:
 			if(DVirtualLeft != 0)
 				return false;
 			break;
 		
-		case EDependencyPlace::EDGE_R:
+		case EHGDependencyPlace::EDGE_R:
 			if(DVirtualRight != 0)
 				return false;
 			break;
 		
-		case EDependencyPlace::DEFAULT:
+		case EHGDependencyPlace::DEFAULT:
 			if(DVirtualRight <= 0 || DVirtualLeft <= 0)
 				return false;
 			break;
@@ -475,12 +522,20 @@ void FRoomGrid::MarkRect(const FFurnitureRect& RotatedPosition, ERoomCellType Ce
 		}
 }
 
-FDoorBlock::FDoorBlock(const FRoomBlock* _MainParent, const FRoomBlock* _SecondParent, 	const EGenerationAxe _OpeningSide, UFurnitureMeshAsset* _DoorAsset)
-	: ParentMain(_MainParent), ParentSecond(_SecondParent), OpeningSide(_OpeningSide), DoorAsset(_DoorAsset) {}
+FDoorBlock::FDoorBlock(const FRoomBlock* _MainParent, const FRoomBlock* _SecondParent, 	const EHGAxe _OpeningSide, const FHGMeshDescriptor& _Door)
+	: ParentMain(_MainParent), ParentSecond(_SecondParent), OpeningSide(_OpeningSide), Door(_Door) {}
+
+FDoorBlock::FDoorBlock(const FRoomBlock* _MainParent, const FRoomBlock* _SecondParent, const EHGAxe _OpeningSide, const FHGMeshDescriptor& _Door, const FVectorGrid& _GlobalPosition, const FRoomBlock* _RecordingRoom)
+	: ParentMain(_MainParent), ParentSecond(_SecondParent), OpeningSide(_OpeningSide), RecordingRoom(_RecordingRoom), GlobalPosition(_GlobalPosition), Door(_Door) {}
+
+FDoorBlock* FDoorBlock::CopyForRooms(const TMap<const FRoomBlock*, const FRoomBlock*>& RoomCopies) const
+{
+	return new FDoorBlock(RoomCopies.FindRef(ParentMain), RoomCopies.FindRef(ParentSecond), OpeningSide, Door, GlobalPosition, RoomCopies.FindRef(RecordingRoom));
+}
 
 void FDoorBlock::SaveLocalPosition(const FVectorGrid& LocalPosition, const FRoomBlock& Parent)
 {
-	if(!IsPositionValid() || !IsRoomParent(Parent))
+	if(IsPositionValid() || !IsRoomParent(Parent))
 		return;
 
 	if(LocalPosition.X < 0 || LocalPosition.Y < 0)
@@ -489,22 +544,22 @@ void FDoorBlock::SaveLocalPosition(const FVectorGrid& LocalPosition, const FRoom
 	GlobalPosition = LocalPosition + Parent.GlobalPosition;
 }
 
-void FDoorBlock::MarkAsPlaced()
+void FDoorBlock::SetRecordingRoom(const FRoomBlock& Parent)
 {
-	if(!IsPositionValid())
+	if(!IsPositionValid() || RecordingRoom != nullptr || !IsRoomParent(Parent))
 		return;
-	
-	Placed = true;
+
+	RecordingRoom = &Parent;
 }
 
-bool FDoorBlock::IsPlaced() const
+bool FDoorBlock::IsRecordedBy(const FRoomBlock& Parent) const
 {
-	return Placed && IsPositionValid();
+	return RecordingRoom == &Parent && IsPositionValid();
 }
 
 bool FDoorBlock::IsPositionValid() const
 {
-	return GlobalPosition.X < 0 || GlobalPosition.Y < 0;
+	return GlobalPosition.X >= 0 && GlobalPosition.Y >= 0;
 }
 
 bool FDoorBlock::IsRoomParent(const FRoomBlock& Parent) const
@@ -520,42 +575,42 @@ FFurnitureRect FDoorBlock::GenerateLocalFurnitureRect(const FRoomBlock& Parent)
 	EFurnitureRotation DoorRot;
 	switch(OpeningSide)
 	{
-		case EGenerationAxe::X_UP: DoorRot = EFurnitureRotation::ROT0 ; break;
-		case EGenerationAxe::X_DOWN: DoorRot = EFurnitureRotation::ROT180; break;
-		case EGenerationAxe::Y_UP: DoorRot = EFurnitureRotation::ROT90; break;
-		case EGenerationAxe::Y_DOWN: DoorRot = EFurnitureRotation::ROT270; break;
+		case EHGAxe::X_UP: DoorRot = EFurnitureRotation::ROT0 ; break;
+		case EHGAxe::X_DOWN: DoorRot = EFurnitureRotation::ROT180; break;
+		case EHGAxe::Y_UP: DoorRot = EFurnitureRotation::ROT90; break;
+		case EHGAxe::Y_DOWN: DoorRot = EFurnitureRotation::ROT270; break;
 		default: DoorRot = EFurnitureRotation::ROT0; break;
 	}
 
-	return  FFurnitureRect(DoorRot, GlobalPosition - Parent.GlobalPosition, DoorAsset->GridSize);
+	return  FFurnitureRect(DoorRot, GlobalPosition - Parent.GlobalPosition, Door.GridSize);
 }
 
-FVectorGrid FDoorBlock::GenerateLocalMarginSize(const FRoomBlock& Parent, const FMarginStruct &DefaultDoorMargin) const
+FVectorGrid FDoorBlock::GenerateLocalMarginSize(const FRoomBlock& Parent, const FHGMargin &DefaultDoorMargin) const
 {
 	if(!IsRoomParent(Parent))
 		return FVectorGrid();
 
 	int MarginDepth = 0;
-	if(DoorAsset->bOverrideConstraint)
-		MarginDepth = (&Parent == ParentMain) ? DoorAsset->ConstraintsOverride.Margin.XUp : DoorAsset->ConstraintsOverride.Margin.XDown;
+	if(Door.bOverrideConstraint)
+		MarginDepth = (&Parent == ParentMain) ? Door.ConstraintsOverride.Margin.XUp : Door.ConstraintsOverride.Margin.XDown;
 	else
 		MarginDepth = (&Parent == ParentMain) ? DefaultDoorMargin.XUp : DefaultDoorMargin.XDown;
 
 	switch(OpeningSide)
 	{
-		case EGenerationAxe::X_UP:
-		case EGenerationAxe::X_DOWN: return FVectorGrid(MarginDepth, DoorAsset->GridSize.Y);
+		case EHGAxe::X_UP:
+		case EHGAxe::X_DOWN: return FVectorGrid(MarginDepth, Door.GridSize.Y);
 		
-		case EGenerationAxe::Y_UP:
-		case EGenerationAxe::Y_DOWN: return FVectorGrid(DoorAsset->GridSize.Y, MarginDepth);
+		case EHGAxe::Y_UP:
+		case EHGAxe::Y_DOWN: return FVectorGrid(Door.GridSize.Y, MarginDepth);
 		default: return FVectorGrid();
 	}
 }
 
-EGenerationAxe FDoorBlock::RoomWallAxe(const FRoomBlock& Parent) const
+EHGAxe FDoorBlock::RoomWallAxe(const FRoomBlock& Parent) const
 {
 	if(!IsRoomParent(Parent))
-		return EGenerationAxe::X_UP;
+		return EHGAxe::X_UP;
 
 	if(&Parent == ParentMain)
 		return GetOppositeAxe(OpeningSide);
@@ -570,42 +625,242 @@ const FRoomBlock* FDoorBlock::ObtainOppositeParent(const FRoomBlock& Parent) con
 	return ParentMain;
 }
 
-UFurnitureMeshAsset* FDoorBlock::GetMeshAsset() const
+const FHGMeshDescriptor& FDoorBlock::GetMesh() const
+{
+	return Door;
+}
+
+const FRoomBlock* FDoorBlock::GetMainParent() const
+{
+	return ParentMain;
+}
+
+const FRoomBlock* FDoorBlock::GetSecondParent() const
+{
+	return ParentSecond;
+}
+
+const FRoomBlock* FDoorBlock::GetRecordingRoom() const
+{
+	return RecordingRoom;
+}
+
+EHGAxe FDoorBlock::GetOpeningSide() const
 {
-	return DoorAsset;
+	return OpeningSide;
+}
+
+const FVectorGrid& FDoorBlock::GetGlobalPosition() const
+{
+	return GlobalPosition;
 }
 
-EGenerationAxe FDoorBlock::GetOppositeAxe(EGenerationAxe A)
+EHGAxe FDoorBlock::GetOppositeAxe(EHGAxe A)
 {
 	switch (A)
 	{
-		case EGenerationAxe::X_UP: return EGenerationAxe::X_DOWN;
-		case EGenerationAxe::X_DOWN: return EGenerationAxe::X_UP;
-		case EGenerationAxe::Y_UP: return EGenerationAxe::Y_DOWN;
-		case EGenerationAxe::Y_DOWN: return EGenerationAxe::Y_UP;
-		default: return EGenerationAxe::X_UP;
+		case EHGAxe::X_UP: return EHGAxe::X_DOWN;
+		case EHGAxe::X_DOWN: return EHGAxe::X_UP;
+		case EHGAxe::Y_UP: return EHGAxe::Y_DOWN;
+		case EHGAxe::Y_DOWN: return EHGAxe::Y_UP;
+		default: return EHGAxe::X_UP;
 	}
 }
 
 FRoomBlock::FRoomBlock(const FVectorGrid& _Size, const FVectorGrid& _GlobalPosition, int _Level)
 	: FBasicBlock(_Size, _GlobalPosition, _Level) {}
 
-FVector FRoomBlock::GenerateRoomOffset(const FBuildingConstraint& BuildData) const
+FVector FRoomBlock::GenerateRoomOffset(const FHGBuildingMetrics& BuildData) const
 {
+	//The real offset includes the wall
 	return FVector(
-		GlobalPosition.X * BuildData.GridSnapLength,
-		GlobalPosition.Y * BuildData.GridSnapLength,
+		RealOffset.X + BuildData.WallWidth,
+		RealOffset.Y + BuildData.WallWidth,
 		Level * (BuildData.FloorHeight + BuildData.FloorWidth)
 	);
 }
 
+void FRoomBlock::AddWindow(const FBox2D& LevelRect, const FWindowLayout& Layout, TArray<FWindowPlacement>& Windows) const
+{
+	const FVector2D Wall(Layout.WallWidth, Layout.WallWidth);
+	AddExteriorWindows(FBox2D(RealOffset + Wall, RealOffset + RealSize - Wall), LevelRect, Level, Layout, Windows);
+}
+
 bool FRoomBlock::operator<(const FRoomBlock& B) const
 {
 	return FMath::Min(Size.X, Size.Y) < FMath::Min(B.Size.X, B.Size.Y);
 }
 
-FDependencyBuffer::FDependencyBuffer(const TArray<FFurnitureDependency>& _Dependencies,	const FFurnitureRect& _ParentPosition)
-	: Dependencies(_Dependencies), ParentPosition(_ParentPosition) {}
+void FRoomBlock::AllocateTypes(const TArray<FRoomBlock*>& SortedRoomBlocks, const TArray<FHGRoomQuota>& Quotas, int RoomInhabitants, int RoomQuantity)
+{
+	//For the next part we suppose that the quotas have already been sorted accordingly to the MinimalSide property of their rooms
+	const int Diff  = RoomQuantity - SortedRoomBlocks.Num();
+	if(0 < Diff)
+	{
+		TArray<FName> RoomsToAvoid;
+		RoomsToAvoid.Reserve(Diff);
+		
+		for (int i = 0; i < Diff; ++i)
+		{
+			TPair<FName, int> MaxPresence;
+			TPair<FName, int> MinRest;
+			MaxPresence.Value = 0;
+			MinRest.Value = 1;
+
+			for (const FHGRoomQuota &Room : Quotas)
+			{
+				//Here we use Floor to check the decimal part : lower one means more rounded when floored
+				const float DesiredNumber = Room.NumPerHab * RoomInhabitants;
+				const float Rest = DesiredNumber - FMath::Floor(DesiredNumber);
+				
+				if(DesiredNumber > MaxPresence.Value)
+				{
+					MaxPresence.Key = Room.RoomType;
+					MaxPresence.Value = DesiredNumber;
+				}
+				else if(DesiredNumber == MaxPresence.Value)
+				{
+					if(RoomsToAvoid.Contains(MaxPresence.Key) && !RoomsToAvoid.Contains(Room.RoomType))
+					{
+						MaxPresence.Key = Room.RoomType;
+						MaxPresence.Value = DesiredNumber;
+					}
+				}
+
+				if(Rest < MinRest.Value)
+				{
+					MinRest.Key = Room.RoomType;
+					MinRest.Value = Rest;
+				}
+				else if(Rest == MinRest.Value)
+				{
+					if(RoomsToAvoid.Contains(MinRest.Key) && !RoomsToAvoid.Contains(Room.RoomType))
+					{
+						MinRest.Key = Room.RoomType;
+						MinRest.Value = Rest;
+					}
+				}
+			}
+
+			if(MaxPresence.Value > 1)
+				RoomsToAvoid.Push(MaxPresence.Key);
+			else
+				RoomsToAvoid.Push(MinRest.Key);
+		}
+
+		int RoomIndex = 0;
+		for (const FHGRoomQuota &Room : Quotas)
+		{
+			const int DesiredNumber = (Room.NumPerHab * RoomInhabitants) - RoomsToAvoid.RemoveAll([&Room](const FName &A) {return A == Room.RoomType;});
+			for (int i = 0; i < DesiredNumber; ++i)
+			{
+				SortedRoomBlocks[RoomIndex]->RoomType = Room.RoomType;
+				++RoomIndex;
+			}
+		}
+	}
+	else if(0 > Diff)
+	{
+		TArray<FName> RoomsToAdd;
+		RoomsToAdd.Reserve(-Diff);
+		
+		for (int i = 0; i < -Diff; ++i)
+		{
+			TPair<FName, int> MinPresence;
+			TPair<FName, int> MaxRest;
+			MinPresence.Value = 0;
+			MaxRest.Value = 1;
+
+			for (const FHGRoomQuota &Room : Quotas)
+			{
+				//Here we use Floor to check the decimal part : bigger one means less rounded when floored
+				const float DesiredNumber = Room.NumPerHab * RoomInhabitants;
+				const float Rest = DesiredNumber - FMath::Floor(DesiredNumber);
+
+				if(Rest > MaxRest.Value)
+				{
+					MaxRest.Key = Room.RoomType;
+					MaxRest.Value = Rest;
+				}
+				else if(Rest == MaxRest.Value)
+				{
+					if(RoomsToAdd.Contains(MaxRest.Key) && !RoomsToAdd.Contains(Room.RoomType))
+					{
+						MaxRest.Key = Room.RoomType;
+						MaxRest.Value = Rest;
+					}
+				}
+
+				if(DesiredNumber < MinPresence.Value)
+				{
+					MinPresence.Key = Room.RoomType;
+					MinPresence.Value = DesiredNumber;
+				}
+				else if(DesiredNumber == MinPresence.Value)
+				{
+					if(RoomsToAdd.Contains(MinPresence.Key) && !RoomsToAdd.Contains(Room.RoomType))
+					{
+						MinPresence.Key = Room.RoomType;
+						MinPresence.Value = DesiredNumber;
+					}
+				}
+			}
+
+			if(MaxRest.Value > 0.5)
+				RoomsToAdd.Push(MaxRest.Key);
+			else
+				RoomsToAdd.Push(MinPresence.Key);
+		}
+
+		int RoomIndex = 0;
+		for (const FHGRoomQuota &Room : Quotas)
+		{
+			const int DesiredNumber = (Room.NumPerHab * RoomInhabitants) + RoomsToAdd.RemoveAll([&Room](const FName &A) {return A == Room.RoomType;});
+			for (int i = 0; i < DesiredNumber; ++i)
+			{
+				SortedRoomBlocks[RoomIndex]->RoomType = Room.RoomType;
+				++RoomIndex;
+			}
+		}
+	}
+}
+
+FDependencyBuffer::FDependencyBuffer(TArray<FHGFurnitureDependency>&& _Dependencies,	const FFurnitureRect& _ParentPosition)
+	: Dependencies(MoveTemp(_Dependencies)), ParentPosition(_ParentPosition) {}
+
+void FFurnitureSpawnBuffer::Record(int32 MeshId, const FFurnitureRect& Rect, const FRoomBlock& Room, const FVector& RoomOffset, const FName& RoomType, const FName& FurnitureType)
+{
+	if(MeshId == INDEX_NONE)
+		return;
+
+	FFurnitureSpawnCommand &Command = Commands.AddDefaulted_GetRef();
+	Command.MeshId = MeshId;
+	Command.Rect = Rect;
+	Command.RoomOffset = RoomOffset;
+	Command.Level = Room.Level;
+	Command.RoomIndex = Room.Index;
+	Command.RoomType = RoomType;
+	Command.FurnitureType = FurnitureType;
+
+	//The commands of a room are recorded one after the other
+	const FFurnitureSpawnCommand * const Previous = Commands.Num() > 1 ? &Commands[Commands.Num() - 2] : nullptr;
+	Command.Index = Previous && Previous->Level == Command.Level && Previous->RoomIndex == Command.RoomIndex ? Previous->Index + 1 : 0;
+}
+
+void FFurnitureSpawnBuffer::Append(const FFurnitureSpawnBuffer& Other)
+{
+	Commands.Append(Other.Commands);
+}
+
+void FFurnitureSpawnBuffer::Empty()
+{
+	Commands.Empty();
+}
+
+int32 FFurnitureSpawnBuffer::Num() const
+{
+	return Commands.Num();
+}
 
 FLevelDivisionData::FLevelDivisionData(int _LevelTotalArea, int _HallArea) : HallTotalArea(_HallArea), LevelTotalArea(_LevelTotalArea) {}
 
@@ -615,7 +870,7 @@ float FLevelDivisionData::GetFutureHallRatio(int HallArea) const
 }
 
 FAdjacencyMarker::FAdjacencyMarker(FUnknownBlock* Block1, FUnknownBlock* Block2, bool DivideAlongX)
-	: MainSide(DivideAlongX ? EGenerationAxe::X_UP : EGenerationAxe::Y_UP)
+	: MainSide(DivideAlongX ? EHGAxe::X_UP : EHGAxe::Y_UP)
 {
 	//Setups the structure
 	if(DivideAlongX)
@@ -636,39 +891,39 @@ void FAdjacencyMarker::UpdateAccordingDivision(FUnknownBlock* InitialBlock, FUnk
 	
 	const bool IsMainBlock = InitialBlock == MainBlock;
 	FUnknownBlock *const OtherBlock = IsMainBlock ? SecondBlock : MainBlock;
-	if(DivideAlongX && MainSide == EGenerationAxe::Y_UP || !DivideAlongX && MainSide == EGenerationAxe::X_UP)
+	if(DivideAlongX && MainSide == EHGAxe::Y_UP || !DivideAlongX && MainSide == EHGAxe::X_UP)
 	{	
 		if(AreBlockStillAdjacent(OtherBlock, LowestChild))
-			new FAdjacencyMarker(OtherBlock, LowestChild, MainSide == EGenerationAxe::X_UP);
+			new FAdjacencyMarker(OtherBlock, LowestChild, MainSide == EHGAxe::X_UP);
 
 		if(AreBlockStillAdjacent(OtherBlock, HighestChild))
-			new FAdjacencyMarker(OtherBlock, HighestChild, MainSide == EGenerationAxe::X_UP);
+			new FAdjacencyMarker(OtherBlock, HighestChild, MainSide == EHGAxe::X_UP);
 	}
 	else
 	{
 		if(IsMainBlock)
-			new FAdjacencyMarker(OtherBlock, HighestChild, MainSide == EGenerationAxe::X_UP);
+			new FAdjacencyMarker(OtherBlock, HighestChild, MainSide == EHGAxe::X_UP);
 		else
-			new FAdjacencyMarker(OtherBlock, LowestChild, MainSide == EGenerationAxe::X_UP);
+			new FAdjacencyMarker(OtherBlock, LowestChild, MainSide == EHGAxe::X_UP);
 	}
 
 	//We assume at least child is adjacent to OtherBlock
 	delete this;
 }
 
-bool FAdjacencyMarker::IsAlongBlockSide(const FUnknownBlock* Block, EGenerationAxe Side) const
+bool FAdjacencyMarker::IsAlongBlockSide(const FUnknownBlock* Block, EHGAxe Side) const
 {
 	const bool IsMainBlock = Block == MainBlock;
 
-	if(MainSide == EGenerationAxe::X_UP)
-		return (IsMainBlock && Side == EGenerationAxe::X_UP) || (!IsMainBlock && Side == EGenerationAxe::X_DOWN);
+	if(MainSide == EHGAxe::X_UP)
+		return (IsMainBlock && Side == EHGAxe::X_UP) || (!IsMainBlock && Side == EHGAxe::X_DOWN);
 	
-	return (IsMainBlock && Side == EGenerationAxe::Y_UP) || (!IsMainBlock && Side == EGenerationAxe::Y_DOWN);
+	return (IsMainBlock && Side == EHGAxe::Y_UP) || (!IsMainBlock && Side == EHGAxe::Y_DOWN);
 }
 
 int FAdjacencyMarker::GetAdjacencyRange() const
 {
-	if(MainSide == EGenerationAxe::X_UP)
+	if(MainSide == EHGAxe::X_UP)
 	{
 		const int Distance = SecondBlock->GlobalPosition.X - MainBlock->GlobalPosition.X;
 		const FUnknownBlock * const LowestBlock =  Distance > 0 ? MainBlock : SecondBlock;
@@ -689,7 +944,7 @@ FUnknownBlock* FAdjacencyMarker::GetOppositeBlock(FUnknownBlock* Block) const
 
 bool FAdjacencyMarker::AreBlockStillAdjacent(const FUnknownBlock* Block1, const FUnknownBlock* Block2) const
 {
-	if(MainSide == EGenerationAxe::X_UP)
+	if(MainSide == EHGAxe::X_UP)
 	{
 		const int Distance = Block2->GlobalPosition.X - Block1->GlobalPosition.X;
 		const FUnknownBlock * const LowestBlock =  Distance > 0 ? Block1 : Block2;
@@ -706,10 +961,25 @@ bool FAdjacencyMarker::AreBlockStillAdjacent(const FUnknownBlock* Block1, const
 FHallBlock::FHallBlock(const FVectorGrid& _Size, const FVectorGrid& _GlobalPosition, int _Level)
 	: FBasicBlock(_Size, _GlobalPosition, _Level) {}
 
-FUnknownBlock::FUnknownBlock(const FVectorGrid& _Size, const FVectorGrid& _GlobalPosition, int _Level, bool _AlongX, uint8 _AdjacentHalls, EGenerationAxe _DoorSide)
+bool FHallBlock::AreWindowSpawned() const
+{
+	return WindowSpawned;
+}
+
+void FHallBlock::AddWindow(const FBox2D& LevelRect, const FWindowLayout& Layout, TArray<FWindowPlacement>& Windows)
+{
+	if(WindowSpawned)
+		return;
+
+	//A hall has no wall of its own
+	AddExteriorWindows(FBox2D(RealOffset, RealOffset + RealSize), LevelRect, Level, Layout, Windows);
+	WindowSpawned = true;
+}
+
+FUnknownBlock::FUnknownBlock(const FVectorGrid& _Size, const FVectorGrid& _GlobalPosition, int _Level, bool _AlongX, uint8 _AdjacentHalls, EHGAxe _DoorSide)
 	: FBasicBlock(_Size, _GlobalPosition, _Level), DivideAlongX(_AlongX), AdjacentHalls(_AdjacentHalls), DoorSide(_DoorSide) {}
 
-FUnknownBlock::DivideMethod FUnknownBlock::ShouldDivide(const FRoomsDivisionConstraints& DivisionCst, FLevelDivisionData& DivisionData) const
+FUnknownBlock::DivideMethod FUnknownBlock::ShouldDivide(const FHGDivisionMetrics& DivisionCst, FLevelDivisionData& DivisionData, const FHGRandomStream& Stream) const
 {
 	//Basic checks
 	check(GlobalPosition.X >= 0 && GlobalPosition.Y >= 0);
@@ -736,7 +1006,7 @@ FUnknownBlock::DivideMethod FUnknownBlock::ShouldDivide(const FRoomsDivisionCons
 			else
 				DivideDecision =  DivideMethod::SPLIT;
 		}		
-		else if(FMath::RandRange(0.f, 1.f) <= DivisionCst.OverDivideProba)
+		else if(Stream.FRandRange(0.f, 1.f) <= DivisionCst.OverDivideProba)
 		{
 			if(ShouldStopSplit)
 				DivideDecision =  DivideMethod::DIVISION;
@@ -762,7 +1032,7 @@ FUnknownBlock::DivideMethod FUnknownBlock::ShouldDivide(const FRoomsDivisionCons
 			else
 				DivideDecision = DivideMethod::SPLIT;
 		}
-		else if(FMath::RandRange(0.f, 1.f) <= DivisionCst.OverDivideProba)
+		else if(Stream.FRandRange(0.f, 1.f) <= DivisionCst.OverDivideProba)
 		{
 			if(ShouldStopSplit)
 				DivideDecision = DivideMethod::DIVISION;
@@ -775,7 +1045,7 @@ FUnknownBlock::DivideMethod FUnknownBlock::ShouldDivide(const FRoomsDivisionCons
 	return DivideDecision;
 }
 
-bool FUnknownBlock::BlockSplit(const FRoomsDivisionConstraints& DivisionCst, FUnknownBlock &FirstResultedBlock,  FUnknownBlock& SecondResultedBlock, FHallBlock& ResultHall)
+bool FUnknownBlock::BlockSplit(const FHGDivisionMetrics& DivisionCst, FUnknownBlock &FirstResultedBlock,  FUnknownBlock& SecondResultedBlock, FHallBlock& ResultHall, const FHGRandomStream& Stream)
 {
 	//Basic checks
 	if(DivideDecision != DivideMethod::SPLIT)
@@ -784,7 +1054,7 @@ bool FUnknownBlock::BlockSplit(const FRoomsDivisionConstraints& DivisionCst, FUn
 	//Make split
 	if(DivideAlongX)
 	{
-		const int HallAxis = FMath::RandRange(DivisionCst.ABSMinimalSide, Size.X - DivisionCst.ABSMinimalSide - DivisionCst.HallWidth);
+		const int HallAxis = Stream.RandRange(DivisionCst.ABSMinimalSide, Size.X - DivisionCst.ABSMinimalSide - DivisionCst.HallWidth);
 
 		//Setup the hall
 		ResultHall.Size = FVectorGrid(DivisionCst.HallWidth, Size.Y);
@@ -794,19 +1064,19 @@ bool FUnknownBlock::BlockSplit(const FRoomsDivisionConstraints& DivisionCst, FUn
 		FirstResultedBlock.DivideAlongX = false;
 		FirstResultedBlock.Size = FVectorGrid(HallAxis, Size.Y);
 		FirstResultedBlock.GlobalPosition = GlobalPosition;
-		FirstResultedBlock.AdjacentHalls = AdjacentHalls | static_cast<uint8>(EGenerationAxe::X_UP);
-		FirstResultedBlock.DoorSide = EGenerationAxe::X_UP;
+		FirstResultedBlock.AdjacentHalls = AdjacentHalls | static_cast<uint8>(EHGAxe::X_UP);
+		FirstResultedBlock.DoorSide = EHGAxe::X_UP;
 		
 		//Setup second block (highest X location)
 		SecondResultedBlock.DivideAlongX = false;
 		SecondResultedBlock.Size = FVectorGrid(Size.X - (HallAxis + DivisionCst.HallWidth), Size.Y);
 		SecondResultedBlock.GlobalPosition = GlobalPosition + FVectorGrid(HallAxis + DivisionCst.HallWidth, 0);
-		SecondResultedBlock.AdjacentHalls = AdjacentHalls | static_cast<uint8>(EGenerationAxe::X_DOWN);
-		SecondResultedBlock.DoorSide = EGenerationAxe::X_DOWN;
+		SecondResultedBlock.AdjacentHalls = AdjacentHalls | static_cast<uint8>(EHGAxe::X_DOWN);
+		SecondResultedBlock.DoorSide = EHGAxe::X_DOWN;
 	}
 	else
 	{
-		const int HallAxis = FMath::RandRange(DivisionCst.ABSMinimalSide, Size.Y - DivisionCst.ABSMinimalSide - DivisionCst.HallWidth);
+		const int HallAxis = Stream.RandRange(DivisionCst.ABSMinimalSide, Size.Y - DivisionCst.ABSMinimalSide - DivisionCst.HallWidth);
 
 		//Setup the hall
 		ResultHall.Size = FVectorGrid(Size.X, DivisionCst.HallWidth);
@@ -816,15 +1086,15 @@ bool FUnknownBlock::BlockSplit(const FRoomsDivisionConstraints& DivisionCst, FUn
 		FirstResultedBlock.DivideAlongX = true;
 		FirstResultedBlock.Size = FVectorGrid(Size.X, HallAxis);
 		FirstResultedBlock.GlobalPosition = GlobalPosition;
-		FirstResultedBlock.AdjacentHalls = AdjacentHalls | static_cast<uint8>(EGenerationAxe::Y_UP);
-		FirstResultedBlock.DoorSide = EGenerationAxe::Y_UP;
+		FirstResultedBlock.AdjacentHalls = AdjacentHalls | static_cast<uint8>(EHGAxe::Y_UP);
+		FirstResultedBlock.DoorSide = EHGAxe::Y_UP;
 
 		//Setup second block (highest Y location)
 		SecondResultedBlock.DivideAlongX = true;
 		SecondResultedBlock.Size = FVectorGrid(Size.X, Size.Y - (HallAxis + DivisionCst.HallWidth));
 		SecondResultedBlock.GlobalPosition = GlobalPosition + FVectorGrid(0, HallAxis + DivisionCst.HallWidth);
-		SecondResultedBlock.AdjacentHalls = AdjacentHalls | static_cast<uint8>(EGenerationAxe::Y_DOWN);
-		SecondResultedBlock.DoorSide = EGenerationAxe::Y_DOWN;
+		SecondResultedBlock.AdjacentHalls = AdjacentHalls | static_cast<uint8>(EHGAxe::Y_DOWN);
+		SecondResultedBlock.DoorSide = EHGAxe::Y_DOWN;
 	}
 
 	//Redundant affectations
@@ -841,49 +1111,49 @@ bool FUnknownBlock::BlockSplit(const FRoomsDivisionConstraints& DivisionCst, FUn
 	return true;
 }
 
-bool FUnknownBlock::BlockDivision(const FRoomsDivisionConstraints& DivisionCst, FUnknownBlock &FirstResultedBlock, FUnknownBlock& SecondResultedBlock)
+bool FUnknownBlock::BlockDivision(const FHGDivisionMetrics& DivisionCst, FUnknownBlock &FirstResultedBlock, FUnknownBlock& SecondResultedBlock, const FHGRandomStream& Stream)
 {
 	//Basic checks
 	if(DivideDecision != DivideMethod::DIVISION)
 		return false;
 
 	//Make split
-	const bool IsRoomSideDown = DoorSide == EGenerationAxe::X_DOWN || DoorSide == EGenerationAxe::Y_DOWN;
+	const bool IsRoomSideDown = DoorSide == EHGAxe::X_DOWN || DoorSide == EHGAxe::Y_DOWN;
 	if(DivideAlongX)
 	{
-		const int WallAxis = FMath::RandRange(DivisionCst.ABSMinimalSide, Size.X - DivisionCst.ABSMinimalSide);
+		const int WallAxis = Stream.RandRange(DivisionCst.ABSMinimalSide, Size.X - DivisionCst.ABSMinimalSide);
 
 		//Setup first block
 		FirstResultedBlock.DivideAlongX	= false;
 		FirstResultedBlock.Size	= FVectorGrid(WallAxis, Size.Y);
 		FirstResultedBlock.GlobalPosition = GlobalPosition;
-		FirstResultedBlock.AdjacentHalls = AdjacentHalls & ~static_cast<uint8>(EGenerationAxe::X_UP);
-		FirstResultedBlock.DoorSide = IsRoomSideDown ? DoorSide : EGenerationAxe::X_UP;
+		FirstResultedBlock.AdjacentHalls = AdjacentHalls & ~static_cast<uint8>(EHGAxe::X_UP);
+		FirstResultedBlock.DoorSide = IsRoomSideDown ? DoorSide : EHGAxe::X_UP;
 
 		//Setup second block (highest X location)
 		SecondResultedBlock.DivideAlongX = false;
 		SecondResultedBlock.Size = FVectorGrid(Size.X - WallAxis, Size.Y);
 		SecondResultedBlock.GlobalPosition = GlobalPosition + FVectorGrid(WallAxis, 0);
-		SecondResultedBlock.AdjacentHalls = AdjacentHalls & ~static_cast<uint8>(EGenerationAxe::X_DOWN);
-		SecondResultedBlock.DoorSide = IsRoomSideDown ?  EGenerationAxe::X_DOWN : DoorSide;
+		SecondResultedBlock.AdjacentHalls = AdjacentHalls & ~static_cast<uint8>(EHGAxe::X_DOWN);
+		SecondResultedBlock.DoorSide = IsRoomSideDown ?  EHGAxe::X_DOWN : DoorSide;
 	}
 	else
 	{
-		const int WallAxis = FMath::RandRange(DivisionCst.ABSMinimalSide, Size.Y - DivisionCst.ABSMinimalSide);
+		const int WallAxis = Stream.RandRange(DivisionCst.ABSMinimalSide, Size.Y - DivisionCst.ABSMinimalSide);
 
 		//Setup first block
 		FirstResultedBlock.DivideAlongX = true;
 		FirstResultedBlock.Size = FVectorGrid(Size.X, WallAxis);
 		FirstResultedBlock.GlobalPosition = GlobalPosition;
-		FirstResultedBlock.AdjacentHalls = AdjacentHalls & ~static_cast<uint8>(EGenerationAxe::Y_UP);
-		FirstResultedBlock.DoorSide = IsRoomSideDown ? DoorSide : EGenerationAxe::Y_UP;
+		FirstResultedBlock.AdjacentHalls = AdjacentHalls & ~static_cast<uint8>(EHGAxe::Y_UP);
+		FirstResultedBlock.DoorSide = IsRoomSideDown ? DoorSide : EHGAxe::Y_UP;
 
 		//Setup the returned block (highest Y location)
 		SecondResultedBlock.DivideAlongX = true;
 		SecondResultedBlock.Size = FVectorGrid(Size.X, Size.Y - WallAxis);
 		SecondResultedBlock.GlobalPosition = GlobalPosition + FVectorGrid(0, WallAxis);
-		SecondResultedBlock.AdjacentHalls = AdjacentHalls & ~static_cast<uint8>(EGenerationAxe::Y_DOWN);
-		SecondResultedBlock.DoorSide = IsRoomSideDown ?  EGenerationAxe::Y_DOWN : DoorSide;
+		SecondResultedBlock.AdjacentHalls = AdjacentHalls & ~static_cast<uint8>(EHGAxe::Y_DOWN);
+		SecondResultedBlock.DoorSide = IsRoomSideDown ?  EHGAxe::Y_DOWN : DoorSide;
 	}
 
 	//Redundant affectations
@@ -917,12 +1187,12 @@ void FUnknownBlock::TransformToRoom(FRoomBlock& CreatedRoom)
 	//Door setup is done later
 }
 
-void FUnknownBlock::ConnectDoors(UFurnitureMeshAsset* DoorAsset)
+void FUnknownBlock::ConnectDoors(const FHGMeshDescriptor& Door, const FHGRandomStream& Stream)
 {
 	if(AdjacentHalls)
 	{
-		TArray<EGenerationAxe> Sides = {EGenerationAxe::X_UP, EGenerationAxe::X_DOWN, EGenerationAxe::Y_UP, EGenerationAxe::Y_DOWN};
-		AHomeGenerator::ShuffleArray(Sides);
+		TArray<EHGAxe> Sides = {EHGAxe::X_UP, EHGAxe::X_DOWN, EHGAxe::Y_UP, EHGAxe::Y_DOWN};
+		Stream.Shuffle(Sides);
 
 		for(auto Side : Sides)
 			if(AdjacentHalls & static_cast<uint8>(Side))
@@ -931,7 +1201,7 @@ void FUnknownBlock::ConnectDoors(UFurnitureMeshAsset* DoorAsset)
 					Room,
 					nullptr,
 					FDoorBlock::GetOppositeAxe(Side),
-					DoorAsset
+					Door
 				));
 				break;
 			}
@@ -942,25 +1212,37 @@ void FUnknownBlock::ConnectDoors(UFurnitureMeshAsset* DoorAsset)
 		for(auto *Connection : AdjacencyConnections)
 		{
 			if(!Connection->IsAlongBlockSide(this, DoorSide)) continue;
-			if(Connection->GetAdjacencyRange() < DoorAsset->GridSize.Y) continue;
+			if(Connection->GetAdjacencyRange() < Door.GridSize.Y) continue;
 			PossibleConnections.Push(Connection);
 		}
 		//ENH : Should maybe select this with biggest range
 		check(PossibleConnections.Num() > 0);
-		const FAdjacencyMarker * const SelectedMarker = PossibleConnections[FMath::RandRange(0, PossibleConnections.Num() - 1)];
+		const FAdjacencyMarker * const SelectedMarker = PossibleConnections[Stream.RandRange(0, PossibleConnections.Num() - 1)];
 
 		Room->ConnectedDoors.Push(new FDoorBlock(
 			Room,
 			SelectedMarker->GetOppositeBlock(this)->Room,
 			FDoorBlock::GetOppositeAxe(DoorSide),
-			DoorAsset
+			Door
 		));
 
 		SelectedMarker->GetOppositeBlock(this)->Room->ConnectedDoors.Push(Room->ConnectedDoors.Last());
 	}
 }
 
-void FUnknownBlock::ComputeRealSizeRecursive(const FBuildingConstraint &BuildingCst, const FRoomsDivisionConstraints &RoomDivisionCst)
+void FUnknownBlock::DeleteAdjacencyMarkers(TDoubleLinkedList<FUnknownBlock>& Blocks)
+{
+	TSet<FAdjacencyMarker *> Markers;
+	for(FUnknownBlock &Block : Blocks)
+	{
+		Markers.Append(Block.AdjacencyConnections);
+		Block.AdjacencyConnections.Empty();
+	}
+	for(FAdjacencyMarker *Marker : Markers)
+		delete Marker;
+}
+
+void FUnknownBlock::ComputeRealSizeRecursive(const FHGBuildingMetrics &BuildingCst, const FHGDivisionMetrics &RoomDivisionCst)
 {
 	check(DivideDecision != DivideMethod::ERROR);
 	if(Child1 == nullptr && Child2 == nullptr || DivideDecision == DivideMethod::NO_DIVIDE) //End case
@@ -1014,7 +1296,7 @@ void FUnknownBlock::ComputeRealSizeRecursive(const FBuildingConstraint &Building
 	}
 }
 
-void FUnknownBlock::ComputeRealOffsetRecursive(const FBuildingConstraint& BuildingCst, const FRoomsDivisionConstraints& RoomDivisionCst, const bool IsHighestAxe) const
+void FUnknownBlock::ComputeRealOffsetRecursive(const FHGBuildingMetrics& BuildingCst, const FHGDivisionMetrics& RoomDivisionCst, const bool IsHighestAxe) const
 {
 	check(DivideDecision != DivideMethod::ERROR);
 	if(Child1 == nullptr && Child2 == nullptr || DivideDecision == DivideMethod::NO_DIVIDE) //End case
@@ -1115,7 +1397,7 @@ int FLevelOrganisation::InitialHallArea() const
 		+	(InitialHalls[HighMargin]	? InitialHalls[HighMargin]->Size.Area()		: 0);
 }
 
-void FLevelOrganisation::ComputeBasicRealData(const FBuildingConstraint& BuildingCst, const FRoomsDivisionConstraints& RoomDivisionCst)
+void FLevelOrganisation::ComputeBasicRealData(const FHGBuildingMetrics& BuildingCst, const FHGDivisionMetrics& RoomDivisionCst)
 {
 	check(InitialHalls[LowCorridor] && InitialBlocks[LowWing] || InitialHalls[HighCorridor] && InitialBlocks[HighWing]);
 	check(InitialHalls[Stairs]);
@@ -1278,7 +1560,7 @@ void FLevelOrganisation::ComputeBasicRealData(const FBuildingConstraint& Buildin
 	//Don't launch recursive offset because before we should calculate all levels
 }
 
-void FLevelOrganisation::ComputeAllRealData(const FVector2D& LevelOffset, const FBuildingConstraint& BuildingCst, const FRoomsDivisionConstraints& RoomDivisionCst)
+void FLevelOrganisation::ComputeAllRealData(const FVector2D& LevelOffset, const FHGBuildingMetrics& BuildingCst, const FHGDivisionMetrics& RoomDivisionCst)
 {
 	check(InitialHalls[LowCorridor] && InitialBlocks[LowWing] || InitialHalls[HighCorridor] && InitialBlocks[HighWing]);
 	check(InitialHalls[Stairs]);
@@ -1292,7 +1574,7 @@ void FLevelOrganisation::ComputeAllRealData(const FVector2D& LevelOffset, const
 		{
 			InitialBlocks[LowWing]->RealOffset = RealOffset;
 			InitialBlocks[LowWing]->RealOffset.Y += (RealSize.Y - InitialBlocks[LowWing]->RealSize.Y) / 2.f;
-			InitialHalls[LowCorridor]->RealOffset.X = LevelOffset.X + InitialBlocks[LowWing]->Size.X;
+			InitialHalls[LowCorridor]->RealOffset.X = InitialBlocks[LowWing]->RealOffset.X + InitialBlocks[LowWing]->RealSize.X;
 			InitialHalls[LowCorridor]->RealOffset.Y = RealOffset.Y;
 		}
 
@@ -1300,7 +1582,7 @@ void FLevelOrganisation::ComputeAllRealData(const FVector2D& LevelOffset, const
 		{
 			InitialBlocks[HighWing]->RealOffset = RealOffset;
 			InitialBlocks[HighWing]->RealOffset.X += RealSize.X - InitialBlocks[HighWing]->RealSize.X;
-			InitialBlocks[HighWing]->RealOffset.Y += (RealSize.Y - InitialBlocks[LowWing]->RealSize.Y) / 2.f;
+			InitialBlocks[HighWing]->RealOffset.Y += (RealSize.Y - InitialBlocks[HighWing]->RealSize.Y) / 2.f;
 			InitialHalls[HighCorridor]->RealOffset.X = InitialBlocks[HighWing]->RealOffset.X
 				- BuildingCst.WallWidth
 				- InitialHalls[HighCorridor]->RealSize.X;
@@ -1313,13 +1595,13 @@ void FLevelOrganisation::ComputeAllRealData(const FVector2D& LevelOffset, const
 		if(InitialHalls[LowMargin])
 		{
 			InitialHalls[LowMargin]->RealOffset = InitialHalls[Stairs]->RealOffset;
-			InitialHalls[LowMargin]->RealOffset.X -= InitialBlocks[LowMargin]->RealSize.X;
+			InitialHalls[LowMargin]->RealOffset.X -= InitialHalls[LowMargin]->RealSize.X;
 		}
 
 		if(InitialHalls[HighMargin])
 		{
 			InitialHalls[HighMargin]->RealOffset = InitialHalls[Stairs]->RealOffset;
-			InitialHalls[HighMargin]->RealOffset.X += InitialBlocks[Stairs]->RealSize.X;
+			InitialHalls[HighMargin]->RealOffset.X += InitialHalls[Stairs]->RealSize.X;
 		}
 
 		//Apartments offset
@@ -1358,7 +1640,7 @@ void FLevelOrganisation::ComputeAllRealData(const FVector2D& LevelOffset, const
 			InitialBlocks[LowWing]->RealOffset = RealOffset;
 			InitialBlocks[LowWing]->RealOffset.X += (RealSize.X - InitialBlocks[LowWing]->RealSize.X) / 2.f;
 			
-			InitialHalls[LowCorridor]->RealOffset.Y = LevelOffset.Y + InitialBlocks[LowWing]->Size.Y;
+			InitialHalls[LowCorridor]->RealOffset.Y = InitialBlocks[LowWing]->RealOffset.Y + InitialBlocks[LowWing]->RealSize.Y;
 			InitialHalls[LowCorridor]->RealOffset.X = RealOffset.X;
 		}
 
@@ -1366,7 +1648,7 @@ void FLevelOrganisation::ComputeAllRealData(const FVector2D& LevelOffset, const
 		{
 			InitialBlocks[HighWing]->RealOffset = RealOffset;
 			InitialBlocks[HighWing]->RealOffset.Y += RealSize.Y - InitialBlocks[HighWing]->RealSize.Y;
-			InitialBlocks[HighWing]->RealOffset.X += (RealSize.X - InitialBlocks[LowWing]->RealSize.X) / 2.f;
+			InitialBlocks[HighWing]->RealOffset.X += (RealSize.X - InitialBlocks[HighWing]->RealSize.X) / 2.f;
 			
 			InitialHalls[HighCorridor]->RealOffset.Y = InitialBlocks[HighWing]->RealOffset.Y
 				- BuildingCst.WallWidth
@@ -1380,13 +1662,13 @@ void FLevelOrganisation::ComputeAllRealData(const FVector2D& LevelOffset, const
 		if(InitialHalls[LowMargin])
 		{
 			InitialHalls[LowMargin]->RealOffset = InitialHalls[Stairs]->RealOffset;
-			InitialHalls[LowMargin]->RealOffset.Y -= InitialBlocks[LowMargin]->RealSize.Y;
+			InitialHalls[LowMargin]->RealOffset.Y -= InitialHalls[LowMargin]->RealSize.Y;
 		}
 
 		if(InitialHalls[HighMargin])
 		{
 			InitialHalls[HighMargin]->RealOffset = InitialHalls[Stairs]->RealOffset;
-			InitialHalls[HighMargin]->RealOffset.Y += InitialBlocks[Stairs]->RealSize.Y;
+			InitialHalls[HighMargin]->RealOffset.Y += InitialHalls[Stairs]->RealSize.Y;
 		}
 
 		//Apartments offset
@@ -1441,3 +1723,29 @@ const TArray<FHallBlock*>& FLevelOrganisation::GetHallList() const
 {
 	return InitialHalls;
 }
+
+FHGDwellingUnit::~FHGDwellingUnit()
+{
+	Reset();
+}
+
+void FHGDwellingUnit::Reset()
+{
+	//The doors of a unit only connect its own rooms (or a hall)
+	TSet<FDoorBlock *> DoorBlocks;
+	for(const FRoomBlock *RoomBlock : Rooms)
+		DoorBlocks.Append(RoomBlock->ConnectedDoors);
+	for(FDoorBlock *DoorBlock : DoorBlocks)
+		delete DoorBlock;
+
+	for(const FRoomBlock *RoomBlock : Rooms)
+		delete RoomBlock;
+	for(const FHallBlock *HallBlock : Halls)
+		delete HallBlock;
+
+	FUnknownBlock::DeleteAdjacencyMarkers(Nodes);
+	Rooms.Empty();
+	Halls.Empty();
+	Nodes.Empty();
+	Root = nullptr;
+}
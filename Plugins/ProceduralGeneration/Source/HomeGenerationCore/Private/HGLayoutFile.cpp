@@ -0,0 +1,150 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "HGLayoutFile.h"
+#include "HomeGenerationCore.h"
+#include "HAL/PlatformFilemanager.h"
+#include "Async/MappedFileHandle.h"
+#include "Misc/FileHelper.h"
+
+//The records are read in place : they must stay plain data with the same layout on all platforms
+static_assert(PLATFORM_LITTLE_ENDIAN, "Layout files are little endian");
+static_assert(sizeof(FHGLayoutHeader) == 116, "Layout header changed : increment HGLayoutFile::Version");
+static_assert(sizeof(FHGLayoutHall) == 40 && sizeof(FHGLayoutRoom) == 44 && sizeof(FHGLayoutDoor) == 32 && sizeof(FHGLayoutFurniture) == 52, "Layout records changed : increment HGLayoutFile::Version");
+
+namespace
+{
+	//Each section starts on 8 bytes
+	template<typename T>
+	void AppendSection(TArray<uint8> &Bytes, FHGLayoutSection &Section, const TArray<T> &Items)
+	{
+		Bytes.AddZeroed(Align(Bytes.Num(), 8) - Bytes.Num());
+		Section.Offset = Bytes.Num();
+		Section.Num = Items.Num();
+		Bytes.Append(reinterpret_cast<const uint8 *>(Items.GetData()), Items.Num() * sizeof(T));
+	}
+}
+
+int32 FHGLayoutWriter::AddString(const FString& String)
+{
+	if(const int32 * const Id = StringIds.Find(String))
+		return *Id;
+
+	const FTCHARToUTF8 Converted(*String);
+	FHGLayoutString &Entry = Strings.AddDefaulted_GetRef();
+	Entry.Offset = Chars.Num();
+	Entry.Length = Converted.Length();
+	Chars.Append(reinterpret_cast<const uint8 *>(Converted.Get()), Converted.Length());
+	return StringIds.Add(String, Strings.Num() - 1);
+}
+
+void FHGLayoutWriter::Write(TArray<uint8>& Bytes)
+{
+	Bytes.Reset();
+	Bytes.AddZeroed(sizeof(FHGLayoutHeader));
+
+	AppendSection(Bytes, Header.Strings, Strings);
+	AppendSection(Bytes, Header.Chars, Chars);
+	AppendSection(Bytes, Header.Meshes, Meshes);
+	AppendSection(Bytes, Header.Halls, Halls);
+	AppendSection(Bytes, Header.Rooms, Rooms);
+	AppendSection(Bytes, Header.Doors, Doors);
+	AppendSection(Bytes, Header.Furniture, Furniture);
+
+	Header.Magic = HGLayoutFile::Magic;
+	Header.Version = HGLayoutFile::Version;
+	Header.HeaderSize = sizeof(FHGLayoutHeader);
+	Header.FileSize = Bytes.Num();
+	FMemory::Memcpy(Bytes.GetData(), &Header, sizeof(FHGLayoutHeader));
+}
+
+bool FHGLayoutView::Initialize(const uint8* _Data, int64 _Size)
+{
+	Data = _Data;
+	Size = _Size;
+	if(Data == nullptr || Size < static_cast<int64>(sizeof(FHGLayoutHeader)))
+		return false;
+
+	const FHGLayoutHeader &Header = GetHeader();
+	if(Header.Magic != HGLayoutFile::Magic || Header.Version != HGLayoutFile::Version || Header.HeaderSize != sizeof(FHGLayoutHeader) || Header.FileSize != Size)
+		return false;
+
+	if(!IsSectionValid<FHGLayoutString>(Header.Strings) || !IsSectionValid<uint8>(Header.Chars) || !IsSectionValid<int32>(Header.Meshes)
+		|| !IsSectionValid<FHGLayoutHall>(Header.Halls) || !IsSectionValid<FHGLayoutRoom>(Header.Rooms)
+		|| !IsSectionValid<FHGLayoutDoor>(Header.Doors) || !IsSectionValid<FHGLayoutFurniture>(Header.Furniture))
+		return false;
+
+	//Strings are checked once : GetString only checks the id
+	for(const FHGLayoutString &String : GetSection<FHGLayoutString>(Header.Strings))
+		if(static_cast<int64>(String.Offset) + String.Length > Header.Chars.Num)
+			return false;
+	return true;
+}
+
+const FHGLayoutHeader& FHGLayoutView::GetHeader() const
+{
+	return *reinterpret_cast<const FHGLayoutHeader *>(Data);
+}
+
+TArrayView<const int32> FHGLayoutView::GetMeshes() const
+{
+	return GetSection<int32>(GetHeader().Meshes);
+}
+
+TArrayView<const FHGLayoutHall> FHGLayoutView::GetHalls() const
+{
+	return GetSection<FHGLayoutHall>(GetHeader().Halls);
+}
+
+TArrayView<const FHGLayoutRoom> FHGLayoutView::GetRooms() const
+{
+	return GetSection<FHGLayoutRoom>(GetHeader().Rooms);
+}
+
+TArrayView<const FHGLayoutDoor> FHGLayoutView::GetDoors() const
+{
+	return GetSection<FHGLayoutDoor>(GetHeader().Doors);
+}
+
+TArrayView<const FHGLayoutFurniture> FHGLayoutView::GetFurniture() const
+{
+	return GetSection<FHGLayoutFurniture>(GetHeader().Furniture);
+}
+
+FString FHGLayoutView::GetString(int32 Id) const
+{
+	const TArrayView<const FHGLayoutString> Strings = GetSection<FHGLayoutString>(GetHeader().Strings);
+	if(!Strings.IsValidIndex(Id))
+		return FString();
+
+	const FUTF8ToTCHAR Converted(reinterpret_cast<const ANSICHAR *>(Data + GetHeader().Chars.Offset + Strings[Id].Offset), Strings[Id].Length);
+	return FString(Converted.Length(), Converted.Get());
+}
+
+FHGLayoutFile::FHGLayoutFile() = default;
+FHGLayoutFile::~FHGLayoutFile() = default;
+
+bool FHGLayoutFile::Open(const FString& Filename)
+{
+	MappedRegion.Reset();
+	MappedFile.Reset();
+	Bytes.Empty();
+
+	//Mapped : the pages are only read when the records are used
+	MappedFile.Reset(FPlatformFileManager::Get().GetPlatformFile().OpenMapped(*Filename));
+	if(MappedFile.IsValid())
+		MappedRegion.Reset(MappedFile->MapRegion());
+
+	const bool bValid = MappedRegion.IsValid()
+		? View.Initialize(MappedRegion->GetMappedPtr(), MappedRegion->GetMappedSize())
+		: FFileHelper::LoadFileToArray(Bytes, *Filename, FILEREAD_Silent) && View.Initialize(Bytes.GetData(), Bytes.Num());
+
+	if(!bValid)
+		UE_LOG(LogHomeGenerationCore, Warning, TEXT("%s isn't a valid layout file (version %d expected)."), *Filename, HGLayoutFile::Version);
+	return bValid;
+}
+
+const FHGLayoutView& FHGLayoutFile::GetView() const
+{
+	return View;
+}
@@ -0,0 +1,105 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "HGLayoutJob.h"
+#include "HGBuildingPlan.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+void HGLayoutJob::ComputeLayout(FHGBuildingPlan& Plan, FFurnitureSpawnBuffer& SpawnBuffer, FHGLayoutJob& Job, TArray<uint8>& Bytes)
+{
+	const double StartTime = FPlatformTime::Seconds();
+
+	//Only the layout is written : no geometry
+	Plan.ComputeLayout(SpawnBuffer);
+	Job.Error = CheckLayout(Plan);
+	if(Job.Error.IsEmpty())
+	{
+		Plan.WriteLayout(SpawnBuffer, Bytes);
+		Job.Size = Bytes.Num();
+	}
+
+	Job.Levels = Plan.RoomBlocks.Num();
+	for(const auto &LevelRooms : Plan.RoomBlocks)
+		Job.Rooms += LevelRooms.Num();
+	Job.Furniture = SpawnBuffer.Num();
+	Job.Milliseconds = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+}
+
+FString HGLayoutJob::CheckLayout(const FHGBuildingPlan& Plan)
+{
+	if(Plan.RoomBlocks.Num() == 0)
+		return TEXT("No level generated");
+
+	for(int32 Level = 0; Level < Plan.RoomBlocks.Num(); ++Level)
+	{
+		if(Plan.RoomBlocks[Level].Num() == 0)
+			return FString::Printf(TEXT("No room in level %d"), Level);
+
+		for(const FRoomBlock &RoomBlock : Plan.RoomBlocks[Level])
+			if(!Plan.Rooms.Contains(RoomBlock.RoomType))
+				return FString::Printf(TEXT("Room %d of level %d not allocated"), RoomBlock.Index, Level);
+	}
+	return FString();
+}
+
+bool HGLayoutJob::ParseSeeds(const FString& Text, TArray<int32>& Seeds)
+{
+	//Signed integer only (IsNumeric accepts decimals)
+	const auto ParseSeed = [] (const FString &SeedText, int32 &Seed)
+	{
+		const int32 Start = SeedText.StartsWith(TEXT("-")) || SeedText.StartsWith(TEXT("+")) ? 1 : 0;
+		if(SeedText.Len() <= Start || SeedText.Len() > Start + 10)
+			return false;
+		for(int32 i = Start; i < SeedText.Len(); ++i)
+			if(!FChar::IsDigit(SeedText[i]))
+				return false;
+
+		const int64 Value = FCString::Atoi64(*SeedText);
+		if(Value < MIN_int32 || Value > MAX_int32)
+			return false;
+		Seed = static_cast<int32>(Value);
+		return true;
+	};
+
+	TArray<FString> Ranges;
+	Text.ParseIntoArray(Ranges, TEXT(","));
+	for(FString Range : Ranges)
+	{
+		//The separator is the first '-' after the sign of the first seed : "-10--5", "-3-4"
+		Range.TrimStartAndEndInline();
+		const int32 Separator = Range.Find(TEXT("-"), ESearchCase::CaseSensitive, ESearchDir::FromStart, 1);
+		const FString First = Separator == INDEX_NONE ? Range : Range.Left(Separator);
+		const FString Last = Separator == INDEX_NONE ? Range : Range.Mid(Separator + 1);
+
+		int32 Start, Stop;
+		if(!ParseSeed(First, Start) || !ParseSeed(Last, Stop) || Stop < Start)
+			return false;
+
+		//int64 : the range can end at MAX_int32
+		for(int64 Seed = Start; Seed <= Stop; ++Seed)
+			Seeds.Push(static_cast<int32>(Seed));
+	}
+	return Seeds.Num() > 0;
+}
+
+bool HGLayoutJob::WriteManifest(const FString& Filename, const TArray<FHGLayoutJob>& Jobs)
+{
+	//Text fields are always quoted : the paths and the errors can contain commas, quotes or new lines
+	const auto Quote = [] (const FString &Field)
+	{
+		return TEXT("\"") + Field.Replace(TEXT("\""), TEXT("\"\"")) + TEXT("\"");
+	};
+
+	TArray<FString> Lines;
+	Lines.Reserve(Jobs.Num() + 1);
+	Lines.Push(TEXT("Preset,Seed,File,Levels,Rooms,Furniture,Bytes,Milliseconds,Error"));
+	for(const FHGLayoutJob &Job : Jobs)
+	{
+		FString RelativeFilename = Job.Filename;
+		FPaths::MakePathRelativeTo(RelativeFilename, *Filename);
+		Lines.Push(FString::Printf(TEXT("%s,%d,%s,%d,%d,%d,%d,%.3f,%s"), *Quote(Job.Preset), Job.Seed, *Quote(Job.Error.IsEmpty() ? RelativeFilename : FString()),
+			Job.Levels, Job.Rooms, Job.Furniture, Job.Size, Job.Milliseconds, *Quote(Job.Error)));
+	}
+	return FFileHelper::SaveStringArrayToFile(Lines, *Filename);
+}
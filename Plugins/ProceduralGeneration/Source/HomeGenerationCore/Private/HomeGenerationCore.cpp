@@ -0,0 +1,19 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "HomeGenerationCore.h"
+
+#define LOCTEXT_NAMESPACE "FHomeGenerationCoreModule"
+
+DEFINE_LOG_CATEGORY(LogHomeGenerationCore);
+
+void FHomeGenerationCoreModule::StartupModule()
+{
+}
+
+void FHomeGenerationCoreModule::ShutdownModule()
+{
+}
+
+#undef LOCTEXT_NAMESPACE
+	
+IMPLEMENT_MODULE(FHomeGenerationCoreModule, HomeGenerationCore)
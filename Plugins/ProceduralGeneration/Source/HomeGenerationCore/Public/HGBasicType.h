@@ -0,0 +1,133 @@
+﻿//Fill with copyright
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+//In degrees
+enum class EFurnitureRotation : uint8
+{
+	ROT0,
+	ROT90,
+	ROT180,
+	ROT270
+};
+
+/**
+ * Seeded random stream : every random choice of the generation goes through one, so the same seed always rebuilds the same building.
+ * Sub streams only depend on the initial seed and their key (not on what has already been drawn) : levels and rooms can be generated in any order or in parallel.
+ */
+struct HOMEGENERATIONCORE_API FHGRandomStream
+{
+	FHGRandomStream();
+	explicit FHGRandomStream(int32 Seed);
+
+	//Independent stream derived from the initial seed and the key
+	FHGRandomStream Split(int32 Key) const;
+
+	//Inclusive
+	int32 RandRange(int32 Min, int32 Max) const;
+	float FRandRange(float Min, float Max) const;
+	bool RandBool() const;
+
+	int32 GetInitialSeed() const;
+
+	//Shuffles the elements of the given array
+	template<typename T>
+	void Shuffle(TArray<T> &InArray) const;
+
+protected:
+	FRandomStream Stream;
+};
+
+template <typename T>
+void FHGRandomStream::Shuffle(TArray<T>& InArray) const
+{
+	for (int32 i = 0; i < InArray.Num(); ++i)
+	{
+		const int32 Index = RandRange(i, InArray.Num() - 1);
+		if (i != Index)
+			InArray.Swap(i, Index);
+	}
+}
+
+namespace HGArray
+{
+	//Generate the list of the integers in the range : [Start; Stop[
+	//Acts like python function : range(start, stop)
+	HOMEGENERATIONCORE_API void GenerateRangeArray(TArray<int32> &InArray, int32 Start, int32 Stop);
+
+	//Generate the list of the integers in the range : [0; Stop[
+	//Acts like python function : range(stop)
+	HOMEGENERATIONCORE_API void GenerateRangeArray(TArray<int32> &InArray, int32 Stop);
+}
+
+//Domains of the sub streams of a generation (first key)
+enum class EHGRandomDomain : int32
+{
+	Building,
+	Stairs,
+	LevelDivision,
+	Doors,
+	Furniture,
+	Decoration
+};
+
+/**
+ * Represents a side of a furniture or an element in the generation system (a room's side for example).
+ * Same values as EGenerationAxe (its asset counterpart), can be used in a mask storage.
+ */
+enum class EHGAxe : uint8
+{
+	//Shouldn't be used, only exists for compilation purposes
+	NONE   = 0,
+	
+	X_UP   = 1,//0001
+	X_DOWN = 2,//0010
+	Y_UP   = 4,//0100
+	Y_DOWN = 8 //1000
+};
+
+HOMEGENERATIONCORE_API uint8 operator|(EHGAxe A, EHGAxe B);
+HOMEGENERATIONCORE_API uint8 operator|(EHGAxe A, uint8 B);
+HOMEGENERATIONCORE_API uint8 operator|(uint8 A, EHGAxe B);
+
+struct HOMEGENERATIONCORE_API FVectorGrid
+{
+	//By default generate a vector null : (0, 0)
+	FVectorGrid();
+	FVectorGrid(int _X, int _Y);
+	FVectorGrid(const FVector2D &Vector);
+	
+	int X;
+	int Y;
+
+	//Operators to Grid
+	FVectorGrid operator+(const FVectorGrid &In) const;
+	FVectorGrid operator-(const FVectorGrid &In) const;
+	FVectorGrid &operator+=(const FVectorGrid &In);
+	FVectorGrid &operator-=(const FVectorGrid &In);
+	
+	//Operators to Vector2D
+	FVector2D operator*(const float Lambda) const;
+
+	//Special calculations
+	int Area() const;
+	int MinSide() const;
+	int MaxSide() const;
+	float Norm() const;
+
+	//Static maths
+	static FVectorGrid Min(const FVectorGrid &a, const FVectorGrid &b);
+	static FVectorGrid Max(const FVectorGrid &a, const FVectorGrid &b);
+	static FVectorGrid Abs(const FVectorGrid &a);
+	static FVectorGrid Random(const FVectorGrid &min, const FVectorGrid &max, const FHGRandomStream &Stream);//Inclusive, by coordinates
+	
+	static const FVectorGrid Zero;
+	static const FVectorGrid Unit;
+	static const FVectorGrid IVector;
+	static const FVectorGrid JVector;
+	
+	//Export
+	FVector ToVector(float GridSnapLength) const;
+};
\ No newline at end of file
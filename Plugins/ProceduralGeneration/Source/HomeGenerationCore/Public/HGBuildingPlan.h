@@ -0,0 +1,283 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HGDescriptors.h"
+#include "HGInternalStruct.h"
+#include "HAL/ThreadSafeBool.h"
+
+struct FHGLayoutView;
+
+/**
+ * Furniture mesh of the catalog as seen by the generation (the asset itself stays in the HomeGeneration module).
+ */
+struct FHGCatalogMesh
+{
+	//Size and constraints for the grid snap length of the generator
+	FHGMeshDescriptor Descriptor;
+
+	//Path of the asset, written in the layout files
+	FString Path;
+
+	//Has something to spawn (the footprint may be missing, see UFurnitureMeshAsset::ValidateFootprint)
+	bool bPlaceable = false;
+};
+
+/**
+ * Window mesh as seen by the generation.
+ */
+struct FHGCatalogWindow
+{
+	FHGWindowDescriptor Descriptor;
+	FString Path;
+};
+
+/**
+ * Division of the levels : only valid during the rooms step (see FHGBuildingPlan::BeginRoomsDivision).
+ */
+struct FHGDivisionState
+{
+	FLevelOrganisation InitialOrganisation;
+	TArray<FLevelOrganisation> LevelsOrganisation;
+	TDoubleLinkedList<FUnknownBlock> NodesToDelete;
+};
+
+/**
+ * Plan file : the parameters of a generator saved by the HomeGeneration module, to compute its layouts without the engine (see FHGPlanParameters::SaveToFile).
+ * The version must be incremented on any change of the parameters or the descriptors.
+ */
+namespace HGPlanFile
+{
+	//"HGPL"
+	constexpr uint32 Magic = 0x4C504748;
+	constexpr uint32 Version = 1;
+}
+
+/**
+ * Everything a generation reads from its generator and its assets, as plain data : the meshes are only known by their id in the catalog.
+ * Filled on the game thread by the HomeGeneration module (see AHomeGenerator::PrepareGeneration), or read from a file by a program without any engine.
+ */
+struct HOMEGENERATIONCORE_API FHGPlanParameters
+{
+	//Logs only
+	FString GeneratorName;
+
+	int Inhabitants = 1;
+	int32 Seed = 0;
+	bool bApartmentBlock = false;
+	int32 MaxUnitAttempts = 4;
+	bool bTypicalFloors = false;
+	int32 TypicalFloorStart = 1;
+
+	//The computed data of the constraints (sides, levels, building size) is only stored here
+	FHGBuildingConstraints BuildingConstraints;
+	FHGDivisionConstraints RoomsDivisionConstraints;
+	FHGFurnitureDescriptor Stairs;
+	FHGFurnitureDescriptor Doors;
+	FHGWindowsDescriptor Windows;
+	TMap<FName, FHGRoomDescriptor> Rooms;
+	TMap<FName, FHGFurnitureDescriptor> Furniture;
+
+	bool bStreamFurniture = false;
+
+	//All the furniture meshes which can be placed (the index is the id used in the spawn commands)
+	TArray<FHGCatalogMesh> CatalogMeshes;
+
+	//All the window meshes (the index is the id used by the windows)
+	TArray<FHGCatalogWindow> CatalogWindows;
+
+	//Id of the mesh with the given path (INDEX_NONE if not found)
+	int32 FindCatalogMesh(const FString &Path) const;
+	int32 FindCatalogWindow(const FString &Path) const;
+
+	//Constraints of the mesh, or the default ones of its furniture
+	const FHGFurnitureConstraint &GetMeshConstraints(int32 MeshId, const FHGFurnitureDescriptor &CorrespondingFurniture) const;
+
+	//Area occupied by the mesh including its margin, without any dependency
+	int GetMeshArea(int32 MeshId, const FHGFurnitureDescriptor &CorrespondingFurniture) const;
+
+	//Average area of all the meshes of the furniture
+	int GetAverageArea(const FHGFurnitureDescriptor &CorrespondingFurniture) const;
+
+	//Computes the minimal side of the room from the area of its furniture
+	int ComputeMinimalSide(FHGRoomDescriptor &Room) const;
+
+	//Writes or reads all the parameters, catalogs included
+	void Serialize(FArchive &Ar);
+
+	//Plan file of the parameters. Returns false if it can't be written, or read with the same version.
+	bool SaveToFile(const FString &Filename) const;
+	bool LoadFromFile(const FString &Filename);
+};
+
+/**
+ * Layout of one generation : its parameters and everything computed from them (blocks, doors, windows, furniture placement).
+ * Computed on any thread : only reads its parameters and writes in itself and the given buffers.
+ */
+class HOMEGENERATIONCORE_API FHGBuildingPlan : public FHGPlanParameters
+{
+public:
+	FHGBuildingPlan() = default;
+	FHGBuildingPlan(const FHGBuildingPlan &) = delete;
+	FHGBuildingPlan &operator=(const FHGBuildingPlan &) = delete;
+	virtual ~FHGBuildingPlan();
+
+	//Checked by the worker between the stages
+	FThreadSafeBool bCancelGeneration;
+
+	//Deletes the blocks (and their doors)
+	void Reset();
+
+	//Memory used by the blocks, their doors and the windows
+	SIZE_T GetAllocatedSize() const;
+
+	//Computes all minimal sides and sort elements based on this value (ex : rooms)
+	//Also computes additional room's constants
+	void ComputeSides();
+
+	//Sub stream of the generation's seed for the given domain (and level and room if needed)
+	FHGRandomStream GetRandomStream(EHGRandomDomain Domain, int32 Level = 0, int32 RoomIndex = 0) const;
+
+	///______________________
+	///Layout pipeline
+	///
+
+	//Building, rooms, doors and windows, then the furniture placement if it isn't streamed (any thread)
+	void ComputeLayout(FFurnitureSpawnBuffer &SpawnBuffer);
+
+	//Writes the layout and the given furniture commands in the layout file format (any thread)
+	void WriteLayout(const FFurnitureSpawnBuffer &SpawnBuffer, TArray<uint8> &Bytes) const;
+
+	//Rebuilds the blocks, the doors and the furniture commands stored in a layout file.
+	//Returns false if the file doesn't match the parameters (seed, floors, walls, room types, assets) or is invalid (the layout must then be reset).
+	bool ReadLayout(const FHGLayoutView &View, FFurnitureSpawnBuffer &SpawnBuffer);
+
+	///______________________
+	///Building Step
+	///
+
+	void DefineBuilding();
+
+	//Selected furniture (stairs, windows and doors) : ids in the catalogs
+	int32 SelectedStair = INDEX_NONE;
+	int32 SelectedDoor = INDEX_NONE;
+	int32 SelectedWindow = INDEX_NONE;
+
+	///______________________
+	///Rooms step
+	///
+
+	//Divides all the levels and places the doors and the windows
+	void DefineRooms();
+
+	//Positions the stairs and prepares the division of all the levels
+	void BeginRoomsDivision(FHGDivisionState &Division);
+
+	//Computes the real data of all the blocks, once all levels are divided, and allocates the rooms
+	void EndRoomsDivision(FHGDivisionState &Division);
+
+	//Defines the position of the stairs and the first halls (stairs must be connected to at least one hall)
+	//These position are used by all levels
+	void StairsPositioning(FLevelOrganisation &InitialOrganisation);
+
+	//Divide given level into a list of room and halls
+	void DivideSurface(const int Level, FLevelOrganisation& LevelOrganisation, TDoubleLinkedList<FUnknownBlock>& NodesToDelete);
+
+	//Divides the blocks until only rooms and halls remain, then connects the doors of the rooms (any thread, only reads the layout).
+	//The created blocks are given to Rooms and Halls, the divided nodes to Nodes (all of them if the division fails).
+	bool DivideBlocks(TDoubleLinkedList<FUnknownBlock> &ToDivide, FLevelDivisionData &DivisionData, const FHGRandomStream &Stream, TArray<FRoomBlock *> &Rooms, TArray<FHallBlock *> &Halls, TDoubleLinkedList<FUnknownBlock> &Nodes) const;
+
+	//Creates the halls of the level from the initial organisation (corridors and stairs)
+	void InitLevelHalls(const int Level, FLevelOrganisation &LevelOrganisation);
+
+	//Number of levels really divided : the others are copies of the typical floor
+	int32 GetDividedLevels() const;
+
+	//The level is a copy of the typical floor
+	bool IsRepeatedLevel(int32 Level) const;
+
+	//Copies the blocks (and the placed doors) of the typical floor in all the repeated levels
+	void RepeatTypicalFloor();
+
+	//Apartment block mode : divides and allocates all the dwelling units of the given levels in parallel, then gives their blocks to the levels
+	void DivideUnits(int FirstLevel, int NumLevels, FHGDivisionState &Division);
+
+	//Divides the unit, connects its doors and allocates its rooms (any thread, only reads the layout).
+	//Returns false if the unit hasn't enough rooms for its inhabitants.
+	bool DivideUnit(FHGDwellingUnit &Unit, const FHGRandomStream &Stream) const;
+
+	//Shares the inhabitants between all the dwelling units of the building, proportionally to their area (at least one per unit)
+	void ComputeUnitInhabitants(const FLevelOrganisation &InitialOrganisation, TArray<int> &UnitInhabitants) const;
+
+	//Computes for each block (room, level, ...) their real offset.
+	//This offset take in account the walls : in the grid system they don't have any width.
+	void ComputeWallEffect(TArray<FLevelOrganisation> &LevelsOrganisation);
+
+	//Called when all levels have been divided to define the type for each room block created.
+	//Acts globally on all levels simultaneously (in apartment block mode, the units are allocated by DivideUnit)
+	void AllocateSurface();
+
+	//Defines the type of the given rooms (sorted by side) for the given number of inhabitants, using the quotas of the Rooms map
+	void AllocateRooms(const TArray<FRoomBlock *> &SortedRoomBlocks, int RoomInhabitants, int RoomQuantity) const;
+
+	//Randomly places all the doors of the rooms (and chooses the room recording each door), copies the typical floor, then places the windows.
+	//Once done, the doors aren't modified anymore : the rooms can be furnished in parallel.
+	void PlaceDoorsAndWindows();
+
+	//Places the selected window along all the exterior walls of the rooms and halls
+	void PlaceWindows();
+
+	//Bounds of the level (walls included), relative to the generator
+	FBox2D ComputeLevelRect(int Level) const;
+
+	//Space inside the walls of a room, relative to the generator
+	FBox2D ComputeRoomInterior(const FRoomBlock &RoomBlock) const;
+
+	//Rects opened in the walls of a level by the doors (under the door height) and the windows (between their bottom and top)
+	void ComputeOpenings(int Level, TArray<FBox2D> &DoorOpenings, TArray<FBox2D> &WindowOpenings) const;
+
+	//Height of the openings made by the doors in the walls
+	float ComputeDoorHeight() const;
+
+	//Placed windows of all the levels
+	TArray<FWindowPlacement> WindowPlacements;
+
+	//Size of the placed windows along the wall, and height of their bottom and top from the floor
+	float WindowWidth = 0.f;
+	float WindowBottom = 0.f;
+	float WindowTop = 0.f;
+
+	//31/12/2021 : No fucking idea how to do this shit
+	//01/02/2022 Lol, progress : 0%
+	//05/02/2022 : Easy : just add placo around rooms : really thick walls just for deco, rest of walls will be empty, same for floor and ceil.
+	//Randomly chooses the position of a door (on the wall of the given room) if it hasn't one yet.
+	void PlaceDoor(const FRoomBlock &RoomBlock, FDoorBlock *DoorBlock);
+
+	//All halls in the building by level (first index)
+	//Blocks are allocated one by one : the pointers on them stay valid
+	TArray<TIndirectArray<FHallBlock>> HallBlocks;
+
+	//All rooms in the building by level (first index)
+	//Blocks are allocated one by one : the pointers on them (doors, sorted rooms,...) stay valid
+	TArray<TIndirectArray<FRoomBlock>> RoomBlocks;
+
+	///______________________
+	///Furniture Step
+	///
+
+	//Places the furniture of all the rooms of the building, in parallel (one task per room) : nothing is spawned (any thread).
+	//The commands are appended room by room, in order, whatever the number of threads.
+	void RecordFurniture(FFurnitureSpawnBuffer &SpawnBuffer) const;
+
+	//Generate and place all the furniture and decoration for a room.
+	//Nothing is spawned : the placements are recorded in the spawn buffer. Only reads the layout : rooms can be generated concurrently.
+	void GenerateRoom(const FName &RoomType, const FRoomBlock &RoomBlock, FFurnitureSpawnBuffer &SpawnBuffer) const;
+
+	//Records the doors of the room (see PlaceDoorsAndWindows), and marks all of them in the grid.
+	//Starts to fill the grid.
+	void GenerateRoomDoors(const FName &RoomType, const FRoomBlock &RoomBlock, FRoomGrid &RoomGrid, FFurnitureSpawnBuffer &SpawnBuffer) const;
+
+	//Place all the needed furniture for a room and their dependencies, and record them.
+	void GenerateFurniture(const FName &RoomType, const FRoomBlock &RoomBlock, FRoomGrid &RoomGrid, FFurnitureSpawnBuffer &SpawnBuffer) const;
+};
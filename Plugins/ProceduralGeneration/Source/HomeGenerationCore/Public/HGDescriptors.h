@@ -0,0 +1,237 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HGBasicType.h"
+
+/**
+ * Plain descriptors used by the generation algorithms : the same data than the assets and the properties of the generator, without any UObject.
+ * The generator converts its constraints into them before computing a building (see the ToCore functions of the corresponding USTRUCTs).
+ */
+
+//Global interaction of a furniture with the room's walls (see EWallGlobalInteraction)
+enum class EHGWallGlobalInteraction : uint8
+{
+	DEFAULT,
+	CORNER,
+	WALL,
+	FAR
+};
+
+//Interaction of furniture's side with the room's walls (see EWallAxeInteraction)
+enum class EHGWallAxeInteraction : uint8
+{
+	IGNORE,
+	ATTRACT,
+	REJECT
+};
+
+//Way a dependency must be placed in front of a side of the parent furniture (see EDependencyPlace)
+enum class EHGDependencyPlace : uint8
+{
+	EDGE_L,
+	EDGE_R,
+	DEFAULT
+};
+
+/**
+ * Interaction with the room's walls for each side of a furniture and its global interaction.
+ */
+struct HOMEGENERATIONCORE_API FHGWallInteraction
+{
+	EHGWallGlobalInteraction WallGlobalInteraction = EHGWallGlobalInteraction::DEFAULT;
+	EHGWallAxeInteraction XUp = EHGWallAxeInteraction::IGNORE;
+	EHGWallAxeInteraction XDown = EHGWallAxeInteraction::IGNORE;
+	EHGWallAxeInteraction YUp = EHGWallAxeInteraction::IGNORE;
+	EHGWallAxeInteraction YDown = EHGWallAxeInteraction::IGNORE;
+
+	//Return the first attracted wall that the function can find. Return false if it can't.
+	//Guarantees that at least one attracted wall exists.
+	bool GetFirstAttractedWall(EHGAxe &First) const;
+	
+	//Return the second attracted wall that the function can find (different from the first one returned by the other function). Return false if it can't.
+	//Guarantees that at least two attracted walls exist.
+	bool GetSecondAttractedWall(EHGAxe &Second) const;
+};
+
+/**
+ * Margin for each side of a furniture (in grid square).
+ */
+struct FHGMargin
+{
+	int XUp = 0;
+	int XDown = 0;
+	int YUp = 0;
+	int YDown = 0;
+};
+
+/**
+ * Constraints used to check a position of a furniture in a room.
+ */
+struct FHGFurnitureConstraint
+{
+	FHGWallInteraction WallAxeInteraction;
+	FHGMargin Margin;
+};
+
+/**
+ * Information needed to place the dependency of a furniture.
+ */
+struct FHGFurnitureDependency
+{
+	//Maximal distance between a dependency and its parent
+	int Distance = 0;
+
+	//Axe of the parent in front of which the dependency is placed
+	EHGAxe Axe = EHGAxe::NONE;
+	EHGDependencyPlace Position = EHGDependencyPlace::DEFAULT;
+
+	FName FurnitureType;
+};
+
+/**
+ * Description of a mesh of the catalog of a generator (only what the algorithms need).
+ */
+struct FHGMeshDescriptor
+{
+	//Id of the mesh in the catalog of the generator
+	int32 MeshId = INDEX_NONE;
+
+	//Size in grid square (non-rotated)
+	FVectorGrid GridSize;
+
+	//Constraints of the mesh itself, replacing the default ones of its furniture if set
+	bool bOverrideConstraint = false;
+	FHGFurnitureConstraint ConstraintsOverride;
+
+	//Height of the bounds of the mesh (used for the door openings)
+	//In UE unit
+	float Height = 0.f;
+};
+
+/**
+ * Description of a window mesh of the catalog of a generator.
+ */
+struct FHGWindowDescriptor
+{
+	//Size in grid square (non-rotated), 0 along the exterior axis
+	FVectorGrid GridSize;
+
+	//The mesh has a footprint (a window without one is never placed)
+	bool bHasBounds = false;
+
+	//Height of the bounds of the mesh, and distance between the floor and its bottom (constraints of the mesh, or the default ones of the windows)
+	//In UE unit
+	float Height = 0.f;
+	float DistanceFromFloor = 0.f;
+
+	EHGAxe ExteriorFace = EHGAxe::NONE;
+};
+
+/**
+ * Type of furniture (see FFurniture) : its meshes are given by their id in the catalog.
+ */
+struct FHGFurnitureDescriptor
+{
+	//Ids of the meshes in the catalog (INDEX_NONE for a missing asset), in the order of the generator
+	TArray<int32> Meshes;
+
+	FHGFurnitureConstraint DefaultConstraints;
+	TArray<FHGFurnitureDependency> Dependencies;
+};
+
+/**
+ * Windows of the building (see FWindow) : its meshes are given by their id in the window catalog.
+ */
+struct FHGWindowsDescriptor
+{
+	TArray<int32> Meshes;
+
+	//Number of grid squares between two windows along a wall
+	int Spacing = 1;
+};
+
+/**
+ * Type of room (see FRoom).
+ */
+struct FHGRoomDescriptor
+{
+	//Priority list of the furniture types placed in the room
+	TArray<FName> Furniture;
+
+	float NumPerHab = 1.f;
+
+	//Computed from the footprints of the furniture (see FHGPlanParameters::ComputeMinimalSide)
+	int MinimalSide = 0;
+};
+
+/**
+ * Dimensions of the building used to compute the real data of the blocks (see FBuildingConstraint).
+ * In UE unit.
+ */
+struct FHGBuildingMetrics
+{
+	float GridSnapLength = 0.f;
+	float FloorWidth = 0.f;
+	float FloorHeight = 0.f;
+	float WallWidth = 0.f;
+};
+
+/**
+ * Shape constraints of the building and its computed dimensions (see FBuildingConstraint).
+ */
+struct FHGBuildingConstraints : FHGBuildingMetrics
+{
+	//In grid square (0 to ignore them)
+	int MinSideFloorLength = 0;
+	int MaxSideFloorLength = 0;
+	int MaxFloorsNumber = 0;
+
+	//Computed by the generation : average minimal side of the rooms (pondered by their quantity) and total quantity of rooms
+	int AverageSide = 0;
+	int NormalRoomQuantity = 0;
+
+	//Computed by the generation
+	FVectorGrid BuildingSize; //In grid square
+	int Levels = 0;
+};
+
+/**
+ * Computed sides controlling the division of the levels (see FRoomsDivisionConstraints).
+ * In grid square.
+ */
+struct FHGDivisionMetrics
+{
+	int HallWidth = 0;
+	float MaxHallRatio = 0.f;
+	float OverDivideProba = 0.f;
+
+	int ABSMinimalSide = 0;
+	int StopSplitSide = 0;
+	int SufficientSide = 0;
+};
+
+/**
+ * Division constraints of the levels : the sides are computed from the coefficients (see FRoomsDivisionConstraints).
+ */
+struct HOMEGENERATIONCORE_API FHGDivisionConstraints : FHGDivisionMetrics
+{
+	float MinSideCoef = 1.f;
+	float StopSplitCoef = 1.f;
+	float SufficientChunkCoef = 1.f;
+
+	//Computes the sides from the minimal, average and maximal sides of the rooms
+	void CalculateAllSides(const int _BasicMinimalSide, const int _BasicAverageSide, const int _BasicMaximalSide);
+};
+
+/**
+ * Wanted presence of a type of room (see FRoom).
+ */
+struct FHGRoomQuota
+{
+	FName RoomType;
+
+	//Number of rooms of this type per inhabitant
+	float NumPerHab = 0.f;
+};
@@ -4,21 +4,43 @@
 
 #include "HGBasicType.h"
 #include "CoreMinimal.h"
-#include "FurnitureMeshAsset.h"
+#include "HGDescriptors.h"
+#include "Containers/List.h"
 
 //ENH : Think to a better organisation of the internal structs files (HGInternalStruct and HGBasicStruct)
 
-//Home generator serialised structures
-struct FBuildingConstraint;
-struct FRoomsDivisionConstraints;
-struct FWindow;
-
 //Local structures
 struct FRoomBlock;
 struct FUnknownBlock;
 struct FLevelOrganisation;
 
-struct FBasicBlock
+/**
+ * Spacing of the windows along the exterior walls (in UE unit).
+ */
+struct FWindowLayout
+{
+	//Size of a window along the wall
+	float Width = 0.f;
+
+	//Empty space between two windows
+	float Spacing = 0.f;
+
+	float WallWidth = 0.f;
+};
+
+/**
+ * Position of a window : the center of the window in the middle of the exterior wall.
+ */
+struct FWindowPlacement
+{
+	int Level = 0;
+	FVector2D Center = FVector2D::ZeroVector;
+
+	//Exterior side of the wall
+	EHGAxe Side = EHGAxe::NONE;
+};
+
+struct HOMEGENERATIONCORE_API FBasicBlock
 {
 	FBasicBlock() = default;
 	FBasicBlock(const FVectorGrid &_Size, const FVectorGrid &_GlobalPosition, int _Level);
@@ -31,6 +53,12 @@ struct FBasicBlock
 	//Geters
 	const FVector2D& GetRealSize() const;
 	const FVector2D& GetRealOffset() const;
+
+	//Restores the real data of a block (used by the layout files, they are normally computed with the walls)
+	void SetRealData(const FVector2D &_RealOffset, const FVector2D &_RealSize);
+
+	//Places windows, evenly spaced, along each side of the interior rect which is on an exterior wall of the level (the walls along the level rect).
+	static void AddExteriorWindows(const FBox2D &Interior, const FBox2D &LevelRect, int Level, const FWindowLayout &Layout, TArray<FWindowPlacement> &Windows);
 	
 protected:
 	//Advance grid data (taking in account the walls)
@@ -38,15 +66,6 @@ protected:
 	FVector2D RealOffset; //Start from origin (not from grid location)
 };
 
-//In degrees
-enum class EFurnitureRotation : uint8
-{
-	ROT0,
-	ROT90,
-	ROT180,
-	ROT270
-};
-
 enum class ERoomCellType : uint8
 {
 	OBJECT,
@@ -54,7 +73,7 @@ enum class ERoomCellType : uint8
 	EMPTY
 };
 
-struct FRoomCell
+struct HOMEGENERATIONCORE_API FRoomCell
 {
 	//When created a cell is empty
 	FRoomCell() = default;
@@ -65,7 +84,7 @@ struct FRoomCell
 	static uint32 IndexToMarker(uint8 FurnitureIndex);
 };
 
-struct FFurnitureRect
+struct HOMEGENERATIONCORE_API FFurnitureRect
 {
 	//By default generate a vector null : (0°, 0, 0)
 	FFurnitureRect() = default;
@@ -86,7 +105,7 @@ struct FFurnitureRect
  * Represents a room being filled by its furniture. It allows the system to check if the proposed position respect all the constraints.
  * The public functions only mark the grid if the position respects the given constraints.
  */
-struct FRoomGrid
+struct HOMEGENERATIONCORE_API FRoomGrid
 {
 	FRoomGrid() = delete;
 	explicit FRoomGrid(int SizeX, int SizeY);
@@ -96,12 +115,12 @@ struct FRoomGrid
 	virtual int GetSizeX() const;
 	virtual int GetSizeY() const;
 
-	virtual bool MarkFurnitureAtPosition(const FFurnitureRect &Position, const FFurnitureConstraint &Constraints, uint8 DependencyMarker = 0);
-	virtual bool MarkDependencyAtPosition(const FFurnitureRect &Position, const FFurnitureRect &ParentPosition, const FFurnitureConstraint &Constraints,const FFurnitureDependency &DependencyConstraints, uint8 DependencyMarker);
+	virtual bool MarkFurnitureAtPosition(const FFurnitureRect &Position, const FHGFurnitureConstraint &Constraints, uint8 DependencyMarker = 0);
+	virtual bool MarkDependencyAtPosition(const FFurnitureRect &Position, const FFurnitureRect &ParentPosition, const FHGFurnitureConstraint &Constraints,const FHGFurnitureDependency &DependencyConstraints, uint8 DependencyMarker);
 	virtual bool MarkDoorAtPosition(const FFurnitureRect &Position);
 
 	//Returns true if the given FurnitureRect is along the wall of the given room's side (as axis or with the correct function)
-	bool IsAlongAxeWall(const FFurnitureRect &Position, const EGenerationAxe Axe) const;
+	bool IsAlongAxeWall(const FFurnitureRect &Position, const EHGAxe Axe) const;
 	bool IsAlongXUpWall(const FFurnitureRect &Position) const;
 	bool IsAlongXDownWall(const FFurnitureRect &Position) const;
 	bool IsAlongYUpWall(const FFurnitureRect &Position) const;
@@ -117,30 +136,30 @@ protected:
 	//Rotate the input data and paste the result in the 'Rotated' structures
 	//The goal of this function is to obtain some structures that represent the same block (with position, margin wall, ...) but on which no rotation information are needed.
 	//The returned position has a rotation parameter of 0° (allows next functions to make checks)
-	static void RotateData(const FFurnitureRect &InPosition, const FFurnitureConstraint &InConstraints, FFurnitureRect &RotatedPosition, FFurnitureConstraint &RotatedConstraints);
+	static void RotateData(const FFurnitureRect &InPosition, const FHGFurnitureConstraint &InConstraints, FFurnitureRect &RotatedPosition, FHGFurnitureConstraint &RotatedConstraints);
 
 	//Rotate the input data and paste the result in the 'Rotated' structures
 	//The goal of this function is to obtain some structures that represent the same block (with position, margin wall, ...) but on which no rotation information are needed.
 	//The returned position has a rotation parameter of 0° (allows next functions to make checks)
-	static void RotateDependencyData(const FFurnitureRect &InParentPosition, const FFurnitureDependency &InDependency, FFurnitureRect &RotatedParentPosition, FFurnitureDependency &RotatedDependency);
+	static void RotateDependencyData(const FFurnitureRect &InParentPosition, const FHGFurnitureDependency &InDependency, FFurnitureRect &RotatedParentPosition, FHGFurnitureDependency &RotatedDependency);
 
 	//Create the rect of a furniture including its margin
-	static void GenerateMarginRect(const FFurnitureRect& RotatedPosition, const FMarginStruct& RotatedMargin, FFurnitureRect &MarginRect);
+	static void GenerateMarginRect(const FFurnitureRect& RotatedPosition, const FHGMargin& RotatedMargin, FFurnitureRect &MarginRect);
 
 	//Checks a furniture position (regardless of its margin).
     //The Dependency Marker must be 0 for normal furniture and the marker of their parent for the dependencies (checks between the given dependency an its parent).
     //Only send rotated data !!
-	virtual bool CheckFurnitureRect(const FFurnitureRect &RotatedPosition, const FWallInteractionStruct &RotatedInteraction, uint8 DependencyMarker = 0) const;
+	virtual bool CheckFurnitureRect(const FFurnitureRect &RotatedPosition, const FHGWallInteraction &RotatedInteraction, uint8 DependencyMarker = 0) const;
 
 	//Checks the margin position for a given furniture.
     //The Dependency Marker must be 0 for normal furniture and the marker of their parent for the dependencies (checks between the given dependency an its parent).
 	//Only send rotated data !!
-	virtual bool CheckMarginRect(const FFurnitureRect &RotatedPosition, const FMarginStruct &RotatedMargin, uint8 DependencyMarker = 0) const;
+	virtual bool CheckMarginRect(const FFurnitureRect &RotatedPosition, const FHGMargin &RotatedMargin, uint8 DependencyMarker = 0) const;
 
 	//Checks the position of the given dependency with respect to its parent (doesn't check the existence of the parent)
 	//The Dependency Marker must be the marker of the parent of the given dependency (checks between the given dependency an its parent).
 	//Only send rotated data !!	
-	virtual bool CheckDependencyConstraints(const FFurnitureRect &RotatedPosition, const FFurnitureRect &RotatedParentPosition, const FFurnitureDependency &RotatedDependency, uint8 DependencyMarker) const;
+	virtual bool CheckDependencyConstraints(const FFurnitureRect &RotatedPosition, const FFurnitureRect &RotatedParentPosition, const FHGFurnitureDependency &RotatedDependency, uint8 DependencyMarker) const;
 
 	//Marks the grid's cells of the indicated rect as object position in the grid.
 	//The Dependency Marker must be 0 for dependencies and furniture with no dependencies and, for the others, their index (starting at 1)  in the list of furniture with dependencies (mark the grid for the dependencies of the furniture).
@@ -148,23 +167,26 @@ protected:
 	virtual void MarkRect(const FFurnitureRect &RotatedPosition, ERoomCellType CellType, uint8 DependencyMarker = 0);
 };
 
-struct FDoorBlock
+struct HOMEGENERATIONCORE_API FDoorBlock
 {
 	//Prevents from creating a door from nothing
 	FDoorBlock() = delete;
 	
 	//Initialises all constant members but set the position to an invalid value (to detect if this door has been already positioned or not)
-	FDoorBlock(const FRoomBlock *_MainParent, const FRoomBlock *_SecondParent, const EGenerationAxe _OpeningSide, UFurnitureMeshAsset * _DoorAsset);
+	FDoorBlock(const FRoomBlock *_MainParent, const FRoomBlock *_SecondParent, const EHGAxe _OpeningSide, const FHGMeshDescriptor &_Door);
+
+	//Restores an already placed door (copies and layout files)
+	FDoorBlock(const FRoomBlock *_MainParent, const FRoomBlock *_SecondParent, const EHGAxe _OpeningSide, const FHGMeshDescriptor &_Door, const FVectorGrid &_GlobalPosition, const FRoomBlock *_RecordingRoom);
 
 	//Transforms the given local position (according to the indicated RoomBlock) and saves it as global.
 	//Doesn't do anything if the coordinates are already valid.
 	void SaveLocalPosition(const FVectorGrid &LocalPosition, const FRoomBlock &Parent);
 
-	//Marked the door as spawned (allows differentiation between setting position and spawning door).
-	void MarkAsPlaced();
+	//Chooses the room which records the door in its furniture (the first one with a valid position wins) : the rooms can then be furnished in any order.
+	void SetRecordingRoom(const FRoomBlock &Parent);
 
-	//Indicates if the door has been already spawned.
-	bool IsPlaced() const;
+	//Indicates if the door is recorded with the furniture of the given room.
+	bool IsRecordedBy(const FRoomBlock &Parent) const;
 
 	//Indicates if the position of this door has been already correctly set.
 	bool IsPositionValid() const;
@@ -177,19 +199,29 @@ struct FDoorBlock
 	FFurnitureRect GenerateLocalFurnitureRect(const FRoomBlock &Parent) const;
 
 	//Gives the size of the margin of the room for the given room block.
-	FVectorGrid GenerateLocalMarginSize(const FRoomBlock &Parent, const FMarginStruct &DefaultDoorMargin) const;
+	FVectorGrid GenerateLocalMarginSize(const FRoomBlock &Parent, const FHGMargin &DefaultDoorMargin) const;
 
 	//Returns the wall of the given room in which the door must be placed.
-	EGenerationAxe RoomWallAxe(const FRoomBlock &Parent) const;
+	EHGAxe RoomWallAxe(const FRoomBlock &Parent) const;
 
 	//Returns the other parent of this door (nullptr if it is a hall)
 	const FRoomBlock *ObtainOppositeParent(const FRoomBlock &Parent) const;
 
 	//Returns the mesh of this door
-	UFurnitureMeshAsset *GetMeshAsset() const;
+	const FHGMeshDescriptor &GetMesh() const;
+
+	//Geters (used to save the door in the layout files)
+	const FRoomBlock *GetMainParent() const;
+	const FRoomBlock *GetSecondParent() const;
+	const FRoomBlock *GetRecordingRoom() const;
+	EHGAxe GetOpeningSide() const;
+	const FVectorGrid &GetGlobalPosition() const;
+
+	//Copy of this door (position and recording room included) between the copies of its rooms
+	FDoorBlock *CopyForRooms(const TMap<const FRoomBlock *, const FRoomBlock *> &RoomCopies) const;
 
 	//Returns the opposite side of the given axis (often needed there)
-	static EGenerationAxe GetOppositeAxe(EGenerationAxe A);
+	static EHGAxe GetOppositeAxe(EHGAxe A);
 	
 protected:
 	//Linked rooms
@@ -197,15 +229,15 @@ protected:
 	const FRoomBlock * const ParentSecond;
 
 	//Position
-	const EGenerationAxe OpeningSide;
-	bool Placed = false;
+	const EHGAxe OpeningSide;
+	const FRoomBlock *RecordingRoom = nullptr;
 	FVectorGrid GlobalPosition = FVectorGrid(-1, -1);
 
 	//In actual configuration, useless. however it allows multiple mesh for the doors in future system
-	UFurnitureMeshAsset * const DoorAsset;
+	const FHGMeshDescriptor Door;
 };
 
-struct FRoomBlock : FBasicBlock
+struct HOMEGENERATIONCORE_API FRoomBlock : FBasicBlock
 {
 	FRoomBlock() = default;
 	FRoomBlock(const FVectorGrid &_Size, const FVectorGrid &_GlobalPosition, int _Level);
@@ -213,28 +245,80 @@ struct FRoomBlock : FBasicBlock
 	TArray<FDoorBlock *> ConnectedDoors;
 	FName RoomType;
 
-	FVector GenerateRoomOffset(const FBuildingConstraint &BuildData) const;
+	//Index of this room in its level
+	int32 Index = INDEX_NONE;
+
+	//Offset of the interior of the room (relative to the generator), from the real data computed with the walls
+	FVector GenerateRoomOffset(const FHGBuildingMetrics &BuildData) const;
+
+	//Places the windows of this room along the exterior walls of its level
+	void AddWindow(const FBox2D &LevelRect, const FWindowLayout &Layout, TArray<FWindowPlacement> &Windows) const;
 
 	//Comparison by minimal side to allow sorting
 	bool operator<(const FRoomBlock &B) const;
 
+	//Gives a type to each room (sorted by minimal side) according to the quotas, which must be sorted the same way.
+	//The rounding of the quotas is corrected to match the given quantity of rooms.
+	static void AllocateTypes(const TArray<FRoomBlock *> &SortedRoomBlocks, const TArray<FHGRoomQuota> &Quotas, int RoomInhabitants, int RoomQuantity);
+
 	friend FUnknownBlock;
 };
 
-struct FDependencyBuffer
+struct HOMEGENERATIONCORE_API FDependencyBuffer
 {
 	FDependencyBuffer() = delete;
-	FDependencyBuffer(const TArray<FFurnitureDependency> &_Dependencies, const FFurnitureRect &_ParentPosition);
+	FDependencyBuffer(TArray<FHGFurnitureDependency> &&_Dependencies, const FFurnitureRect &_ParentPosition);
 	
-	const TArray<FFurnitureDependency> &Dependencies;
+	const TArray<FHGFurnitureDependency> Dependencies;
 	const FFurnitureRect ParentPosition; //Can't be reference
 };
 
+/**
+ * Plain description of a furniture to spawn, recorded by the placement step and replayed by the spawn step.
+ */
+struct FFurnitureSpawnCommand
+{
+	//Id of the mesh asset in the generator's catalog
+	int32 MeshId = INDEX_NONE;
+
+	//Placement in the room's grid
+	FFurnitureRect Rect;
+
+	//Offset of the room (relative to the generator)
+	FVector RoomOffset = FVector::ZeroVector;
+
+	//Identification of the furniture
+	int32 Level = INDEX_NONE;
+	int32 RoomIndex = INDEX_NONE;
+	FName RoomType;
+	FName FurnitureType;
+
+	//Order of placement in the room (negative for the furniture added by the gameplay)
+	int32 Index = INDEX_NONE;
+};
+
+/**
+ * Ordered list of spawn commands : the placement step only fills it, nothing is spawned until it is executed.
+ */
+struct HOMEGENERATIONCORE_API FFurnitureSpawnBuffer
+{
+	TArray<FFurnitureSpawnCommand> Commands;
+
+	//Records a new command
+	void Record(int32 MeshId, const FFurnitureRect &Rect, const FRoomBlock &Room, const FVector &RoomOffset, const FName &RoomType, const FName &FurnitureType);
+
+	//Appends all the commands of another buffer
+	void Append(const FFurnitureSpawnBuffer &Other);
+
+	void Empty();
+	int32 Num() const;
+};
+
 /**
  * Structures used to divide a level into rooms.
  */
 
-struct FLevelDivisionData
+struct HOMEGENERATIONCORE_API FLevelDivisionData
 {
 	FLevelDivisionData() = delete;
 	FLevelDivisionData(int _LevelTotalArea, int _HallArea);
@@ -251,7 +335,7 @@ struct FLevelDivisionData
 	//Nothing else for instance...
 };
 
-struct FAdjacencyMarker
+struct HOMEGENERATIONCORE_API FAdjacencyMarker
 {
 	//Creates a connection : update corresponding array of each block
 	FAdjacencyMarker() = delete;
@@ -261,7 +345,7 @@ struct FAdjacencyMarker
 	//Deletes this connection (even if there is no update)
 	void UpdateAccordingDivision(FUnknownBlock *InitialBlock, FUnknownBlock *LowestChild, FUnknownBlock *HighestChild, bool DivideAlongX = true);
 
-	bool IsAlongBlockSide(const FUnknownBlock *Block, EGenerationAxe Side) const;
+	bool IsAlongBlockSide(const FUnknownBlock *Block, EHGAxe Side) const;
 
 	//Returns the length of the common side of the two blocks
 	int GetAdjacencyRange() const;
@@ -278,23 +362,31 @@ protected:
 
 	//Side of the main block on which the connection is.
 	//Should always be an UP side.
-	const EGenerationAxe MainSide;
+	const EHGAxe MainSide;
 };
 
 /**
  * Represents a hall : a space between rooms with special decoration
  * Real sizes does not include wall (just a space), offsets starts at the interior of the block (inside the wall)
  */
-struct FHallBlock : FBasicBlock
+struct HOMEGENERATIONCORE_API FHallBlock : FBasicBlock
 {
 	FHallBlock()= default;
 	FHallBlock(const FVectorGrid &_Size, const FVectorGrid &_GlobalPosition, int _Level);
 
+	//Set for the hall containing the stairs (the floor above it is open)
+	bool StairsHall = false;
+
+protected:
+	bool WindowSpawned = false;
+
+public:
+
 	//Checks if the windows of this hall have been already placed
-	bool AreWindowSpawned();
+	bool AreWindowSpawned() const;
 
-	//Choose, place and spawned the needed windows for this hall
-	void AddWindow();
+	//Places the windows of this hall along the exterior walls of its level (only once)
+	void AddWindow(const FBox2D &LevelRect, const FWindowLayout &Layout, TArray<FWindowPlacement> &Windows);
 
 	friend FUnknownBlock;
 	friend FLevelOrganisation;
@@ -304,10 +396,10 @@ struct FHallBlock : FBasicBlock
  * Represents a block being built : a "step" of the division of a level process
  * Real sizes includes wall, offsets starts at the interior of the block (inside the wall)
  */
-struct FUnknownBlock : FBasicBlock
+struct HOMEGENERATIONCORE_API FUnknownBlock : FBasicBlock
 {
 	FUnknownBlock() = default;
-	FUnknownBlock(const FVectorGrid &_Size, const FVectorGrid &_GlobalPosition, int _Level, bool _AlongX, uint8 _AdjacentHalls, EGenerationAxe _DoorSide);
+	FUnknownBlock(const FVectorGrid &_Size, const FVectorGrid &_GlobalPosition, int _Level, bool _AlongX, uint8 _AdjacentHalls, EHGAxe _DoorSide);
 
 	enum class DivideMethod : uint8
 	{
@@ -324,15 +416,15 @@ struct FUnknownBlock : FBasicBlock
 	//Check if it is possible to divide this block and using which method (minimal side's size,...)
 	//Partially random (for the block that could be divide or stopped, depending on the wanted size)
 	//If it decides to split, it updates automatically the FLevelDivisionData struct
-	DivideMethod ShouldDivide(const FRoomsDivisionConstraints &DivisionCst, FLevelDivisionData &DivisionData) const;
+	DivideMethod ShouldDivide(const FHGDivisionMetrics &DivisionCst, FLevelDivisionData &DivisionData, const FHGRandomStream &Stream) const;
 
 	//Try to split the current block : create a hall in between the two new blocks.
 	//The current block is kept and the two created are returned.
-	bool BlockSplit(const FRoomsDivisionConstraints& DivisionCst, FUnknownBlock &FirstResultedBlock, FUnknownBlock &SecondResultedBlock, FHallBlock &ResultHall);
+	bool BlockSplit(const FHGDivisionMetrics& DivisionCst, FUnknownBlock &FirstResultedBlock, FUnknownBlock &SecondResultedBlock, FHallBlock &ResultHall, const FHGRandomStream &Stream);
 	
 	//Try to make a division into the current block : no hall is created.
 	//The current block is kept and the two created are returned.
-	bool BlockDivision(const FRoomsDivisionConstraints& DivisionCst,  FUnknownBlock &FirstResultedBlock, FUnknownBlock &SecondResultedBlock);
+	bool BlockDivision(const FHGDivisionMetrics& DivisionCst,  FUnknownBlock &FirstResultedBlock, FUnknownBlock &SecondResultedBlock, const FHGRandomStream &Stream);
 
 	//Once this block is stopped by the system, it might be transformed to a room
 	void TransformToRoom(FRoomBlock &CreatedRoom);
@@ -340,18 +432,21 @@ struct FUnknownBlock : FBasicBlock
 	//Creates the door connection between the linked room and another.
 	//Must only be called in a "final" block
 	//Must be called once all the "final" blocks have been transformed into rooms.
-	void ConnectDoors(UFurnitureMeshAsset *DoorAsset);
+	void ConnectDoors(const FHGMeshDescriptor &Door, const FHGRandomStream &Stream);
+
+	//Deletes the adjacency markers of the blocks (each one is shared by two blocks of the list) : they are only used until the doors are connected
+	static void DeleteAdjacencyMarkers(TDoubleLinkedList<FUnknownBlock> &Blocks);
 
 	///
 	///Calculation part
 	///
 
 	//Calculates the dimensions of this block using its child blocks
-	void ComputeRealSizeRecursive(const FBuildingConstraint &BuildingCst, const FRoomsDivisionConstraints &RoomDivisionCst); //Upward phase
+	void ComputeRealSizeRecursive(const FHGBuildingMetrics &BuildingCst, const FHGDivisionMetrics &RoomDivisionCst); //Upward phase
 
 	//Generates the needed data to create walls (using previously calculated sizes)
 	//Thus are calculated : new offset for the rooms.
-	void ComputeRealOffsetRecursive(const FBuildingConstraint& BuildingCst, const FRoomsDivisionConstraints& RoomDivisionCst, const bool IsHighestAxe) const; //Downward phase
+	void ComputeRealOffsetRecursive(const FHGBuildingMetrics& BuildingCst, const FHGDivisionMetrics& RoomDivisionCst, const bool IsHighestAxe) const; //Downward phase
 	
 protected:
 	//Indicate along which axis we should divide (set by the previous block)
@@ -376,7 +471,7 @@ protected:
 	//Adjacency Graph
 	TArray<FAdjacencyMarker *> AdjacencyConnections;
 	uint8 AdjacentHalls = 0;
-	EGenerationAxe DoorSide;
+	EHGAxe DoorSide;
 	
 	//Others
 	FHallBlock *HallBlock = nullptr;
@@ -387,7 +482,7 @@ protected:
 	friend FAdjacencyMarker;
 };
 
-struct FLevelOrganisation
+struct HOMEGENERATIONCORE_API FLevelOrganisation
 {
 	enum EInitialBlockPositions { LowWing, HighWing, LowApartment, HighApartment, BlockPositionsSize};
 	enum EInitialHallPositions { LowCorridor, HighCorridor, LowMargin, HighMargin, Stairs, HallPositionsSize};
@@ -427,11 +522,11 @@ struct FLevelOrganisation
 	//Computes all sizes of all linked blocks and hall of this level (included the LevelOrganisation in itself)
 	//Computes the offset of the stairs only
 	//Be careful these calculated value aren't absolute : they must be update according to the stairs of each level.
-	void ComputeBasicRealData(const FBuildingConstraint& BuildingCst, const FRoomsDivisionConstraints& RoomDivisionCst);
+	void ComputeBasicRealData(const FHGBuildingMetrics& BuildingCst, const FHGDivisionMetrics& RoomDivisionCst);
 
 	//Using the given additional offset, the function will update the stairs' and level's offset
 	//It will then calculate the offset for each block (and launch the recursive call)
-	void ComputeAllRealData(const FVector2D &LevelOffset ,const FBuildingConstraint& BuildingCst, const FRoomsDivisionConstraints& RoomDivisionCst);
+	void ComputeAllRealData(const FVector2D &LevelOffset ,const FHGBuildingMetrics& BuildingCst, const FHGDivisionMetrics& RoomDivisionCst);
 
 	//Returns the real offset of the Hall which represent the stairs
 	const FVector2D &GetStairsRealOffset() const;
@@ -466,3 +561,37 @@ protected:
 	///  4 : HighMargin
 	///  5 : Stairs
 };
+
+/**
+ * Dwelling unit of the apartment block mode : one initial block of a level (a wing or an apartment), divided and allocated on its own.
+ * Owns the blocks it creates until they are given to the generator.
+ */
+struct HOMEGENERATIONCORE_API FHGDwellingUnit
+{
+	FHGDwellingUnit() = default;
+	FHGDwellingUnit(const FHGDwellingUnit &) = delete;
+	~FHGDwellingUnit();
+
+	int Level = 0;
+	FLevelOrganisation::EInitialBlockPositions Position = FLevelOrganisation::LowWing;
+
+	//Block of the initial organisation : never modified, each attempt starts from it
+	const FUnknownBlock *InitialBlock = nullptr;
+
+	//Share of the inhabitants living in this unit, and number of rooms they need
+	int Inhabitants = 0;
+	int RoomQuantity = 0;
+
+	//Blocks created by the last attempt (Root is the divided copy of the initial block, null if the division failed)
+	TArray<FRoomBlock *> Rooms;
+	TArray<FHallBlock *> Halls;
+	TDoubleLinkedList<FUnknownBlock> Nodes;
+	FUnknownBlock *Root = nullptr;
+
+	//Number of attempts done, and if the last one gave enough rooms
+	int Attempts = 0;
+	bool bSucceeded = false;
+
+	//Deletes all the blocks (the doors and the adjacency markers too) of the last attempt
+	void Reset();
+};
@@ -0,0 +1,222 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/ArrayView.h"
+
+class IMappedFileHandle;
+class IMappedFileRegion;
+
+/**
+ * Binary layout file of a generated building : blocks, doors and furniture placements.
+ * All the records are plain data at fixed offsets from the start of the file (no pointer, little endian) : the file is read in place, once mapped in memory.
+ * The names (room types, furniture types, asset paths) are stored once in a string table and referenced by id.
+ * The version must be incremented on any change of the records.
+ */
+namespace HGLayoutFile
+{
+	//"HGLY"
+	constexpr uint32 Magic = 0x594C4748;
+	constexpr uint16 Version = 1;
+}
+
+//Array of records in the file
+struct FHGLayoutSection
+{
+	//From the start of the file
+	uint32 Offset = 0;
+	uint32 Num = 0;
+};
+
+struct FHGLayoutHeader
+{
+	uint32 Magic = HGLayoutFile::Magic;
+	uint16 Version = HGLayoutFile::Version;
+	uint16 HeaderSize = 0;
+	uint32 FileSize = 0;
+
+	int32 Seed = 0;
+
+	//Building data
+	int32 Levels = 0;
+	int32 DividedLevels = 0;//Levels above are copies of the typical floor
+	int32 BuildingSizeX = 0;
+	int32 BuildingSizeY = 0;
+	float GridSnapLength = 0.f;
+	float FloorHeight = 0.f;
+	float FloorWidth = 0.f;
+	float WallWidth = 0.f;
+
+	//String ids of the paths of the selected assets
+	int32 SelectedDoor = INDEX_NONE;
+	int32 SelectedStair = INDEX_NONE;
+	int32 SelectedWindow = INDEX_NONE;
+
+	//FHGLayoutString, UTF-8 characters, and string ids of the paths of the furniture meshes (the catalog of the file)
+	FHGLayoutSection Strings;
+	FHGLayoutSection Chars;
+	FHGLayoutSection Meshes;
+
+	FHGLayoutSection Halls;
+	FHGLayoutSection Rooms;
+	FHGLayoutSection Doors;
+	FHGLayoutSection Furniture;
+};
+
+struct FHGLayoutString
+{
+	//In the Chars section (not null terminated)
+	uint32 Offset = 0;
+	uint32 Length = 0;
+};
+
+struct FHGLayoutHall
+{
+	int32 Level = 0;
+	int32 PositionX = 0;
+	int32 PositionY = 0;
+	int32 SizeX = 0;
+	int32 SizeY = 0;
+	float RealOffsetX = 0.f;
+	float RealOffsetY = 0.f;
+	float RealSizeX = 0.f;
+	float RealSizeY = 0.f;
+	uint8 bStairsHall = 0;
+	uint8 Padding[3] = {};
+};
+
+//Stored by level, in the order of their index
+struct FHGLayoutRoom
+{
+	int32 Level = 0;
+	int32 Index = 0;
+	int32 PositionX = 0;
+	int32 PositionY = 0;
+	int32 SizeX = 0;
+	int32 SizeY = 0;
+	float RealOffsetX = 0.f;
+	float RealOffsetY = 0.f;
+	float RealSizeX = 0.f;
+	float RealSizeY = 0.f;
+	int32 RoomType = INDEX_NONE;
+};
+
+struct FHGLayoutDoor
+{
+	int32 Level = 0;
+
+	//Room indices in the level (INDEX_NONE for a hall or no recording room)
+	int32 MainRoom = INDEX_NONE;
+	int32 SecondRoom = INDEX_NONE;
+	int32 RecordingRoom = INDEX_NONE;
+
+	//Global grid position (-1 if the door has no valid position)
+	int32 PositionX = -1;
+	int32 PositionY = -1;
+
+	//String id of the path of the door asset
+	int32 Mesh = INDEX_NONE;
+
+	uint8 OpeningSide = 0;
+	uint8 Padding[3] = {};
+};
+
+struct FHGLayoutFurniture
+{
+	//Id in the Meshes section
+	int32 Mesh = INDEX_NONE;
+
+	int32 PositionX = 0;
+	int32 PositionY = 0;
+	int32 SizeX = 0;
+	int32 SizeY = 0;
+	float RoomOffsetX = 0.f;
+	float RoomOffsetY = 0.f;
+	float RoomOffsetZ = 0.f;
+	int32 Level = 0;
+	int32 RoomIndex = 0;
+	int32 RoomType = INDEX_NONE;
+	int32 FurnitureType = INDEX_NONE;
+	uint8 Rotation = 0;
+	uint8 Padding[3] = {};
+};
+
+/**
+ * Builds a layout file in memory.
+ */
+struct HOMEGENERATIONCORE_API FHGLayoutWriter
+{
+	FHGLayoutHeader Header;
+	TArray<int32> Meshes;
+	TArray<FHGLayoutHall> Halls;
+	TArray<FHGLayoutRoom> Rooms;
+	TArray<FHGLayoutDoor> Doors;
+	TArray<FHGLayoutFurniture> Furniture;
+
+	//Returns the id of the string (added only once)
+	int32 AddString(const FString &String);
+
+	void Write(TArray<uint8> &Bytes);
+
+protected:
+	TArray<FHGLayoutString> Strings;
+	TArray<uint8> Chars;
+	TMap<FString, int32> StringIds;
+};
+
+/**
+ * Read only view on the bytes of a layout file : the records are used in place.
+ */
+struct HOMEGENERATIONCORE_API FHGLayoutView
+{
+	//Checks the header and that all the sections are inside the data
+	bool Initialize(const uint8 *_Data, int64 _Size);
+
+	const FHGLayoutHeader &GetHeader() const;
+
+	TArrayView<const int32> GetMeshes() const;
+	TArrayView<const FHGLayoutHall> GetHalls() const;
+	TArrayView<const FHGLayoutRoom> GetRooms() const;
+	TArrayView<const FHGLayoutDoor> GetDoors() const;
+	TArrayView<const FHGLayoutFurniture> GetFurniture() const;
+
+	//Empty string for an invalid id
+	FString GetString(int32 Id) const;
+
+protected:
+	const uint8 *Data = nullptr;
+	int64 Size = 0;
+
+	template<typename T>
+	TArrayView<const T> GetSection(const FHGLayoutSection &Section) const
+	{
+		return MakeArrayView(reinterpret_cast<const T *>(Data + Section.Offset), Section.Num);
+	}
+
+	template<typename T>
+	bool IsSectionValid(const FHGLayoutSection &Section) const
+	{
+		return Section.Offset % alignof(T) == 0 && static_cast<int64>(Section.Offset) + static_cast<int64>(Section.Num) * sizeof(T) <= Size;
+	}
+};
+
+/**
+ * Layout file opened for reading : mapped in memory if the platform allows it, else loaded at once.
+ */
+struct HOMEGENERATIONCORE_API FHGLayoutFile
+{
+	FHGLayoutFile();
+	~FHGLayoutFile();
+
+	bool Open(const FString &Filename);
+
+	const FHGLayoutView &GetView() const;
+
+protected:
+	TUniquePtr<IMappedFileHandle> MappedFile;
+	TUniquePtr<IMappedFileRegion> MappedRegion;
+	TArray<uint8> Bytes;
+
+	FHGLayoutView View;
+};
@@ -0,0 +1,42 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class FHGBuildingPlan;
+struct FFurnitureSpawnBuffer;
+
+//Generation of one seed (one line of the manifest)
+struct FHGLayoutJob
+{
+	FString Preset;
+	int32 Seed = 0;
+	FString Filename;
+
+	//Empty if the layout has been written
+	FString Error;
+
+	int32 Levels = 0;
+	int32 Rooms = 0;
+	int32 Furniture = 0;
+	int32 Size = 0;
+	double Milliseconds = 0.0;
+};
+
+/**
+ * Offline computation of layouts, shared by the layout commandlet and the layout tool : both write the same layout files and manifest for the same parameters.
+ */
+namespace HGLayoutJob
+{
+	//Any thread : computes the layout of the plan in the layout file format (Bytes is left empty if the layout is invalid)
+	HOMEGENERATIONCORE_API void ComputeLayout(FHGBuildingPlan &Plan, FFurnitureSpawnBuffer &SpawnBuffer, FHGLayoutJob &Job, TArray<uint8> &Bytes);
+
+	//Returns the reason why the computed layout can't be used (empty if it is valid)
+	HOMEGENERATIONCORE_API FString CheckLayout(const FHGBuildingPlan &Plan);
+
+	//Parses ranges of signed seeds : "0-99,150,200-210,-20--10"
+	HOMEGENERATIONCORE_API bool ParseSeeds(const FString &Text, TArray<int32> &Seeds);
+
+	HOMEGENERATIONCORE_API bool WriteManifest(const FString &Filename, const TArray<FHGLayoutJob> &Jobs);
+}
@@ -0,0 +1,21 @@
+﻿// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Modules/ModuleManager.h"
+
+DECLARE_LOG_CATEGORY_EXTERN(LogHomeGenerationCore, Log, All);
+
+/**
+ * Algorithms of the home generation working only on plain data (no world, no UObject) : building sizing, stairs placement, levels division, real data computation, rooms allocation and furniture placement (see FHGBuildingPlan).
+ * The HomeGeneration module converts its assets and actor properties into these structures, then spawns the result.
+ */
+class FHomeGenerationCoreModule : public IModuleInterface
+{
+public:
+
+	/** IModuleInterface implementation */
+	virtual void StartupModule() override;
+	virtual void ShutdownModule() override;
+};
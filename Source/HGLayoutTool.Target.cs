@@ -0,0 +1,30 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+using UnrealBuildTool;
+using System.Collections.Generic;
+
+//Computes the layouts of the plan files exported by the layout commandlet, without the engine (see HGLayoutTool.cpp)
+[SupportedPlatforms(UnrealPlatformClass.Desktop)]
+public class HGLayoutToolTarget : TargetRules
+{
+	public HGLayoutToolTarget(TargetInfo Target) : base(Target)
+	{
+		Type = TargetType.Program;
+		DefaultBuildSettings = BuildSettingsVersion.V2;
+		LinkType = TargetLinkType.Monolithic;
+		LaunchModuleName = "HGLayoutTool";
+
+		//Only the HomeGenerationCore module of the plugin is built : the HomeGeneration module isn't built for the programs (see ProceduralGeneration.uplugin)
+		bCompileWithPluginSupport = true;
+		EnablePlugins.Add("ProceduralGeneration");
+
+		bCompileAgainstEngine = false;
+		bCompileAgainstCoreUObject = false;
+		bCompileAgainstApplicationCore = false;
+		bBuildDeveloperTools = false;
+		bBuildWithEditorOnlyData = false;
+
+		//Console application : main() instead of WinMain()
+		bIsBuildingConsoleApplication = true;
+	}
+}
@@ -0,0 +1,16 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+using System.IO;
+using UnrealBuildTool;
+
+public class HGLayoutTool : ModuleRules
+{
+	public HGLayoutTool(ReadOnlyTargetRules Target) : base(Target)
+	{
+		//RequiredProgramMainCPPInclude.h
+		PublicIncludePaths.Add(Path.Combine(EngineDirectory, "Source/Runtime/Launch/Public"));
+		PrivateIncludePaths.Add(Path.Combine(EngineDirectory, "Source/Runtime/Launch/Private"));
+
+		PrivateDependencyModuleNames.AddRange(new string[] { "Core", "Projects", "HomeGenerationCore" });
+	}
+}
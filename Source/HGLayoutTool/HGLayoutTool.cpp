@@ -0,0 +1,136 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "HGLayoutTool.h"
+#include "RequiredProgramMainCPPInclude.h"
+#include "HGBuildingPlan.h"
+#include "HGLayoutJob.h"
+#include "Async/ParallelFor.h"
+#include "HAL/PlatformMisc.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogHGLayoutTool, Log, All);
+
+IMPLEMENT_APPLICATION(HGLayoutTool, "HGLayoutTool");
+
+/**
+ * Computes the layouts of ranges of seeds from the plan files of the generators (see UHGLayoutCommandlet -ExportPlans), with only the HomeGenerationCore module.
+ * The layout files and the manifest are the same as the ones of the layout commandlet for the same presets and seeds.
+ *
+ * HGLayoutTool -Plans=Dir/BP_House_C.hgplan[,...] -Seeds=0-999[,2000,...] -Output=Dir [-Workers=N]
+ */
+namespace
+{
+	const TCHAR *Usage = TEXT("HGLayoutTool -Plans=Dir/BP_House_C.hgplan[,...] -Seeds=0-999[,...] -Output=Dir [-Workers=N]");
+
+	//Generates all the seeds with the parameters of the plan file. Returns false if the plan can't be read.
+	bool GeneratePlan(const FString &PlanPath, const TArray<int32> &Seeds, int32 Workers, const FString &Output, TArray<FHGLayoutJob> &Jobs)
+	{
+		//Read once : the catalog stays loaded for all the seeds
+		FHGPlanParameters Parameters;
+		if(!Parameters.LoadFromFile(PlanPath))
+		{
+			UE_LOG(LogHGLayoutTool, Error, TEXT("Can't read the plan %s."), *PlanPath);
+			return false;
+		}
+
+		//Same directory as the commandlet : the plan is named after its preset
+		const FString Name = FPaths::GetBaseFilename(PlanPath);
+		const FString Directory = Output / Name;
+		for(int32 First = 0; First < Seeds.Num(); First += Workers)
+		{
+			const int32 Num = FMath::Min(Workers, Seeds.Num() - First);
+			const int32 FirstJob = Jobs.Num();
+			for(int32 i = 0; i < Num; ++i)
+			{
+				FHGLayoutJob &Job = Jobs.AddDefaulted_GetRef();
+				Job.Preset = PlanPath;
+				Job.Seed = Seeds[First + i];
+				Job.Filename = Directory / FString::Printf(TEXT("%d.hglayout"), Job.Seed);
+			}
+
+			//Each worker has its own copy of the parameters, like the generators of the commandlet
+			ParallelFor(Num, [&Parameters, &Jobs, FirstJob] (int32 i)
+			{
+				FHGLayoutJob &Job = Jobs[FirstJob + i];
+				FHGBuildingPlan Plan;
+				static_cast<FHGPlanParameters &>(Plan) = Parameters;
+				Plan.Seed = Job.Seed;
+
+				FFurnitureSpawnBuffer SpawnBuffer;
+				TArray<uint8> Bytes;
+				HGLayoutJob::ComputeLayout(Plan, SpawnBuffer, Job, Bytes);
+				if(Job.Error.IsEmpty() && !FFileHelper::SaveArrayToFile(Bytes, *Job.Filename))
+					Job.Error = TEXT("Can't write the layout file");
+			});
+
+			for(int32 JobIndex = FirstJob; JobIndex < Jobs.Num(); ++JobIndex)
+			{
+				const FHGLayoutJob &Job = Jobs[JobIndex];
+				if(Job.Error.IsEmpty())
+				{
+					UE_LOG(LogHGLayoutTool, Display, TEXT("%s seed %d : %d levels, %d rooms, %d furniture in %.2f ms."), *Name, Job.Seed, Job.Levels, Job.Rooms, Job.Furniture, Job.Milliseconds);
+				}
+				else
+				{
+					UE_LOG(LogHGLayoutTool, Warning, TEXT("%s seed %d failed : %s"), *Name, Job.Seed, *Job.Error);
+				}
+			}
+		}
+		return true;
+	}
+
+	int32 RunLayoutTool(const TCHAR *CommandLine)
+	{
+		FString PlansParam, SeedsParam, Output;
+		TArray<int32> Seeds;
+		if(!FParse::Value(CommandLine, TEXT("Plans="), PlansParam, false) || !FParse::Value(CommandLine, TEXT("Seeds="), SeedsParam, false)
+			|| !FParse::Value(CommandLine, TEXT("Output="), Output) || !HGLayoutJob::ParseSeeds(SeedsParam, Seeds))
+		{
+			UE_LOG(LogHGLayoutTool, Error, TEXT("Usage : %s"), Usage);
+			return 1;
+		}
+
+		int32 Workers = FPlatformMisc::NumberOfCoresIncludingHyperthreads();
+		FParse::Value(CommandLine, TEXT("Workers="), Workers);
+		Workers = FMath::Clamp(Workers, 1, Seeds.Num());
+
+		TArray<FString> Plans;
+		PlansParam.ParseIntoArray(Plans, TEXT(","));
+
+		TArray<FHGLayoutJob> Jobs;
+		int32 InvalidPlans = 0;
+		for(const FString &Plan : Plans)
+			if(!GeneratePlan(Plan, Seeds, Workers, Output, Jobs))
+				++InvalidPlans;
+
+		const FString Manifest = Output / TEXT("Manifest.csv");
+		if(!HGLayoutJob::WriteManifest(Manifest, Jobs))
+			UE_LOG(LogHGLayoutTool, Error, TEXT("Can't write the manifest %s."), *Manifest);
+
+		int32 Failures = 0;
+		double TotalTime = 0.0, MaxTime = 0.0;
+		for(const FHGLayoutJob &Job : Jobs)
+		{
+			Failures += Job.Error.IsEmpty() ? 0 : 1;
+			TotalTime += Job.Milliseconds;
+			MaxTime = FMath::Max(MaxTime, Job.Milliseconds);
+		}
+		UE_LOG(LogHGLayoutTool, Display, TEXT("%d layouts computed, %d failed (%d invalid plans). Average %.2f ms, max %.2f ms per seed."),
+			Jobs.Num() - Failures, Failures, InvalidPlans, Jobs.Num() > 0 ? TotalTime / Jobs.Num() : 0.0, MaxTime);
+
+		return Failures > 0 || InvalidPlans > 0 ? 1 : 0;
+	}
+}
+
+INT32_MAIN_INT32_ARGC_TCHAR_ARGV()
+{
+	GEngineLoop.PreInit(ArgC, ArgV);
+	const int32 Result = RunLayoutTool(FCommandLine::Get());
+
+	GLog->Flush();
+	FEngineLoop::AppPreExit();
+	FModuleManager::Get().UnloadModulesAtShutdown();
+	FEngineLoop::AppExit();
+	return Result;
+}